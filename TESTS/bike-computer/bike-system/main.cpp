@@ -24,6 +24,8 @@
 
 #include <chrono>
 
+#include "common/coalescing_mailbox.hpp"
+#include "common/deferred_log.hpp"
 #include "greentea-client/test_env.h"
 #include "mbed.h"
 #include "multi_tasking/bike_system.hpp"
@@ -35,6 +37,42 @@
 
 using namespace utest::v1;
 
+// allow for 2 msecs of release jitter for 99% of the task invocations
+static constexpr std::chrono::microseconds kMaxReleaseJitterP99 = 2000us;
+
+static void printTaskStatistics(const bike_computer::TaskTracer& taskTracer,
+                                uint8_t taskIndex) {
+    const bike_computer::TaskTracer::TaskStatistics& statistics =
+        taskTracer.getTaskStatistics(taskIndex);
+    const bike_computer::LatencyHistogram* histograms[] = {
+        &statistics.releaseJitter, &statistics.responseTime, &statistics.executionTime};
+    const char* const names[] = {"release jitter", "response time", "execution time"};
+    for (uint8_t index = 0; index < 3; index++) {
+        const bike_computer::LatencyHistogram& histogram = *histograms[index];
+        printf("Task %" PRIu8 " %s: %" PRIu32 " samples, min %" PRId64 " p50 %" PRId64
+               " p99 %" PRId64 " p99.9 %" PRId64 " max %" PRId64 " usecs\n",
+               taskIndex,
+               names[index],
+               histogram.getCount(),
+               static_cast<int64_t>(histogram.getMin().count()),
+               static_cast<int64_t>(histogram.getPercentile(50.0f).count()),
+               static_cast<int64_t>(histogram.getPercentile(99.0f).count()),
+               static_cast<int64_t>(histogram.getPercentile(99.9f).count()),
+               static_cast<int64_t>(histogram.getMax().count()));
+    }
+}
+
+// check the release jitter on all invocations and not only on the last one
+static void checkReleaseJitter(const bike_computer::TaskTracer& taskTracer,
+                               uint8_t taskIndex) {
+    printTaskStatistics(taskTracer, taskIndex);
+    const bike_computer::LatencyHistogram& releaseJitter =
+        taskTracer.getTaskStatistics(taskIndex).releaseJitter;
+    TEST_ASSERT_TRUE(releaseJitter.getCount() > 0);
+    TEST_ASSERT_LESS_OR_EQUAL(kMaxReleaseJitterP99.count(),
+                              releaseJitter.getPercentile(99.0f).count());
+}
+
 // test_bike_system handler function
 static void test_bike_system() {
     // create the BikeSystem instance
@@ -70,7 +108,46 @@ static void test_bike_system() {
             deltaUs,
             taskComputationTimes[taskIndex].count(),
             bikeSystem.getTaskLogger().getComputationTime(taskIndex).count());
+
+        checkReleaseJitter(bikeSystem.getTaskLogger(), taskIndex);
+        const bike_computer::LatencyHistogram& executionTime =
+            bikeSystem.getTaskLogger().getTaskStatistics(taskIndex).executionTime;
+        TEST_ASSERT_UINT64_WITHIN(deltaUs,
+                                  taskComputationTimes[taskIndex].count(),
+                                  executionTime.getPercentile(99.0f).count());
+    }
+
+    // the frames are released at absolute times and none is late
+    TEST_ASSERT_EQUAL_UINT32(0, bikeSystem.getNbrOfFrameOverruns());
+}
+
+// test_bike_system_cpu_task handler function
+static void test_bike_system_cpu_task() {
+    static_scheduling::BikeSystem bikeSystem;
+
+    Thread thread;
+    thread.start(callback(&bikeSystem, &static_scheduling::BikeSystem::start));
+
+    // more records than the serial port can send in the idle end of the
+    // display task 1 frame, where the cpu task runs, the time for sending them
+    // is charged to the cpu task (see cpuTask())
+    bike_computer::DeferredLog& deferredLog = bike_computer::DeferredLog::getInstance();
+    for (uint8_t cycle = 0; cycle < 6; cycle++) {
+        // fill the ring buffer
+        for (uint32_t i = 0; i < bike_computer::DeferredLog::kCapacity; i++) {
+            DEFERRED_LOG_INFO(bike_computer::kLogResetResponseTime, static_cast<int64_t>(i));
+        }
+        ThisThread::sleep_for(1600ms);
     }
+
+    // the drain is bounded: records are left for the next cycles and no frame
+    // is late
+    const uint32_t nbrOfPendingRecords = deferredLog.getNbrOfPendingRecords();
+    bikeSystem.stop();
+    thread.join();
+    printf("%" PRIu32 " deferred log records pending\n", nbrOfPendingRecords);
+    TEST_ASSERT_TRUE(nbrOfPendingRecords > 0);
+    TEST_ASSERT_EQUAL_UINT32(0, bikeSystem.getNbrOfFrameOverruns());
 }
 
 // test_bike_system_event_queue handler function
@@ -104,6 +181,40 @@ static void test_bike_system_event_queue() {
             kDeltaUs,
             taskPeriods[taskIndex].count(),
             bikeSystem.getTaskLogger().getPeriod(taskIndex).count());
+        checkReleaseJitter(bikeSystem.getTaskLogger(), taskIndex);
+    }
+}
+
+// test_bike_system_edf_event_queue handler function
+static void test_bike_system_edf_event_queue() {
+    // create the BikeSystem instance
+    static_scheduling_with_event::BikeSystem bikeSystem;
+
+    // run the bike system in a separate thread
+    Thread thread;
+    thread.start(callback(&bikeSystem,
+                          &static_scheduling_with_event::BikeSystem::startWithEdfEventQueue));
+
+    // let the bike system run for 20 secs
+    ThisThread::sleep_for(20s);
+
+    // stop the bike system
+    bikeSystem.stop();
+
+    // the schedule is feasible, so that it is the same as with the EventQueue
+    // and no deadline is missed
+    constexpr std::chrono::microseconds taskPeriods[] = {
+        800000us, 400000us, 1600000us, 800000us, 1600000us, 1600000us};
+    constexpr uint64_t kDeltaUs = 2000;
+    for (uint8_t taskIndex = 0; taskIndex < advembsof::TaskLogger::kNbrOfTasks;
+         taskIndex++) {
+        TEST_ASSERT_UINT64_WITHIN(
+            kDeltaUs,
+            taskPeriods[taskIndex].count(),
+            bikeSystem.getTaskLogger().getPeriod(taskIndex).count());
+        checkReleaseJitter(bikeSystem.getTaskLogger(), taskIndex);
+        TEST_ASSERT_EQUAL_UINT32(
+            0, bikeSystem.getTaskLogger().getTaskStatistics(taskIndex).nbrOfDeadlineMisses);
     }
 }
 
@@ -137,6 +248,7 @@ static void test_bike_system_with_event() {
     TEST_ASSERT_UINT64_WITHIN(
         deltaUs, taskPeriods[taskIndex].count(),
         bikeSystem.getTaskLogger().getPeriod(taskIndex).count());
+    checkReleaseJitter(bikeSystem.getTaskLogger(), taskIndex);
   }
     // allow for 2 msecs offset (with EventQueue)
     constexpr uint64_t kDeltaUs = 2000;
@@ -185,6 +297,30 @@ static void test_multi_tasking_bike_system() {
         bikeSystem.getTaskLogger()
             .getPeriod(advembsof::TaskLogger::kDisplayTask1Index)
             .count());
+    checkReleaseJitter(bikeSystem.getTaskLogger(),
+                       advembsof::TaskLogger::kTemperatureTaskIndex);
+    checkReleaseJitter(bikeSystem.getTaskLogger(),
+                       advembsof::TaskLogger::kDisplayTask1Index);
+
+    // the gear and speed do not change and the temperature hardly changes
+    // (steady ride), so that these fields are drawn once and then skipped
+    const bike_computer::IncrementalDisplay& display = bikeSystem.getIncrementalDisplay();
+    const uint32_t nbrOfDisplayPeriods =
+        bikeSystem.getTaskLogger()
+            .getTaskStatistics(advembsof::TaskLogger::kDisplayTask1Index)
+            .executionTime.getCount();
+    constexpr bike_computer::IncrementalDisplay::Field kSteadyFields[] = {
+        bike_computer::IncrementalDisplay::kGearField,
+        bike_computer::IncrementalDisplay::kSpeedField};
+    for (bike_computer::IncrementalDisplay::Field field : kSteadyFields) {
+        TEST_ASSERT_EQUAL_UINT32(1, display.getNbrOfRedraws(field));
+        TEST_ASSERT_EQUAL_UINT32(nbrOfDisplayPeriods - 1, display.getNbrOfSkips(field));
+    }
+    printf("Display: temperature %" PRIu32 " redraws, distance %" PRIu32
+           " redraws in %" PRIu32 " periods\n",
+           display.getNbrOfRedraws(bike_computer::IncrementalDisplay::kTemperatureField),
+           display.getNbrOfRedraws(bike_computer::IncrementalDisplay::kDistanceField),
+           nbrOfDisplayPeriods);
 }
 
 // test_reset_multi_tasking_bike_system handler function
@@ -263,6 +399,8 @@ static void test_gear_multi_tasking_bike_system() {
     for (uint8_t i = 0; i <= bike_computer::kMaxGear; i++) {
         uint8_t currentGear = bikeSystem.getCurrentGear();
         bikeSystem.getGearDevice().onUp();
+        // let the bike system process the gear event
+        ThisThread::sleep_for(1ms);
 
         uint8_t nextGear = bikeSystem.getCurrentGear();
 
@@ -277,6 +415,8 @@ static void test_gear_multi_tasking_bike_system() {
     for (uint8_t i = bike_computer::kMaxGear; i >= bike_computer::kMinGear; i--) {
         uint8_t currentGear = bikeSystem.getCurrentGear();
         bikeSystem.getGearDevice().onDown();
+        // let the bike system process the gear event
+        ThisThread::sleep_for(1ms);
 
         uint8_t nextGear = bikeSystem.getCurrentGear();
 
@@ -287,9 +427,123 @@ static void test_gear_multi_tasking_bike_system() {
         }
     }
 
+    // no gear event may be lost with one press per msec
+    TEST_ASSERT_EQUAL_UINT32(0, bikeSystem.getNbrOfDroppedEvents());
+
+    bikeSystem.stop();
+}
+
+static void test_event_coalescing_multi_tasking_bike_system() {
+    multi_tasking::BikeSystem bikeSystem;
+
+    Thread thread;
+    thread.start(callback(&bikeSystem, &multi_tasking::BikeSystem::start));
+
+    // let the bike system start
+    ThisThread::sleep_for(10ms);
+    TEST_ASSERT_EQUAL_UINT32(0, bikeSystem.getNbrOfDroppedEvents());
+
+    // a burst of joystick presses faster than the events are dispatched
+    // collapses into a single gear event with the newest gear
+    constexpr uint32_t kNbrOfPresses = 64;
+    const uint32_t nbrOfCoalescedEvents = bikeSystem.getGearDevice().getNbrOfCoalescedEvents();
+    for (uint32_t i = 0; i < kNbrOfPresses / 2; i++) {
+        bikeSystem.getGearDevice().onUp();
+        bikeSystem.getGearDevice().onDown();
+    }
+    bikeSystem.getGearDevice().onUp();
+    printf("%" PRIu32 " gear events coalesced out of %" PRIu32 "\n",
+           bikeSystem.getGearDevice().getNbrOfCoalescedEvents() - nbrOfCoalescedEvents,
+           kNbrOfPresses + 1);
+    TEST_ASSERT_EQUAL_UINT32(0, bikeSystem.getNbrOfDroppedEvents());
+    TEST_ASSERT_EQUAL_UINT32(
+        kNbrOfPresses, bikeSystem.getGearDevice().getNbrOfCoalescedEvents() - nbrOfCoalescedEvents);
+
+    // the newest gear is handled
+    ThisThread::sleep_for(1ms);
+    TEST_ASSERT_EQUAL_UINT8(bike_computer::kMinGear + 1, bikeSystem.getCurrentGear());
+
+    // and a later change posts a new event
+    bikeSystem.getGearDevice().onUp();
+    ThisThread::sleep_for(1ms);
+    TEST_ASSERT_EQUAL_UINT8(bike_computer::kMinGear + 2, bikeSystem.getCurrentGear());
+
     bikeSystem.stop();
 }
 
+static uint8_t deliveredGear = 0;
+static void onGearDelivered(const uint8_t& gear) { deliveredGear = gear; }
+static void emptyEvent() {}
+
+static void test_event_overflow_coalescing_mailbox() {
+    // a queue with room for a few events, filled before the mailbox posts
+    constexpr size_t kNbrOfEvents = 4;
+    unsigned char buffer[kNbrOfEvents * EVENTS_EVENT_SIZE];
+    EventQueue eventQueue(sizeof(buffer), buffer);
+    bike_computer::CoalescingMailbox<uint8_t> mailbox(eventQueue, callback(onGearDelivered));
+    uint32_t nbrOfQueuedEvents = 0;
+    while (eventQueue.call(emptyEvent) != 0) {
+        nbrOfQueuedEvents++;
+    }
+    TEST_ASSERT_TRUE(nbrOfQueuedEvents > 0);
+
+    // the overflow is counted and the value is not marked as pending
+    TEST_ASSERT_FALSE(mailbox.post(1));
+    TEST_ASSERT_EQUAL_UINT32(1, mailbox.getNbrOfDroppedEvents());
+    TEST_ASSERT_FALSE(mailbox.post(2));
+    TEST_ASSERT_EQUAL_UINT32(2, mailbox.getNbrOfDroppedEvents());
+    TEST_ASSERT_EQUAL_UINT32(0, mailbox.getNbrOfCoalescedValues());
+
+    // the mailbox posts again once the queue is dispatched
+    eventQueue.dispatch_for(1ms);
+    deliveredGear = 0;
+    TEST_ASSERT_TRUE(mailbox.post(3));
+    eventQueue.dispatch_for(1ms);
+    TEST_ASSERT_EQUAL_UINT8(3, deliveredGear);
+    TEST_ASSERT_EQUAL_UINT32(2, mailbox.getNbrOfDroppedEvents());
+}
+
+static void test_rate_monotonic_multi_tasking_bike_system() {
+    multi_tasking::BikeSystem bikeSystem;
+
+    Thread thread;
+    thread.start(
+        callback(&bikeSystem, &multi_tasking::BikeSystem::startWithRateMonotonicThreads));
+
+    // let the bike system run for 2 secs
+    ThisThread::sleep_for(2s);
+
+    // the reset thread preempts the periodic tasks
+    bikeSystem.getSpeedometer().setOnResetCallback(resetCallback);
+    timer.start();
+    constexpr uint8_t kNbrOfResets = 10;
+    for (uint8_t i = 0; i < kNbrOfResets; i++) {
+        const auto startTime = timer.elapsed_time();
+        bikeSystem.onReset();
+        eventFlags.wait_all(kResetEventFlag);
+        const auto responseTime = resetTime - startTime;
+        constexpr std::chrono::microseconds kMaxExpectedResponseTime(20);
+        TEST_ASSERT_TRUE(responseTime.count() <= kMaxExpectedResponseTime.count());
+        // spread the resets over the major cycle
+        ThisThread::sleep_for(1700ms);
+    }
+
+    bikeSystem.stop();
+
+    // the periodic threads are released at their period, without deadline
+    // misses
+    constexpr uint8_t kPeriodicTaskIndexes[] = {advembsof::TaskLogger::kTemperatureTaskIndex,
+                                                advembsof::TaskLogger::kDisplayTask1Index};
+    constexpr uint64_t kDeltaUs = 2000;
+    for (uint8_t taskIndex : kPeriodicTaskIndexes) {
+        TEST_ASSERT_UINT64_WITHIN(
+            kDeltaUs, 1600000, bikeSystem.getTaskLogger().getPeriod(taskIndex).count());
+        checkReleaseJitter(bikeSystem.getTaskLogger(), taskIndex);
+        TEST_ASSERT_EQUAL_UINT32(
+            0, bikeSystem.getTaskLogger().getTaskStatistics(taskIndex).nbrOfDeadlineMisses);
+    }
+}
+
 static utest::v1::status_t greentea_setup(const size_t number_of_cases) {
     // Here, we specify the timeout (60s) and the host test (a built-in host test or the
     // name of our Python file)
@@ -301,15 +555,17 @@ static utest::v1::status_t greentea_setup(const size_t number_of_cases) {
 // List of test cases in this file
 static Case cases[] = {
     Case("test bike system", test_bike_system),
-    Case("test bike system with event", test_bike_system_with_event),
-    Case("test bike system event queue", test_bike_system_event_queue),
-};
-
+    Case("test bike system cpu task", test_bike_system_cpu_task),
     Case("test bike system with event queue", test_bike_system_event_queue),
     Case("test bike system with event", test_bike_system_with_event),
+    Case("test bike system with edf event queue", test_bike_system_edf_event_queue),
     Case("test multi-tasking bike system", test_multi_tasking_bike_system),
     Case("test reset multi-tasking bike system", test_reset_multi_tasking_bike_system),
-    Case("test gear system", test_gear_multi_tasking_bike_system)};
+    Case("test gear system", test_gear_multi_tasking_bike_system),
+    Case("test event overflow", test_event_overflow_coalescing_mailbox),
+    Case("test event coalescing", test_event_coalescing_multi_tasking_bike_system),
+    Case("test rate monotonic multi-tasking bike system",
+         test_rate_monotonic_multi_tasking_bike_system)};
 static Specification specification(greentea_setup, cases);
 
 int main() { return !Harness::run(specification); }
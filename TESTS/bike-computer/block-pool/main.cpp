@@ -0,0 +1,224 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file main.cpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Bike computer test suite: block pools
+ *
+ * @date 2024-06-17
+ * @version 1.0.0
+ ***************************************************************************/
+
+#include <chrono>
+
+#include "common/block_pool.hpp"
+#include "common/heap_profiler.hpp"
+#include "greentea-client/test_env.h"
+#include "mbed.h"
+#include "multi_tasking/bike_system.hpp"
+#include "unity/unity.h"
+#include "utest/utest.h"
+
+using namespace utest::v1;
+
+using bike_computer::BlockPool;
+using bike_computer::HeapProfiler;
+
+// counts the live instances
+struct Payload {
+    static int nbrOfInstances;
+
+    explicit Payload(uint32_t value) : value(value) { nbrOfInstances++; }
+    ~Payload() { nbrOfInstances--; }
+
+    uint32_t value;
+    double alignment;
+};
+int Payload::nbrOfInstances = 0;
+
+static constexpr uint32_t kCapacity = 8;
+static constexpr uint32_t kNbrOfBurstResets =
+    multi_tasking::BikeSystem::kEventQueueForISRsCapacity + 2;
+
+// test_block_pool_allocate_free handler function
+static void test_block_pool_allocate_free() {
+    BlockPool<Payload, kCapacity> blockPool;
+    TEST_ASSERT_EQUAL_UINT32(kCapacity, blockPool.getCapacity());
+
+    // constructed, aligned and distinct blocks
+    Payload* payloads[kCapacity] = {};
+    for (uint32_t index = 0; index < kCapacity; index++) {
+        payloads[index] = blockPool.allocate(index);
+        TEST_ASSERT_NOT_NULL(payloads[index]);
+        TEST_ASSERT_EQUAL(0, reinterpret_cast<uintptr_t>(payloads[index]) % alignof(Payload));
+        TEST_ASSERT_TRUE(blockPool.contains(payloads[index]));
+        for (uint32_t other = 0; other < index; other++) {
+            TEST_ASSERT_TRUE(payloads[index] != payloads[other]);
+        }
+    }
+    TEST_ASSERT_EQUAL(kCapacity, Payload::nbrOfInstances);
+    for (uint32_t index = 0; index < kCapacity; index++) {
+        TEST_ASSERT_EQUAL_UINT32(index, payloads[index]->value);
+    }
+
+    // exhausted
+    TEST_ASSERT_NULL(blockPool.allocate(0));
+    TEST_ASSERT_NULL(blockPool.allocate(0));
+    BlockPool<Payload, kCapacity>::Statistics statistics = blockPool.getStatistics();
+    TEST_ASSERT_EQUAL_UINT32(kCapacity, statistics.capacity);
+    TEST_ASSERT_EQUAL_UINT32(kCapacity, statistics.nbrOfAllocatedBlocks);
+    TEST_ASSERT_EQUAL_UINT32(kCapacity, statistics.highWaterMark);
+    TEST_ASSERT_EQUAL_UINT32(2, statistics.nbrOfExhaustions);
+
+    // a freed block is destroyed and allocated again
+    blockPool.free(payloads[3]);
+    TEST_ASSERT_EQUAL(kCapacity - 1, Payload::nbrOfInstances);
+    TEST_ASSERT_TRUE(blockPool.allocate(33) == payloads[3]);
+    TEST_ASSERT_EQUAL_UINT32(33, payloads[3]->value);
+
+    for (Payload* payload : payloads) {
+        blockPool.free(payload);
+    }
+    blockPool.free(nullptr);
+    TEST_ASSERT_EQUAL(0, Payload::nbrOfInstances);
+    statistics = blockPool.getStatistics();
+    TEST_ASSERT_EQUAL_UINT32(0, statistics.nbrOfAllocatedBlocks);
+    TEST_ASSERT_EQUAL_UINT32(kCapacity, statistics.highWaterMark);
+
+    blockPool.resetStatistics();
+    statistics = blockPool.getStatistics();
+    TEST_ASSERT_EQUAL_UINT32(0, statistics.highWaterMark);
+    TEST_ASSERT_EQUAL_UINT32(0, statistics.nbrOfExhaustions);
+
+    // not a block of the pool
+    Payload payload(0);
+    TEST_ASSERT_FALSE(blockPool.contains(&payload));
+    TEST_ASSERT_FALSE(blockPool.contains(reinterpret_cast<Payload*>(
+        reinterpret_cast<uintptr_t>(payloads[0]) + 1)));
+}
+
+// test_block_pool_history handler function
+static void test_block_pool_history() {
+    BlockPool<Payload, kCapacity> blockPool;
+    HeapProfiler& heapProfiler = HeapProfiler::getInstance();
+    heapProfiler.enable(true);
+    const HeapProfiler::Snapshot before = heapProfiler.takeSnapshot();
+
+    // random allocations and frees (fixed seed)
+    Payload* payloads[kCapacity] = {};
+    uint32_t nbrOfAllocatedBlocks = 0;
+    uint32_t state                = 0x12345678;
+    for (uint32_t operation = 0; operation < 1000; operation++) {
+        state               = state * 1664525 + 1013904223;
+        const uint32_t slot = (state >> 16) % kCapacity;
+        if (payloads[slot] == nullptr) {
+            payloads[slot] = blockPool.allocate(operation);
+            TEST_ASSERT_NOT_NULL(payloads[slot]);
+            nbrOfAllocatedBlocks++;
+        } else {
+            blockPool.free(payloads[slot]);
+            payloads[slot] = nullptr;
+            nbrOfAllocatedBlocks--;
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(nbrOfAllocatedBlocks,
+                             blockPool.getStatistics().nbrOfAllocatedBlocks);
+
+    // whatever the history, all free blocks can be allocated
+    for (Payload*& payload : payloads) {
+        if (payload == nullptr) {
+            payload = blockPool.allocate(0);
+            TEST_ASSERT_NOT_NULL(payload);
+        }
+    }
+    TEST_ASSERT_NULL(blockPool.allocate(0));
+    for (Payload* payload : payloads) {
+        blockPool.free(payload);
+    }
+
+    // the heap is never used
+    const HeapProfiler::HeapDiff heapDiff = heapProfiler.diffSince(before);
+    heapProfiler.enable(false);
+    TEST_ASSERT_EQUAL_UINT32(0, heapDiff.nbrOfAllocations);
+    TEST_ASSERT_EQUAL_UINT32(0, heapDiff.nbrOfFrees);
+}
+
+// test_reset_event_pool handler function
+static void test_reset_event_pool() {
+    // create the BikeSystem instance
+    multi_tasking::BikeSystem bikeSystem;
+
+    // run the bike system in a separate thread
+    Thread thread;
+    thread.start(
+        callback(&bikeSystem, &multi_tasking::BikeSystem::startWithRateMonotonicThreads));
+    ThisThread::sleep_for(500ms);
+
+    // single resets, dispatched one by one
+    constexpr uint32_t kNbrOfResets = 5;
+    for (uint32_t i = 0; i < kNbrOfResets; i++) {
+        bikeSystem.onReset();
+        ThisThread::sleep_for(200ms);
+    }
+    multi_tasking::BikeSystem::ResetEventPoolStatistics statistics =
+        bikeSystem.getResetEventPoolStatistics();
+    TEST_ASSERT_EQUAL_UINT32(0, statistics.nbrOfAllocatedBlocks);
+    TEST_ASSERT_EQUAL_UINT32(1, statistics.highWaterMark);
+    TEST_ASSERT_EQUAL_UINT32(kNbrOfResets, bikeSystem.getTelemetry().resetCount);
+
+    // a burst from a thread that preempts the reset thread (like nested
+    // ISRs) exhausts the pool, the resets that did not fit are dropped
+    Thread burstThread(osPriorityRealtime);
+    burstThread.start([&bikeSystem]() {
+        for (uint32_t i = 0; i < kNbrOfBurstResets; i++) {
+            bikeSystem.onReset();
+        }
+    });
+    burstThread.join();
+    ThisThread::sleep_for(200ms);
+    statistics = bikeSystem.getResetEventPoolStatistics();
+    printf("Reset event pool: capacity %" PRIu32 ", high-water mark %" PRIu32
+           ", exhaustions %" PRIu32 "\n",
+           statistics.capacity,
+           statistics.highWaterMark,
+           statistics.nbrOfExhaustions);
+    TEST_ASSERT_EQUAL_UINT32(0, statistics.nbrOfAllocatedBlocks);
+    TEST_ASSERT_EQUAL_UINT32(statistics.capacity, statistics.highWaterMark);
+    TEST_ASSERT_EQUAL_UINT32(kNbrOfBurstResets - statistics.capacity,
+                             statistics.nbrOfExhaustions);
+    TEST_ASSERT_EQUAL_UINT32(statistics.nbrOfExhaustions, bikeSystem.getNbrOfDroppedEvents());
+    TEST_ASSERT_EQUAL_UINT32(kNbrOfResets + statistics.capacity,
+                             bikeSystem.getTelemetry().resetCount);
+
+    bikeSystem.stop();
+}
+
+static utest::v1::status_t greentea_setup(const size_t number_of_cases) {
+    // Here, we specify the timeout (60s) and the host test (a built-in host test or the
+    // name of our Python file)
+    GREENTEA_SETUP(60, "default_auto");
+
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+// List of test cases in this file
+static Case cases[] = {Case("test block pool allocate free", test_block_pool_allocate_free),
+                       Case("test block pool history", test_block_pool_history),
+                       Case("test reset event pool", test_reset_event_pool)};
+
+static Specification specification(greentea_setup, cases);
+
+int main() { return !Harness::run(specification); }
@@ -0,0 +1,188 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file main.cpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Bike computer test suite: cyclic schedule generation
+ *
+ * @date 2024-03-11
+ * @version 1.0.0
+ ***************************************************************************/
+
+#include <chrono>
+
+#include "common/cyclic_schedule.hpp"
+#include "greentea-client/test_env.h"
+#include "mbed.h"
+#include "unity/unity.h"
+#include "utest/utest.h"
+
+using namespace utest::v1;
+
+using bike_computer::CyclicScheduleError;
+using bike_computer::CyclicTask;
+using bike_computer::makeCyclicSchedule;
+
+namespace {
+
+// records the order in which the tasks are called
+class TaskRecorder {
+   public:
+    void taskA() { record('A'); }
+    void taskB() { record('B'); }
+    void taskC() { record('C'); }
+
+    char _calls[32] = {};
+    size_t _nbrOfCalls = 0;
+
+   private:
+    void record(char task) {
+        if (_nbrOfCalls < sizeof(_calls) - 1) {
+            _calls[_nbrOfCalls++] = task;
+        }
+    }
+};
+
+// same timing as the static_scheduling super-loop
+constexpr CyclicTask<TaskRecorder> kBikeTasks[] = {
+    {800ms, 0ms, 100ms, &TaskRecorder::taskA},     // gear
+    {400ms, 100ms, 200ms, &TaskRecorder::taskB},   // speed and distance
+    {1600ms, 300ms, 200ms, &TaskRecorder::taskC},  // display 1
+    {800ms, 700ms, 100ms, &TaskRecorder::taskA},   // reset
+    {1600ms, 1100ms, 100ms, &TaskRecorder::taskC}, // temperature
+    {1600ms, 1200ms, 100ms, &TaskRecorder::taskC}, // display 2
+};
+constexpr auto kBikeSchedule = makeCyclicSchedule<16>(kBikeTasks);
+static_assert(kBikeSchedule.error == CyclicScheduleError::None, "Bike schedule must be feasible");
+static_assert(kBikeSchedule.majorCycle == 1600ms, "Unexpected major cycle");
+static_assert(kBikeSchedule.nbrOfFrames == 11, "Unexpected number of frames");
+
+}  // namespace
+
+// test_frames handler function
+static void test_frames() {
+    // frames are sorted by start time and refer to the table
+    constexpr uint8_t expectedTaskIndexes[] = {0, 1, 2, 1, 3, 0, 1, 4, 5, 1, 3};
+    constexpr int expectedStartTimes[] = {0, 100, 300, 500, 700, 800, 900, 1100, 1200, 1300, 1500};
+    TEST_ASSERT_EQUAL_UINT32(11, kBikeSchedule.nbrOfFrames);
+    for (size_t frameIndex = 0; frameIndex < kBikeSchedule.nbrOfFrames; frameIndex++) {
+        TEST_ASSERT_EQUAL_UINT8(expectedTaskIndexes[frameIndex],
+                                kBikeSchedule.frames[frameIndex].taskIndex);
+        TEST_ASSERT_EQUAL(expectedStartTimes[frameIndex],
+                          kBikeSchedule.frames[frameIndex].startTime.count());
+    }
+    // the bike tasks use the whole major cycle
+    TEST_ASSERT_EQUAL(1600, kBikeSchedule.busyTime.count());
+
+    // the frames call the task functions in order
+    TaskRecorder recorder;
+    for (size_t frameIndex = 0; frameIndex < kBikeSchedule.nbrOfFrames; frameIndex++) {
+        (recorder.*kBikeTasks[kBikeSchedule.frames[frameIndex].taskIndex].function)();
+    }
+    TEST_ASSERT_EQUAL_STRING("ABCBAABCCBA", recorder._calls);
+}
+
+// test_non_harmonic_periods handler function
+static void test_non_harmonic_periods() {
+    constexpr CyclicTask<TaskRecorder> kTasks[] = {
+        {40ms, 0ms, 10ms, &TaskRecorder::taskA},
+        {60ms, 50ms, 10ms, &TaskRecorder::taskB},
+    };
+    constexpr auto kSchedule = makeCyclicSchedule<8>(kTasks);
+    static_assert(kSchedule.error == CyclicScheduleError::None, "Schedule must be feasible");
+
+    // the major cycle is the least common multiple of the periods
+    TEST_ASSERT_EQUAL(120, kSchedule.majorCycle.count());
+    // A at 0, 40 and 80, B at 50 and 110
+    constexpr int expectedStartTimes[] = {0, 40, 50, 80, 110};
+    TEST_ASSERT_EQUAL_UINT32(5, kSchedule.nbrOfFrames);
+    for (size_t frameIndex = 0; frameIndex < kSchedule.nbrOfFrames; frameIndex++) {
+        TEST_ASSERT_EQUAL(expectedStartTimes[frameIndex],
+                          kSchedule.frames[frameIndex].startTime.count());
+    }
+    TEST_ASSERT_EQUAL(50, kSchedule.busyTime.count());
+
+    // with B at 35 and 95, its first frame overlaps the second frame of A
+    constexpr CyclicTask<TaskRecorder> kShiftedTasks[] = {
+        {40ms, 0ms, 10ms, &TaskRecorder::taskA},
+        {60ms, 35ms, 10ms, &TaskRecorder::taskB},
+    };
+    constexpr auto kShiftedSchedule = makeCyclicSchedule<8>(kShiftedTasks);
+    TEST_ASSERT_TRUE(kShiftedSchedule.error == CyclicScheduleError::Overlap);
+    TEST_ASSERT_EQUAL_UINT8(1, kShiftedSchedule.errorTaskIndex);
+}
+
+// test_infeasible_tables handler function
+static void test_infeasible_tables() {
+    // B is released while A is running
+    constexpr CyclicTask<TaskRecorder> kOverlappingTasks[] = {
+        {100ms, 0ms, 30ms, &TaskRecorder::taskA},
+        {100ms, 20ms, 30ms, &TaskRecorder::taskB},
+    };
+    constexpr auto kOverlap = makeCyclicSchedule<8>(kOverlappingTasks);
+    TEST_ASSERT_TRUE(kOverlap.error == CyclicScheduleError::Overlap);
+    TEST_ASSERT_EQUAL_UINT8(0, kOverlap.errorTaskIndex);
+
+    // the last frame runs into the first frame of the next major cycle
+    constexpr CyclicTask<TaskRecorder> kWrappingTasks[] = {
+        {100ms, 10ms, 30ms, &TaskRecorder::taskA},
+        {100ms, 90ms, 30ms, &TaskRecorder::taskB},
+    };
+    constexpr auto kWrap = makeCyclicSchedule<8>(kWrappingTasks);
+    TEST_ASSERT_TRUE(kWrap.error == CyclicScheduleError::Overlap);
+    TEST_ASSERT_EQUAL_UINT8(1, kWrap.errorTaskIndex);
+
+    // C cannot complete before its next release
+    constexpr CyclicTask<TaskRecorder> kLateTasks[] = {
+        {100ms, 0ms, 30ms, &TaskRecorder::taskA},
+        {50ms, 40ms, 60ms, &TaskRecorder::taskC},
+    };
+    constexpr auto kDeadlineMiss = makeCyclicSchedule<8>(kLateTasks);
+    TEST_ASSERT_TRUE(kDeadlineMiss.error == CyclicScheduleError::DeadlineMiss);
+    TEST_ASSERT_EQUAL_UINT8(1, kDeadlineMiss.errorTaskIndex);
+
+    // the offset must be within the period
+    constexpr CyclicTask<TaskRecorder> kInvalidTasks[] = {
+        {100ms, 100ms, 10ms, &TaskRecorder::taskA},
+    };
+    constexpr auto kInvalid = makeCyclicSchedule<8>(kInvalidTasks);
+    TEST_ASSERT_TRUE(kInvalid.error == CyclicScheduleError::InvalidTask);
+
+    // 16 frames do not fit in a schedule of 8
+    constexpr CyclicTask<TaskRecorder> kFastTasks[] = {
+        {10ms, 0ms, 1ms, &TaskRecorder::taskA},
+        {160ms, 5ms, 1ms, &TaskRecorder::taskB},
+    };
+    constexpr auto kTooManyFrames = makeCyclicSchedule<8>(kFastTasks);
+    TEST_ASSERT_TRUE(kTooManyFrames.error == CyclicScheduleError::TooManyFrames);
+}
+
+static utest::v1::status_t greentea_setup(const size_t number_of_cases) {
+    // Here, we specify the timeout (60s) and the host test (a built-in host test or the
+    // name of our Python file)
+    GREENTEA_SETUP(60, "default_auto");
+
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+// List of test cases in this file
+static Case cases[] = {Case("test frames", test_frames),
+                       Case("test non harmonic periods", test_non_harmonic_periods),
+                       Case("test infeasible tables", test_infeasible_tables)};
+
+static Specification specification(greentea_setup, cases);
+
+int main() { return !Harness::run(specification); }
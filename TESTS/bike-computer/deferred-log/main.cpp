@@ -0,0 +1,201 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file main.cpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Bike computer test suite: deferred binary logging
+ *
+ * @date 2024-05-20
+ * @version 1.0.0
+ ***************************************************************************/
+
+#include <cstring>
+
+#include "common/deferred_log.hpp"
+#include "greentea-client/test_env.h"
+#include "mbed.h"
+#include "unity/unity.h"
+#include "utest/utest.h"
+
+using namespace utest::v1;
+
+using bike_computer::DeferredLog;
+using bike_computer::frame::getU16;
+using bike_computer::frame::getU32;
+
+static constexpr size_t kMaxRecordSize = DeferredLog::kRecordHeaderSize + DeferredLog::kMaxPayloadSize;
+
+static uint64_t getU64(const uint8_t* buffer) {
+    return getU32(buffer) | (static_cast<uint64_t>(getU32(buffer + 4)) << 32);
+}
+
+// test_levels handler function
+static void test_levels() {
+    DeferredLog& deferredLog = DeferredLog::getInstance();
+    deferredLog.enable(true);
+    TEST_ASSERT_EQUAL_UINT8(MBED_CONF_APP_DEFERRED_LOG_MAX_LEVEL, deferredLog.getLevel());
+
+    // lines above the active level are not recorded
+    deferredLog.setLevel(DEFERRED_LOG_LEVEL_WARN);
+    DEFERRED_LOG_INFO(bike_computer::kLogStartingSuperLoop);
+    DEFERRED_LOG_DEBUG(bike_computer::kLogStartingSuperLoop);
+    TEST_ASSERT_EQUAL_UINT32(0, deferredLog.getNbrOfPendingRecords());
+    DEFERRED_LOG_WARN(bike_computer::kLogMajorCycleOverrun, 1U);
+    DEFERRED_LOG_ERROR(bike_computer::kLogSensorInitFailed);
+    TEST_ASSERT_EQUAL_UINT32(2, deferredLog.getNbrOfPendingRecords());
+
+    // the logger is also disabled at run time
+    deferredLog.enable(false);
+    DEFERRED_LOG_ERROR(bike_computer::kLogSensorInitFailed);
+    TEST_ASSERT_EQUAL_UINT32(2, deferredLog.getNbrOfPendingRecords());
+
+    deferredLog.setLevel(MBED_CONF_APP_DEFERRED_LOG_MAX_LEVEL);
+    deferredLog.enable(true);
+}
+
+// test_records_and_frames handler function
+static void test_records_and_frames() {
+    DeferredLog& deferredLog = DeferredLog::getInstance();
+    deferredLog.enable(true);
+
+    DEFERRED_LOG_INFO(bike_computer::kLogWorkloadCalibrated, 42U, static_cast<int64_t>(-5));
+    ThisThread::sleep_for(2ms);
+    DEFERRED_LOG_ERROR(bike_computer::kLogDisplayInitFailed, -3, 12.5f, "lcd");
+    DEFERRED_LOG_INFO(bike_computer::kLogUpdateClientStarted);
+    TEST_ASSERT_EQUAL_UINT32(3, deferredLog.getNbrOfPendingRecords());
+
+    uint8_t frame[DeferredLog::kFrameHeaderSize + 4 * kMaxRecordSize];
+    const size_t frameSize = deferredLog.drain(frame, sizeof(frame));
+    // records are only as large as their payload
+    const size_t firstPayloadSize  = (1 + 4) + (1 + 8);
+    const size_t secondPayloadSize = (1 + 4) + (1 + 4) + (1 + 1 + 3);
+    TEST_ASSERT_EQUAL_UINT32(DeferredLog::kFrameHeaderSize + 3 * DeferredLog::kRecordHeaderSize +
+                                 firstPayloadSize + secondPayloadSize,
+                             frameSize);
+    TEST_ASSERT_EQUAL_MEMORY(DeferredLog::kFrameMagic, frame, sizeof(DeferredLog::kFrameMagic));
+    TEST_ASSERT_EQUAL_UINT16(3, getU16(frame + 4));
+    TEST_ASSERT_EQUAL_UINT16(0, getU16(frame + 6));
+
+    // id, level, payload size, timestamp and typed arguments
+    const uint8_t* first = frame + DeferredLog::kFrameHeaderSize;
+    TEST_ASSERT_EQUAL_UINT16(bike_computer::kLogWorkloadCalibrated, getU16(first));
+    TEST_ASSERT_EQUAL_UINT8(DEFERRED_LOG_LEVEL_INFO, first[2]);
+    TEST_ASSERT_EQUAL_UINT8(firstPayloadSize, first[3]);
+    const uint8_t* payload = first + DeferredLog::kRecordHeaderSize;
+    TEST_ASSERT_EQUAL_UINT8(DeferredLog::kUint32, payload[0]);
+    TEST_ASSERT_EQUAL_UINT32(42, getU32(payload + 1));
+    TEST_ASSERT_EQUAL_UINT8(DeferredLog::kInt64, payload[5]);
+    TEST_ASSERT_TRUE(static_cast<int64_t>(getU64(payload + 6)) == -5);
+
+    const uint8_t* second = first + DeferredLog::kRecordHeaderSize + firstPayloadSize;
+    TEST_ASSERT_EQUAL_UINT16(bike_computer::kLogDisplayInitFailed, getU16(second));
+    TEST_ASSERT_EQUAL_UINT8(DEFERRED_LOG_LEVEL_ERROR, second[2]);
+    TEST_ASSERT_EQUAL_UINT8(secondPayloadSize, second[3]);
+    // timestamps in usecs since the logger was enabled
+    TEST_ASSERT_UINT32_WITHIN(1000, 2000, getU32(second + 4) - getU32(first + 4));
+    payload = second + DeferredLog::kRecordHeaderSize;
+    TEST_ASSERT_EQUAL_UINT8(DeferredLog::kInt32, payload[0]);
+    TEST_ASSERT_EQUAL_INT32(-3, static_cast<int32_t>(getU32(payload + 1)));
+    TEST_ASSERT_EQUAL_UINT8(DeferredLog::kFloat, payload[5]);
+    float value                   = 0.0f;
+    const uint32_t floatArgument = getU32(payload + 6);
+    std::memcpy(&value, &floatArgument, sizeof(value));
+    TEST_ASSERT_EQUAL_FLOAT(12.5f, value);
+    TEST_ASSERT_EQUAL_UINT8(DeferredLog::kString, payload[10]);
+    TEST_ASSERT_EQUAL_UINT8(3, payload[11]);
+    TEST_ASSERT_EQUAL_MEMORY("lcd", payload + 12, 3);
+
+    const uint8_t* third = second + DeferredLog::kRecordHeaderSize + secondPayloadSize;
+    TEST_ASSERT_EQUAL_UINT16(bike_computer::kLogUpdateClientStarted, getU16(third));
+    TEST_ASSERT_EQUAL_UINT8(0, third[3]);
+
+    // nothing left
+    TEST_ASSERT_EQUAL_UINT32(0, deferredLog.getNbrOfPendingRecords());
+    TEST_ASSERT_EQUAL_UINT32(0, deferredLog.drain(frame, sizeof(frame)));
+}
+
+// test_truncated_records handler function
+static void test_truncated_records() {
+    DeferredLog& deferredLog = DeferredLog::getInstance();
+    deferredLog.enable(true);
+
+    // strings are shortened to the room left in the payload
+    DEFERRED_LOG_INFO(bike_computer::kLogStartingSuperLoop,
+                      "a string that is longer than the payload of a record");
+    // arguments that do not fit are dropped
+    DEFERRED_LOG_INFO(bike_computer::kLogStartingSuperLoop, 1ULL, 2ULL, 3ULL);
+
+    uint8_t frame[DeferredLog::kFrameHeaderSize + 4 * kMaxRecordSize];
+    TEST_ASSERT_TRUE(deferredLog.drain(frame, sizeof(frame)) > 0);
+    TEST_ASSERT_EQUAL_UINT16(2, getU16(frame + 4));
+
+    const uint8_t* first = frame + DeferredLog::kFrameHeaderSize;
+    TEST_ASSERT_EQUAL_UINT8(DEFERRED_LOG_LEVEL_INFO | DeferredLog::kTruncatedFlag, first[2]);
+    TEST_ASSERT_EQUAL_UINT8(DeferredLog::kMaxPayloadSize, first[3]);
+    TEST_ASSERT_EQUAL_UINT8(DeferredLog::kMaxPayloadSize - 2,
+                            first[DeferredLog::kRecordHeaderSize + 1]);
+    TEST_ASSERT_EQUAL_MEMORY(
+        "a string", first + DeferredLog::kRecordHeaderSize + 2, std::strlen("a string"));
+
+    const uint8_t* second = first + DeferredLog::kRecordHeaderSize + first[3];
+    TEST_ASSERT_EQUAL_UINT8(DEFERRED_LOG_LEVEL_INFO | DeferredLog::kTruncatedFlag, second[2]);
+    TEST_ASSERT_EQUAL_UINT8(2 * (1 + 8), second[3]);
+}
+
+// test_dropped_records handler function
+static void test_dropped_records() {
+    DeferredLog& deferredLog = DeferredLog::getInstance();
+    deferredLog.enable(true);
+
+    constexpr uint32_t kNbrOfDrops = 3;
+    for (uint32_t index = 0; index < DeferredLog::kCapacity + kNbrOfDrops; index++) {
+        DEFERRED_LOG_WARN(bike_computer::kLogMajorCycleOverrun, index);
+    }
+    TEST_ASSERT_EQUAL_UINT32(DeferredLog::kCapacity, deferredLog.getNbrOfPendingRecords());
+    TEST_ASSERT_EQUAL_UINT32(kNbrOfDrops, deferredLog.getNbrOfDroppedRecords());
+
+    // the drops are reported in the first frame, the oldest records are kept
+    constexpr size_t kRecordSize = DeferredLog::kRecordHeaderSize + 1 + 4;
+    uint8_t frame[DeferredLog::kFrameHeaderSize + 8 * kMaxRecordSize];
+    const size_t frameSize = deferredLog.drain(frame, sizeof(frame));
+    const uint16_t nbrOfRecords = getU16(frame + 4);
+    TEST_ASSERT_EQUAL_UINT32(DeferredLog::kFrameHeaderSize + nbrOfRecords * kRecordSize, frameSize);
+    TEST_ASSERT_EQUAL_UINT16(kNbrOfDrops, getU16(frame + 6));
+    TEST_ASSERT_EQUAL_UINT32(
+        0, getU32(frame + DeferredLog::kFrameHeaderSize + DeferredLog::kRecordHeaderSize + 1));
+    deferredLog.drain(frame, sizeof(frame));
+    TEST_ASSERT_EQUAL_UINT16(0, getU16(frame + 6));
+    TEST_ASSERT_EQUAL_UINT32(DeferredLog::kCapacity - 2 * nbrOfRecords,
+                             deferredLog.getNbrOfPendingRecords());
+}
+
+static utest::v1::status_t greentea_setup(const size_t number_of_cases) {
+    // Here, we specify the timeout (60s) and the host test (a built-in host test or the
+    // name of our Python file)
+    GREENTEA_SETUP(60, "default_auto");
+
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+// List of test cases in this file
+static Case cases[] = {Case("test levels", test_levels),
+                       Case("test records and frames", test_records_and_frames),
+                       Case("test truncated records", test_truncated_records),
+                       Case("test dropped records", test_dropped_records)};
+
+static Specification specification(greentea_setup, cases);
+
+int main() { return !Harness::run(specification); }
@@ -0,0 +1,185 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file main.cpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Bike computer test suite: TLSF allocator and fragmentation benchmark
+ *
+ * The report of the fragmentation benchmark is printed on the console, this
+ * is how the benchmark is run on target.
+ *
+ * @date 2024-06-10
+ * @version 1.0.0
+ ***************************************************************************/
+
+#include "common/fragmentation_benchmark.hpp"
+#include "common/tlsf_allocator.hpp"
+#include "greentea-client/test_env.h"
+#include "mbed.h"
+#include "unity/unity.h"
+#include "utest/utest.h"
+
+using namespace utest::v1;
+
+using bike_computer::FirstFitAllocator;
+using bike_computer::FragmentationBenchmark;
+using bike_computer::TlsfAllocator;
+
+static constexpr size_t kBufferSize = 4096;
+alignas(8) static uint8_t buffer[kBufferSize];
+
+// statically allocated (the arena is part of the instance)
+static FragmentationBenchmark benchmark;
+
+// test_tlsf_allocate_free handler function
+static void test_tlsf_allocate_free() {
+    TlsfAllocator tlsfAllocator;
+    tlsfAllocator.init(buffer, kBufferSize);
+    const size_t freeSize = tlsfAllocator.getFreeSize();
+    TEST_ASSERT_TRUE(freeSize > kBufferSize - 4 * TlsfAllocator::kBlockHeaderSize);
+
+    // aligned blocks that do not overlap
+    uint8_t* blocks[3] = {};
+    for (uint8_t*& block : blocks) {
+        block = static_cast<uint8_t*>(tlsfAllocator.allocate(100));
+        TEST_ASSERT_NOT_NULL(block);
+        TEST_ASSERT_EQUAL(0, reinterpret_cast<uintptr_t>(block) % TlsfAllocator::kAlignment);
+        memset(block, 0xA5, 100);
+    }
+    TEST_ASSERT_TRUE(blocks[1] >= blocks[0] + 100);
+    TEST_ASSERT_TRUE(blocks[2] >= blocks[1] + 100);
+
+    // the freed blocks are merged with their free neighbours
+    tlsfAllocator.free(blocks[0]);
+    tlsfAllocator.free(blocks[2]);
+    tlsfAllocator.free(blocks[1]);
+    TEST_ASSERT_EQUAL(freeSize, tlsfAllocator.getFreeSize());
+    TEST_ASSERT_NOT_NULL(tlsfAllocator.allocate(tlsfAllocator.getLargestFreeBlock()));
+
+    // too large
+    tlsfAllocator.init(buffer, kBufferSize);
+    TEST_ASSERT_NULL(tlsfAllocator.allocate(kBufferSize));
+}
+
+// test_tlsf_fragmentation handler function
+static void test_tlsf_fragmentation() {
+    TlsfAllocator tlsfAllocator;
+    tlsfAllocator.init(buffer, kBufferSize);
+
+    // every other block is freed, no block larger than the freed ones fits
+    constexpr size_t kBlockSize = 256;
+    void* blocks[kBufferSize / (kBlockSize + TlsfAllocator::kBlockHeaderSize)] = {};
+    uint32_t nbrOfBlocks = 0;
+    while (nbrOfBlocks < sizeof(blocks) / sizeof(blocks[0]) &&
+           (blocks[nbrOfBlocks] = tlsfAllocator.allocate(kBlockSize)) != nullptr) {
+        nbrOfBlocks++;
+    }
+    for (uint32_t index = 0; index < nbrOfBlocks; index += 2) {
+        tlsfAllocator.free(blocks[index]);
+    }
+    TEST_ASSERT_TRUE(tlsfAllocator.getFreeSize() >= (nbrOfBlocks / 2) * kBlockSize);
+    TEST_ASSERT_TRUE(tlsfAllocator.getLargestFreeBlock() < 2 * kBlockSize);
+    TEST_ASSERT_NULL(tlsfAllocator.allocate(2 * kBlockSize));
+    TEST_ASSERT_NOT_NULL(tlsfAllocator.allocate(kBlockSize));
+}
+
+// test_first_fit_allocate_free handler function
+static void test_first_fit_allocate_free() {
+    FirstFitAllocator firstFitAllocator;
+    firstFitAllocator.reset(buffer, kBufferSize);
+    const size_t largestFreeBlock = firstFitAllocator.getLargestFreeBlock();
+    TEST_ASSERT_TRUE(largestFreeBlock < kBufferSize);
+
+    // aligned blocks that do not overlap
+    constexpr size_t kBlockSize = 1000;
+    uint8_t* blocks[4] = {};
+    for (uint8_t*& block : blocks) {
+        block = static_cast<uint8_t*>(firstFitAllocator.allocate(kBlockSize));
+        TEST_ASSERT_NOT_NULL(block);
+        TEST_ASSERT_EQUAL(0, reinterpret_cast<uintptr_t>(block) % 8);
+        memset(block, 0xA5, kBlockSize);
+    }
+    TEST_ASSERT_TRUE(blocks[1] >= blocks[0] + kBlockSize);
+    TEST_ASSERT_NULL(firstFitAllocator.allocate(kBlockSize));
+
+    // the even blocks are freed, half of the arena is free but a block of
+    // twice the size does not fit
+    firstFitAllocator.free(blocks[0], kBlockSize);
+    firstFitAllocator.free(blocks[2], kBlockSize);
+    TEST_ASSERT_TRUE(firstFitAllocator.getLargestFreeBlock() < 2 * kBlockSize);
+    TEST_ASSERT_NULL(firstFitAllocator.allocate(2 * kBlockSize));
+
+    // the freed blocks are merged with their free neighbours
+    firstFitAllocator.free(blocks[1], kBlockSize);
+    firstFitAllocator.free(blocks[3], kBlockSize);
+    TEST_ASSERT_EQUAL(largestFreeBlock, firstFitAllocator.getLargestFreeBlock());
+    TEST_ASSERT_NOT_NULL(firstFitAllocator.allocate(largestFreeBlock));
+}
+
+// test_fragmentation_benchmark handler function
+static void test_fragmentation_benchmark() {
+    benchmark.run();
+    benchmark.printReport();
+
+    // the MemoryFragmenter pattern fails on its last allocation
+    for (const FragmentationBenchmark::Allocator allocator :
+         {FragmentationBenchmark::kFirstFitAllocator, FragmentationBenchmark::kTlsfAllocator}) {
+        const FragmentationBenchmark::Result& fixedBlocks =
+            benchmark.getResult(FragmentationBenchmark::kFixedBlocks, allocator);
+        TEST_ASSERT_EQUAL_UINT32(1, fixedBlocks.nbrOfFailures);
+        TEST_ASSERT_EQUAL_INT32(12, fixedBlocks.failureIndex);
+    }
+
+    for (uint8_t allocator = 0; allocator < FragmentationBenchmark::kNbrOfAllocators;
+         allocator++) {
+        // the same traces are replayed against all allocators
+        for (uint8_t trace = 0; trace < FragmentationBenchmark::kNbrOfTraces; trace++) {
+            TEST_ASSERT_EQUAL_UINT32(
+                benchmark
+                    .getResult(static_cast<FragmentationBenchmark::Trace>(trace),
+                               FragmentationBenchmark::kFirstFitAllocator)
+                    .nbrOfAllocations,
+                benchmark
+                    .getResult(static_cast<FragmentationBenchmark::Trace>(trace),
+                               static_cast<FragmentationBenchmark::Allocator>(allocator))
+                    .nbrOfAllocations);
+        }
+    }
+    // the event payloads fit in the TLSF arena
+    TEST_ASSERT_EQUAL_UINT32(0,
+                             benchmark
+                                 .getResult(FragmentationBenchmark::kBurstyPayloads,
+                                            FragmentationBenchmark::kTlsfAllocator)
+                                 .nbrOfFailures);
+}
+
+static utest::v1::status_t greentea_setup(const size_t number_of_cases) {
+    // Here, we specify the timeout (60s) and the host test (a built-in host test or the
+    // name of our Python file)
+    GREENTEA_SETUP(60, "default_auto");
+
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+// List of test cases in this file
+static Case cases[] = {Case("test TLSF allocate free", test_tlsf_allocate_free),
+                       Case("test TLSF fragmentation", test_tlsf_fragmentation),
+                       Case("test first fit allocate free", test_first_fit_allocate_free),
+                       Case("test fragmentation benchmark", test_fragmentation_benchmark)};
+
+static Specification specification(greentea_setup, cases);
+
+int main() { return !Harness::run(specification); }
@@ -0,0 +1,244 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file main.cpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Bike computer test suite: heap profiler and heap growth
+ *
+ * @date 2024-06-03
+ * @version 1.0.0
+ ***************************************************************************/
+
+#include <chrono>
+
+#include "common/heap_profiler.hpp"
+#include "greentea-client/test_env.h"
+#include "mbed.h"
+#include "multi_tasking/bike_system.hpp"
+#include "unity/unity.h"
+#include "utest/utest.h"
+
+using namespace utest::v1;
+
+using bike_computer::HeapProfiler;
+
+// keeps the test blocks alive, the compiler may remove unused allocations
+static void* volatile lastBlock = nullptr;
+
+template <typename T>
+static T* use(T* block) {
+    lastBlock = block;
+    return block;
+}
+
+// test_block_tracking handler function
+static void test_block_tracking() {
+    HeapProfiler& heapProfiler = HeapProfiler::getInstance();
+    heapProfiler.enable(true);
+    const HeapProfiler::Snapshot before = heapProfiler.takeSnapshot();
+
+    int* array = use(new int[10]);
+    HeapProfiler::HeapDiff heapDiff = heapProfiler.diffSince(before);
+    TEST_ASSERT_EQUAL_INT32(10 * sizeof(int), heapDiff.sizeGrowth);
+    TEST_ASSERT_EQUAL_INT32(1, heapDiff.nbrOfBlocksGrowth);
+    TEST_ASSERT_EQUAL_UINT32(1, heapDiff.nbrOfAllocations);
+    TEST_ASSERT_EQUAL(1, heapDiff.nbrOfCallSites);
+    TEST_ASSERT_TRUE(heapDiff.callSites[0].caller != 0);
+    TEST_ASSERT_EQUAL_UINT32(1, heapDiff.callSites[0].nbrOfBlocks);
+    TEST_ASSERT_EQUAL_UINT32(10 * sizeof(int), heapDiff.callSites[0].size);
+
+    delete[] array;
+    heapDiff = heapProfiler.diffSince(before);
+    TEST_ASSERT_EQUAL_INT32(0, heapDiff.sizeGrowth);
+    TEST_ASSERT_EQUAL_INT32(0, heapDiff.nbrOfBlocksGrowth);
+    TEST_ASSERT_EQUAL_UINT32(1, heapDiff.nbrOfFrees);
+    TEST_ASSERT_EQUAL(0, heapDiff.nbrOfCallSites);
+
+    heapProfiler.enable(false);
+}
+
+// test_snapshot_diff handler function
+static void test_snapshot_diff() {
+    HeapProfiler& heapProfiler = HeapProfiler::getInstance();
+    heapProfiler.enable(true);
+
+    constexpr uint32_t kNbrOfBlocks = 3;
+    constexpr uint32_t kBlockSize   = 16;
+    uint8_t* blocks[kNbrOfBlocks]   = {};
+    const HeapProfiler::Snapshot first = heapProfiler.takeSnapshot();
+    for (uint8_t*& block : blocks) {
+        block = use(new uint8_t[kBlockSize]);
+    }
+    const HeapProfiler::Snapshot second = heapProfiler.takeSnapshot();
+    delete[] blocks[0];
+    const HeapProfiler::Snapshot third = heapProfiler.takeSnapshot();
+
+    HeapProfiler::HeapDiff heapDiff = HeapProfiler::diff(first, second);
+    TEST_ASSERT_EQUAL_INT32(kNbrOfBlocks * kBlockSize, heapDiff.sizeGrowth);
+    TEST_ASSERT_EQUAL_UINT32(kNbrOfBlocks, heapDiff.nbrOfAllocations);
+    TEST_ASSERT_EQUAL_UINT32(0, heapDiff.nbrOfFrees);
+
+    heapDiff = HeapProfiler::diff(second, third);
+    TEST_ASSERT_EQUAL_INT32(-static_cast<int32_t>(kBlockSize), heapDiff.sizeGrowth);
+    TEST_ASSERT_EQUAL_INT32(-1, heapDiff.nbrOfBlocksGrowth);
+    TEST_ASSERT_EQUAL_UINT32(1, heapDiff.nbrOfFrees);
+
+    // the blocks still allocated are grouped by call site
+    heapDiff = heapProfiler.diffSince(first);
+    HeapProfiler::printDiff(heapDiff);
+    TEST_ASSERT_EQUAL(1, heapDiff.nbrOfCallSites);
+    TEST_ASSERT_EQUAL_UINT32(kNbrOfBlocks - 1, heapDiff.callSites[0].nbrOfBlocks);
+    TEST_ASSERT_EQUAL_UINT32((kNbrOfBlocks - 1) * kBlockSize, heapDiff.callSites[0].size);
+
+    // the blocks allocated before the second snapshot are not listed
+    heapDiff = heapProfiler.diffSince(second);
+    TEST_ASSERT_EQUAL(0, heapDiff.nbrOfCallSites);
+
+    for (uint32_t index = 1; index < kNbrOfBlocks; index++) {
+        delete[] blocks[index];
+    }
+    TEST_ASSERT_EQUAL_INT32(0, heapProfiler.diffSince(first).sizeGrowth);
+    heapProfiler.enable(false);
+}
+
+// test_table_overflow handler function
+static void test_table_overflow() {
+    HeapProfiler& heapProfiler = HeapProfiler::getInstance();
+    heapProfiler.enable(true);
+
+    constexpr uint32_t kNbrOfUntrackedBlocks = 4;
+    static uint32_t* blocks[HeapProfiler::kCapacity + kNbrOfUntrackedBlocks] = {};
+    const HeapProfiler::Snapshot before = heapProfiler.takeSnapshot();
+    for (uint32_t*& block : blocks) {
+        block = use(new uint32_t);
+    }
+    const HeapProfiler::Snapshot full = heapProfiler.takeSnapshot();
+    TEST_ASSERT_EQUAL_UINT32(HeapProfiler::kCapacity, full.nbrOfBlocks);
+    TEST_ASSERT_EQUAL_UINT32(kNbrOfUntrackedBlocks, heapProfiler.getNbrOfUntrackedBlocks());
+    // every allocation is counted, the untracked ones also separately
+    TEST_ASSERT_EQUAL_UINT32(HeapProfiler::kCapacity + kNbrOfUntrackedBlocks,
+                             full.nbrOfAllocations - before.nbrOfAllocations);
+    TEST_ASSERT_EQUAL_UINT32(kNbrOfUntrackedBlocks,
+                             full.nbrOfUntrackedAllocations - before.nbrOfUntrackedAllocations);
+
+    // the untracked blocks are ignored when freed
+    for (uint32_t* block : blocks) {
+        delete block;
+    }
+    const HeapProfiler::HeapDiff heapDiff = heapProfiler.diffSince(before);
+    TEST_ASSERT_EQUAL_INT32(0, heapDiff.sizeGrowth);
+    TEST_ASSERT_EQUAL_UINT32(HeapProfiler::kCapacity, heapDiff.nbrOfFrees);
+    TEST_ASSERT_EQUAL_UINT32(HeapProfiler::kCapacity + kNbrOfUntrackedBlocks,
+                             heapDiff.nbrOfAllocations);
+    TEST_ASSERT_EQUAL_UINT32(kNbrOfUntrackedBlocks, heapDiff.nbrOfUntrackedAllocations);
+
+    // the table is usable again
+    uint32_t* block = use(new uint32_t);
+    TEST_ASSERT_EQUAL_INT32(sizeof(uint32_t), heapProfiler.diffSince(before).sizeGrowth);
+    delete block;
+    heapProfiler.enable(false);
+}
+
+// two call sites of new, that the compiler may not merge
+MBED_NOINLINE static uint32_t* allocateFirst() { return use(new uint32_t[4]); }
+MBED_NOINLINE static uint32_t* allocateSecond() { return use(new uint32_t[8]); }
+
+// test_call_sites handler function
+static void test_call_sites() {
+    HeapProfiler& heapProfiler = HeapProfiler::getInstance();
+    heapProfiler.enable(true);
+    const HeapProfiler::Snapshot before = heapProfiler.takeSnapshot();
+
+    // each new is attributed to its own call site (not to operator new)
+    uint32_t* first  = allocateFirst();
+    uint32_t* second = allocateSecond();
+    HeapProfiler::HeapDiff heapDiff = heapProfiler.diffSince(before);
+    HeapProfiler::printDiff(heapDiff);
+    TEST_ASSERT_EQUAL(2, heapDiff.nbrOfCallSites);
+    TEST_ASSERT_TRUE(heapDiff.callSites[0].caller != heapDiff.callSites[1].caller);
+    // largest size first
+    TEST_ASSERT_EQUAL_UINT32(8 * sizeof(uint32_t), heapDiff.callSites[0].size);
+    TEST_ASSERT_EQUAL_UINT32(4 * sizeof(uint32_t), heapDiff.callSites[1].size);
+
+    // the caller given by operator new replaces the one of malloc()
+    const uintptr_t caller = heapDiff.callSites[1].caller + 1;
+    heapProfiler.setCaller(first, reinterpret_cast<void*>(caller));
+    heapDiff = heapProfiler.diffSince(before);
+    TEST_ASSERT_EQUAL(2, heapDiff.nbrOfCallSites);
+    TEST_ASSERT_EQUAL_UINT32(caller, heapDiff.callSites[1].caller);
+    TEST_ASSERT_EQUAL_UINT32(2, heapDiff.nbrOfAllocations);
+
+    delete[] first;
+    delete[] second;
+    TEST_ASSERT_EQUAL(0, heapProfiler.diffSince(before).nbrOfCallSites);
+    heapProfiler.enable(false);
+}
+
+// test_no_heap_growth_multi_tasking_bike_system handler function
+static void test_no_heap_growth_multi_tasking_bike_system() {
+    HeapProfiler& heapProfiler = HeapProfiler::getInstance();
+    heapProfiler.enable(true);
+
+    multi_tasking::BikeSystem bikeSystem;
+    Thread thread;
+    thread.start(callback(&bikeSystem, &multi_tasking::BikeSystem::start));
+
+    // the initialization may allocate, the run may not
+    ThisThread::sleep_for(500ms);
+    const HeapProfiler::Snapshot before = heapProfiler.takeSnapshot();
+
+    constexpr uint32_t kNbrOfInputs = 20;
+    for (uint32_t index = 0; index < kNbrOfInputs; index++) {
+        if (index % 4 == 3) {
+            bikeSystem.onReset();
+        } else if (index % 2 == 0) {
+            bikeSystem.getGearDevice().onUp();
+        } else {
+            bikeSystem.getGearDevice().onDown();
+        }
+        ThisThread::sleep_for(250ms);
+    }
+
+    const HeapProfiler::HeapDiff heapDiff = heapProfiler.diffSince(before);
+    HeapProfiler::printDiff(heapDiff);
+    bikeSystem.stop();
+    heapProfiler.enable(false);
+
+    TEST_ASSERT_EQUAL_UINT32(0, heapProfiler.getNbrOfUntrackedBlocks());
+    TEST_ASSERT_EQUAL_INT32(0, heapDiff.sizeGrowth);
+    TEST_ASSERT_EQUAL_INT32(0, heapDiff.nbrOfBlocksGrowth);
+}
+
+static utest::v1::status_t greentea_setup(const size_t number_of_cases) {
+    // Here, we specify the timeout (60s) and the host test (a built-in host test or the
+    // name of our Python file)
+    GREENTEA_SETUP(60, "default_auto");
+
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+// List of test cases in this file
+static Case cases[] = {
+    Case("test block tracking", test_block_tracking),
+    Case("test snapshot diff", test_snapshot_diff),
+    Case("test table overflow", test_table_overflow),
+    Case("test call sites", test_call_sites),
+    Case("test no heap growth multi-tasking bike system",
+         test_no_heap_growth_multi_tasking_bike_system)};
+
+static Specification specification(greentea_setup, cases);
+
+int main() { return !Harness::run(specification); }
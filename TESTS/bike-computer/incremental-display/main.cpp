@@ -0,0 +1,117 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file main.cpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Bike computer test suite: incremental display
+ *
+ * @date 2024-02-26
+ * @version 1.0.0
+ ***************************************************************************/
+
+#include "common/incremental_display.hpp"
+#include "display_device.hpp"
+#include "greentea-client/test_env.h"
+#include "mbed.h"
+#include "unity/unity.h"
+#include "utest/utest.h"
+
+using namespace utest::v1;
+
+using bike_computer::IncrementalDisplay;
+
+static advembsof::DisplayDevice displayDevice;
+
+// test_redraw_on_change handler function
+static void test_redraw_on_change() {
+    IncrementalDisplay display(displayDevice);
+
+    // everything is drawn the first time
+    display.displayGear(3);
+    display.displaySpeed(25.0f);
+    display.displayDistance(1.5f);
+    display.displayTemperature(21.5f);
+    for (uint8_t field = 0; field < IncrementalDisplay::kNbrOfFields; field++) {
+        TEST_ASSERT_EQUAL_UINT32(
+            1, display.getNbrOfRedraws(static_cast<IncrementalDisplay::Field>(field)));
+        TEST_ASSERT_EQUAL_UINT32(
+            0, display.getNbrOfSkips(static_cast<IncrementalDisplay::Field>(field)));
+    }
+
+    // same values are skipped
+    display.displayGear(3);
+    display.displaySpeed(25.0f);
+    TEST_ASSERT_EQUAL_UINT32(1, display.getNbrOfRedraws(IncrementalDisplay::kGearField));
+    TEST_ASSERT_EQUAL_UINT32(1, display.getNbrOfSkips(IncrementalDisplay::kGearField));
+    TEST_ASSERT_EQUAL_UINT32(1, display.getNbrOfRedraws(IncrementalDisplay::kSpeedField));
+    TEST_ASSERT_EQUAL_UINT32(1, display.getNbrOfSkips(IncrementalDisplay::kSpeedField));
+
+    // different values with the same text (2 decimals) are skipped
+    display.displayTemperature(21.501f);
+    display.displayTemperature(21.498f);
+    TEST_ASSERT_EQUAL_UINT32(1,
+                             display.getNbrOfRedraws(IncrementalDisplay::kTemperatureField));
+    TEST_ASSERT_EQUAL_UINT32(2, display.getNbrOfSkips(IncrementalDisplay::kTemperatureField));
+
+    // changed texts are redrawn
+    display.displayGear(4);
+    display.displayDistance(1.51f);
+    TEST_ASSERT_EQUAL_UINT32(2, display.getNbrOfRedraws(IncrementalDisplay::kGearField));
+    TEST_ASSERT_EQUAL_UINT32(2, display.getNbrOfRedraws(IncrementalDisplay::kDistanceField));
+
+    // going back to a former value is a change
+    display.displayGear(3);
+    TEST_ASSERT_EQUAL_UINT32(3, display.getNbrOfRedraws(IncrementalDisplay::kGearField));
+}
+
+// test_invalidate handler function
+static void test_invalidate() {
+    IncrementalDisplay display(displayDevice);
+
+    display.displaySpeed(30.0f);
+    display.displaySpeed(30.0f);
+    TEST_ASSERT_EQUAL_UINT32(1, display.getNbrOfRedraws(IncrementalDisplay::kSpeedField));
+
+    // everything is redrawn after invalidate
+    display.invalidate();
+    display.displaySpeed(30.0f);
+    TEST_ASSERT_EQUAL_UINT32(2, display.getNbrOfRedraws(IncrementalDisplay::kSpeedField));
+    TEST_ASSERT_EQUAL_UINT32(1, display.getNbrOfSkips(IncrementalDisplay::kSpeedField));
+
+    display.resetCounters();
+    TEST_ASSERT_EQUAL_UINT32(0, display.getNbrOfRedraws(IncrementalDisplay::kSpeedField));
+    TEST_ASSERT_EQUAL_UINT32(0, display.getNbrOfSkips(IncrementalDisplay::kSpeedField));
+    display.displaySpeed(30.0f);
+    TEST_ASSERT_EQUAL_UINT32(1, display.getNbrOfSkips(IncrementalDisplay::kSpeedField));
+}
+
+static utest::v1::status_t greentea_setup(const size_t number_of_cases) {
+    // Here, we specify the timeout (60s) and the host test (a built-in host test or the
+    // name of our Python file)
+    GREENTEA_SETUP(60, "default_auto");
+
+    displayDevice.init();
+
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+// List of test cases in this file
+static Case cases[] = {Case("test redraw on change", test_redraw_on_change),
+                       Case("test invalidate", test_invalidate)};
+
+static Specification specification(greentea_setup, cases);
+
+int main() { return !Harness::run(specification); }
@@ -0,0 +1,119 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file main.cpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Bike computer test suite: latency histogram
+ *
+ * @date 2024-02-19
+ * @version 1.0.0
+ ***************************************************************************/
+
+#include <chrono>
+
+#include "common/latency_histogram.hpp"
+#include "greentea-client/test_env.h"
+#include "mbed.h"
+#include "unity/unity.h"
+#include "utest/utest.h"
+
+using namespace utest::v1;
+
+using bike_computer::LatencyHistogram;
+
+// test_buckets handler function
+static void test_buckets() {
+    // small values are exact
+    for (uint32_t value = 0; value < 2 * LatencyHistogram::kNbrOfSubBuckets; value++) {
+        TEST_ASSERT_EQUAL_UINT32(value, LatencyHistogram::getBucketIndex(value));
+        TEST_ASSERT_EQUAL_UINT32(value, LatencyHistogram::getBucketUpperBound(value));
+    }
+
+    // buckets are contiguous and each value is at most 12.5% below the upper
+    // bound of its bucket
+    uint32_t lastBucketIndex = 2 * LatencyHistogram::kNbrOfSubBuckets - 1;
+    for (uint32_t value = 2 * LatencyHistogram::kNbrOfSubBuckets;
+         value <= LatencyHistogram::kMaxValue;
+         value += 1 + value / 64) {
+        const uint32_t bucketIndex = LatencyHistogram::getBucketIndex(value);
+        TEST_ASSERT_TRUE(bucketIndex >= lastBucketIndex);
+        TEST_ASSERT_TRUE(bucketIndex <= lastBucketIndex + 1);
+        TEST_ASSERT_TRUE(bucketIndex < LatencyHistogram::kNbrOfBuckets);
+        const uint32_t upperBound = LatencyHistogram::getBucketUpperBound(bucketIndex);
+        TEST_ASSERT_TRUE(value <= upperBound);
+        TEST_ASSERT_TRUE(upperBound - value <= value / 8);
+        lastBucketIndex = bucketIndex;
+    }
+    TEST_ASSERT_EQUAL_UINT32(LatencyHistogram::kNbrOfBuckets - 1,
+                             LatencyHistogram::getBucketIndex(LatencyHistogram::kMaxValue));
+    TEST_ASSERT_EQUAL_UINT32(
+        LatencyHistogram::kMaxValue,
+        LatencyHistogram::getBucketUpperBound(LatencyHistogram::kNbrOfBuckets - 1));
+}
+
+// test_percentiles handler function
+static void test_percentiles() {
+    static LatencyHistogram histogram;
+    histogram.reset();
+
+    TEST_ASSERT_EQUAL_UINT32(0, histogram.getCount());
+    TEST_ASSERT_EQUAL(0, histogram.getPercentile(99.0f).count());
+
+    // 1000 samples of 1 ms with 10 samples of 5 ms and one of 20 ms
+    for (uint32_t index = 0; index < 989; index++) {
+        histogram.record(1000us);
+    }
+    for (uint32_t index = 0; index < 10; index++) {
+        histogram.record(5000us);
+    }
+    histogram.record(20000us);
+
+    TEST_ASSERT_EQUAL_UINT32(1000, histogram.getCount());
+    TEST_ASSERT_EQUAL(1000, histogram.getMin().count());
+    TEST_ASSERT_EQUAL(20000, histogram.getMax().count());
+    // values are reported as the upper bound of their bucket
+    TEST_ASSERT_UINT32_WITHIN(1000 / 8, 1000, histogram.getPercentile(50.0f).count());
+    TEST_ASSERT_UINT32_WITHIN(1000 / 8, 1000, histogram.getPercentile(98.0f).count());
+    TEST_ASSERT_UINT32_WITHIN(5000 / 8, 5000, histogram.getPercentile(99.0f).count());
+    TEST_ASSERT_UINT32_WITHIN(5000 / 8, 5000, histogram.getPercentile(99.9f).count());
+    TEST_ASSERT_EQUAL(20000, histogram.getPercentile(100.0f).count());
+
+    // out of range values are clamped
+    histogram.record(-1us);
+    histogram.record(std::chrono::microseconds(LatencyHistogram::kMaxValue + 1ULL));
+    TEST_ASSERT_EQUAL(0, histogram.getMin().count());
+    TEST_ASSERT_EQUAL(LatencyHistogram::kMaxValue, histogram.getMax().count());
+
+    histogram.reset();
+    TEST_ASSERT_EQUAL_UINT32(0, histogram.getCount());
+    TEST_ASSERT_EQUAL(0, histogram.getMax().count());
+}
+
+static utest::v1::status_t greentea_setup(const size_t number_of_cases) {
+    // Here, we specify the timeout (60s) and the host test (a built-in host test or the
+    // name of our Python file)
+    GREENTEA_SETUP(60, "default_auto");
+
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+// List of test cases in this file
+static Case cases[] = {Case("test buckets", test_buckets),
+                       Case("test percentiles", test_percentiles)};
+
+static Specification specification(greentea_setup, cases);
+
+int main() { return !Harness::run(specification); }
@@ -0,0 +1,181 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file main.cpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Bike computer test suite: input to display latency tracer
+ *
+ * @date 2024-04-29
+ * @version 1.0.0
+ ***************************************************************************/
+
+#include <chrono>
+
+#include "common/latency_tracer.hpp"
+#include "greentea-client/test_env.h"
+#include "mbed.h"
+#include "multi_tasking/bike_system.hpp"
+#include "unity/unity.h"
+#include "utest/utest.h"
+
+using namespace utest::v1;
+
+using bike_computer::LatencyTracer;
+
+// allow for 1 msec of timer and scheduling inaccuracy per stage
+static constexpr uint32_t kStageDeltaUs = 1000;
+static constexpr const char* kStageNames[LatencyTracer::kNbrOfStages] = {
+    "interrupt", "dispatch", "update", "display"};
+
+// the stage latencies of a single trace add up to its end-to-end latency
+static void checkSingleTrace(const LatencyTracer::ChainStatistics& statistics) {
+    TEST_ASSERT_EQUAL_UINT32(1, statistics.nbrOfCompletedTraces);
+    TEST_ASSERT_EQUAL_UINT32(1, statistics.endToEndLatency.getCount());
+    std::chrono::microseconds sum = std::chrono::microseconds::zero();
+    for (uint8_t stage = LatencyTracer::kInterruptStage + 1; stage < LatencyTracer::kNbrOfStages;
+         stage++) {
+        TEST_ASSERT_EQUAL_UINT32(1, statistics.stageLatency[stage].getCount());
+        sum += statistics.stageLatency[stage].getMax();
+    }
+    TEST_ASSERT_EQUAL(statistics.endToEndLatency.getMax().count(), sum.count());
+}
+
+static void printBreakdown(const char* chainName, const LatencyTracer::ChainStatistics& statistics) {
+    printf("%s: end-to-end latency %" PRId64 " usecs\n",
+           chainName,
+           static_cast<int64_t>(statistics.endToEndLatency.getMax().count()));
+    for (uint8_t stage = LatencyTracer::kInterruptStage + 1; stage < LatencyTracer::kNbrOfStages;
+         stage++) {
+        printf("  %-8s %8" PRId64 " usecs\n",
+               kStageNames[stage],
+               static_cast<int64_t>(statistics.stageLatency[stage].getMax().count()));
+    }
+}
+
+// test_stage_latencies handler function
+static void test_stage_latencies() {
+    LatencyTracer& latencyTracer = LatencyTracer::getInstance();
+    latencyTracer.enable(true);
+
+    const uint32_t traceId = latencyTracer.begin(LatencyTracer::kGearChain);
+    TEST_ASSERT_TRUE(traceId != LatencyTracer::kNoTrace);
+    ThisThread::sleep_for(1ms);
+    latencyTracer.mark(LatencyTracer::kGearChain, traceId, LatencyTracer::kDispatchStage);
+    ThisThread::sleep_for(2ms);
+    latencyTracer.mark(LatencyTracer::kGearChain, traceId, LatencyTracer::kUpdateStage);
+    ThisThread::sleep_for(3ms);
+    TEST_ASSERT_TRUE(latencyTracer.complete(LatencyTracer::kGearChain, traceId));
+    // a trace is completed once, e.g. by the first display task that shows it
+    TEST_ASSERT_FALSE(latencyTracer.complete(LatencyTracer::kGearChain, traceId));
+
+    const LatencyTracer::ChainStatistics& statistics =
+        latencyTracer.getChainStatistics(LatencyTracer::kGearChain);
+    checkSingleTrace(statistics);
+    TEST_ASSERT_UINT32_WITHIN(
+        kStageDeltaUs, 1000, statistics.stageLatency[LatencyTracer::kDispatchStage].getMax().count());
+    TEST_ASSERT_UINT32_WITHIN(
+        kStageDeltaUs, 2000, statistics.stageLatency[LatencyTracer::kUpdateStage].getMax().count());
+    TEST_ASSERT_UINT32_WITHIN(
+        kStageDeltaUs, 3000, statistics.stageLatency[LatencyTracer::kDisplayStage].getMax().count());
+    TEST_ASSERT_EQUAL_UINT32(
+        0, latencyTracer.getChainStatistics(LatencyTracer::kResetChain).nbrOfCompletedTraces);
+
+    // traces that skip a stage are not recorded
+    const uint32_t incompleteTraceId = latencyTracer.begin(LatencyTracer::kGearChain);
+    TEST_ASSERT_TRUE(latencyTracer.complete(LatencyTracer::kGearChain, incompleteTraceId));
+    TEST_ASSERT_EQUAL_UINT32(1, statistics.nbrOfIncompleteTraces);
+    TEST_ASSERT_EQUAL_UINT32(1, statistics.nbrOfCompletedTraces);
+}
+
+// test_superseded_traces handler function
+static void test_superseded_traces() {
+    LatencyTracer& latencyTracer = LatencyTracer::getInstance();
+    latencyTracer.enable(true);
+
+    // the oldest pending trace is overwritten by the newest one
+    const uint32_t firstTraceId = latencyTracer.begin(LatencyTracer::kResetChain);
+    uint32_t lastTraceId        = firstTraceId;
+    for (uint32_t index = 0; index < LatencyTracer::kMaxNbrOfPendingTraces; index++) {
+        lastTraceId = latencyTracer.begin(LatencyTracer::kResetChain);
+    }
+    const LatencyTracer::ChainStatistics& statistics =
+        latencyTracer.getChainStatistics(LatencyTracer::kResetChain);
+    TEST_ASSERT_EQUAL_UINT32(1, statistics.nbrOfSupersededTraces);
+    latencyTracer.mark(LatencyTracer::kResetChain, firstTraceId, LatencyTracer::kDispatchStage);
+    TEST_ASSERT_FALSE(latencyTracer.complete(LatencyTracer::kResetChain, firstTraceId));
+    TEST_ASSERT_TRUE(latencyTracer.complete(LatencyTracer::kResetChain, lastTraceId));
+
+    // a disabled tracer gives no trace id, which is ignored
+    latencyTracer.enable(false);
+    TEST_ASSERT_EQUAL_UINT32(LatencyTracer::kNoTrace, latencyTracer.begin(LatencyTracer::kGearChain));
+    TEST_ASSERT_FALSE(latencyTracer.complete(LatencyTracer::kGearChain, LatencyTracer::kNoTrace));
+}
+
+// test_multi_tasking_latency_breakdown handler function
+static void test_multi_tasking_latency_breakdown() {
+    multi_tasking::BikeSystem bikeSystem;
+
+    Thread thread;
+    thread.start(callback(&bikeSystem, &multi_tasking::BikeSystem::start));
+
+    // let the bike system start and display a first time
+    ThisThread::sleep_for(500ms);
+
+    bikeSystem.getGearDevice().onUp();
+    bikeSystem.onReset();
+
+    // the next display task shows both inputs
+    constexpr std::chrono::milliseconds kDisplayTaskPeriod = 1600ms;
+    ThisThread::sleep_for(kDisplayTaskPeriod);
+
+    const bike_computer::LatencyTracer& latencyTracer = bikeSystem.getLatencyTracer();
+    const LatencyTracer::ChainStatistics& gearStatistics =
+        latencyTracer.getChainStatistics(LatencyTracer::kGearChain);
+    const LatencyTracer::ChainStatistics& resetStatistics =
+        latencyTracer.getChainStatistics(LatencyTracer::kResetChain);
+    printBreakdown("Gear", gearStatistics);
+    printBreakdown("Reset", resetStatistics);
+
+    checkSingleTrace(gearStatistics);
+    checkSingleTrace(resetStatistics);
+    // the inputs wait for the display task, the other stages are immediate
+    TEST_ASSERT_TRUE(gearStatistics.endToEndLatency.getMax() <= kDisplayTaskPeriod);
+    TEST_ASSERT_TRUE(resetStatistics.endToEndLatency.getMax() <= kDisplayTaskPeriod);
+    TEST_ASSERT_UINT32_WITHIN(
+        kStageDeltaUs,
+        gearStatistics.endToEndLatency.getMax().count(),
+        gearStatistics.stageLatency[LatencyTracer::kDisplayStage].getMax().count());
+
+    bikeSystem.stop();
+}
+
+static utest::v1::status_t greentea_setup(const size_t number_of_cases) {
+    // Here, we specify the timeout (60s) and the host test (a built-in host test or the
+    // name of our Python file)
+    GREENTEA_SETUP(60, "default_auto");
+
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+// List of test cases in this file
+static Case cases[] = {
+    Case("test stage latencies", test_stage_latencies),
+    Case("test superseded traces", test_superseded_traces),
+    Case("test multi tasking latency breakdown", test_multi_tasking_latency_breakdown)};
+
+static Specification specification(greentea_setup, cases);
+
+int main() { return !Harness::run(specification); }
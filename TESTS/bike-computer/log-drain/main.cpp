@@ -0,0 +1,211 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file main.cpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Bike computer test suite: asynchronous log drain and drop policies
+ *
+ * @date 2024-05-27
+ * @version 1.0.0
+ ***************************************************************************/
+
+#include <chrono>
+#include <cstring>
+
+#include "common/deferred_log.hpp"
+#include "common/log_drain.hpp"
+#include "greentea-client/test_env.h"
+#include "mbed.h"
+#include "unity/unity.h"
+#include "utest/utest.h"
+
+using namespace utest::v1;
+
+using bike_computer::DeferredLog;
+using bike_computer::LogDrain;
+using bike_computer::frame::getU16;
+using bike_computer::frame::getU32;
+
+static constexpr size_t kMaxRecordSize =
+    DeferredLog::kRecordHeaderSize + DeferredLog::kMaxPayloadSize;
+// record of a line with a single 32 bit argument
+static constexpr size_t kRecordSize = DeferredLog::kRecordHeaderSize + 1 + 4;
+
+// time of sending a frame over the serial port
+static constexpr std::chrono::milliseconds kWriteTime = 10ms;
+
+// keeps the deferred log frames written by the drain
+class CaptureFileHandle : public mbed::FileHandle {
+   public:
+    ssize_t write(const void* buffer, size_t size) override {
+        const uint8_t* bytes = static_cast<const uint8_t*>(buffer);
+        if (size >= 4 && std::memcmp(bytes, DeferredLog::kFrameMagic, 4) == 0 &&
+            _size + size <= sizeof(_bytes)) {
+            std::memcpy(_bytes + _size, bytes, size);
+            _size += size;
+        }
+        // the caller is blocked until the frame is sent
+        ThisThread::sleep_for(kWriteTime);
+        return size;
+    }
+    ssize_t read(void* buffer, size_t size) { return -1; }
+    off_t seek(off_t offset, int whence = SEEK_SET) { return -1; }
+    int close() { return 0; }
+
+    // number of deferred log records of the captured frames
+    uint32_t getNbrOfRecords() const {
+        uint32_t nbrOfRecords = 0;
+        size_t offset         = 0;
+        while (offset + DeferredLog::kFrameHeaderSize <= _size) {
+            const uint16_t nbrOfFrameRecords = getU16(_bytes + offset + 4);
+            nbrOfRecords += nbrOfFrameRecords;
+            offset += DeferredLog::kFrameHeaderSize + nbrOfFrameRecords * kRecordSize;
+        }
+        return nbrOfRecords;
+    }
+
+   private:
+    uint8_t _bytes[1024] = {};
+    size_t _size         = 0;
+};
+
+// test_drop_newest handler function
+static void test_drop_newest() {
+    DeferredLog& deferredLog = DeferredLog::getInstance();
+    deferredLog.enable(true);
+    deferredLog.setDropPolicy(DeferredLog::kDropNewest);
+
+    constexpr uint32_t kNbrOfDrops = 3;
+    for (uint32_t index = 0; index < DeferredLog::kCapacity + kNbrOfDrops; index++) {
+        DEFERRED_LOG_WARN(bike_computer::kLogMajorCycleOverrun, index);
+    }
+    TEST_ASSERT_EQUAL_UINT32(DeferredLog::kCapacity, deferredLog.getNbrOfPendingRecords());
+    TEST_ASSERT_EQUAL_UINT32(kNbrOfDrops, deferredLog.getNbrOfDroppedRecords());
+
+    // the oldest records are kept
+    uint8_t frame[DeferredLog::kFrameHeaderSize + 8 * kMaxRecordSize];
+    TEST_ASSERT_TRUE(deferredLog.drain(frame, sizeof(frame)) > 0);
+    TEST_ASSERT_EQUAL_UINT16(kNbrOfDrops, getU16(frame + 6));
+    TEST_ASSERT_EQUAL_UINT32(
+        0, getU32(frame + DeferredLog::kFrameHeaderSize + DeferredLog::kRecordHeaderSize + 1));
+}
+
+// test_drop_oldest handler function
+static void test_drop_oldest() {
+    DeferredLog& deferredLog = DeferredLog::getInstance();
+    deferredLog.enable(true);
+    deferredLog.setDropPolicy(DeferredLog::kDropOldest);
+
+    constexpr uint32_t kNbrOfDrops = 3;
+    for (uint32_t index = 0; index < DeferredLog::kCapacity + kNbrOfDrops; index++) {
+        DEFERRED_LOG_WARN(bike_computer::kLogMajorCycleOverrun, index);
+    }
+    TEST_ASSERT_EQUAL_UINT32(DeferredLog::kCapacity, deferredLog.getNbrOfPendingRecords());
+    TEST_ASSERT_EQUAL_UINT32(kNbrOfDrops, deferredLog.getNbrOfDroppedRecords());
+
+    // the newest records are kept, in order
+    uint8_t frame[DeferredLog::kFrameHeaderSize + 8 * kMaxRecordSize];
+    uint32_t expectedIndex = kNbrOfDrops;
+    bool isFirstFrame      = true;
+    size_t frameSize       = 0;
+    while ((frameSize = deferredLog.drain(frame, sizeof(frame))) > 0) {
+        TEST_ASSERT_EQUAL_UINT16(isFirstFrame ? kNbrOfDrops : 0, getU16(frame + 6));
+        const uint16_t nbrOfRecords = getU16(frame + 4);
+        for (uint16_t recordIndex = 0; recordIndex < nbrOfRecords; recordIndex++) {
+            const uint8_t* record =
+                frame + DeferredLog::kFrameHeaderSize + recordIndex * kRecordSize;
+            TEST_ASSERT_EQUAL_UINT32(expectedIndex,
+                                     getU32(record + DeferredLog::kRecordHeaderSize + 1));
+            expectedIndex++;
+        }
+        isFirstFrame = false;
+    }
+    TEST_ASSERT_EQUAL_UINT32(DeferredLog::kCapacity + kNbrOfDrops, expectedIndex);
+
+    deferredLog.setDropPolicy(
+        static_cast<DeferredLog::DropPolicy>(MBED_CONF_APP_DEFERRED_LOG_DROP_POLICY));
+}
+
+// test_drain_thread handler function
+static void test_drain_thread() {
+    DeferredLog& deferredLog = DeferredLog::getInstance();
+    deferredLog.enable(true);
+    CaptureFileHandle fileHandle;
+    LogDrain logDrain;
+    TEST_ASSERT_EQUAL(osOK, logDrain.start(fileHandle));
+
+    // the records are sent periodically
+    DEFERRED_LOG_WARN(bike_computer::kLogMajorCycleOverrun, 1U);
+    ThisThread::sleep_for(LogDrain::kDrainPeriod + 2 * kWriteTime);
+    TEST_ASSERT_EQUAL_UINT32(0, deferredLog.getNbrOfPendingRecords());
+    TEST_ASSERT_EQUAL_UINT32(1, fileHandle.getNbrOfRecords());
+
+    // or when the drain is notified
+    DEFERRED_LOG_WARN(bike_computer::kLogMajorCycleOverrun, 2U);
+    logDrain.notify();
+    ThisThread::sleep_for(2 * kWriteTime);
+    TEST_ASSERT_EQUAL_UINT32(2, fileHandle.getNbrOfRecords());
+
+    // and when the drain stops
+    DEFERRED_LOG_WARN(bike_computer::kLogMajorCycleOverrun, 3U);
+    logDrain.stop();
+    TEST_ASSERT_EQUAL_UINT32(3, fileHandle.getNbrOfRecords());
+    TEST_ASSERT_TRUE(logDrain.getNbrOfDrains() >= 3);
+}
+
+// test_logging_does_not_block handler function
+static void test_logging_does_not_block() {
+    DeferredLog& deferredLog = DeferredLog::getInstance();
+    deferredLog.enable(true);
+    CaptureFileHandle fileHandle;
+    LogDrain logDrain;
+    logDrain.start(fileHandle);
+
+    // the lines are logged while the drain thread waits for the serial port
+    Timer timer;
+    timer.start();
+    std::chrono::microseconds maxLogTime = std::chrono::microseconds::zero();
+    for (uint32_t index = 0; index < 2 * DeferredLog::kCapacity; index++) {
+        const auto startTime = timer.elapsed_time();
+        DEFERRED_LOG_WARN(bike_computer::kLogMajorCycleOverrun, index);
+        maxLogTime = std::max(maxLogTime, timer.elapsed_time() - startTime);
+        if (index % 8 == 0) {
+            logDrain.notify();
+            ThisThread::sleep_for(1ms);
+        }
+    }
+    logDrain.stop();
+    TEST_ASSERT_TRUE(maxLogTime < 10us);
+    TEST_ASSERT_EQUAL_UINT32(0, deferredLog.getNbrOfPendingRecords());
+}
+
+static utest::v1::status_t greentea_setup(const size_t number_of_cases) {
+    // Here, we specify the timeout (60s) and the host test (a built-in host test or the
+    // name of our Python file)
+    GREENTEA_SETUP(60, "default_auto");
+
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+// List of test cases in this file
+static Case cases[] = {Case("test drop newest", test_drop_newest),
+                       Case("test drop oldest", test_drop_oldest),
+                       Case("test drain thread", test_drain_thread),
+                       Case("test logging does not block", test_logging_does_not_block)};
+
+static Specification specification(greentea_setup, cases);
+
+int main() { return !Harness::run(specification); }
@@ -0,0 +1,106 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file main.cpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Bike computer test suite: drift-free periodic release
+ *
+ * @date 2024-04-08
+ * @version 1.0.0
+ ***************************************************************************/
+
+#include <chrono>
+
+#include "common/periodic_release.hpp"
+#include "greentea-client/test_env.h"
+#include "mbed.h"
+#include "unity/unity.h"
+#include "utest/utest.h"
+
+using namespace utest::v1;
+
+static constexpr std::chrono::milliseconds kPeriod = 100ms;
+
+// frames with a varying amount of work must not shift the following periods
+static void test_no_drift() {
+    bike_computer::PeriodicRelease periodicRelease(kPeriod);
+    periodicRelease.start();
+    const auto epoch = periodicRelease.getPeriodStartTime();
+
+    constexpr uint32_t kNbrOfPeriods = 50;
+    for (uint32_t periodIndex = 0; periodIndex < kNbrOfPeriods; periodIndex++) {
+        TEST_ASSERT_TRUE(periodicRelease.sleepUntil(0ms));
+        // between 0 and 39.7 msecs of work, not a multiple of the tick
+        wait_us(static_cast<int>((periodIndex * 7919) % 40000));
+        TEST_ASSERT_TRUE(periodicRelease.sleepUntil(40ms));
+        wait_us(static_cast<int>((periodIndex * 4999) % 50000));
+        TEST_ASSERT_TRUE(periodicRelease.sleepUntilNextPeriod());
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(0, periodicRelease.getNbrOfOverruns());
+    const auto elapsedTime = periodicRelease.getPeriodStartTime() - epoch;
+    TEST_ASSERT_EQUAL_INT64((kPeriod * kNbrOfPeriods).count(),
+                            std::chrono::duration_cast<std::chrono::milliseconds>(elapsedTime)
+                                .count());
+    // the thread wakes up at the start of the last period
+    TEST_ASSERT_UINT64_WITHIN(1,
+                              (kPeriod * kNbrOfPeriods).count(),
+                              std::chrono::duration_cast<std::chrono::milliseconds>(
+                                  Kernel::Clock::now() - epoch)
+                                  .count());
+}
+
+// overruns are reported and do not shift the following releases
+static void test_overrun() {
+    bike_computer::PeriodicRelease periodicRelease(kPeriod);
+    periodicRelease.start();
+    const auto epoch = periodicRelease.getPeriodStartTime();
+
+    // the first frame takes 130 msecs, the second frame of the period and the
+    // start of the next period are late
+    TEST_ASSERT_TRUE(periodicRelease.sleepUntil(0ms));
+    wait_us(130000);
+    TEST_ASSERT_FALSE(periodicRelease.sleepUntil(50ms));
+    TEST_ASSERT_FALSE(periodicRelease.sleepUntilNextPeriod());
+    TEST_ASSERT_EQUAL_UINT32(2, periodicRelease.getNbrOfOverruns());
+
+    // the second frame of the late period is still released on time
+    TEST_ASSERT_TRUE(periodicRelease.sleepUntil(50ms));
+    TEST_ASSERT_UINT64_WITHIN(1,
+                              150,
+                              std::chrono::duration_cast<std::chrono::milliseconds>(
+                                  Kernel::Clock::now() - epoch)
+                                  .count());
+    TEST_ASSERT_TRUE(periodicRelease.sleepUntilNextPeriod());
+    TEST_ASSERT_TRUE(periodicRelease.getPeriodStartTime() - epoch == 2 * kPeriod);
+    TEST_ASSERT_EQUAL_UINT32(2, periodicRelease.getNbrOfOverruns());
+}
+
+static utest::v1::status_t greentea_setup(const size_t number_of_cases) {
+    // Here, we specify the timeout (60s) and the host test (a built-in host test or the
+    // name of our Python file)
+    GREENTEA_SETUP(60, "default_auto");
+
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+// List of test cases in this file
+static Case cases[] = {Case("test no drift", test_no_drift),
+                       Case("test overrun", test_overrun)};
+
+static Specification specification(greentea_setup, cases);
+
+int main() { return !Harness::run(specification); }
@@ -181,6 +181,38 @@ static control_t test_rotation_speed(const size_t call_count) {
   return CaseNext;
 }
 
+// test the speedometer over the whole gear size and rotation time domain
+static control_t test_speed_domain(const size_t call_count) {
+  // create a timer
+  Timer timer;
+  // start the timer
+  timer.start();
+
+  // create a speedometer instance
+  bike_computer::Speedometer speedometer(timer);
+
+  // get speedometer constant values
+  const auto traySize = speedometer.getTraySize();
+  const auto wheelCircumference = speedometer.getWheelCircumference();
+
+  for (uint8_t gearSize = bike_computer::kMinGearSize;
+       gearSize <= bike_computer::kMaxGearSize; gearSize++) {
+    speedometer.setGearSize(gearSize);
+    for (auto pedalRotationTime = bike_computer::kMinPedalRotationTime;
+         pedalRotationTime <= bike_computer::kMaxPedalRotationTime;
+         pedalRotationTime += bike_computer::kDeltaPedalRotationTime) {
+      speedometer.setCurrentRotationTime(pedalRotationTime);
+
+      // check the speed against the expected one
+      check_current_speed(pedalRotationTime, traySize, gearSize,
+                          wheelCircumference, speedometer.getCurrentSpeed());
+    }
+  }
+
+  // execute the test only once and move to the next one, without waiting
+  return CaseNext;
+}
+
 // test the speedometer by modifying the pedal rotation speed
 static control_t test_distance(const size_t call_count) {
   // create a timer
@@ -335,6 +367,7 @@ static utest::v1::status_t greentea_setup(const size_t number_of_cases) {
 static Case cases[] = {
     Case("test speedometer gear size change", test_gear_size),
     Case("test speedometer rotation speed change", test_rotation_speed),
+    Case("test speedometer speed domain", test_speed_domain),
     Case("test speedometer distance", test_distance),
     Case("test speedometer reset", test_reset)};
 
@@ -0,0 +1,120 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file main.cpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Bike computer test suite: calibrated synthetic workload
+ *
+ * @date 2024-04-15
+ * @version 1.0.0
+ ***************************************************************************/
+
+#include <algorithm>
+#include <chrono>
+
+#include "common/synthetic_workload.hpp"
+#include "greentea-client/test_env.h"
+#include "mbed.h"
+#include "unity/unity.h"
+#include "utest/utest.h"
+
+using namespace utest::v1;
+
+static int64_t elapsedUs(const Timer& timer) {
+    return static_cast<int64_t>(timer.elapsed_time().count());
+}
+
+// the consumed CPU time matches the requested one when the thread runs alone
+static void test_consume() {
+    bike_computer::SyntheticWorkload& workload = bike_computer::SyntheticWorkload::getInstance();
+    workload.calibrate();
+    TEST_ASSERT_TRUE(workload.isCalibrated());
+    TEST_ASSERT_TRUE(workload.getNbrOfChunksPerMs() > 0);
+
+    Timer timer;
+    timer.start();
+    workload.consume(20ms);
+    // within 2%
+    TEST_ASSERT_INT64_WITHIN(400, 20000, elapsedUs(timer));
+}
+
+// a preempted workload takes longer, unlike a busy wait on the timer
+static void test_preemption() {
+    bike_computer::SyntheticWorkload& workload = bike_computer::SyntheticWorkload::getInstance();
+    // each 10 msecs, the thread is busy for 5 msecs (3 times)
+    Thread thread(osPriorityAboveNormal, OS_STACK_SIZE, nullptr, "interference");
+    thread.start([]() {
+        for (uint32_t index = 0; index < 3; index++) {
+            ThisThread::sleep_for(10ms);
+            wait_us(5000);
+        }
+    });
+
+    Timer timer;
+    timer.start();
+    workload.consume(40ms);
+    const int64_t elapsedTime = elapsedUs(timer);
+    thread.join();
+    // 40 msecs of CPU time and 15 msecs of preemption
+    TEST_ASSERT_INT64_WITHIN(1000, 55000, elapsedTime);
+}
+
+// each run consumes between (100 - variation)% and 100% of the WCET
+static void test_variation() {
+    bike_computer::TaskWorkloads taskWorkloads;
+    const uint8_t taskIndex = advembsof::TaskLogger::kDisplayTask1Index;
+
+    // no workload by default and for invalid tasks
+    TEST_ASSERT_TRUE(taskWorkloads.run(taskIndex) == std::chrono::microseconds::zero());
+    taskWorkloads.set(advembsof::TaskLogger::kNbrOfTasks, 1ms);
+    TEST_ASSERT_TRUE(taskWorkloads.run(advembsof::TaskLogger::kNbrOfTasks) ==
+                     std::chrono::microseconds::zero());
+
+    taskWorkloads.set(taskIndex, 2ms, 50);
+    std::chrono::microseconds minExecutionTime = 2ms;
+    std::chrono::microseconds maxExecutionTime = 0us;
+    for (uint32_t runIndex = 0; runIndex < 50; runIndex++) {
+        const std::chrono::microseconds executionTime = taskWorkloads.run(taskIndex);
+        TEST_ASSERT_TRUE(executionTime >= 1ms && executionTime <= 2ms);
+        minExecutionTime = std::min(minExecutionTime, executionTime);
+        maxExecutionTime = std::max(maxExecutionTime, executionTime);
+    }
+    // spread over the interval
+    TEST_ASSERT_TRUE(maxExecutionTime - minExecutionTime > 500us);
+
+    // without variation, each run consumes the WCET
+    taskWorkloads.set(taskIndex, 2ms);
+    TEST_ASSERT_TRUE(taskWorkloads.run(taskIndex) == 2ms);
+    taskWorkloads.set(taskIndex, 0ms);
+    TEST_ASSERT_TRUE(taskWorkloads.run(taskIndex) == std::chrono::microseconds::zero());
+}
+
+static utest::v1::status_t greentea_setup(const size_t number_of_cases) {
+    // Here, we specify the timeout (60s) and the host test (a built-in host test or the
+    // name of our Python file)
+    GREENTEA_SETUP(60, "default_auto");
+
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+// List of test cases in this file
+static Case cases[] = {Case("test consume", test_consume),
+                       Case("test preemption", test_preemption),
+                       Case("test variation", test_variation)};
+
+static Specification specification(greentea_setup, cases);
+
+int main() { return !Harness::run(specification); }
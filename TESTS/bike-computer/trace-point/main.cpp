@@ -0,0 +1,155 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file main.cpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Bike computer test suite: compile-time trace points
+ *
+ * @date 2024-05-13
+ * @version 1.0.0
+ ***************************************************************************/
+
+#include <cstring>
+
+#include "common/trace_point.hpp"
+#include "greentea-client/test_env.h"
+#include "mbed.h"
+#include "unity/unity.h"
+#include "utest/utest.h"
+
+using namespace utest::v1;
+
+using bike_computer::TracePoints;
+using bike_computer::frame::getU16;
+using bike_computer::frame::getU32;
+
+// modules of the test, with different levels
+#define MBED_CONF_APP_TRACE_POINT_LEVEL_TEST_DEBUG TRACE_POINT_LEVEL_DEBUG
+#define MBED_CONF_APP_TRACE_POINT_LEVEL_TEST_WARN TRACE_POINT_LEVEL_WARN
+#define MBED_CONF_APP_TRACE_POINT_LEVEL_TEST_NONE TRACE_POINT_LEVEL_NONE
+
+static uint32_t nbrOfEvaluations = 0;
+
+static uint32_t evaluate(uint32_t value) {
+    nbrOfEvaluations++;
+    return value;
+}
+
+// test_compile_time_levels handler function
+static void test_compile_time_levels() {
+    TracePoints& tracePoints = TracePoints::getInstance();
+    tracePoints.enable(true);
+    nbrOfEvaluations = 0;
+
+    // the trace points of disabled levels do not evaluate their arguments
+    TRACE_POINT_DEBUG(TEST_WARN, bike_computer::kTracePointCycleTime, evaluate(1));
+    TRACE_POINT_INFO(TEST_WARN, bike_computer::kTracePointCycleTime, evaluate(2));
+    TRACE_POINT_ERROR(TEST_NONE, bike_computer::kTracePointCycleTime, evaluate(3));
+    TEST_ASSERT_EQUAL_UINT32(0, nbrOfEvaluations);
+    TEST_ASSERT_EQUAL_UINT32(0, tracePoints.getNbrOfPendingRecords());
+
+    // levels up to the module level are recorded
+    TRACE_POINT_WARN(TEST_WARN, bike_computer::kTracePointCycleTime, evaluate(4));
+    TRACE_POINT_ERROR(TEST_WARN, bike_computer::kTracePointCycleTime, evaluate(5));
+    TRACE_POINT_DEBUG(TEST_DEBUG, bike_computer::kTracePointHeapAfterAllocation);
+    TEST_ASSERT_EQUAL_UINT32(2, nbrOfEvaluations);
+    TEST_ASSERT_EQUAL_UINT32(3, tracePoints.getNbrOfPendingRecords());
+
+    // trace points are also disabled at run time
+    tracePoints.enable(false);
+    TRACE_POINT_DEBUG(TEST_DEBUG, bike_computer::kTracePointCycleTime, evaluate(6));
+    TEST_ASSERT_EQUAL_UINT32(3, nbrOfEvaluations);
+    TEST_ASSERT_EQUAL_UINT32(3, tracePoints.getNbrOfPendingRecords());
+}
+
+// test_records_and_frames handler function
+static void test_records_and_frames() {
+    TracePoints& tracePoints = TracePoints::getInstance();
+    tracePoints.enable(true);
+
+    TRACE_POINT_DEBUG(TEST_DEBUG, bike_computer::kTracePointNewSpeed, TracePoints::toArgument(12.5f));
+    ThisThread::sleep_for(2ms);
+    TRACE_POINT_DEBUG(
+        TEST_DEBUG, bike_computer::kTracePointAllocatedBlock, 7, 0x100, 0xDEADBEEF);
+    TEST_ASSERT_EQUAL_UINT32(2, tracePoints.getNbrOfPendingRecords());
+
+    uint8_t frame[TracePoints::kFrameHeaderSize + 4 * TracePoints::kRecordSize];
+    const size_t frameSize = tracePoints.drain(frame, sizeof(frame));
+    TEST_ASSERT_EQUAL_UINT32(TracePoints::kFrameHeaderSize + 2 * TracePoints::kRecordSize,
+                             frameSize);
+    TEST_ASSERT_EQUAL_MEMORY(TracePoints::kFrameMagic, frame, sizeof(TracePoints::kFrameMagic));
+    TEST_ASSERT_EQUAL_UINT16(2, getU16(frame + 4));
+    TEST_ASSERT_EQUAL_UINT16(0, getU16(frame + 6));
+
+    const uint8_t* first  = frame + TracePoints::kFrameHeaderSize;
+    const uint8_t* second = first + TracePoints::kRecordSize;
+    TEST_ASSERT_EQUAL_UINT16(bike_computer::kTracePointNewSpeed, getU16(first));
+    float speed = 0.0f;
+    const uint32_t speedArgument = getU32(first + 8);
+    std::memcpy(&speed, &speedArgument, sizeof(speed));
+    TEST_ASSERT_EQUAL_FLOAT(12.5f, speed);
+    TEST_ASSERT_EQUAL_UINT16(bike_computer::kTracePointAllocatedBlock, getU16(second));
+    TEST_ASSERT_EQUAL_UINT32(7, getU32(second + 8));
+    TEST_ASSERT_EQUAL_UINT32(0x100, getU32(second + 12));
+    TEST_ASSERT_EQUAL_UINT32(0xDEADBEEF, getU32(second + 16));
+    // timestamps in usecs since the trace points were enabled
+    TEST_ASSERT_UINT32_WITHIN(1000, 2000, getU32(second + 4) - getU32(first + 4));
+
+    // nothing left
+    TEST_ASSERT_EQUAL_UINT32(0, tracePoints.getNbrOfPendingRecords());
+    TEST_ASSERT_EQUAL_UINT32(0, tracePoints.drain(frame, sizeof(frame)));
+}
+
+// test_dropped_records handler function
+static void test_dropped_records() {
+    TracePoints& tracePoints = TracePoints::getInstance();
+    tracePoints.enable(true);
+
+    constexpr uint32_t kNbrOfDrops = 3;
+    for (uint32_t index = 0; index < TracePoints::kCapacity + kNbrOfDrops; index++) {
+        TRACE_POINT_DEBUG(TEST_DEBUG, bike_computer::kTracePointCycleTime, index);
+    }
+    TEST_ASSERT_EQUAL_UINT32(TracePoints::kCapacity, tracePoints.getNbrOfPendingRecords());
+    TEST_ASSERT_EQUAL_UINT32(kNbrOfDrops, tracePoints.getNbrOfDroppedRecords());
+
+    // the drops are reported in the first frame, the oldest records are kept
+    uint8_t frame[TracePoints::kFrameHeaderSize + 8 * TracePoints::kRecordSize];
+    TEST_ASSERT_EQUAL_UINT32(sizeof(frame), tracePoints.drain(frame, sizeof(frame)));
+    TEST_ASSERT_EQUAL_UINT16(8, getU16(frame + 4));
+    TEST_ASSERT_EQUAL_UINT16(kNbrOfDrops, getU16(frame + 6));
+    TEST_ASSERT_EQUAL_UINT32(0, getU32(frame + TracePoints::kFrameHeaderSize + 8));
+    TEST_ASSERT_EQUAL_UINT32(sizeof(frame), tracePoints.drain(frame, sizeof(frame)));
+    TEST_ASSERT_EQUAL_UINT16(0, getU16(frame + 6));
+    TEST_ASSERT_EQUAL_UINT32(TracePoints::kCapacity - 16, tracePoints.getNbrOfPendingRecords());
+    tracePoints.enable(false);
+}
+
+static utest::v1::status_t greentea_setup(const size_t number_of_cases) {
+    // Here, we specify the timeout (60s) and the host test (a built-in host test or the
+    // name of our Python file)
+    GREENTEA_SETUP(60, "default_auto");
+
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+// List of test cases in this file
+static Case cases[] = {Case("test compile time levels", test_compile_time_levels),
+                       Case("test records and frames", test_records_and_frames),
+                       Case("test dropped records", test_dropped_records)};
+
+static Specification specification(greentea_setup, cases);
+
+int main() { return !Harness::run(specification); }
@@ -0,0 +1,135 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file block_pool.hpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Typed pool of fixed-size blocks with a compile-time capacity
+ *
+ * The blocks are part of the instance and the free blocks are linked through
+ * their own storage, so that allocate() and free() take a constant time
+ * whatever the allocation history: a pool cannot fragment, it is exhausted
+ * only when all its blocks are allocated. Both may be called from threads
+ * and ISRs (the free list is updated in a critical section).
+ *
+ * The statistics give the high-water mark of the allocated blocks, which
+ * tells whether the capacity is right, and the number of failed allocations
+ * (exhaustions).
+ *
+ * @date 2024-06-17
+ * @version 1.0.0
+ ***************************************************************************/
+
+#pragma once
+
+#include <new>
+#include <utility>
+
+#include "mbed.h"
+
+namespace bike_computer {
+
+template <typename T, uint32_t N> class BlockPool {
+public:
+  static_assert(N > 0, "A block pool needs at least one block");
+
+  struct Statistics {
+    uint32_t capacity;
+    uint32_t nbrOfAllocatedBlocks;
+    uint32_t highWaterMark;
+    uint32_t nbrOfExhaustions;
+  };
+
+  BlockPool() {
+    for (uint32_t index = 0; index < N - 1; index++) {
+      _blocks[index].next = &_blocks[index + 1];
+    }
+    _blocks[N - 1].next = nullptr;
+    _freeBlocks = &_blocks[0];
+  }
+
+  // make the class non copyable
+  BlockPool(BlockPool &) = delete;
+  BlockPool &operator=(BlockPool &) = delete;
+
+  // constructs a T in a free block, returns nullptr if the pool is exhausted
+  template <typename... Args> T *allocate(Args &&...args) {
+    Block *block = nullptr;
+    {
+      CriticalSectionLock lock;
+      if (_freeBlocks == nullptr) {
+        _nbrOfExhaustions++;
+        return nullptr;
+      }
+      block = _freeBlocks;
+      _freeBlocks = block->next;
+      _nbrOfAllocatedBlocks++;
+      if (_nbrOfAllocatedBlocks > _highWaterMark) {
+        _highWaterMark = _nbrOfAllocatedBlocks;
+      }
+    }
+    return new (block->storage) T(std::forward<Args>(args)...);
+  }
+
+  // destroys the T and gives its block back, ptr must come from this pool
+  void free(T *ptr) {
+    if (ptr == nullptr) {
+      return;
+    }
+    MBED_ASSERT(contains(ptr));
+    ptr->~T();
+    Block *block = reinterpret_cast<Block *>(ptr);
+    CriticalSectionLock lock;
+    block->next = _freeBlocks;
+    _freeBlocks = block;
+    _nbrOfAllocatedBlocks--;
+  }
+
+  bool contains(const T *ptr) const {
+    const uintptr_t address = reinterpret_cast<uintptr_t>(ptr);
+    const uintptr_t start = reinterpret_cast<uintptr_t>(&_blocks[0]);
+    return address >= start && address < start + sizeof(_blocks) &&
+           (address - start) % sizeof(Block) == 0;
+  }
+
+  static constexpr uint32_t getCapacity() { return N; }
+
+  Statistics getStatistics() const {
+    CriticalSectionLock lock;
+    return {N, _nbrOfAllocatedBlocks, _highWaterMark, _nbrOfExhaustions};
+  }
+
+  // the high-water mark restarts from the blocks currently allocated
+  void resetStatistics() {
+    CriticalSectionLock lock;
+    _highWaterMark = _nbrOfAllocatedBlocks;
+    _nbrOfExhaustions = 0;
+  }
+
+private:
+  // a free block holds the link to the next free block
+  union Block {
+    Block *next;
+    alignas(T) unsigned char storage[sizeof(T)];
+  };
+
+  Block _blocks[N];
+  Block *_freeBlocks = nullptr;
+  uint32_t _nbrOfAllocatedBlocks = 0;
+  uint32_t _highWaterMark = 0;
+  uint32_t _nbrOfExhaustions = 0;
+};
+
+} // namespace bike_computer
@@ -0,0 +1,94 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file coalescing_mailbox.hpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Latest-value mailbox between ISRs and an event queue
+ *
+ * The mailbox keeps only the newest posted value and a pending flag. An
+ * event is posted to the queue only when no event is pending, so that any
+ * number of updates between two dispatches collapse into a single callback
+ * with the newest value. At most one event per mailbox is thus in the queue,
+ * whatever the update rate.
+ *
+ * The pending flag is cleared before the value is read in the event, so
+ * that a value posted while the callback runs always posts a new event and
+ * is never lost (it may at worst be delivered twice).
+ *
+ * @date 2024-03-04
+ * @version 1.0.0
+ ***************************************************************************/
+
+#pragma once
+
+#include "mbed.h"
+#include "seq_lock.hpp"
+
+namespace bike_computer {
+
+template <typename T>
+class CoalescingMailbox {
+public:
+  CoalescingMailbox(EventQueue &eventQueue, // NOLINT(runtime/references)
+                    mbed::Callback<void(const T &)> cb)
+      : _eventQueue(eventQueue), _cb(cb) {}
+
+  // make the class non copyable
+  CoalescingMailbox(CoalescingMailbox &) = delete;
+  CoalescingMailbox &operator=(CoalescingMailbox &) = delete;
+
+  // publish a new value, may be called from threads and ISRs, returns false
+  // if an event was needed and the queue is full
+  bool post(const T &value) {
+    _value.write(value);
+    if (core_util_atomic_exchange_bool(&_isPending, true)) {
+      // the pending event will deliver this value
+      core_util_atomic_incr_u32(&_nbrOfCoalescedValues, 1);
+      return true;
+    }
+    if (_eventQueue.call(callback(this, &CoalescingMailbox::dispatch)) == 0) {
+      core_util_atomic_store_bool(&_isPending, false);
+      core_util_atomic_incr_u32(&_nbrOfDroppedEvents, 1);
+      return false;
+    }
+    return true;
+  }
+
+  // number of values replaced by a newer one before being delivered
+  uint32_t getNbrOfCoalescedValues() const {
+    return core_util_atomic_load_u32(&_nbrOfCoalescedValues);
+  }
+
+  // number of events that could not be posted (full queue)
+  uint32_t getNbrOfDroppedEvents() const {
+    return core_util_atomic_load_u32(&_nbrOfDroppedEvents);
+  }
+
+private:
+  void dispatch() {
+    core_util_atomic_store_bool(&_isPending, false);
+    _cb(_value.read());
+  }
+
+  EventQueue &_eventQueue;
+  mbed::Callback<void(const T &)> _cb;
+  SeqLock<T> _value;
+  volatile bool _isPending = false;
+  volatile uint32_t _nbrOfCoalescedValues = 0;
+  volatile uint32_t _nbrOfDroppedEvents = 0;
+};
+
+} // namespace bike_computer
@@ -0,0 +1,73 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file cycle_counter.hpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Cycle counter for measuring short code sequences
+ *
+ * On target, the DWT cycle counter of the Cortex-M core is used. The host
+ * simulation has no cycle counter (and its virtual time does not advance
+ * while code runs), the host time in nsecs is used instead: getUnit() gives
+ * the unit of the counts for the reports.
+ *
+ * @date 2024-06-10
+ * @version 1.0.0
+ ***************************************************************************/
+
+#pragma once
+
+#include <chrono>
+
+#include "mbed.h"
+
+namespace bike_computer {
+
+class CycleCounter {
+public:
+  static void enable() {
+#if defined(DWT_CTRL_CYCCNTENA_Msk)
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+#if defined(__CORTEX_M) && (__CORTEX_M == 7U)
+    // the DWT registers of the Cortex-M7 are locked at reset
+    DWT->LAR = 0xC5ACCE55;
+#endif
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+  }
+
+  // the counts wrap around, only differences are meaningful
+  static uint32_t read() {
+#if defined(DWT_CTRL_CYCCNTENA_Msk)
+    return DWT->CYCCNT;
+#else
+    return static_cast<uint32_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+#endif
+  }
+
+  static const char *getUnit() {
+#if defined(DWT_CTRL_CYCCNTENA_Msk)
+    return "cycles";
+#else
+    return "host ns";
+#endif
+  }
+};
+
+} // namespace bike_computer
@@ -0,0 +1,164 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file cyclic_schedule.hpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Compile time frame table of a cyclic executive
+ *
+ * makeCyclicSchedule() expands a table of periodic tasks (period, offset,
+ * computation time and member function) into the frames of one major cycle
+ * (the least common multiple of the periods), sorted by start time. Each
+ * frame starts at the release of its task (offset + k * period), so that the
+ * table must be feasible as is: a frame may not start before the previous one
+ * ends (including the first frame of the next major cycle) and each task must
+ * complete before its next release. The result is meant to be a constexpr
+ * variable whose error is checked with static_assert, e.g.
+ *
+ *   static_assert(kSchedule.error != CyclicScheduleError::Overlap, "...");
+ *
+ * The frames refer to the tasks by their index in the table.
+ *
+ * @date 2024-03-11
+ * @version 1.0.0
+ ***************************************************************************/
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace bike_computer {
+
+template <typename T> struct CyclicTask {
+  std::chrono::milliseconds period;
+  std::chrono::milliseconds offset;
+  std::chrono::milliseconds computationTime;
+  void (T::*function)();
+};
+
+enum class CyclicScheduleError {
+  None,
+  // a period is not positive or an offset is not within the period
+  InvalidTask,
+  // the major cycle has more frames than the schedule can hold
+  TooManyFrames,
+  // a frame starts before the previous one ends
+  Overlap,
+  // a task does not complete before its next release
+  DeadlineMiss
+};
+
+template <size_t kMaxNbrOfFrames> struct CyclicSchedule {
+  struct Frame {
+    std::chrono::milliseconds startTime;
+    uint8_t taskIndex;
+  };
+
+  std::chrono::milliseconds majorCycle;
+  size_t nbrOfFrames;
+  Frame frames[kMaxNbrOfFrames];
+  // sum of the frame computation times over the major cycle
+  std::chrono::milliseconds busyTime;
+  CyclicScheduleError error;
+  // task in error (for InvalidTask, Overlap and DeadlineMiss)
+  uint8_t errorTaskIndex;
+};
+
+namespace detail {
+
+constexpr int64_t gcd(int64_t a, int64_t b) {
+  while (b != 0) {
+    const int64_t remainder = a % b;
+    a = b;
+    b = remainder;
+  }
+  return a;
+}
+
+} // namespace detail
+
+template <size_t kMaxNbrOfFrames, typename T, size_t N>
+constexpr CyclicSchedule<kMaxNbrOfFrames>
+makeCyclicSchedule(const CyclicTask<T> (&tasks)[N]) {
+  static_assert(N > 0 && N <= UINT8_MAX, "Invalid number of tasks");
+
+  CyclicSchedule<kMaxNbrOfFrames> schedule{};
+  schedule.error = CyclicScheduleError::None;
+
+  // each task must have a valid release and must fit in its period
+  int64_t majorCycle = 1;
+  for (size_t taskIndex = 0; taskIndex < N; taskIndex++) {
+    const CyclicTask<T> &task = tasks[taskIndex];
+    if (task.period.count() <= 0 || task.offset.count() < 0 ||
+        task.offset >= task.period || task.computationTime.count() < 0) {
+      schedule.error = CyclicScheduleError::InvalidTask;
+      schedule.errorTaskIndex = taskIndex;
+      return schedule;
+    }
+    if (task.computationTime > task.period) {
+      schedule.error = CyclicScheduleError::DeadlineMiss;
+      schedule.errorTaskIndex = taskIndex;
+      return schedule;
+    }
+    majorCycle = majorCycle / detail::gcd(majorCycle, task.period.count()) *
+                 task.period.count();
+  }
+  schedule.majorCycle = std::chrono::milliseconds(majorCycle);
+
+  // one frame per release in the major cycle, inserted by start time (frames
+  // released at the same time keep the table order and then overlap)
+  for (size_t taskIndex = 0; taskIndex < N; taskIndex++) {
+    const CyclicTask<T> &task = tasks[taskIndex];
+    for (auto startTime = task.offset; startTime < schedule.majorCycle;
+         startTime = startTime + task.period) {
+      if (schedule.nbrOfFrames == kMaxNbrOfFrames) {
+        schedule.error = CyclicScheduleError::TooManyFrames;
+        return schedule;
+      }
+      size_t frameIndex = schedule.nbrOfFrames++;
+      while (frameIndex > 0 &&
+             schedule.frames[frameIndex - 1].startTime > startTime) {
+        schedule.frames[frameIndex] = schedule.frames[frameIndex - 1];
+        frameIndex--;
+      }
+      schedule.frames[frameIndex].startTime = startTime;
+      schedule.frames[frameIndex].taskIndex = taskIndex;
+      schedule.busyTime = schedule.busyTime + task.computationTime;
+    }
+  }
+
+  // each frame must end before the next one starts, the last frame before the
+  // first one of the next major cycle
+  for (size_t frameIndex = 0; frameIndex < schedule.nbrOfFrames; frameIndex++) {
+    const auto &frame = schedule.frames[frameIndex];
+    const auto endTime =
+        frame.startTime + tasks[frame.taskIndex].computationTime;
+    const auto nextStartTime =
+        frameIndex + 1 < schedule.nbrOfFrames
+            ? schedule.frames[frameIndex + 1].startTime
+            : schedule.frames[0].startTime + schedule.majorCycle;
+    if (endTime > nextStartTime) {
+      schedule.error = CyclicScheduleError::Overlap;
+      schedule.errorTaskIndex = frame.taskIndex;
+      return schedule;
+    }
+  }
+
+  return schedule;
+}
+
+} // namespace bike_computer
@@ -0,0 +1,117 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file deferred_log.cpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Deferred binary logger implementation (ring buffer)
+ *
+ * @date 2024-05-20
+ * @version 1.0.0
+ ***************************************************************************/
+
+#include "deferred_log.hpp"
+
+namespace bike_computer {
+
+constexpr uint8_t DeferredLog::kFrameMagic[4];
+
+DeferredLog &DeferredLog::getInstance() {
+  // statically allocated (the ring buffer is part of the instance)
+  static DeferredLog instance;
+  return instance;
+}
+
+DeferredLog::DeferredLog() { _timer.start(); }
+
+void DeferredLog::enable(bool enable) {
+  if (enable) {
+    core_util_atomic_store_bool(&_isEnabled, false);
+    _ring.clear();
+    _timer.reset();
+    _timer.start();
+  }
+  core_util_atomic_store_bool(&_isEnabled, enable);
+}
+
+void DeferredLog::setLevel(uint8_t level) {
+  core_util_atomic_store_u8(&_level, level);
+}
+
+uint8_t DeferredLog::getLevel() const {
+  return core_util_atomic_load_u8(&_level);
+}
+
+void DeferredLog::setDropPolicy(DropPolicy dropPolicy) {
+  core_util_atomic_store_u8(&_dropPolicy, dropPolicy);
+}
+
+DeferredLog::DropPolicy DeferredLog::getDropPolicy() const {
+  return static_cast<DropPolicy>(core_util_atomic_load_u8(&_dropPolicy));
+}
+
+bool DeferredLog::reserve(uint32_t &index) {
+  if (!core_util_atomic_load_bool(&_isEnabled) ||
+      !_ring.reserve(index, getDropPolicy() == kDropOldest)) {
+    return false;
+  }
+  _ring.getRecord(index).timestamp =
+      static_cast<uint32_t>(_timer.elapsed_time().count());
+  return true;
+}
+
+size_t DeferredLog::drain(uint8_t *buffer, size_t size) {
+  if (size < kFrameHeaderSize + kRecordHeaderSize + kMaxPayloadSize) {
+    return 0;
+  }
+  return _ring.drain(
+      kFrameMagic, buffer, size,
+      [](const Record &record, uint8_t *recordBuffer, size_t room) -> size_t {
+        // the size is bounded, the record may be overwritten while it is
+        // copied (drop oldest)
+        const uint8_t payloadSize = std::min<uint8_t>(
+            record.payloadSize, static_cast<uint8_t>(kMaxPayloadSize));
+        if (kRecordHeaderSize + payloadSize > room) {
+          return 0;
+        }
+        frame::putU16(recordBuffer, record.id);
+        recordBuffer[2] = record.level;
+        recordBuffer[3] = payloadSize;
+        frame::putU32(recordBuffer + 4, record.timestamp);
+        std::memcpy(recordBuffer + kRecordHeaderSize, record.payload,
+                    payloadSize);
+        return kRecordHeaderSize + payloadSize;
+      });
+}
+
+void DeferredLog::drainTo(mbed::FileHandle &fileHandle) {
+  // frames are sent by chunks of at least 8 records
+  static uint8_t frame[kFrameHeaderSize +
+                       8 * (kRecordHeaderSize + kMaxPayloadSize)];
+  size_t frameSize = 0;
+  while ((frameSize = drain(frame, sizeof(frame))) > 0) {
+    fileHandle.write(frame, frameSize);
+  }
+}
+
+uint32_t DeferredLog::getNbrOfPendingRecords() const {
+  return _ring.getNbrOfPendingRecords();
+}
+
+uint32_t DeferredLog::getNbrOfDroppedRecords() const {
+  return _ring.getNbrOfDroppedRecords();
+}
+
+} // namespace bike_computer
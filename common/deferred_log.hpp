@@ -0,0 +1,301 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file deferred_log.hpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Deferred binary logger, replacement of tr_info() and co
+ *
+ * A log line is a format string id and its arguments, e.g.
+ *
+ *   DEFERRED_LOG_WARN(kLogMajorCycleOverrun, nbrOfOverruns);
+ *
+ * The format strings are not part of the firmware: they are only given in
+ * log_formats.hpp, from which the host decoder reconstructs the text (see
+ * host_simulation/tools/log_decoder.cpp). At run time, the id, the level, a
+ * timestamp and the raw bytes of the arguments are written in a statically
+ * allocated lock-free ring buffer, from threads or ISRs, and drained in
+ * binary frames with the frames of the TaskTracer.
+ *
+ * Each argument is written with its type (1 byte) followed by its value:
+ * 32 or 64 bit integers, floats (doubles are written as floats) and strings
+ * (length and characters). Arguments that do not fit in the payload of a
+ * record are dropped and the record is flagged as truncated. Enumerations
+ * must be cast to an integer type.
+ *
+ * When the ring buffer is full, either the new record (drop newest, the
+ * default) or the oldest pending record (drop oldest) is dropped, as
+ * selected with "deferred-log-drop-policy" in mbed_app.json or at run time.
+ * Dropped records are counted and reported in the next frame.
+ *
+ * The maximal level is selected at compile time with
+ * "deferred-log-max-level" in mbed_app.json (like "mbed-trace.max-level"),
+ * the lines of higher levels are removed by the preprocessor. The active
+ * level may be lowered at run time.
+ *
+ * @date 2024-05-20
+ * @version 1.0.0
+ ***************************************************************************/
+
+#pragma once
+
+#include <cstring>
+#include <type_traits>
+
+#include "log_formats.hpp"
+#include "mbed.h"
+#include "mpsc_ring.hpp"
+
+#define DEFERRED_LOG_LEVEL_NONE 0
+#define DEFERRED_LOG_LEVEL_ERROR 1
+#define DEFERRED_LOG_LEVEL_WARN 2
+#define DEFERRED_LOG_LEVEL_INFO 3
+#define DEFERRED_LOG_LEVEL_DEBUG 4
+
+#if !defined(MBED_CONF_APP_DEFERRED_LOG_MAX_LEVEL)
+#define MBED_CONF_APP_DEFERRED_LOG_MAX_LEVEL DEFERRED_LOG_LEVEL_DEBUG
+#endif
+
+#if !defined(MBED_CONF_APP_DEFERRED_LOG_CAPACITY)
+#define MBED_CONF_APP_DEFERRED_LOG_CAPACITY 64
+#endif
+
+#define DEFERRED_LOG_DROP_NEWEST 0
+#define DEFERRED_LOG_DROP_OLDEST 1
+
+#if !defined(MBED_CONF_APP_DEFERRED_LOG_DROP_POLICY)
+#define MBED_CONF_APP_DEFERRED_LOG_DROP_POLICY DEFERRED_LOG_DROP_NEWEST
+#endif
+
+#if MBED_CONF_APP_DEFERRED_LOG_MAX_LEVEL >= DEFERRED_LOG_LEVEL_ERROR
+#define DEFERRED_LOG_ERROR(...)                                               \
+  ::bike_computer::DeferredLog::getInstance().log(DEFERRED_LOG_LEVEL_ERROR,   \
+                                                  __VA_ARGS__)
+#else
+#define DEFERRED_LOG_ERROR(...)                                               \
+  do {                                                                        \
+  } while (0)
+#endif
+
+#if MBED_CONF_APP_DEFERRED_LOG_MAX_LEVEL >= DEFERRED_LOG_LEVEL_WARN
+#define DEFERRED_LOG_WARN(...)                                                \
+  ::bike_computer::DeferredLog::getInstance().log(DEFERRED_LOG_LEVEL_WARN,    \
+                                                  __VA_ARGS__)
+#else
+#define DEFERRED_LOG_WARN(...)                                                \
+  do {                                                                        \
+  } while (0)
+#endif
+
+#if MBED_CONF_APP_DEFERRED_LOG_MAX_LEVEL >= DEFERRED_LOG_LEVEL_INFO
+#define DEFERRED_LOG_INFO(...)                                                \
+  ::bike_computer::DeferredLog::getInstance().log(DEFERRED_LOG_LEVEL_INFO,    \
+                                                  __VA_ARGS__)
+#else
+#define DEFERRED_LOG_INFO(...)                                                \
+  do {                                                                        \
+  } while (0)
+#endif
+
+#if MBED_CONF_APP_DEFERRED_LOG_MAX_LEVEL >= DEFERRED_LOG_LEVEL_DEBUG
+#define DEFERRED_LOG_DEBUG(...)                                               \
+  ::bike_computer::DeferredLog::getInstance().log(DEFERRED_LOG_LEVEL_DEBUG,   \
+                                                  __VA_ARGS__)
+#else
+#define DEFERRED_LOG_DEBUG(...)                                               \
+  do {                                                                        \
+  } while (0)
+#endif
+
+namespace bike_computer {
+
+// ids of all log lines, the formats are in log_formats.hpp
+#define DEFERRED_LOG_ID(id, group, format) id,
+enum DeferredLogId : uint16_t {
+  kLogNone = 0,
+  DEFERRED_LOG_FORMATS(DEFERRED_LOG_ID) kNbrOfLogIds
+};
+#undef DEFERRED_LOG_ID
+
+class DeferredLog {
+public:
+  static constexpr uint32_t kCapacity = MBED_CONF_APP_DEFERRED_LOG_CAPACITY;
+  static_assert((kCapacity & (kCapacity - 1)) == 0 && kCapacity > 0,
+                "deferred-log-capacity must be a power of 2");
+  static constexpr size_t kMaxPayloadSize = 24;
+
+  // type of each argument in the payload
+  enum ArgumentType : uint8_t {
+    kUint32 = 1,
+    kInt32,
+    kUint64,
+    kInt64,
+    kFloat,
+    // length (u8) and characters
+    kString
+  };
+
+  // record dropped when the ring buffer is full
+  enum DropPolicy : uint8_t {
+    kDropNewest = DEFERRED_LOG_DROP_NEWEST,
+    kDropOldest = DEFERRED_LOG_DROP_OLDEST
+  };
+
+  // binary frame format (little endian)
+  static constexpr uint8_t kFrameMagic[4] = {'D', 'L', 'O', 'G'};
+  // magic, number of records (u16), number of dropped records (u16)
+  static constexpr size_t kFrameHeaderSize = 8;
+  // id (u16), level (u8), payload size (u8), timestamp in usecs (u32), then
+  // the payload
+  static constexpr size_t kRecordHeaderSize = 8;
+  // set in the level of records with dropped arguments
+  static constexpr uint8_t kTruncatedFlag = 0x80;
+
+  static DeferredLog &getInstance();
+
+  // make the class non copyable
+  DeferredLog(DeferredLog &) = delete;
+  DeferredLog &operator=(DeferredLog &) = delete;
+
+  // the logger is enabled at startup, enabling it clears all records and
+  // restarts the timestamps
+  void enable(bool enable);
+
+  // lines above the active level are not recorded
+  void setLevel(uint8_t level);
+  uint8_t getLevel() const;
+
+  void setDropPolicy(DropPolicy dropPolicy);
+  DropPolicy getDropPolicy() const;
+
+  // called by the log macros, may be called from threads and ISRs
+  template <typename... Args>
+  bool log(uint8_t level, DeferredLogId id, Args... arguments) {
+    if (level > core_util_atomic_load_u8(&_level)) {
+      return false;
+    }
+    uint32_t index = 0;
+    if (!reserve(index)) {
+      return false;
+    }
+    Record &record = _ring.getRecord(index);
+    Encoder encoder = {record.payload, 0, false};
+    encodeArguments(encoder, arguments...);
+    record.id = id;
+    record.level =
+        static_cast<uint8_t>(encoder.isTruncated ? level | kTruncatedFlag : level);
+    record.payloadSize = encoder.size;
+    _ring.commit(index);
+    return true;
+  }
+
+  // encode as many pending records as possible into a frame, returns the
+  // frame size (0 if there is no pending record or the buffer is too small)
+  // must be called from a single thread
+  size_t drain(uint8_t *buffer, size_t size);
+
+  // drain all pending records into the file handle (e.g. the serial port)
+  void drainTo(mbed::FileHandle &fileHandle); // NOLINT(runtime/references)
+
+  uint32_t getNbrOfPendingRecords() const;
+  uint32_t getNbrOfDroppedRecords() const;
+
+private:
+  DeferredLog();
+
+  struct Record {
+    uint16_t id;
+    uint8_t level;
+    uint8_t payloadSize;
+    uint32_t timestamp;
+    uint8_t payload[kMaxPayloadSize];
+  };
+
+  struct Encoder {
+    uint8_t *buffer;
+    uint8_t size;
+    bool isTruncated;
+  };
+
+  // reserve a slot and timestamp it
+  bool reserve(uint32_t &index); // NOLINT(runtime/references)
+
+  static bool put(Encoder &encoder, ArgumentType type, uint64_t value,
+                  uint8_t size) {
+    if (encoder.isTruncated ||
+        static_cast<size_t>(encoder.size) + 1 + size > kMaxPayloadSize) {
+      encoder.isTruncated = true;
+      return false;
+    }
+    uint8_t *buffer = encoder.buffer + encoder.size;
+    buffer[0] = type;
+    for (uint8_t index = 0; index < size; index++) {
+      buffer[1 + index] = static_cast<uint8_t>(value >> (8 * index));
+    }
+    encoder.size = static_cast<uint8_t>(encoder.size + 1 + size);
+    return true;
+  }
+
+  template <typename T>
+  static typename std::enable_if<std::is_integral<T>::value>::type
+  encode(Encoder &encoder, T value) {
+    if (sizeof(T) <= sizeof(uint32_t)) {
+      put(encoder, std::is_signed<T>::value ? kInt32 : kUint32,
+          static_cast<uint32_t>(value), sizeof(uint32_t));
+    } else {
+      put(encoder, std::is_signed<T>::value ? kInt64 : kUint64,
+          static_cast<uint64_t>(value), sizeof(uint64_t));
+    }
+  }
+
+  static void encode(Encoder &encoder, double value) {
+    const float floatValue = static_cast<float>(value);
+    uint32_t bits = 0;
+    std::memcpy(&bits, &floatValue, sizeof(bits));
+    put(encoder, kFloat, bits, sizeof(bits));
+  }
+
+  static void encode(Encoder &encoder, const char *value) {
+    // strings are shortened to the room left in the payload
+    const size_t room = kMaxPayloadSize - encoder.size;
+    if (encoder.isTruncated || room < 2) {
+      encoder.isTruncated = true;
+      return;
+    }
+    const size_t fullLength = std::strlen(value);
+    const size_t length = std::min(fullLength, room - 2);
+    put(encoder, kString, length, 1);
+    std::memcpy(encoder.buffer + encoder.size, value, length);
+    encoder.size = static_cast<uint8_t>(encoder.size + length);
+    encoder.isTruncated = length < fullLength;
+  }
+
+  static void encodeArguments(Encoder &) {}
+
+  template <typename T, typename... Args>
+  static void encodeArguments(Encoder &encoder, T argument,
+                              Args... arguments) {
+    encode(encoder, argument);
+    encodeArguments(encoder, arguments...);
+  }
+
+  volatile bool _isEnabled = true;
+  volatile uint8_t _level = MBED_CONF_APP_DEFERRED_LOG_MAX_LEVEL;
+  volatile uint8_t _dropPolicy = MBED_CONF_APP_DEFERRED_LOG_DROP_POLICY;
+  Timer _timer;
+  MpscRing<Record, kCapacity> _ring;
+};
+
+} // namespace bike_computer
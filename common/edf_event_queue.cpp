@@ -0,0 +1,169 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file edf_event_queue.cpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Earliest deadline first dispatcher implementation
+ *
+ * @date 2024-03-25
+ * @version 1.0.0
+ ***************************************************************************/
+
+#include "edf_event_queue.hpp"
+
+namespace bike_computer {
+
+constexpr std::chrono::milliseconds EdfEvent::kNotPeriodic;
+constexpr std::chrono::milliseconds EdfEvent::kNoDeadline;
+
+EdfEvent::EdfEvent(EdfEventQueue *queue, mbed::Callback<void()> cb)
+    : _queue(queue), _cb(cb) {}
+
+bool EdfEvent::post() {
+  {
+    CriticalSectionLock lock;
+    if (_isPending) {
+      return false;
+    }
+    _isPending = true;
+    _release = Kernel::Clock::now() + _delay;
+    _absoluteDeadline = _release + getRelativeDeadline();
+    _queue->link(*this);
+  }
+  // wake up the dispatcher, the release may be earlier than the one it waits
+  // for
+  _queue->_semaphore.release();
+  return true;
+}
+
+void EdfEvent::cancel() {
+  CriticalSectionLock lock;
+  if (_isLinked) {
+    _queue->unlink(*this);
+  }
+  _isPending = false;
+}
+
+std::chrono::milliseconds EdfEvent::getRelativeDeadline() const {
+  if (_deadline != kNoDeadline) {
+    return _deadline;
+  }
+  if (_period != kNotPeriodic) {
+    return _period;
+  }
+  // events without deadline are dispatched after all the others (but they
+  // still run before later releases, there is no starvation in a feasible
+  // schedule)
+  return std::chrono::hours(24);
+}
+
+void EdfEventQueue::dispatch_forever() {
+  dispatchUntil(Kernel::Clock::time_point::max());
+}
+
+void EdfEventQueue::dispatch_for(const std::chrono::milliseconds &duration) {
+  dispatchUntil(Kernel::Clock::now() + duration);
+}
+
+void EdfEventQueue::break_dispatch() {
+  _breakDispatch = true;
+  _semaphore.release();
+}
+
+uint32_t EdfEventQueue::getNbrOfDeadlineMisses() const {
+  return core_util_atomic_load_u32(&_nbrOfDeadlineMisses);
+}
+
+void EdfEventQueue::link(EdfEvent &event) {
+  event._next = _events;
+  _events = &event;
+  event._isLinked = true;
+}
+
+void EdfEventQueue::unlink(EdfEvent &event) {
+  EdfEvent **link = &_events;
+  while (*link != nullptr && *link != &event) {
+    link = &(*link)->_next;
+  }
+  if (*link != nullptr) {
+    *link = event._next;
+  }
+  event._next = nullptr;
+  event._isLinked = false;
+}
+
+void EdfEventQueue::dispatchUntil(const Kernel::Clock::time_point &endTime) {
+  _breakDispatch = false;
+  while (!_breakDispatch) {
+    auto now = Kernel::Clock::now();
+    if (now >= endTime) {
+      break;
+    }
+
+    // released event with the earliest absolute deadline
+    EdfEvent *nextEvent = nullptr;
+    auto nextRelease = endTime;
+    {
+      CriticalSectionLock lock;
+      for (EdfEvent *event = _events; event != nullptr; event = event->_next) {
+        if (event->_release > now) {
+          if (event->_release < nextRelease) {
+            nextRelease = event->_release;
+          }
+        } else if (nextEvent == nullptr ||
+                   event->_absoluteDeadline < nextEvent->_absoluteDeadline) {
+          nextEvent = event;
+        }
+      }
+      if (nextEvent != nullptr) {
+        unlink(*nextEvent);
+        // a one-shot event may be posted again while it runs
+        if (nextEvent->_period == EdfEvent::kNotPeriodic) {
+          nextEvent->_isPending = false;
+        }
+      }
+    }
+
+    if (nextEvent == nullptr) {
+      // sleep until the next release, a post wakes the dispatcher up
+      if (nextRelease == Kernel::Clock::time_point::max()) {
+        _semaphore.acquire();
+      } else {
+        _semaphore.try_acquire_until(nextRelease);
+      }
+      continue;
+    }
+
+    const auto absoluteDeadline = nextEvent->_absoluteDeadline;
+    nextEvent->_cb();
+    nextEvent->_nbrOfCompletions++;
+    if (Kernel::Clock::now() > absoluteDeadline) {
+      nextEvent->_nbrOfDeadlineMisses++;
+      core_util_atomic_incr_u32(&_nbrOfDeadlineMisses, 1);
+    }
+
+    // next release of a periodic event, unless it was cancelled meanwhile
+    CriticalSectionLock lock;
+    if (nextEvent->_period != EdfEvent::kNotPeriodic && nextEvent->_isPending) {
+      nextEvent->_release += nextEvent->_period;
+      nextEvent->_absoluteDeadline =
+          nextEvent->_release + nextEvent->getRelativeDeadline();
+      link(*nextEvent);
+    }
+  }
+}
+
+} // namespace bike_computer
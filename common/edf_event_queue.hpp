@@ -0,0 +1,127 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file edf_event_queue.hpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Earliest deadline first dispatcher, alternative to the mbed
+ *        EventQueue
+ *
+ * EdfEvent has the same delay()/period()/post() interface as mbed::Event and
+ * an additional relative deadline (the period by default). Among the released
+ * events, the dispatcher always runs the one with the earliest absolute
+ * deadline, whereas the EventQueue runs them by release time. Each event
+ * counts its invocations that complete after their absolute deadline.
+ *
+ * Events are owned by the caller and linked into the queue when posted, so
+ * that posting never allocates memory. An event has at most one pending
+ * invocation: posting an event that is already pending is ignored (periodic
+ * events are pending until cancelled). Events may be posted from ISRs.
+ *
+ * Times use the rtos clock (1 msec resolution), like the EventQueue on the
+ * target.
+ *
+ * @date 2024-03-25
+ * @version 1.0.0
+ ***************************************************************************/
+
+#pragma once
+
+#include <chrono>
+
+#include "mbed.h"
+
+namespace bike_computer {
+
+class EdfEventQueue;
+
+class EdfEvent {
+public:
+  EdfEvent(EdfEventQueue *queue, mbed::Callback<void()> cb);
+
+  // make the class non copyable
+  EdfEvent(EdfEvent &) = delete;
+  EdfEvent &operator=(EdfEvent &) = delete;
+
+  void delay(const std::chrono::milliseconds &delay) { _delay = delay; }
+  void period(const std::chrono::milliseconds &period) { _period = period; }
+  // relative to each release
+  void deadline(const std::chrono::milliseconds &deadline) {
+    _deadline = deadline;
+  }
+
+  // returns false if the event is already pending
+  bool post();
+  void cancel();
+
+  uint32_t getNbrOfCompletions() const { return _nbrOfCompletions; }
+  uint32_t getNbrOfDeadlineMisses() const { return _nbrOfDeadlineMisses; }
+
+private:
+  friend class EdfEventQueue;
+
+  static constexpr std::chrono::milliseconds kNotPeriodic{-1};
+  static constexpr std::chrono::milliseconds kNoDeadline{-1};
+
+  std::chrono::milliseconds getRelativeDeadline() const;
+
+  EdfEventQueue *_queue;
+  mbed::Callback<void()> _cb;
+  std::chrono::milliseconds _delay = std::chrono::milliseconds::zero();
+  std::chrono::milliseconds _period = kNotPeriodic;
+  std::chrono::milliseconds _deadline = kNoDeadline;
+
+  // state of the pending invocation, protected by a critical section
+  Kernel::Clock::time_point _release;
+  Kernel::Clock::time_point _absoluteDeadline;
+  bool _isPending = false;
+  // false while the event is being dispatched
+  bool _isLinked = false;
+  EdfEvent *_next = nullptr;
+
+  uint32_t _nbrOfCompletions = 0;
+  uint32_t _nbrOfDeadlineMisses = 0;
+};
+
+class EdfEventQueue {
+public:
+  EdfEventQueue() = default;
+
+  // make the class non copyable
+  EdfEventQueue(EdfEventQueue &) = delete;
+  EdfEventQueue &operator=(EdfEventQueue &) = delete;
+
+  void dispatch_forever();
+  void dispatch_for(const std::chrono::milliseconds &duration);
+  void break_dispatch();
+
+  // sum over all events dispatched by this queue
+  uint32_t getNbrOfDeadlineMisses() const;
+
+private:
+  friend class EdfEvent;
+
+  void link(EdfEvent &event);
+  void unlink(EdfEvent &event);
+  void dispatchUntil(const Kernel::Clock::time_point &endTime);
+
+  // posted events, in no particular order
+  EdfEvent *_events = nullptr;
+  Semaphore _semaphore{0, 1};
+  volatile bool _breakDispatch = false;
+  volatile uint32_t _nbrOfDeadlineMisses = 0;
+};
+
+} // namespace bike_computer
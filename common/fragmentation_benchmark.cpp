@@ -0,0 +1,493 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file fragmentation_benchmark.cpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Allocation traces, allocators under test and trace replay
+ *
+ * @date 2024-06-10
+ * @version 1.0.0
+ ***************************************************************************/
+
+#include "fragmentation_benchmark.hpp"
+
+#include <cinttypes>
+#include <cstdlib>
+
+#include "cycle_counter.hpp"
+
+namespace bike_computer {
+
+// HeapAllocator
+
+void HeapAllocator::reset(uint8_t *arena, size_t size) {
+  _budget = size;
+  _allocatedSize = 0;
+}
+
+void *HeapAllocator::allocate(size_t size) {
+  if (_allocatedSize + size > _budget) {
+    return nullptr;
+  }
+  void *ptr = std::malloc(size);
+  if (ptr != nullptr) {
+    _allocatedSize += size;
+  }
+  return ptr;
+}
+
+void HeapAllocator::free(void *ptr, size_t size) {
+  std::free(ptr);
+  _allocatedSize -= size;
+}
+
+size_t HeapAllocator::getLargestFreeBlock() {
+  // binary search of the largest size malloc() succeeds with
+  size_t minSize = 0;
+  size_t maxSize = _budget - _allocatedSize;
+  while (minSize < maxSize) {
+    const size_t size = (minSize + maxSize + 1) / 2;
+    void *ptr = std::malloc(size);
+    if (ptr != nullptr) {
+      std::free(ptr);
+      minSize = size;
+    } else {
+      maxSize = size - 1;
+    }
+  }
+  return minSize;
+}
+
+// FirstFitAllocator
+
+constexpr size_t FirstFitAllocator::kMinChunkSize;
+
+void FirstFitAllocator::reset(uint8_t *arena, size_t size) {
+  _freeChunks = reinterpret_cast<Chunk *>(arena);
+  _freeChunks->size = size & ~(kAlignment - 1);
+  _freeChunks->next = nullptr;
+}
+
+void *FirstFitAllocator::allocate(size_t size) {
+  const size_t chunkSize = std::max(
+      (size + kHeaderSize + kAlignment - 1) & ~(kAlignment - 1), kMinChunkSize);
+  Chunk **link = &_freeChunks;
+  while (*link != nullptr && (*link)->size < chunkSize) {
+    link = &(*link)->next;
+  }
+  Chunk *chunk = *link;
+  if (chunk == nullptr) {
+    return nullptr;
+  }
+  if (chunk->size - chunkSize >= kMinChunkSize) {
+    // the rest of the chunk stays free, at the same place in the list
+    Chunk *rest =
+        reinterpret_cast<Chunk *>(reinterpret_cast<uint8_t *>(chunk) + chunkSize);
+    rest->size = chunk->size - chunkSize;
+    rest->next = chunk->next;
+    chunk->size = chunkSize;
+    *link = rest;
+  } else {
+    *link = chunk->next;
+  }
+  return reinterpret_cast<uint8_t *>(chunk) + kHeaderSize;
+}
+
+void FirstFitAllocator::free(void *ptr, size_t size) {
+  Chunk *chunk =
+      reinterpret_cast<Chunk *>(static_cast<uint8_t *>(ptr) - kHeaderSize);
+  Chunk *previous = nullptr;
+  Chunk *next = _freeChunks;
+  while (next != nullptr && next < chunk) {
+    previous = next;
+    next = next->next;
+  }
+  // merged with the adjacent free chunks
+  if (next != nullptr &&
+      reinterpret_cast<uint8_t *>(chunk) + chunk->size ==
+          reinterpret_cast<uint8_t *>(next)) {
+    chunk->size += next->size;
+    next = next->next;
+  }
+  chunk->next = next;
+  if (previous == nullptr) {
+    _freeChunks = chunk;
+  } else if (reinterpret_cast<uint8_t *>(previous) + previous->size ==
+             reinterpret_cast<uint8_t *>(chunk)) {
+    previous->size += chunk->size;
+    previous->next = next;
+  } else {
+    previous->next = chunk;
+  }
+}
+
+size_t FirstFitAllocator::getLargestFreeBlock() {
+  size_t largestChunkSize = 0;
+  for (Chunk *chunk = _freeChunks; chunk != nullptr; chunk = chunk->next) {
+    largestChunkSize = std::max(largestChunkSize, chunk->size);
+  }
+  return largestChunkSize > kHeaderSize ? largestChunkSize - kHeaderSize : 0;
+}
+
+// TlsfBenchmarkAllocator
+
+void TlsfBenchmarkAllocator::reset(uint8_t *arena, size_t size) {
+  _tlsfAllocator.init(arena, size);
+}
+
+void *TlsfBenchmarkAllocator::allocate(size_t size) {
+  return _tlsfAllocator.allocate(size);
+}
+
+void TlsfBenchmarkAllocator::free(void *ptr, size_t size) {
+  _tlsfAllocator.free(ptr);
+}
+
+size_t TlsfBenchmarkAllocator::getLargestFreeBlock() {
+  return _tlsfAllocator.getLargestFreeBlock();
+}
+
+// BlockPoolsAllocator
+
+void BlockPoolsAllocator::reset(uint8_t *arena, size_t size) {
+  // the same number of blocks in each pool
+  const size_t nbrOfBlocks =
+      size / (kSmallestBlockSize * ((1UL << kNbrOfPools) - 1));
+  uint8_t *start = arena;
+  for (uint8_t poolIndex = 0; poolIndex < kNbrOfPools; poolIndex++) {
+    const size_t blockSize = kSmallestBlockSize << poolIndex;
+    Pool &pool = _pools[poolIndex];
+    pool.start = start;
+    pool.end = pool.start + nbrOfBlocks * blockSize;
+    pool.freeBlocks = nullptr;
+    start = pool.end;
+    // the first block is at the head of the free list
+    for (uint8_t *block = pool.end; block > pool.start;) {
+      block -= blockSize;
+      FreeBlock *freeBlock = reinterpret_cast<FreeBlock *>(block);
+      freeBlock->next = pool.freeBlocks;
+      pool.freeBlocks = freeBlock;
+    }
+  }
+}
+
+void *BlockPoolsAllocator::allocate(size_t size) {
+  for (uint8_t poolIndex = 0; poolIndex < kNbrOfPools; poolIndex++) {
+    Pool &pool = _pools[poolIndex];
+    if ((kSmallestBlockSize << poolIndex) >= size &&
+        pool.freeBlocks != nullptr) {
+      FreeBlock *block = pool.freeBlocks;
+      pool.freeBlocks = block->next;
+      return block;
+    }
+  }
+  return nullptr;
+}
+
+void BlockPoolsAllocator::free(void *ptr, size_t size) {
+  uint8_t *block = static_cast<uint8_t *>(ptr);
+  for (Pool &pool : _pools) {
+    if (block >= pool.start && block < pool.end) {
+      FreeBlock *freeBlock = reinterpret_cast<FreeBlock *>(block);
+      freeBlock->next = pool.freeBlocks;
+      pool.freeBlocks = freeBlock;
+      return;
+    }
+  }
+}
+
+size_t BlockPoolsAllocator::getLargestFreeBlock() {
+  for (uint8_t poolIndex = kNbrOfPools; poolIndex > 0; poolIndex--) {
+    if (_pools[poolIndex - 1].freeBlocks != nullptr) {
+      return kSmallestBlockSize << (poolIndex - 1);
+    }
+  }
+  return 0;
+}
+
+// FragmentationBenchmark
+
+// space left by the MemoryFragmenter pattern
+static constexpr size_t kMarginSpace = 1024;
+static constexpr uint8_t kNbrOfFixedBlocks = 8;
+static constexpr size_t kRandomTraceLength = 1000;
+static constexpr uint32_t kRandomAllocationPercent = 60;
+static constexpr uint32_t kMinRandomSize = 8;
+static constexpr uint32_t kMaxRandomSize = 512;
+static constexpr size_t kBurstyTraceLength = 1000;
+static constexpr uint32_t kMinBurstLength = 8;
+static constexpr uint32_t kMaxBurstLength = 64;
+static constexpr uint32_t kPayloadSizes[] = {32, 64, 128, 256};
+// one payload in kLongLivedPeriod lives kLongLivedBursts more bursts
+static constexpr uint32_t kLongLivedPeriod = 8;
+static constexpr uint32_t kLongLivedBursts = 4;
+static constexpr uint32_t kSeed = 0x2024;
+
+// state of the slots while generating and replaying a trace, statically
+// allocated (replay() and makeTrace() are not reentrant)
+static bool isSlotAllocated[FragmentationBenchmark::kMaxNbrOfSlots];
+static uint32_t slotExpiries[FragmentationBenchmark::kMaxNbrOfSlots];
+static void *slotBlocks[FragmentationBenchmark::kMaxNbrOfSlots];
+static uint32_t slotSizes[FragmentationBenchmark::kMaxNbrOfSlots];
+
+// linear congruential generator, the same on the host and on target
+static uint32_t getRandom(uint32_t &state) {
+  state = state * 1664525U + 1013904223U;
+  return state >> 8;
+}
+
+const char *FragmentationBenchmark::getTraceName(Trace trace) {
+  switch (trace) {
+  case kFixedBlocks:
+    return "fixed blocks";
+  case kRandomSizes:
+    return "random sizes";
+  case kBurstyPayloads:
+    return "bursty payloads";
+  default:
+    return "unknown";
+  }
+}
+
+size_t FragmentationBenchmark::makeTrace(Trace trace, size_t budget,
+                                         Operation *operations,
+                                         size_t maxNbrOfOperations) {
+  size_t nbrOfOperations = 0;
+  auto add = [&](uint16_t slot, uint32_t size) {
+    if (nbrOfOperations < maxNbrOfOperations) {
+      operations[nbrOfOperations++] = {size, slot};
+      isSlotAllocated[slot] = (size > 0);
+    }
+  };
+  for (bool &isAllocated : isSlotAllocated) {
+    isAllocated = false;
+  }
+  uint32_t randomState = kSeed;
+
+  switch (trace) {
+  case kFixedBlocks: {
+    const uint32_t blockSize = static_cast<uint32_t>(
+        (budget > kMarginSpace ? budget - kMarginSpace : budget) /
+        kNbrOfFixedBlocks);
+    for (uint16_t slot = 0; slot < kNbrOfFixedBlocks; slot++) {
+      add(slot, blockSize);
+    }
+    for (uint16_t slot = 0; slot < kNbrOfFixedBlocks; slot += 2) {
+      add(slot, 0);
+    }
+    // fits in the freed size, but not in any of the freed blocks
+    add(0, blockSize + 8);
+    break;
+  }
+
+  case kRandomSizes: {
+    uint16_t nbrOfAllocatedSlots = 0;
+    while (nbrOfOperations < std::min(kRandomTraceLength, maxNbrOfOperations)) {
+      const uint32_t random = getRandom(randomState);
+      const bool isAllocation =
+          nbrOfAllocatedSlots == 0 ||
+          (nbrOfAllocatedSlots < kMaxNbrOfSlots &&
+           random % 100 < kRandomAllocationPercent);
+      // next slot in the expected state from a random slot
+      uint16_t slot = (random >> 8) % kMaxNbrOfSlots;
+      while (isSlotAllocated[slot] == isAllocation) {
+        slot = (slot + 1) % kMaxNbrOfSlots;
+      }
+      if (isAllocation) {
+        add(slot, kMinRandomSize + getRandom(randomState) %
+                                       (kMaxRandomSize - kMinRandomSize + 1));
+        nbrOfAllocatedSlots++;
+      } else {
+        add(slot, 0);
+        nbrOfAllocatedSlots--;
+      }
+    }
+    break;
+  }
+
+  case kBurstyPayloads: {
+    uint32_t nbrOfPayloads = 0;
+    uint16_t burstSlots[kMaxBurstLength] = {};
+    const size_t traceLength = std::min(kBurstyTraceLength, maxNbrOfOperations);
+    for (uint32_t burst = 0; nbrOfOperations < traceLength; burst++) {
+      const uint32_t burstLength =
+          kMinBurstLength +
+          getRandom(randomState) % (kMaxBurstLength - kMinBurstLength + 1);
+      uint32_t nbrOfBurstSlots = 0;
+      uint16_t slot = 0;
+      for (uint32_t index = 0; index < burstLength; index++) {
+        while (slot < kMaxNbrOfSlots && isSlotAllocated[slot]) {
+          slot++;
+        }
+        if (slot == kMaxNbrOfSlots) {
+          break;
+        }
+        slotExpiries[slot] = (nbrOfPayloads % kLongLivedPeriod == 0)
+                                 ? burst + kLongLivedBursts
+                                 : burst;
+        add(slot, kPayloadSizes[getRandom(randomState) %
+                                (sizeof(kPayloadSizes) / sizeof(uint32_t))]);
+        burstSlots[nbrOfBurstSlots++] = slot;
+        nbrOfPayloads++;
+      }
+      // the payloads of the burst are freed in order, then the long lived
+      // payloads of the previous bursts
+      for (uint32_t index = 0; index < nbrOfBurstSlots; index++) {
+        if (slotExpiries[burstSlots[index]] == burst) {
+          add(burstSlots[index], 0);
+        }
+      }
+      for (slot = 0; slot < kMaxNbrOfSlots; slot++) {
+        if (isSlotAllocated[slot] && slotExpiries[slot] == burst) {
+          add(slot, 0);
+        }
+      }
+    }
+    break;
+  }
+
+  default:
+    break;
+  }
+  return nbrOfOperations;
+}
+
+FragmentationBenchmark::Result
+FragmentationBenchmark::replay(const Operation *operations,
+                               size_t nbrOfOperations,
+                               BenchmarkAllocator &allocator) {
+  Result result = {};
+  result.failureIndex = -1;
+  for (uint16_t slot = 0; slot < kMaxNbrOfSlots; slot++) {
+    slotBlocks[slot] = nullptr;
+    slotSizes[slot] = 0;
+  }
+  uint32_t allocatedSize = 0;
+
+  for (size_t index = 0; index < nbrOfOperations; index++) {
+    const Operation &operation = operations[index];
+    void *&block = slotBlocks[operation.slot];
+    if (operation.size == 0) {
+      // the allocation of the slot may have failed
+      if (block == nullptr) {
+        continue;
+      }
+      const uint32_t startTime = CycleCounter::read();
+      allocator.free(block, slotSizes[operation.slot]);
+      result.maxFreeTime =
+          std::max(result.maxFreeTime, CycleCounter::read() - startTime);
+      allocatedSize -= slotSizes[operation.slot];
+      block = nullptr;
+      continue;
+    }
+
+    result.nbrOfAllocations++;
+    const uint32_t startTime = CycleCounter::read();
+    block = allocator.allocate(operation.size);
+    result.maxAllocTime =
+        std::max(result.maxAllocTime, CycleCounter::read() - startTime);
+    if (block == nullptr) {
+      if (result.nbrOfFailures == 0) {
+        result.failureIndex = static_cast<int32_t>(index);
+        result.allocatedSizeAtFailure = allocatedSize;
+      }
+      result.nbrOfFailures++;
+      continue;
+    }
+    slotSizes[operation.slot] = operation.size;
+    allocatedSize += operation.size;
+    result.maxAllocatedSize = std::max(result.maxAllocatedSize, allocatedSize);
+  }
+
+  result.largestFreeBlock =
+      static_cast<uint32_t>(allocator.getLargestFreeBlock());
+  for (uint16_t slot = 0; slot < kMaxNbrOfSlots; slot++) {
+    if (slotBlocks[slot] != nullptr) {
+      allocator.free(slotBlocks[slot], slotSizes[slot]);
+      slotBlocks[slot] = nullptr;
+    }
+  }
+  return result;
+}
+
+void FragmentationBenchmark::run() {
+  CycleCounter::enable();
+  for (uint8_t trace = 0; trace < kNbrOfTraces; trace++) {
+    const size_t nbrOfOperations =
+        makeTrace(static_cast<Trace>(trace), kArenaSize, _operations,
+                  kMaxNbrOfOperations);
+    for (uint8_t allocator = 0; allocator < kNbrOfAllocators; allocator++) {
+      BenchmarkAllocator &benchmarkAllocator =
+          getAllocator(static_cast<Allocator>(allocator));
+      benchmarkAllocator.reset(_arena, kArenaSize);
+      _results[trace][allocator] =
+          replay(_operations, nbrOfOperations, benchmarkAllocator);
+    }
+  }
+}
+
+const FragmentationBenchmark::Result &
+FragmentationBenchmark::getResult(Trace trace, Allocator allocator) const {
+  return _results[trace][allocator];
+}
+
+const char *FragmentationBenchmark::getAllocatorName(Allocator allocator) const {
+  switch (allocator) {
+  case kTlsfAllocator:
+    return _tlsfAllocator.getName();
+  case kBlockPools:
+    return _blockPoolsAllocator.getName();
+  default:
+    return _firstFitAllocator.getName();
+  }
+}
+
+void FragmentationBenchmark::printReport() const {
+  // no field widths, they are not supported by minimal-printf
+  printf("Fragmentation benchmark: arena of %" PRIu32 " bytes, times in %s\n",
+         static_cast<uint32_t>(kArenaSize), CycleCounter::getUnit());
+  for (uint8_t trace = 0; trace < kNbrOfTraces; trace++) {
+    for (uint8_t allocator = 0; allocator < kNbrOfAllocators; allocator++) {
+      const Result &result = _results[trace][allocator];
+      printf("%s / %s: %" PRIu32 " allocations, %" PRIu32 " failures",
+             getTraceName(static_cast<Trace>(trace)),
+             getAllocatorName(static_cast<Allocator>(allocator)),
+             result.nbrOfAllocations, result.nbrOfFailures);
+      if (result.failureIndex >= 0) {
+        printf(" (first at operation %" PRId32 " with %" PRIu32
+               " bytes allocated)",
+               result.failureIndex, result.allocatedSizeAtFailure);
+      }
+      printf(", peak %" PRIu32 " bytes, largest free block %" PRIu32
+             " bytes, max alloc %" PRIu32 ", max free %" PRIu32 "\n",
+             result.maxAllocatedSize, result.largestFreeBlock,
+             result.maxAllocTime, result.maxFreeTime);
+    }
+  }
+}
+
+BenchmarkAllocator &FragmentationBenchmark::getAllocator(Allocator allocator) {
+  switch (allocator) {
+  case kTlsfAllocator:
+    return _tlsfAllocator;
+  case kBlockPools:
+    return _blockPoolsAllocator;
+  default:
+    return _firstFitAllocator;
+  }
+}
+
+} // namespace bike_computer
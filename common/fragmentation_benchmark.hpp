@@ -0,0 +1,224 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file fragmentation_benchmark.hpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Replays allocation traces against several allocators
+ *
+ * A trace is a sequence of allocations and frees of numbered slots, scaled
+ * to a memory budget (the arena size):
+ * - kFixedBlocks: the pattern of the MemoryFragmenter, 8 blocks sharing the
+ *   budget are allocated, the even ones are freed and a slightly larger
+ *   block is allocated
+ * - kRandomSizes: allocations of 8 to 512 bytes and frees of random slots,
+ *   with more allocations than frees until the budget is exhausted
+ * - kBurstyPayloads: bursts of event payloads (32 to 256 bytes) freed at
+ *   the end of their burst, one in 8 living 4 bursts longer
+ * The traces are generated from a fixed seed and are the same on the host
+ * and on target.
+ *
+ * Each trace is replayed on an arena of the budget size against a first
+ * fit allocator (a model of the newlib malloc(), the default allocator on
+ * target: chunks with a size header in an address ordered free list,
+ * split on allocation and merged with their neighbours when freed), a TLSF
+ * allocator and fixed-size block pools (one pool per power of 2 from 32 to
+ * 512 bytes, each with the same number of blocks, a full pool falls back
+ * to the next one). The host malloc() cannot be limited to the budget, the
+ * HeapAllocator is only used on the mbed heap (MemoryFragmenter). The
+ * result gives
+ * the first failed allocation, the largest block that can be allocated at
+ * the end of the trace and the worst alloc / free times, in CPU cycles on
+ * target and in host nsecs in the host simulation (see CycleCounter).
+ *
+ * The benchmark runs in the host build (benchmark-fragmentation) and on
+ * target (the fragmentation test suite), which both print the same report.
+ *
+ * @date 2024-06-10
+ * @version 1.0.0
+ ***************************************************************************/
+
+#pragma once
+
+#include "mbed.h"
+#include "tlsf_allocator.hpp"
+
+namespace bike_computer {
+
+// allocator under test, the size of each block is given when freed
+class BenchmarkAllocator {
+public:
+  virtual ~BenchmarkAllocator() = default;
+
+  virtual const char *getName() const = 0;
+  // called before each trace, once the blocks of the previous trace are
+  // freed, the arena (of the budget size) may be used
+  virtual void reset(uint8_t *arena, size_t size) = 0;
+  virtual void *allocate(size_t size) = 0;
+  virtual void free(void *ptr, size_t size) = 0;
+  // largest size that can currently be allocated
+  virtual size_t getLargestFreeBlock() = 0;
+};
+
+// malloc() and free(), allocations above the budget fail, the budget must
+// be the free size of the heap (on the host, malloc() is not bounded and its
+// overhead is not counted)
+class HeapAllocator : public BenchmarkAllocator {
+public:
+  const char *getName() const override { return "default"; }
+  void reset(uint8_t *arena, size_t size) override;
+  void *allocate(size_t size) override;
+  void free(void *ptr, size_t size) override;
+  // binary search of the largest size malloc() succeeds with
+  size_t getLargestFreeBlock() override;
+
+private:
+  size_t _budget = 0;
+  size_t _allocatedSize = 0;
+};
+
+// first fit in an address ordered list of free chunks, on the arena
+class FirstFitAllocator : public BenchmarkAllocator {
+public:
+  const char *getName() const override { return "first fit"; }
+  void reset(uint8_t *arena, size_t size) override;
+  void *allocate(size_t size) override;
+  void free(void *ptr, size_t size) override;
+  size_t getLargestFreeBlock() override;
+
+private:
+  // the size (header included) is kept in the header of each chunk, next
+  // is only valid in free chunks
+  struct Chunk {
+    size_t size;
+    Chunk *next;
+  };
+  static constexpr size_t kAlignment = 8;
+  static constexpr size_t kHeaderSize =
+      (sizeof(size_t) + kAlignment - 1) & ~(kAlignment - 1);
+  static constexpr size_t kMinChunkSize =
+      (sizeof(Chunk) + kAlignment - 1) & ~(kAlignment - 1);
+
+  Chunk *_freeChunks = nullptr;
+};
+
+class TlsfBenchmarkAllocator : public BenchmarkAllocator {
+public:
+  const char *getName() const override { return "TLSF"; }
+  void reset(uint8_t *arena, size_t size) override;
+  void *allocate(size_t size) override;
+  void free(void *ptr, size_t size) override;
+  size_t getLargestFreeBlock() override;
+
+private:
+  TlsfAllocator _tlsfAllocator;
+};
+
+class BlockPoolsAllocator : public BenchmarkAllocator {
+public:
+  static constexpr uint8_t kNbrOfPools = 5;
+  static constexpr size_t kSmallestBlockSize = 32;
+
+  const char *getName() const override { return "block pools"; }
+  void reset(uint8_t *arena, size_t size) override;
+  void *allocate(size_t size) override;
+  void free(void *ptr, size_t size) override;
+  size_t getLargestFreeBlock() override;
+
+private:
+  struct FreeBlock {
+    FreeBlock *next;
+  };
+  struct Pool {
+    uint8_t *start;
+    uint8_t *end;
+    FreeBlock *freeBlocks;
+  };
+  Pool _pools[kNbrOfPools] = {};
+};
+
+class FragmentationBenchmark {
+public:
+  static constexpr size_t kArenaSize = 16384;
+  static constexpr uint16_t kMaxNbrOfSlots = 128;
+  static constexpr size_t kMaxNbrOfOperations = 1024;
+
+  enum Trace : uint8_t {
+    kFixedBlocks = 0,
+    kRandomSizes,
+    kBurstyPayloads,
+    kNbrOfTraces
+  };
+
+  enum Allocator : uint8_t {
+    kFirstFitAllocator = 0,
+    kTlsfAllocator,
+    kBlockPools,
+    kNbrOfAllocators
+  };
+
+  // allocation of size bytes in the slot, or free of the slot if size is 0
+  struct Operation {
+    uint32_t size;
+    uint16_t slot;
+  };
+
+  struct Result {
+    uint32_t nbrOfAllocations;
+    uint32_t nbrOfFailures;
+    // index of the first failed operation (-1 if none) and the requested
+    // bytes allocated at that point
+    int32_t failureIndex;
+    uint32_t allocatedSizeAtFailure;
+    uint32_t maxAllocatedSize;
+    // largest block that can be allocated at the end of the trace
+    uint32_t largestFreeBlock;
+    // CycleCounter counts
+    uint32_t maxAllocTime;
+    uint32_t maxFreeTime;
+  };
+
+  FragmentationBenchmark() = default;
+
+  // make the class non copyable
+  FragmentationBenchmark(FragmentationBenchmark &) = delete;
+  FragmentationBenchmark &operator=(FragmentationBenchmark &) = delete;
+
+  static const char *getTraceName(Trace trace);
+  // writes the operations of the trace for the budget, returns their number
+  static size_t makeTrace(Trace trace, size_t budget, Operation *operations,
+                          size_t maxNbrOfOperations);
+  // the blocks still allocated at the end of the trace are freed
+  static Result replay(const Operation *operations, size_t nbrOfOperations,
+                       BenchmarkAllocator &allocator);
+
+  // replays all traces against all allocators
+  void run();
+  const Result &getResult(Trace trace, Allocator allocator) const;
+  const char *getAllocatorName(Allocator allocator) const;
+  void printReport() const;
+
+private:
+  BenchmarkAllocator &getAllocator(Allocator allocator);
+
+  FirstFitAllocator _firstFitAllocator;
+  TlsfBenchmarkAllocator _tlsfAllocator;
+  BlockPoolsAllocator _blockPoolsAllocator;
+  Result _results[kNbrOfTraces][kNbrOfAllocators] = {};
+  Operation _operations[kMaxNbrOfOperations] = {};
+  alignas(8) uint8_t _arena[kArenaSize] = {};
+};
+
+} // namespace bike_computer
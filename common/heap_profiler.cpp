@@ -0,0 +1,325 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file heap_profiler.cpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Heap allocation profiler implementation (hash table of blocks)
+ *
+ * @date 2024-06-03
+ * @version 1.0.0
+ ***************************************************************************/
+
+#include "heap_profiler.hpp"
+
+#include <cinttypes>
+#include <cstdarg>
+#include <new>
+
+#include "mbed_mem_trace.h"
+
+namespace bike_computer {
+
+HeapProfiler &HeapProfiler::getInstance() {
+  // statically allocated (the table is part of the instance)
+  static HeapProfiler instance;
+  return instance;
+}
+
+void HeapProfiler::enable(bool enable) {
+  if (!enable) {
+    mbed_mem_trace_set_callback(nullptr);
+    core_util_atomic_store_bool(&_isEnabled, false);
+    return;
+  }
+  {
+    CriticalSectionLock lock;
+    _startTime = Kernel::Clock::now().time_since_epoch().count();
+    _nbrOfAllocations = 0;
+    _nbrOfFrees = 0;
+    _nbrOfBlocks = 0;
+    _size = 0;
+    _nbrOfUntrackedBlocks = 0;
+    for (Entry &entry : _entries) {
+      entry.ptr = 0;
+    }
+  }
+  core_util_atomic_store_bool(&_isEnabled, true);
+  mbed_mem_trace_set_callback(onMemoryTrace);
+}
+
+bool HeapProfiler::isEnabled() const {
+  return core_util_atomic_load_bool(&_isEnabled);
+}
+
+HeapProfiler::Snapshot HeapProfiler::takeSnapshot() const {
+  CriticalSectionLock lock;
+  return {_nbrOfAllocations, _nbrOfFrees, _nbrOfUntrackedBlocks,
+          _nbrOfBlocks, _size, getTimestamp()};
+}
+
+HeapProfiler::HeapDiff HeapProfiler::diff(const Snapshot &from,
+                                          const Snapshot &to) {
+  HeapDiff heapDiff = {};
+  heapDiff.sizeGrowth =
+      static_cast<int32_t>(to.size) - static_cast<int32_t>(from.size);
+  heapDiff.nbrOfBlocksGrowth = static_cast<int32_t>(to.nbrOfBlocks) -
+                               static_cast<int32_t>(from.nbrOfBlocks);
+  heapDiff.nbrOfAllocations = to.nbrOfAllocations - from.nbrOfAllocations;
+  heapDiff.nbrOfFrees = to.nbrOfFrees - from.nbrOfFrees;
+  heapDiff.nbrOfUntrackedAllocations =
+      to.nbrOfUntrackedAllocations - from.nbrOfUntrackedAllocations;
+  return heapDiff;
+}
+
+HeapProfiler::HeapDiff HeapProfiler::diffSince(const Snapshot &from) const {
+  CriticalSectionLock lock;
+  HeapDiff heapDiff = diff(from, takeSnapshot());
+  for (const Entry &entry : _entries) {
+    // the sequence numbers are compared with a subtraction, as they wrap
+    if (entry.ptr == 0 ||
+        static_cast<int32_t>(entry.sequence - from.nbrOfAllocations) < 0) {
+      continue;
+    }
+    size_t index = 0;
+    while (index < heapDiff.nbrOfCallSites &&
+           heapDiff.callSites[index].caller != entry.caller) {
+      index++;
+    }
+    if (index == heapDiff.nbrOfCallSites) {
+      if (index == kMaxNbrOfCallSites) {
+        heapDiff.nbrOfUnlistedBlocks++;
+        continue;
+      }
+      heapDiff.callSites[index] = {entry.caller, 0, 0};
+      heapDiff.nbrOfCallSites++;
+    }
+    heapDiff.callSites[index].nbrOfBlocks++;
+    heapDiff.callSites[index].size += entry.size;
+  }
+  // largest size first (insertion sort of a few call sites)
+  for (size_t index = 1; index < heapDiff.nbrOfCallSites; index++) {
+    const CallSite callSite = heapDiff.callSites[index];
+    size_t position = index;
+    while (position > 0 &&
+           heapDiff.callSites[position - 1].size < callSite.size) {
+      heapDiff.callSites[position] = heapDiff.callSites[position - 1];
+      position--;
+    }
+    heapDiff.callSites[position] = callSite;
+  }
+  return heapDiff;
+}
+
+void HeapProfiler::printDiff(const HeapDiff &heapDiff) {
+  printf("Heap growth: %" PRId32 " bytes in %" PRId32 " blocks (%" PRIu32
+         " allocations, %" PRIu32 " frees)\n",
+         heapDiff.sizeGrowth, heapDiff.nbrOfBlocksGrowth,
+         heapDiff.nbrOfAllocations, heapDiff.nbrOfFrees);
+  for (size_t index = 0; index < heapDiff.nbrOfCallSites; index++) {
+    const CallSite &callSite = heapDiff.callSites[index];
+    printf("  caller 0x%08" PRIxPTR ": %" PRIu32 " bytes in %" PRIu32
+           " blocks\n",
+           callSite.caller, callSite.size, callSite.nbrOfBlocks);
+  }
+  if (heapDiff.nbrOfUntrackedAllocations > 0) {
+    printf("  %" PRIu32 " allocations not tracked (table full)\n",
+           heapDiff.nbrOfUntrackedAllocations);
+  }
+  if (heapDiff.nbrOfUnlistedBlocks > 0) {
+    printf("  %" PRIu32 " blocks of other callers\n",
+           heapDiff.nbrOfUnlistedBlocks);
+  }
+}
+
+uint32_t HeapProfiler::getNbrOfUntrackedBlocks() const {
+  CriticalSectionLock lock;
+  return _nbrOfUntrackedBlocks;
+}
+
+void HeapProfiler::onAllocation(void *ptr, size_t size, void *caller) {
+  if (ptr == nullptr || !isEnabled()) {
+    return;
+  }
+  const uint32_t timestamp = getTimestamp();
+  CriticalSectionLock lock;
+  // every allocation gets a sequence number, tracked or not
+  const uint32_t sequence = _nbrOfAllocations++;
+  if (_nbrOfBlocks == kCapacity) {
+    _nbrOfUntrackedBlocks++;
+    return;
+  }
+  const uintptr_t address = reinterpret_cast<uintptr_t>(ptr);
+  uint32_t index = getHomeIndex(address);
+  while (_entries[index].ptr != 0) {
+    index = (index + 1) & (kCapacity - 1);
+  }
+  _entries[index] = {address, reinterpret_cast<uintptr_t>(caller),
+                     static_cast<uint32_t>(size), timestamp, sequence};
+  _nbrOfBlocks++;
+  _size += static_cast<uint32_t>(size);
+}
+
+void HeapProfiler::onFree(void *ptr) {
+  if (ptr == nullptr || !isEnabled()) {
+    return;
+  }
+  CriticalSectionLock lock;
+  const uint32_t index = find(reinterpret_cast<uintptr_t>(ptr));
+  if (index == kCapacity) {
+    // allocated before the profiler was enabled or not tracked
+    return;
+  }
+  _nbrOfFrees++;
+  _nbrOfBlocks--;
+  _size -= _entries[index].size;
+  remove(index);
+}
+
+void HeapProfiler::setCaller(void *ptr, void *caller) {
+  if (ptr == nullptr || !isEnabled()) {
+    return;
+  }
+  CriticalSectionLock lock;
+  const uint32_t index = find(reinterpret_cast<uintptr_t>(ptr));
+  if (index != kCapacity) {
+    _entries[index].caller = reinterpret_cast<uintptr_t>(caller);
+  }
+}
+
+void HeapProfiler::onMemoryTrace(uint8_t op, void *result, void *caller,
+                                 ...) {
+  HeapProfiler &heapProfiler = getInstance();
+  va_list arguments;
+  va_start(arguments, caller);
+  switch (op) {
+  case MBED_MEM_TRACE_MALLOC: {
+    const size_t size = va_arg(arguments, size_t);
+    heapProfiler.onAllocation(result, size, caller);
+    break;
+  }
+  case MBED_MEM_TRACE_REALLOC: {
+    void *ptr = va_arg(arguments, void *);
+    const size_t size = va_arg(arguments, size_t);
+    // the block is left untouched when realloc() fails
+    if (result != nullptr || size == 0) {
+      heapProfiler.onFree(ptr);
+      heapProfiler.onAllocation(result, size, caller);
+    }
+    break;
+  }
+  case MBED_MEM_TRACE_CALLOC: {
+    const size_t nbrOfMembers = va_arg(arguments, size_t);
+    const size_t size = va_arg(arguments, size_t);
+    heapProfiler.onAllocation(result, nbrOfMembers * size, caller);
+    break;
+  }
+  case MBED_MEM_TRACE_FREE:
+    heapProfiler.onFree(va_arg(arguments, void *));
+    break;
+  default:
+    break;
+  }
+  va_end(arguments);
+}
+
+uint32_t HeapProfiler::getHomeIndex(uintptr_t ptr) {
+  // the blocks are at least 8 bytes aligned (Fibonacci hashing)
+  return (static_cast<uint32_t>(ptr >> 3) * 2654435769U) & (kCapacity - 1);
+}
+
+uint32_t HeapProfiler::find(uintptr_t ptr) const {
+  uint32_t index = getHomeIndex(ptr);
+  for (uint32_t nbrOfProbes = 0; nbrOfProbes < kCapacity; nbrOfProbes++) {
+    if (_entries[index].ptr == ptr) {
+      return index;
+    }
+    if (_entries[index].ptr == 0) {
+      break;
+    }
+    index = (index + 1) & (kCapacity - 1);
+  }
+  return kCapacity;
+}
+
+void HeapProfiler::remove(uint32_t index) {
+  // backward shift deletion: the following entries of the probe sequence
+  // are moved into the hole unless their home index is after the hole
+  uint32_t next = index;
+  while (true) {
+    next = (next + 1) & (kCapacity - 1);
+    if (_entries[next].ptr == 0 || next == index) {
+      break;
+    }
+    const uint32_t home = getHomeIndex(_entries[next].ptr);
+    const uint32_t distanceToHole = (index - home) & (kCapacity - 1);
+    const uint32_t distanceToNext = (next - home) & (kCapacity - 1);
+    if (distanceToHole < distanceToNext) {
+      _entries[index] = _entries[next];
+      index = next;
+    }
+  }
+  _entries[index].ptr = 0;
+}
+
+uint32_t HeapProfiler::getTimestamp() const {
+  return static_cast<uint32_t>(Kernel::Clock::now().time_since_epoch().count() -
+                               _startTime);
+}
+
+} // namespace bike_computer
+
+#if MBED_MEM_TRACING_ENABLED
+// the blocks of new are reported by malloc() with operator new as caller,
+// they are given the caller of new (the host simulation replaces these
+// operators in mbed_shim.cpp, where memory tracing is not configured)
+static void *allocate(size_t size, void *caller) {
+  void *ptr = malloc(size);
+  if (ptr == nullptr) {
+    MBED_ERROR1(MBED_MAKE_ERROR(MBED_MODULE_PLATFORM,
+                                MBED_ERROR_CODE_OUT_OF_MEMORY),
+                "Operator new out of memory\r\n", size);
+  }
+  bike_computer::HeapProfiler::getInstance().setCaller(ptr, caller);
+  return ptr;
+}
+
+static void *allocate(size_t size, const std::nothrow_t &, void *caller) {
+  void *ptr = malloc(size);
+  bike_computer::HeapProfiler::getInstance().setCaller(ptr, caller);
+  return ptr;
+}
+
+void *operator new(std::size_t size) {
+  return allocate(size, MBED_CALLER_ADDR());
+}
+
+void *operator new[](std::size_t size) {
+  return allocate(size, MBED_CALLER_ADDR());
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &nothrow) {
+  return allocate(size, nothrow, MBED_CALLER_ADDR());
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &nothrow) {
+  return allocate(size, nothrow, MBED_CALLER_ADDR());
+}
+
+// the blocks are removed from the table by the trace of free()
+void operator delete(void *ptr) { free(ptr); }
+
+void operator delete[](void *ptr) { free(ptr); }
+#endif // MBED_MEM_TRACING_ENABLED
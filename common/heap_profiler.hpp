@@ -0,0 +1,172 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file heap_profiler.hpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Heap allocation profiler with call-site attribution
+ *
+ * Once enabled, the profiler receives the malloc / realloc / calloc / free
+ * calls through the mbed memory tracing callback ("platform.memory-tracing-
+ * enabled" in mbed_app.json) and keeps each allocated block (address,
+ * caller address, size, timestamp and sequence number) in a statically
+ * allocated hash table of "heap-profiler-capacity" entries. The blocks
+ * allocated while the table is full are counted (in the allocations and
+ * separately as untracked allocations) but not tracked, their size and their
+ * frees are missing from the heap growth.
+ *
+ * Memory tracing adds a callback to each allocation, it is only enabled by
+ * the profiles/heap_profiler.json build profile (MBED_MEM_TRACING_ENABLED),
+ * without it the profiler sees no allocation on target.
+ *
+ * A snapshot records the heap state at a point of the program, two
+ * snapshots give the net heap growth between these points:
+ *
+ *   const HeapProfiler::Snapshot before = heapProfiler.takeSnapshot();
+ *   ...
+ *   const HeapProfiler::HeapDiff diff = heapProfiler.diffSince(before);
+ *   TEST_ASSERT_EQUAL_INT32(0, diff.sizeGrowth);
+ *
+ * and the diff with the current state also lists, by call site, the blocks
+ * allocated since the first snapshot that are still allocated (the leak
+ * candidates).
+ *
+ * On target, new and delete call malloc() and free(), whose trace gives
+ * operator new as caller. When memory tracing is enabled, heap_profiler.cpp
+ * replaces the global operators new, which give their blocks the address of
+ * the code calling new (setCaller()). In the host simulation, new and delete
+ * are attributed to their caller by the simulated heap.
+ *
+ * @date 2024-06-03
+ * @version 1.0.0
+ ***************************************************************************/
+
+#pragma once
+
+#include "mbed.h"
+
+#if !defined(MBED_CONF_APP_HEAP_PROFILER_CAPACITY)
+#define MBED_CONF_APP_HEAP_PROFILER_CAPACITY 128
+#endif
+
+namespace bike_computer {
+
+class HeapProfiler {
+public:
+  static constexpr uint32_t kCapacity = MBED_CONF_APP_HEAP_PROFILER_CAPACITY;
+  static_assert((kCapacity & (kCapacity - 1)) == 0 && kCapacity > 0,
+                "heap-profiler-capacity must be a power of 2");
+  static constexpr size_t kMaxNbrOfCallSites = 8;
+
+  // heap state at a point of the program (the blocks and size are those of
+  // the tracked blocks)
+  struct Snapshot {
+    // allocations (tracked or not) and frees of tracked blocks since the
+    // profiler was enabled, the number of allocations is also the sequence
+    // number of the next allocation
+    uint32_t nbrOfAllocations;
+    uint32_t nbrOfFrees;
+    // allocations made while the table was full
+    uint32_t nbrOfUntrackedAllocations;
+    uint32_t nbrOfBlocks;
+    uint32_t size;
+    // msecs since the profiler was enabled
+    uint32_t timestamp;
+  };
+
+  // blocks allocated by the same caller
+  struct CallSite {
+    uintptr_t caller;
+    uint32_t nbrOfBlocks;
+    uint32_t size;
+  };
+
+  struct HeapDiff {
+    int32_t sizeGrowth;
+    int32_t nbrOfBlocksGrowth;
+    uint32_t nbrOfAllocations;
+    uint32_t nbrOfFrees;
+    uint32_t nbrOfUntrackedAllocations;
+    // blocks allocated after the first snapshot and still allocated, by
+    // call site (largest size first), only filled by diffSince()
+    size_t nbrOfCallSites;
+    CallSite callSites[kMaxNbrOfCallSites];
+    // blocks of the call sites that did not fit in the list
+    uint32_t nbrOfUnlistedBlocks;
+  };
+
+  static HeapProfiler &getInstance();
+
+  // make the class non copyable
+  HeapProfiler(HeapProfiler &) = delete;
+  HeapProfiler &operator=(HeapProfiler &) = delete;
+
+  // enabling the profiler clears the table and installs the memory tracing
+  // callback, the blocks allocated before are ignored when freed
+  void enable(bool enable);
+  bool isEnabled() const;
+
+  Snapshot takeSnapshot() const;
+  // net heap growth between two snapshots
+  static HeapDiff diff(const Snapshot &from, const Snapshot &to);
+  // net heap growth since the snapshot and the blocks allocated since then
+  // that are still allocated, by call site
+  HeapDiff diffSince(const Snapshot &from) const;
+  static void printDiff(const HeapDiff &heapDiff);
+
+  // blocks allocated while the table was full
+  uint32_t getNbrOfUntrackedBlocks() const;
+
+  // called by the memory tracing callback, may also be called by custom
+  // allocators
+  void onAllocation(void *ptr, size_t size, void *caller);
+  void onFree(void *ptr);
+  // gives a tracked block another caller, called by operator new once the
+  // block is reported by malloc() (an untracked block is not counted again)
+  void setCaller(void *ptr, void *caller);
+
+private:
+  HeapProfiler() = default;
+
+  static void onMemoryTrace(uint8_t op, void *result, void *caller, ...);
+
+  struct Entry {
+    // 0 for free entries
+    uintptr_t ptr;
+    uintptr_t caller;
+    uint32_t size;
+    uint32_t timestamp;
+    uint32_t sequence;
+  };
+
+  static uint32_t getHomeIndex(uintptr_t ptr);
+  // index of the entry of the block, kCapacity if not tracked
+  uint32_t find(uintptr_t ptr) const;
+  void remove(uint32_t index);
+  uint32_t getTimestamp() const;
+
+  volatile bool _isEnabled = false;
+  // Kernel::Clock time when the profiler was enabled
+  uint64_t _startTime = 0;
+  uint32_t _nbrOfAllocations = 0;
+  uint32_t _nbrOfFrees = 0;
+  uint32_t _nbrOfBlocks = 0;
+  uint32_t _size = 0;
+  uint32_t _nbrOfUntrackedBlocks = 0;
+  // open addressing with linear probing
+  Entry _entries[kCapacity] = {};
+};
+
+} // namespace bike_computer
@@ -0,0 +1,101 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file incremental_display.cpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Incremental display layer implementation
+ *
+ * @date 2024-02-26
+ * @version 1.0.0
+ ***************************************************************************/
+
+#include "incremental_display.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+namespace bike_computer {
+
+IncrementalDisplay::IncrementalDisplay(advembsof::DisplayDevice &displayDevice)
+    : _displayDevice(displayDevice) {}
+
+void IncrementalDisplay::displayGear(uint8_t gear) {
+  if (update(kGearField, gear, "Gear: %.0f")) {
+    _displayDevice.displayGear(gear);
+  }
+}
+
+void IncrementalDisplay::displaySpeed(float speed) {
+  if (update(kSpeedField, speed, "Speed: %.2f km/h")) {
+    _displayDevice.displaySpeed(speed);
+  }
+}
+
+void IncrementalDisplay::displayDistance(float distance) {
+  if (update(kDistanceField, distance, "Distance: %.2f km")) {
+    _displayDevice.displayDistance(distance);
+  }
+}
+
+void IncrementalDisplay::displayTemperature(float temperature) {
+  if (update(kTemperatureField, temperature, "Temperature: %.2f C")) {
+    _displayDevice.displayTemperature(temperature);
+  }
+}
+
+void IncrementalDisplay::invalidate() {
+  for (FieldState &field : _fields) {
+    field.isValid = false;
+  }
+}
+
+uint32_t IncrementalDisplay::getNbrOfRedraws(Field field) const {
+  return _fields[field].nbrOfRedraws;
+}
+
+uint32_t IncrementalDisplay::getNbrOfSkips(Field field) const {
+  return _fields[field].nbrOfSkips;
+}
+
+void IncrementalDisplay::resetCounters() {
+  for (FieldState &field : _fields) {
+    field.nbrOfRedraws = 0;
+    field.nbrOfSkips = 0;
+  }
+}
+
+bool IncrementalDisplay::update(Field field, float value, const char *format) {
+  FieldState &state = _fields[field];
+  // same value, no need to format it
+  if (state.isValid && std::memcmp(&state.value, &value, sizeof(value)) == 0) {
+    state.nbrOfSkips++;
+    return false;
+  }
+  state.value = value;
+
+  char text[kMaxTextLength];
+  snprintf(text, sizeof(text), format, static_cast<double>(value));
+  if (state.isValid && std::strcmp(state.text, text) == 0) {
+    state.nbrOfSkips++;
+    return false;
+  }
+  std::memcpy(state.text, text, sizeof(text));
+  state.isValid = true;
+  state.nbrOfRedraws++;
+  return true;
+}
+
+} // namespace bike_computer
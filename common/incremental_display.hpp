@@ -0,0 +1,90 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file incremental_display.hpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Display layer redrawing only the fields whose text changed
+ *
+ * The layer remembers, for each field of the advembsof::DisplayDevice, the
+ * last displayed value and the text it was rendered to. A field with the
+ * same value is skipped without formatting, a field with a new value is
+ * formatted (with the same format as the DisplayDevice, 2 decimals) and is
+ * only sent to the LCD if its text changed. On a steady ride, most display
+ * periods therefore redraw at most the distance.
+ *
+ * The number of redraws and of skips is counted for each field. All methods
+ * must be called from the display task only.
+ *
+ * @date 2024-02-26
+ * @version 1.0.0
+ ***************************************************************************/
+
+#pragma once
+
+#include "display_device.hpp"
+#include "mbed.h"
+
+namespace bike_computer {
+
+class IncrementalDisplay {
+public:
+  enum Field {
+    kGearField = 0,
+    kSpeedField,
+    kDistanceField,
+    kTemperatureField,
+    kNbrOfFields
+  };
+
+  explicit IncrementalDisplay(
+      advembsof::DisplayDevice &displayDevice); // NOLINT(runtime/references)
+
+  // make the class non copyable
+  IncrementalDisplay(IncrementalDisplay &) = delete;
+  IncrementalDisplay &operator=(IncrementalDisplay &) = delete;
+
+  void displayGear(uint8_t gear);
+  void displaySpeed(float speed);
+  void displayDistance(float distance);
+  void displayTemperature(float temperature);
+
+  // force the next update of each field to be redrawn (e.g. after the
+  // display was initialized or cleared)
+  void invalidate();
+
+  uint32_t getNbrOfRedraws(Field field) const;
+  uint32_t getNbrOfSkips(Field field) const;
+  void resetCounters();
+
+private:
+  static constexpr uint8_t kMaxTextLength = 32;
+
+  struct FieldState {
+    bool isValid;
+    float value;
+    char text[kMaxTextLength];
+    uint32_t nbrOfRedraws;
+    uint32_t nbrOfSkips;
+  };
+
+  // true if the field must be redrawn with the given value
+  bool update(Field field, float value, const char *format);
+
+  advembsof::DisplayDevice &_displayDevice;
+  FieldState _fields[kNbrOfFields] = {};
+};
+
+} // namespace bike_computer
@@ -0,0 +1,115 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file latency_histogram.cpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Log-bucketed histogram implementation
+ *
+ * @date 2024-02-19
+ * @version 1.0.0
+ ***************************************************************************/
+
+#include "latency_histogram.hpp"
+
+#include <cstring>
+
+namespace bike_computer {
+
+void LatencyHistogram::record(const std::chrono::microseconds &value) {
+  uint32_t valueUs = 0;
+  if (value.count() > 0) {
+    valueUs = value.count() > kMaxValue ? kMaxValue
+                                        : static_cast<uint32_t>(value.count());
+  }
+  _buckets[getBucketIndex(valueUs)]++;
+  _count++;
+  if (valueUs < _min) {
+    _min = valueUs;
+  }
+  if (valueUs > _max) {
+    _max = valueUs;
+  }
+}
+
+void LatencyHistogram::reset() {
+  _count = 0;
+  _min = UINT32_MAX;
+  _max = 0;
+  std::memset(_buckets, 0, sizeof(_buckets));
+}
+
+std::chrono::microseconds LatencyHistogram::getMin() const {
+  return std::chrono::microseconds(_count == 0 ? 0 : _min);
+}
+
+std::chrono::microseconds LatencyHistogram::getMax() const {
+  return std::chrono::microseconds(_max);
+}
+
+std::chrono::microseconds
+LatencyHistogram::getPercentile(float percentile) const {
+  if (_count == 0) {
+    return std::chrono::microseconds::zero();
+  }
+  // rank of the value, between 1 and _count, computed with integers from the
+  // percentile in 1/1000 % for being exact (e.g. 99.9f is not)
+  const uint64_t percentileMilli =
+      static_cast<uint64_t>(std::lround(percentile * 1000.0f));
+  uint64_t rank = (percentileMilli * _count + 100000 - 1) / 100000;
+  if (rank < 1) {
+    rank = 1;
+  } else if (rank > _count) {
+    rank = _count;
+  }
+  uint32_t cumulativeCount = 0;
+  for (uint32_t bucketIndex = 0; bucketIndex < kNbrOfBuckets; bucketIndex++) {
+    cumulativeCount += _buckets[bucketIndex];
+    if (cumulativeCount >= rank) {
+      uint32_t value = getBucketUpperBound(bucketIndex);
+      if (value > _max) {
+        value = _max;
+      }
+      if (value < _min) {
+        value = _min;
+      }
+      return std::chrono::microseconds(value);
+    }
+  }
+  return getMax();
+}
+
+uint32_t LatencyHistogram::getBucketIndex(uint32_t value) {
+  if (value < 2 * kNbrOfSubBuckets) {
+    return value;
+  }
+  // value has its most significant bit at msb >= kSubBucketBits + 1, the
+  // kSubBucketBits bits below it select the sub-bucket
+  const uint32_t msb = 31 - __builtin_clz(value);
+  const uint32_t shift = msb - kSubBucketBits;
+  return (shift + 1) * kNbrOfSubBuckets +
+         ((value >> shift) & (kNbrOfSubBuckets - 1));
+}
+
+uint32_t LatencyHistogram::getBucketUpperBound(uint32_t bucketIndex) {
+  if (bucketIndex < 2 * kNbrOfSubBuckets) {
+    return bucketIndex;
+  }
+  const uint32_t shift = bucketIndex / kNbrOfSubBuckets - 1;
+  const uint32_t subBucket = bucketIndex % kNbrOfSubBuckets;
+  return ((kNbrOfSubBuckets + subBucket + 1) << shift) - 1;
+}
+
+} // namespace bike_computer
@@ -0,0 +1,73 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file latency_histogram.hpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Log-bucketed histogram of durations in usecs
+ *
+ * Values below 16 usecs have their own bucket, larger values are stored in
+ * 8 linear sub-buckets per power of 2 (at most 12.5% relative error), up to
+ * kMaxValue (about 16.7 secs, larger values are counted in the last bucket).
+ * Recording a value is O(1) (one count leading zeros) without allocation,
+ * and the minimum, maximum and count are exact.
+ *
+ * record() must be called from a single thread or ISR, the getters are meant
+ * to be called once recording is over (e.g. in tests).
+ *
+ * @date 2024-02-19
+ * @version 1.0.0
+ ***************************************************************************/
+
+#pragma once
+
+#include <chrono>
+
+#include "mbed.h"
+
+namespace bike_computer {
+
+class LatencyHistogram {
+public:
+  static constexpr uint8_t kSubBucketBits = 3;
+  static constexpr uint32_t kNbrOfSubBuckets = 1UL << kSubBucketBits;
+  static constexpr uint8_t kMaxValueBits = 24;
+  static constexpr uint32_t kMaxValue = (1UL << kMaxValueBits) - 1;
+  static constexpr uint32_t kNbrOfBuckets =
+      (kMaxValueBits - kSubBucketBits + 1) * kNbrOfSubBuckets;
+
+  LatencyHistogram() = default;
+
+  void record(const std::chrono::microseconds &value);
+  void reset();
+
+  uint32_t getCount() const { return _count; }
+  std::chrono::microseconds getMin() const;
+  std::chrono::microseconds getMax() const;
+  // upper bound of the bucket containing the given percentile (e.g. 99.9f),
+  // clamped to the exact minimum and maximum
+  std::chrono::microseconds getPercentile(float percentile) const;
+
+  static uint32_t getBucketIndex(uint32_t value);
+  static uint32_t getBucketUpperBound(uint32_t bucketIndex);
+
+private:
+  uint32_t _count = 0;
+  uint32_t _min = UINT32_MAX;
+  uint32_t _max = 0;
+  uint32_t _buckets[kNbrOfBuckets] = {};
+};
+
+} // namespace bike_computer
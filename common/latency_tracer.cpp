@@ -0,0 +1,130 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file latency_tracer.cpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief End-to-end latency tracer implementation
+ *
+ * @date 2024-04-29
+ * @version 1.0.0
+ ***************************************************************************/
+
+#include "latency_tracer.hpp"
+
+#include <cstring>
+
+namespace bike_computer {
+
+LatencyTracer &LatencyTracer::getInstance() {
+  static LatencyTracer instance;
+  return instance;
+}
+
+void LatencyTracer::enable(bool enable) {
+  if (enable) {
+    core_util_atomic_store_bool(&_isEnabled, false);
+    for (uint8_t chain = 0; chain < kNbrOfChains; chain++) {
+      for (Trace &trace : _traces[chain]) {
+        core_util_atomic_store_u32(&trace.traceId, kNoTrace);
+      }
+      ChainStatistics &statistics = _statistics[chain];
+      for (LatencyHistogram &histogram : statistics.stageLatency) {
+        histogram.reset();
+      }
+      statistics.endToEndLatency.reset();
+      statistics.nbrOfCompletedTraces = 0;
+      statistics.nbrOfSupersededTraces = 0;
+      statistics.nbrOfIncompleteTraces = 0;
+    }
+    _timer.reset();
+    _timer.start();
+  }
+  core_util_atomic_store_bool(&_isEnabled, enable);
+}
+
+uint32_t LatencyTracer::begin(Chain chain) {
+  if (!core_util_atomic_load_bool(&_isEnabled) || chain >= kNbrOfChains) {
+    return kNoTrace;
+  }
+  uint32_t traceId = core_util_atomic_incr_u32(&_lastTraceId[chain], 1);
+  if (traceId == kNoTrace) {
+    traceId = core_util_atomic_incr_u32(&_lastTraceId[chain], 1);
+  }
+
+  Trace &trace = _traces[chain][traceId & (kMaxNbrOfPendingTraces - 1)];
+  if (core_util_atomic_exchange_u32(&trace.traceId, kNoTrace) != kNoTrace) {
+    core_util_atomic_incr_u32(&_statistics[chain].nbrOfSupersededTraces, 1);
+  }
+  std::memset(trace.stageTime, 0, sizeof(trace.stageTime));
+  trace.stageTime[kInterruptStage] = now();
+  core_util_atomic_store_u32(&trace.traceId, traceId);
+  return traceId;
+}
+
+void LatencyTracer::mark(Chain chain, uint32_t traceId, Stage stage) {
+  if (traceId == kNoTrace || chain >= kNbrOfChains || stage >= kNbrOfStages) {
+    return;
+  }
+  Trace &trace = _traces[chain][traceId & (kMaxNbrOfPendingTraces - 1)];
+  if (core_util_atomic_load_u32(&trace.traceId) == traceId) {
+    trace.stageTime[stage] = now();
+  }
+}
+
+bool LatencyTracer::complete(Chain chain, uint32_t traceId) {
+  if (traceId == kNoTrace || chain >= kNbrOfChains) {
+    return false;
+  }
+  Trace &trace = _traces[chain][traceId & (kMaxNbrOfPendingTraces - 1)];
+  uint64_t stageTime[kNbrOfStages];
+  std::memcpy(stageTime, trace.stageTime, sizeof(stageTime));
+  stageTime[kDisplayStage] = now();
+  // the trace is released once, unless a newer trace took its place while
+  // its timestamps were copied
+  uint32_t expectedTraceId = traceId;
+  if (!core_util_atomic_cas_u32(&trace.traceId, &expectedTraceId,
+                                kNoTrace)) {
+    return false;
+  }
+
+  ChainStatistics &statistics = _statistics[chain];
+  for (uint8_t stage = 0; stage < kNbrOfStages; stage++) {
+    if (stageTime[stage] == 0) {
+      statistics.nbrOfIncompleteTraces++;
+      return true;
+    }
+  }
+  for (uint8_t stage = kInterruptStage + 1; stage < kNbrOfStages; stage++) {
+    statistics.stageLatency[stage].record(
+        std::chrono::microseconds(stageTime[stage] - stageTime[stage - 1]));
+  }
+  statistics.endToEndLatency.record(std::chrono::microseconds(
+      stageTime[kDisplayStage] - stageTime[kInterruptStage]));
+  statistics.nbrOfCompletedTraces++;
+  return true;
+}
+
+const LatencyTracer::ChainStatistics &
+LatencyTracer::getChainStatistics(Chain chain) const {
+  return _statistics[chain];
+}
+
+uint64_t LatencyTracer::now() {
+  // 0 is kept for stages that were not reached
+  return static_cast<uint64_t>(_timer.elapsed_time().count()) + 1;
+}
+
+} // namespace bike_computer
@@ -0,0 +1,110 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file latency_tracer.hpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief End-to-end latency tracer, from an input interrupt to the display
+ *
+ * A chain of processing stages (e.g. joystick ISR, event dispatch, state
+ * update, display) is traced with a causal trace id. The id is created in
+ * the ISR with begin(), carried with the data through the event queues and
+ * the shared state, and each stage timestamps it with mark(). complete()
+ * timestamps the last stage and records the latency of each stage (from
+ * the previous stage) and the end-to-end latency in histograms.
+ *
+ * A few traces per chain may be in flight, a trace that is overwritten by a
+ * newer one before completing (e.g. coalesced gear events) is counted as
+ * superseded. begin() and mark() may be called from ISRs and threads,
+ * complete() must be called from a single thread per chain.
+ *
+ * @date 2024-04-29
+ * @version 1.0.0
+ ***************************************************************************/
+
+#pragma once
+
+#include <chrono>
+
+#include "latency_histogram.hpp"
+#include "mbed.h"
+
+namespace bike_computer {
+
+class LatencyTracer {
+public:
+  enum Chain : uint8_t { kGearChain = 0, kResetChain, kNbrOfChains };
+  enum Stage : uint8_t {
+    kInterruptStage = 0,
+    kDispatchStage,
+    kUpdateStage,
+    kDisplayStage,
+    kNbrOfStages
+  };
+
+  // trace id given when the tracer is disabled, ignored by all methods
+  static constexpr uint32_t kNoTrace = 0;
+  static constexpr uint32_t kMaxNbrOfPendingTraces = 4;
+  static_assert((kMaxNbrOfPendingTraces & (kMaxNbrOfPendingTraces - 1)) == 0,
+                "kMaxNbrOfPendingTraces must be a power of 2");
+
+  struct ChainStatistics {
+    // latency of each stage from the previous one (none for the interrupt)
+    LatencyHistogram stageLatency[kNbrOfStages];
+    LatencyHistogram endToEndLatency;
+    uint32_t nbrOfCompletedTraces = 0;
+    uint32_t nbrOfSupersededTraces = 0;
+    // traces completed with a missing stage, not recorded
+    uint32_t nbrOfIncompleteTraces = 0;
+  };
+
+  static LatencyTracer &getInstance();
+
+  // make the class non copyable
+  LatencyTracer(LatencyTracer &) = delete;
+  LatencyTracer &operator=(LatencyTracer &) = delete;
+
+  // enabling the tracer clears all traces and statistics
+  void enable(bool enable);
+
+  // start a trace at the interrupt stage, returns its id
+  uint32_t begin(Chain chain);
+  // timestamp an intermediate stage of a pending trace
+  void mark(Chain chain, uint32_t traceId, Stage stage);
+  // timestamp the display stage and record the latencies, returns false if
+  // the trace is no longer pending (already completed or superseded)
+  bool complete(Chain chain, uint32_t traceId);
+
+  const ChainStatistics &getChainStatistics(Chain chain) const;
+
+private:
+  LatencyTracer() = default;
+
+  struct Trace {
+    volatile uint32_t traceId;
+    // timestamps in usecs + 1, 0 for stages not reached yet
+    uint64_t stageTime[kNbrOfStages];
+  };
+
+  uint64_t now();
+
+  volatile bool _isEnabled = false;
+  Timer _timer;
+  volatile uint32_t _lastTraceId[kNbrOfChains] = {};
+  Trace _traces[kNbrOfChains][kMaxNbrOfPendingTraces] = {};
+  ChainStatistics _statistics[kNbrOfChains];
+};
+
+} // namespace bike_computer
@@ -0,0 +1,69 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file log_drain.cpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Asynchronous drain of the log records implementation
+ *
+ * @date 2024-05-27
+ * @version 1.0.0
+ ***************************************************************************/
+
+#include "log_drain.hpp"
+
+#include "deferred_log.hpp"
+#include "task_tracer.hpp"
+#include "trace_point.hpp"
+
+namespace bike_computer {
+
+constexpr std::chrono::milliseconds LogDrain::kDrainPeriod;
+
+LogDrain::LogDrain(unsigned char *stackMemory, uint32_t stackSize)
+    : _thread(kPriority, stackSize, stackMemory, "logDrain") {}
+
+osStatus LogDrain::start(mbed::FileHandle &fileHandle) {
+  _fileHandle = &fileHandle;
+  return _thread.start(callback(this, &LogDrain::run));
+}
+
+void LogDrain::notify() { _eventFlags.set(kNotifyFlag); }
+
+void LogDrain::stop() {
+  core_util_atomic_store_bool(&_stopFlag, true);
+  notify();
+  _thread.join();
+}
+
+void LogDrain::flush(mbed::FileHandle &fileHandle) {
+  TaskTracer::getInstance().drainTo(fileHandle);
+  TracePoints::getInstance().drainTo(fileHandle);
+  DeferredLog::getInstance().drainTo(fileHandle);
+  core_util_atomic_incr_u32(&_nbrOfDrains, 1);
+}
+
+uint32_t LogDrain::getNbrOfDrains() const {
+  return core_util_atomic_load_u32(&_nbrOfDrains);
+}
+
+void LogDrain::run() {
+  while (!core_util_atomic_load_bool(&_stopFlag)) {
+    _eventFlags.wait_any_for(kNotifyFlag, kDrainPeriod);
+    flush(*_fileHandle);
+  }
+}
+
+} // namespace bike_computer
@@ -0,0 +1,93 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file log_drain.hpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Asynchronous drain of the deferred log, trace point and task tracer
+ *        records
+ *
+ * The tasks only copy their records into the lock-free ring buffers of the
+ * DeferredLog, TracePoints and TaskTracer, which never block. The LogDrain
+ * thread runs at the lowest application priority (osPriorityLow) and writes
+ * the pending records to the serial port every "log-drain-period-ms" (see
+ * mbed_app.json), or earlier when notified. The serial output, which may
+ * block until the bytes are sent, is then never part of the response time
+ * of a task.
+ *
+ * The records are not drained from the idle hook: the idle thread must not
+ * block, which writing to the buffered serial port may do.
+ *
+ * @date 2024-05-27
+ * @version 1.0.0
+ ***************************************************************************/
+
+#pragma once
+
+#include <chrono>
+
+#include "mbed.h"
+
+#if !defined(MBED_CONF_APP_LOG_DRAIN_PERIOD_MS)
+#define MBED_CONF_APP_LOG_DRAIN_PERIOD_MS 100
+#endif
+
+namespace bike_computer {
+
+class LogDrain {
+public:
+  static constexpr std::chrono::milliseconds kDrainPeriod =
+      std::chrono::milliseconds(MBED_CONF_APP_LOG_DRAIN_PERIOD_MS);
+  static constexpr osPriority kPriority = osPriorityLow;
+  static constexpr uint32_t kStackSize = 1024;
+
+  // the stack is allocated when the thread starts if not given
+  explicit LogDrain(unsigned char *stackMemory = nullptr,
+                    uint32_t stackSize = kStackSize);
+
+  // make the class non copyable
+  LogDrain(LogDrain &) = delete;
+  LogDrain &operator=(LogDrain &) = delete;
+
+  // starts the drain thread, the records are written to the file handle
+  // (e.g. the serial port), a LogDrain may only be started once
+  osStatus start(mbed::FileHandle &fileHandle); // NOLINT(runtime/references)
+
+  // wakes the drain thread up before the end of its period, may be called
+  // from threads and ISRs
+  void notify();
+
+  // drains the pending records and stops the drain thread
+  void stop();
+
+  // drains the pending records in the calling thread, must not be called
+  // while the drain thread is running
+  void flush(mbed::FileHandle &fileHandle); // NOLINT(runtime/references)
+
+  uint32_t getNbrOfDrains() const;
+
+private:
+  void run();
+
+  static constexpr uint32_t kNotifyFlag = 0x1;
+
+  Thread _thread;
+  EventFlags _eventFlags;
+  mbed::FileHandle *_fileHandle = nullptr;
+  volatile bool _stopFlag = false;
+  volatile uint32_t _nbrOfDrains = 0;
+};
+
+} // namespace bike_computer
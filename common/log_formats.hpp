@@ -0,0 +1,84 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file log_formats.hpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Format strings of the trace points and of the deferred log lines
+ *
+ * Both tables are X macros. The firmware only expands the ids (see
+ * trace_point.hpp and deferred_log.hpp), so that the format strings are not
+ * part of the firmware. The host decoder (host_simulation/tools/
+ * log_decoder.cpp) expands the ids and the format strings, to reconstruct
+ * the text of each record.
+ *
+ * Ids are given in order, new entries must be appended at the end of a
+ * table so that older captures can still be decoded. The formats use the
+ * <cinttypes> macros for fixed size integers (e.g. PRIu32), which expand to
+ * the conversions of the host when decoding.
+ *
+ * @date 2024-05-20
+ * @version 1.0.0
+ ***************************************************************************/
+
+#pragma once
+
+#include <cinttypes>
+
+// X(id, format), the arguments of a trace point are 32 bit words: %f takes a
+// float and the 64 bit conversions take two words (low word first)
+#define TRACE_POINT_FORMATS(X)                                                \
+  X(kTracePointNewSpeed, "New speed is %f")                                   \
+  X(kTracePointDistance, "Total distance %" PRIu64 " um, speed %f")           \
+  X(kTracePointCycleTime, "Repeating cycle time is %" PRIu32 " milliseconds") \
+  X(kTracePointAvailableHeap,                                                 \
+    "Available heap size is %" PRIu32 " (reserved %" PRIu32 ")")              \
+  X(kTracePointAllocatingBlocks, "Allocating blocks of size %" PRIu32)        \
+  X(kTracePointAllocatedBlock,                                                \
+    "Allocated block index %" PRIu32 " of size %" PRIu32                      \
+    " at address 0x%08" PRIx32)                                               \
+  X(kTracePointHeapAfterAllocation, "Heap statistics after full allocation:") \
+  X(kTracePointHeapAfterDeallocation,                                         \
+    "Heap statistics after half deallocation:")
+
+// X(id, group, format), the arguments of a deferred log line carry their
+// type (see deferred_log.hpp)
+#define DEFERRED_LOG_FORMATS(X)                                               \
+  X(kLogStartingSuperLoop, "BikeSystem",                                      \
+    "Starting Super-Loop without event handling")                             \
+  X(kLogStartingSuperLoopWithEvents, "BikeSystem",                            \
+    "Starting Super-Loop with event handling")                                \
+  X(kLogStartingSuperLoopWithEdf, "BikeSystem",                               \
+    "Starting Super-Loop with earliest deadline first event handling")        \
+  X(kLogStartingRateMonotonicThreads, "BikeSystem",                           \
+    "Starting with rate monotonic threads")                                   \
+  X(kLogFrameOverrun, "BikeSystem",                                           \
+    "Frame %" PRIu32 " overrun (%" PRIu32 " overruns)")                       \
+  X(kLogMajorCycleOverrun, "BikeSystem",                                      \
+    "Major cycle overrun (%" PRIu32 " overruns)")                             \
+  X(kLogDisplayInitFailed, "BikeSystem",                                      \
+    "Failed to initialized the lcd display: %d")                              \
+  X(kLogSensorInitFailed, "BikeSystem",                                       \
+    "Sensor not present or initialization failed")                            \
+  X(kLogResetResponseTime, "BikeSystem",                                      \
+    "Reset task: response time is %" PRIu64 " usecs")                         \
+  X(kLogSensorNotPresent, "SensorDevice", "HDC1000 not present !")            \
+  X(kLogWorkloadCalibrated, "SyntheticWorkload",                              \
+    "Calibrated %" PRIu32 " chunks in %" PRId64 " usecs")                     \
+  X(kLogBlockAllocationFailed, "MemoryFragmenter",                            \
+    "Cannot allocate block memory for index %" PRIu32)                        \
+  X(kLogUpdateClientInitFailed, "UpdateClient",                               \
+    "Cannot initialize update client: %d")                                    \
+  X(kLogUpdateClientStarted, "UpdateClient", "Update client started")
@@ -0,0 +1,211 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file mpsc_ring.hpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Lock-free multi-producer single-consumer ring buffer of binary
+ *        records, drained in frames
+ *
+ * Producers (threads and ISRs) reserve a slot with a compare-and-swap on the
+ * head, fill the record in place and commit it. When the ring is full, the
+ * new record is dropped, or the oldest committed record when dropOldest is
+ * set. Drops are counted and reported in the header of the next frame.
+ *
+ * The consumer drains the committed records into frames (little endian):
+ * magic (4 bytes), number of records (u16), number of dropped records (u16),
+ * then the records, each encoded by the owner of the ring. This is the
+ * storage of the TaskTracer, the TracePoints and the DeferredLog.
+ *
+ * @date 2024-06-24
+ * @version 1.0.0
+ ***************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+
+#include "mbed.h"
+
+namespace bike_computer {
+
+// little endian encoding of the frames, also used by the decoders
+namespace frame {
+
+inline void putU16(uint8_t *buffer, uint16_t value) {
+  buffer[0] = static_cast<uint8_t>(value);
+  buffer[1] = static_cast<uint8_t>(value >> 8);
+}
+
+inline void putU32(uint8_t *buffer, uint32_t value) {
+  putU16(buffer, static_cast<uint16_t>(value));
+  putU16(buffer + 2, static_cast<uint16_t>(value >> 16));
+}
+
+inline uint16_t getU16(const uint8_t *buffer) {
+  return static_cast<uint16_t>(buffer[0] | (buffer[1] << 8));
+}
+
+inline uint32_t getU32(const uint8_t *buffer) {
+  return getU16(buffer) | (static_cast<uint32_t>(getU16(buffer + 2)) << 16);
+}
+
+} // namespace frame
+
+template <typename T, uint32_t N> class MpscRing {
+public:
+  static_assert((N & (N - 1)) == 0 && N > 0,
+                "The capacity of a ring must be a power of 2");
+
+  static constexpr uint32_t kCapacity = N;
+  // magic, number of records (u16), number of dropped records (u16)
+  static constexpr size_t kFrameHeaderSize = 8;
+
+  MpscRing() = default;
+
+  // make the class non copyable
+  MpscRing(MpscRing &) = delete;
+  MpscRing &operator=(MpscRing &) = delete;
+
+  // drop all pending records and reset the drop counters, producers must be
+  // stopped
+  void clear() {
+    core_util_atomic_store_u32(&_tail, core_util_atomic_load_u32(&_head));
+    core_util_atomic_store_u32(&_nbrOfDroppedRecords, 0);
+    core_util_atomic_store_u32(&_nbrOfUnreportedDrops, 0);
+  }
+
+  // reserve a slot, returns false (the record is dropped) if the ring is full
+  // unless dropOldest is set
+  bool reserve(uint32_t &index, // NOLINT(runtime/references)
+               bool dropOldest = false) {
+    while (true) {
+      // the tail is read first, so that it is never ahead of the head
+      uint32_t tail = core_util_atomic_load_u32(&_tail);
+      uint32_t head = core_util_atomic_load_u32(&_head);
+      if (head - tail < kCapacity) {
+        if (core_util_atomic_cas_u32(&_head, &head, head + 1)) {
+          index = head;
+          return true;
+        }
+        continue;
+      }
+      // the oldest record is only dropped once committed, its producer may
+      // still be writing it otherwise
+      if (!dropOldest ||
+          core_util_atomic_load_u32(&getSlot(tail).sequence) != tail + 1) {
+        countDrop();
+        return false;
+      }
+      // unless released by the consumer or dropped by another producer
+      if (core_util_atomic_cas_u32(&_tail, &tail, tail + 1)) {
+        countDrop();
+      }
+    }
+  }
+
+  // record of a reserved slot, to be filled before commit()
+  T &getRecord(uint32_t index) { return getSlot(index).record; }
+
+  void commit(uint32_t index) {
+    core_util_atomic_store_u32(&getSlot(index).sequence, index + 1);
+  }
+
+  // encode as many committed records as possible into a frame, returns the
+  // frame size (0 if there is nothing to report)
+  // encodeRecord(record, buffer, size) writes a record into the buffer and
+  // returns its size, or 0 if it does not fit
+  // must be called from a single thread
+  template <typename EncodeRecord>
+  size_t drain(const uint8_t (&magic)[4], uint8_t *buffer, size_t size,
+               EncodeRecord encodeRecord) {
+    if (size < kFrameHeaderSize) {
+      return 0;
+    }
+    uint32_t tail = core_util_atomic_load_u32(&_tail);
+    uint16_t nbrOfRecords = 0;
+    size_t frameSize = kFrameHeaderSize;
+    while (nbrOfRecords < 0xFFFF) {
+      const Slot &slot = getSlot(tail);
+      // stop at the first record that is not committed yet
+      if (core_util_atomic_load_u32(&slot.sequence) != tail + 1) {
+        break;
+      }
+      const size_t recordSize =
+          encodeRecord(slot.record, buffer + frameSize, size - frameSize);
+      if (recordSize == 0) {
+        break;
+      }
+      // release the slot, unless a producer dropped the record (drop oldest):
+      // the copy is then discarded and the new tail is reloaded
+      if (!core_util_atomic_cas_u32(&_tail, &tail, tail + 1)) {
+        continue;
+      }
+      frameSize += recordSize;
+      nbrOfRecords++;
+      tail++;
+    }
+
+    // drops that do not fit in this frame are reported in the next ones
+    const uint16_t nbrOfDrops = static_cast<uint16_t>(std::min<uint32_t>(
+        core_util_atomic_load_u32(&_nbrOfUnreportedDrops), 0xFFFF));
+    core_util_atomic_decr_u32(&_nbrOfUnreportedDrops, nbrOfDrops);
+    if (nbrOfRecords == 0 && nbrOfDrops == 0) {
+      return 0;
+    }
+    std::memcpy(buffer, magic, sizeof(magic));
+    frame::putU16(buffer + 4, nbrOfRecords);
+    frame::putU16(buffer + 6, nbrOfDrops);
+    return frameSize;
+  }
+
+  uint32_t getNbrOfPendingRecords() const {
+    return core_util_atomic_load_u32(&_head) -
+           core_util_atomic_load_u32(&_tail);
+  }
+
+  uint32_t getNbrOfDroppedRecords() const {
+    return core_util_atomic_load_u32(&_nbrOfDroppedRecords);
+  }
+
+private:
+  struct Slot {
+    // index + 1 of the record once it is committed
+    volatile uint32_t sequence;
+    T record;
+  };
+
+  Slot &getSlot(uint32_t index) { return _slots[index & (kCapacity - 1)]; }
+
+  void countDrop() {
+    core_util_atomic_incr_u32(&_nbrOfDroppedRecords, 1);
+    core_util_atomic_incr_u32(&_nbrOfUnreportedDrops, 1);
+  }
+
+  // next slot to be reserved by a producer / read by the consumer
+  volatile uint32_t _head = 0;
+  volatile uint32_t _tail = 0;
+  volatile uint32_t _nbrOfDroppedRecords = 0;
+  // dropped records that were not yet reported in a frame
+  volatile uint32_t _nbrOfUnreportedDrops = 0;
+  Slot _slots[N] = {};
+};
+
+template <typename T, uint32_t N> constexpr uint32_t MpscRing<T, N>::kCapacity;
+template <typename T, uint32_t N>
+constexpr size_t MpscRing<T, N>::kFrameHeaderSize;
+
+} // namespace bike_computer
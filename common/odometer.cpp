@@ -0,0 +1,54 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file odometer.cpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Fixed-point odometer implementation
+ *
+ * @date 2024-01-29
+ * @version 1.0.0
+ ***************************************************************************/
+
+#include "odometer.hpp"
+
+namespace bike_computer {
+
+void Odometer::setRate(uint32_t numerator, uint32_t denominator) {
+  if (denominator != _denominator) {
+    // keep the sub-micrometre distance (rounded down) in the new unit
+    _remainder = (_remainder * denominator) / _denominator;
+    _denominator = denominator;
+  }
+  _numerator = numerator;
+}
+
+void Odometer::update(const std::chrono::microseconds &elapsedTime) {
+  if (elapsedTime.count() <= 0) {
+    return;
+  }
+  const uint64_t distance =
+      static_cast<uint64_t>(elapsedTime.count()) * _numerator + _remainder;
+  _remainder = distance % _denominator;
+  core_util_atomic_fetch_add_u64(&_micrometres, distance / _denominator);
+}
+
+uint64_t Odometer::getMicrometres() const {
+  return core_util_atomic_load_u64(&_micrometres);
+}
+
+void Odometer::reset() { core_util_atomic_store_u64(&_micrometres, 0); }
+
+} // namespace bike_computer
@@ -0,0 +1,74 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file odometer.hpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Fixed-point odometer accumulating micrometres
+ *
+ * The traveled distance is accumulated as an integer number of micrometres in
+ * a 64-bit counter, from integer microsecond deltas and a rational speed
+ * (micrometres per usec given as numerator / denominator). The remainder of
+ * each division is carried to the next update, so that no distance is lost
+ * whatever the update rate.
+ *
+ * update() and setRate() must not run concurrently: they are called from a
+ * single thread, or the caller serializes them (the multi tasking BikeSystem
+ * locks a mutex around the Speedometer). The counter is accessed with atomic
+ * operations, so that getMicrometres() and reset() may be called from any
+ * thread or ISR without blocking.
+ *
+ * @date 2024-01-29
+ * @version 1.0.0
+ ***************************************************************************/
+
+#pragma once
+
+#include <chrono>
+
+#include "mbed.h"
+
+namespace bike_computer {
+
+class Odometer {
+public:
+  Odometer() = default;
+
+  // make the class non copyable
+  Odometer(Odometer &) = delete;
+  Odometer &operator=(Odometer &) = delete;
+
+  // set the speed as numerator / denominator micrometres per usec, the
+  // product of numerator and of the elapsed time given to update() must fit
+  // into 64 bits (about 48 hours between updates at 1.05e8 um)
+  void setRate(uint32_t numerator, uint32_t denominator);
+
+  // add the distance traveled during elapsedTime at the current rate
+  void update(const std::chrono::microseconds &elapsedTime);
+
+  // traveled distance since the last reset
+  uint64_t getMicrometres() const;
+
+  void reset();
+
+private:
+  volatile uint64_t _micrometres = 0;
+  uint32_t _numerator = 0;
+  uint32_t _denominator = 1;
+  // sub-micrometre distance, expressed in 1 / _denominator micrometres
+  uint64_t _remainder = 0;
+};
+
+} // namespace bike_computer
@@ -0,0 +1,57 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file periodic_release.cpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Drift-free periodic release implementation
+ *
+ * @date 2024-04-08
+ * @version 1.0.0
+ ***************************************************************************/
+
+#include "periodic_release.hpp"
+
+namespace bike_computer {
+
+PeriodicRelease::PeriodicRelease(const std::chrono::milliseconds &period)
+    : _period(period) {}
+
+void PeriodicRelease::start() {
+  _periodStartTime = Kernel::Clock::now();
+  _nbrOfOverruns = 0;
+}
+
+bool PeriodicRelease::sleepUntil(const std::chrono::milliseconds &offset) {
+  return sleepUntil(_periodStartTime + offset);
+}
+
+bool PeriodicRelease::sleepUntilNextPeriod() {
+  // the next period starts one period after the current one, even after an
+  // overrun
+  _periodStartTime = _periodStartTime + _period;
+  return sleepUntil(_periodStartTime);
+}
+
+bool PeriodicRelease::sleepUntil(const Kernel::Clock::time_point &releaseTime) {
+  if (Kernel::Clock::now() > releaseTime) {
+    _nbrOfOverruns++;
+    return false;
+  }
+  ThisThread::sleep_until(releaseTime);
+  return true;
+}
+
+} // namespace bike_computer
@@ -0,0 +1,74 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file periodic_release.hpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Drift-free periodic release of the frames of a super-loop
+ *
+ * The start of each period is computed from the epoch set by start() (epoch +
+ * k * period) and the frames are released at absolute offsets from it, so
+ * that the wake-up latency and the overruns do not accumulate from one frame
+ * or period to the next. A release whose time is already over is an overrun:
+ * it is counted and reported to the caller, and the following releases keep
+ * their times.
+ *
+ * Times use the rtos clock (1 msec resolution).
+ *
+ * @date 2024-04-08
+ * @version 1.0.0
+ ***************************************************************************/
+
+#pragma once
+
+#include <chrono>
+
+#include "mbed.h"
+
+namespace bike_computer {
+
+class PeriodicRelease {
+public:
+  explicit PeriodicRelease(const std::chrono::milliseconds &period);
+
+  // make the class non copyable
+  PeriodicRelease(PeriodicRelease &) = delete;
+  PeriodicRelease &operator=(PeriodicRelease &) = delete;
+
+  // the current time becomes the start of the first period
+  void start();
+
+  // sleeps until the given offset from the start of the current period,
+  // returns false (overrun) if this time is already over
+  bool sleepUntil(const std::chrono::milliseconds &offset);
+
+  // sleeps until the start of the next period, which becomes the current one,
+  // returns false (overrun) if this time is already over
+  bool sleepUntilNextPeriod();
+
+  Kernel::Clock::time_point getPeriodStartTime() const {
+    return _periodStartTime;
+  }
+  uint32_t getNbrOfOverruns() const { return _nbrOfOverruns; }
+
+private:
+  bool sleepUntil(const Kernel::Clock::time_point &releaseTime);
+
+  const std::chrono::milliseconds _period;
+  Kernel::Clock::time_point _periodStartTime;
+  uint32_t _nbrOfOverruns = 0;
+};
+
+} // namespace bike_computer
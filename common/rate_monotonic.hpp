@@ -0,0 +1,129 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file rate_monotonic.hpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Compile time rate monotonic analysis of a task table
+ *
+ * Each task is described by its period (or the minimal inter-arrival time of
+ * its events for sporadic tasks) and its worst case computation time, with an
+ * implicit deadline equal to the period. The functions are constexpr, so that
+ * a task table can be checked with static_assert:
+ *
+ * - isBelowLiuLaylandBound(): U <= n * (2^(1/n) - 1)
+ * - isBelowHyperbolicBound(): prod(U_i + 1) <= 2 (less pessimistic)
+ *
+ * Both are sufficient conditions for the feasibility under preemptive fixed
+ * priorities assigned with getRateMonotonicPriority() (the shorter the period,
+ * the higher the priority, ties are broken by the table order).
+ *
+ * @date 2024-03-18
+ * @version 1.0.0
+ ***************************************************************************/
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace bike_computer {
+
+struct RateMonotonicTask {
+  std::chrono::milliseconds period;
+  std::chrono::milliseconds computationTime;
+};
+
+constexpr double getUtilization(const RateMonotonicTask &task) {
+  return static_cast<double>(task.computationTime.count()) /
+         static_cast<double>(task.period.count());
+}
+
+template <size_t N>
+constexpr double getUtilization(const RateMonotonicTask (&tasks)[N]) {
+  double utilization = 0.0;
+  for (size_t taskIndex = 0; taskIndex < N; taskIndex++) {
+    utilization += getUtilization(tasks[taskIndex]);
+  }
+  return utilization;
+}
+
+// n * (2^(1/n) - 1), the n-th root of 2 is computed by bisection
+constexpr double getLiuLaylandBound(size_t nbrOfTasks) {
+  double low = 1.0;
+  double high = 2.0;
+  for (uint8_t iteration = 0; iteration < 64; iteration++) {
+    const double middle = (low + high) / 2.0;
+    double power = 1.0;
+    for (size_t index = 0; index < nbrOfTasks; index++) {
+      power *= middle;
+    }
+    if (power > 2.0) {
+      high = middle;
+    } else {
+      low = middle;
+    }
+  }
+  return nbrOfTasks * (low - 1.0);
+}
+
+template <size_t N>
+constexpr bool isBelowLiuLaylandBound(const RateMonotonicTask (&tasks)[N]) {
+  return getUtilization(tasks) <= getLiuLaylandBound(N);
+}
+
+template <size_t N>
+constexpr bool isBelowHyperbolicBound(const RateMonotonicTask (&tasks)[N]) {
+  double product = 1.0;
+  for (size_t taskIndex = 0; taskIndex < N; taskIndex++) {
+    product *= getUtilization(tasks[taskIndex]) + 1.0;
+  }
+  return product <= 2.0;
+}
+
+// lowestPriority plus the number of tasks with a lower rate monotonic
+// priority, so that all tasks get distinct priorities
+template <size_t N>
+constexpr int getRateMonotonicPriority(const RateMonotonicTask (&tasks)[N],
+                                       size_t taskIndex, int lowestPriority) {
+  int priority = lowestPriority;
+  for (size_t otherIndex = 0; otherIndex < N; otherIndex++) {
+    if (tasks[otherIndex].period > tasks[taskIndex].period ||
+        (tasks[otherIndex].period == tasks[taskIndex].period &&
+         otherIndex > taskIndex)) {
+      priority++;
+    }
+  }
+  return priority;
+}
+
+// priority of the task with the shortest period
+template <size_t N>
+constexpr int
+getHighestRateMonotonicPriority(const RateMonotonicTask (&tasks)[N],
+                                int lowestPriority) {
+  int highestPriority = lowestPriority;
+  for (size_t taskIndex = 0; taskIndex < N; taskIndex++) {
+    const int priority =
+        getRateMonotonicPriority(tasks, taskIndex, lowestPriority);
+    if (priority > highestPriority) {
+      highestPriority = priority;
+    }
+  }
+  return highestPriority;
+}
+
+} // namespace bike_computer
@@ -12,11 +12,7 @@
 
 #include "sensor_device.hpp"
 #include "constants.hpp"
-#include "mbed_trace.h"
-
-#if MBED_CONF_MBED_TRACE_ENABLE
-#define TRACE_GROUP "SensorDevice"
-#endif // MBED_CONF_MBED_TRACE_ENABLE
+#include "deferred_log.hpp"
 
 namespace bike_computer {
 
@@ -25,7 +21,7 @@ SensorDevice::SensorDevice() : _hdc1000(PD_13, PD_12, PC_6) {}
 bool SensorDevice::init() {
   bool isDevice = _hdc1000.probe();
   if (!isDevice) {
-    tr_error("HDC1000 not present !");
+    DEFERRED_LOG_ERROR(kLogSensorNotPresent);
   }
   return isDevice;
 }
@@ -0,0 +1,114 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file seq_lock.hpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Sequence lock for sharing a small trivially copyable value between
+ *        writers and lock-free readers
+ *
+ * Writers are serialized with a (short) critical section and increment the
+ * sequence number before and after modifying the value, so that the sequence
+ * is odd while a write is in progress. Readers never block: they copy the
+ * value and retry if the sequence was odd or has changed during the copy. On
+ * a single core a read is retried only if the reader is preempted by a writer
+ * in the middle of the copy.
+ *
+ * The value is stored as 32-bit words accessed with atomic operations, so
+ * that the copy is also free of data races when the readers and writers run
+ * on different cores (host stress tests).
+ *
+ * @date 2024-02-05
+ * @version 1.0.0
+ ***************************************************************************/
+
+#pragma once
+
+#include <cstring>
+#include <type_traits>
+
+#include "mbed.h"
+
+namespace bike_computer {
+
+template <typename T>
+class SeqLock {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "SeqLock values must be trivially copyable");
+
+public:
+  SeqLock() { write(T()); }
+
+  // make the class non copyable
+  SeqLock(SeqLock &) = delete;
+  SeqLock &operator=(SeqLock &) = delete;
+
+  // replace the value, may be called from threads and ISRs
+  void write(const T &value) {
+    uint32_t words[kNbrOfWords] = {0};
+    std::memcpy(words, &value, sizeof(T));
+    CriticalSectionLock lock;
+    store(words);
+  }
+
+  // modify the value in place, the modifier is called in a critical section
+  // and must be short
+  template <typename F> void update(F modifier) {
+    CriticalSectionLock lock;
+    uint32_t words[kNbrOfWords] = {0};
+    for (uint32_t index = 0; index < kNbrOfWords; index++) {
+      words[index] = core_util_atomic_load_u32(&_words[index]);
+    }
+    T value;
+    std::memcpy(&value, words, sizeof(T));
+    modifier(value);
+    std::memcpy(words, &value, sizeof(T));
+    store(words);
+  }
+
+  // get a consistent copy of the value, never blocks
+  T read() const {
+    uint32_t words[kNbrOfWords];
+    uint32_t sequence = 0;
+    do {
+      sequence = core_util_atomic_load_u32(&_sequence);
+      for (uint32_t index = 0; index < kNbrOfWords; index++) {
+        words[index] = core_util_atomic_load_u32(&_words[index]);
+      }
+    } while ((sequence & 1U) != 0 ||
+             sequence != core_util_atomic_load_u32(&_sequence));
+    T value;
+    std::memcpy(&value, words, sizeof(T));
+    return value;
+  }
+
+private:
+  static constexpr uint32_t kNbrOfWords =
+      (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+  // must be called in a critical section
+  void store(const uint32_t *words) {
+    core_util_atomic_incr_u32(&_sequence, 1);
+    for (uint32_t index = 0; index < kNbrOfWords; index++) {
+      core_util_atomic_store_u32(&_words[index], words[index]);
+    }
+    core_util_atomic_incr_u32(&_sequence, 1);
+  }
+
+  volatile uint32_t _sequence = 0;
+  volatile uint32_t _words[kNbrOfWords] = {0};
+};
+
+} // namespace bike_computer
@@ -0,0 +1,98 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file speed_table.hpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Compile-time table of the bike speed for each gear size and pedal
+ *        rotation time
+ *
+ * The input domain of the speedometer is small (gear sizes between
+ * kMinGearSize and kMaxGearSize, pedal rotation times between
+ * kMinPedalRotationTime and kMaxPedalRotationTime by steps of
+ * kDeltaPedalRotationTime), so that all speeds can be computed by the
+ * compiler and looked up with a single indexed load.
+ *
+ * @date 2024-01-22
+ * @version 1.0.0
+ ***************************************************************************/
+
+#pragma once
+
+#include <chrono>
+
+#include "constants.hpp"
+
+namespace bike_computer {
+
+// speed in km / h for a given tray size, wheel circumference (m), gear size and
+// pedal rotation time. The distance run with one pedal turn is the tray size
+// divided by the gear size times the wheel circumference, e.g.
+// 50 / 15 * 2.1 m = 6.99 m, and at 80 pedal turns / min (750 ms per turn) this
+// gives 6.99 * 80 m / min ~= 33.6 km / h
+constexpr float computeSpeed(uint8_t traySize, float wheelCircumference,
+                             uint8_t gearSize,
+                             const std::chrono::milliseconds &pedalRotationTime) {
+  return ((static_cast<float>(traySize) / static_cast<float>(gearSize)) *
+          wheelCircumference * 3600.0f) /
+         pedalRotationTime.count();
+}
+
+class SpeedTable {
+public:
+  struct Entry {
+    // speed in km / h
+    float speed;
+  };
+
+  static constexpr uint8_t kNbrOfGearSizes = kMaxGearSize - kMinGearSize + 1;
+  static constexpr uint32_t kNbrOfRotationTimes = static_cast<uint32_t>(
+      (kMaxPedalRotationTime - kMinPedalRotationTime).count() /
+          kDeltaPedalRotationTime.count() +
+      1);
+
+  constexpr SpeedTable(uint8_t traySize, float wheelCircumference)
+      : _entries() {
+    for (uint8_t gearIndex = 0; gearIndex < kNbrOfGearSizes; gearIndex++) {
+      for (uint32_t timeIndex = 0; timeIndex < kNbrOfRotationTimes;
+           timeIndex++) {
+        _entries[gearIndex][timeIndex].speed = computeSpeed(
+            traySize, wheelCircumference, kMinGearSize + gearIndex,
+            kMinPedalRotationTime + timeIndex * kDeltaPedalRotationTime);
+      }
+    }
+  }
+
+  // returns nullptr if the gear size or the pedal rotation time is out of the
+  // table domain
+  constexpr const Entry *
+  lookup(uint8_t gearSize,
+         const std::chrono::milliseconds &pedalRotationTime) const {
+    const auto timeOffset = pedalRotationTime - kMinPedalRotationTime;
+    if (gearSize < kMinGearSize || gearSize > kMaxGearSize ||
+        pedalRotationTime < kMinPedalRotationTime ||
+        pedalRotationTime > kMaxPedalRotationTime ||
+        (timeOffset % kDeltaPedalRotationTime).count() != 0) {
+      return nullptr;
+    }
+    return &_entries[gearSize - kMinGearSize]
+                    [timeOffset / kDeltaPedalRotationTime];
+  }
+
+private:
+  Entry _entries[kNbrOfGearSizes][kNbrOfRotationTimes];
+};
+
+} // namespace bike_computer
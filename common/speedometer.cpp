@@ -29,14 +29,13 @@
 
 // from disco_h747i/wrappers
 #include "joystick.hpp"
-#include "mbed_trace.h"
-
-#if MBED_CONF_MBED_TRACE_ENABLE
-#define TRACE_GROUP "Speedometer"
-#endif // MBED_CONF_MBED_TRACE_ENABLE
+#include "trace_point.hpp"
 
 namespace bike_computer {
 
+// definition of the constexpr table (C++14), its value is given in the class
+constexpr SpeedTable Speedometer::kSpeedTable;
+
 Speedometer::Speedometer(Timer &timer) : _timer(timer) {
   // update _lastTime
   _lastTime = _timer.elapsed_time();
@@ -74,13 +73,17 @@ float Speedometer::getCurrentSpeed() const { return _currentSpeed; }
 float Speedometer::getDistance() {
   // make sure to update the distance traveled
   computeDistance();
-  return _totalDistance;
+  return static_cast<float>(_odometer.getMicrometres()) / 1000000000.0f;
 }
 
 void Speedometer::reset() {
-  _totalDistanceMutex.lock();
-  _totalDistance = 0.0f;
-  _totalDistanceMutex.unlock();
+  _odometer.reset();
+
+#if defined(MBED_TEST_MODE)
+  if (_cb) {
+    _cb();
+  }
+#endif // defined(MBED_TEST_MODE)
 }
 
 #if defined(MBED_TEST_MODE)
@@ -99,50 +102,41 @@ void Speedometer::setOnResetCallback(mbed::Callback<void()> cb) { _cb = cb; }
 #endif // defined(MBED_TEST_MODE)
 
 void Speedometer::computeSpeed() {
-  // For computing the speed given a rear gear (braquet), one must divide the
-  // size of the tray (plateau) by the size of the rear gear (pignon arrière),
-  // and then multiply the result by the circumference of the wheel. Example:
-  // tray = 50, rear gear = 15. Distance run with one pedal turn (wheel
-  // circumference = 2.10 m) = 50/15 * 2.1 m = 6.99m If you ride at 80 pedal
-  // turns / min, you run a distance of 6.99 * 80 / min
-  // ~= 560 m / min = 33.6 km/h
-
-  float distancePerPedalRotation =
-      (static_cast<float>(kTraySize) / static_cast<float>(_gearSize)) *
-      kWheelCircumference;
-
-  _currentSpeed =
-      (distancePerPedalRotation * 3600.0f) /
-      std::chrono::duration_cast<std::chrono::milliseconds>(_pedalRotationTime)
-          .count();
-  tr_debug("New speed is %f", _currentSpeed);
+  // the speed is looked up in the table computed at compile time (see
+  // speed_table.hpp), the float computation is only used for values outside
+  // of the gear size / pedal rotation time domain
+  const SpeedTable::Entry *entry =
+      kSpeedTable.lookup(_gearSize, _pedalRotationTime);
+  if (entry != nullptr) {
+    _currentSpeed = entry->speed;
+  } else {
+    _currentSpeed = bike_computer::computeSpeed(kTraySize, kWheelCircumference,
+                                                _gearSize, _pedalRotationTime);
+  }
+
+  // the distance run with one pedal turn is traySize / gearSize * wheel
+  // circumference, which gives the exact odometer rate in um per usec
+  const auto pedalRotationTimeUs =
+      std::chrono::duration_cast<std::chrono::microseconds>(_pedalRotationTime);
+  _odometer.setRate(kTraySize * kWheelCircumferenceUm,
+                    _gearSize *
+                        static_cast<uint32_t>(pedalRotationTimeUs.count()));
+  TRACE_POINT_DEBUG(SPEEDOMETER, kTracePointNewSpeed,
+                    TracePoints::toArgument(_currentSpeed));
 }
 
 void Speedometer::computeDistance() {
-  // For computing the speed given a rear gear (braquet), one must divide the
-  // size of the tray (plateau) by the size of the rear gear (pignon arrière),
-  // and then multiply the result by the circumference of the wheel. Example:
-  // tray = 50, rear gear = 15. Distance run with one pedal turn (wheel
-  // circumference = 2.10 m) = 50/15 * 2.1 m = 6.99m If you ride at 80 pedal
-  // turns / min, you run a distance of 6.99 * 80 / min
-  // ~= 560 m / min = 33.6 km/h. We then multiply the speed by the time for
-  // getting the distance traveled.
-
-  std::chrono::microseconds currentTime = _timer.elapsed_time();
-  const std::chrono::microseconds elapsedTime =
-      std::chrono::duration_cast<std::chrono::milliseconds>(currentTime -
-                                                            _lastTime);
-
-  float distance = _currentSpeed * elapsedTime.count() / 3600000000.0;
-
-  _totalDistanceMutex.lock();
-  _totalDistance += distance;
-  _totalDistanceMutex.unlock();
-
-  tr_debug("Total distance %f, distance %f, speed %f, elapsed time %" PRIu64 "",
-           _totalDistance, distance, _currentSpeed, elapsedTime.count());
-
-  _lastTime = _timer.elapsed_time();
+  // the distance is accumulated by the odometer at the rate set in
+  // computeSpeed(), from the integer elapsed time since the last update
+  const std::chrono::microseconds currentTime = _timer.elapsed_time();
+  _odometer.update(currentTime - _lastTime);
+  _lastTime = currentTime;
+
+  TRACE_POINT_DEBUG(
+      SPEEDOMETER, kTracePointDistance,
+      static_cast<uint32_t>(_odometer.getMicrometres()),
+      static_cast<uint32_t>(_odometer.getMicrometres() >> 32),
+      TracePoints::toArgument(_currentSpeed));
 }
 
 } // namespace bike_computer
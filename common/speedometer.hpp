@@ -26,6 +26,8 @@
 
 #include "constants.hpp"
 #include "mbed.h"
+#include "odometer.hpp"
+#include "speed_table.hpp"
 
 namespace bike_computer {
 
@@ -74,6 +76,11 @@ private:
   // constants related to speed computation
   static constexpr float kWheelCircumference = 2.1f;
   static constexpr uint8_t kTraySize = 50;
+  static constexpr uint32_t kWheelCircumferenceUm =
+      static_cast<uint32_t>(kWheelCircumference * 1000000.0f + 0.5f);
+  // speeds for the whole gear size / pedal rotation time domain, computed by
+  // the compiler (constant initialization, the table is placed in flash)
+  static constexpr SpeedTable kSpeedTable{kTraySize, kWheelCircumference};
   std::chrono::microseconds _lastTime = std::chrono::microseconds::zero();
   std::chrono::milliseconds _pedalRotationTime = kInitialPedalRotationTime;
 
@@ -81,8 +88,8 @@ private:
   Timer &_timer;
   LowPowerTicker _ticker;
   float _currentSpeed = 0.0f;
-  Mutex _totalDistanceMutex;
-  float _totalDistance = 0.0f;
+  // traveled distance, updated without locking
+  Odometer _odometer;
   uint8_t _gearSize = 1;
 
   Thread _thread;
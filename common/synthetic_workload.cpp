@@ -0,0 +1,126 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file synthetic_workload.cpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Calibrated busy loop implementation
+ *
+ * @date 2024-04-15
+ * @version 1.0.0
+ ***************************************************************************/
+
+#include "synthetic_workload.hpp"
+
+#include "deferred_log.hpp"
+
+namespace bike_computer {
+
+constexpr std::chrono::milliseconds SyntheticWorkload::kCalibrationTime;
+
+SyntheticWorkload &SyntheticWorkload::getInstance() {
+  static SyntheticWorkload instance;
+  return instance;
+}
+
+void SyntheticWorkload::calibrate() {
+  _timer.start();
+  // the calibration loop is made of the same chunks as consume()
+  uint32_t nbrOfChunks = 0;
+  std::chrono::microseconds elapsedTime = std::chrono::microseconds::zero();
+  const std::chrono::microseconds startTime = _timer.elapsed_time();
+  do {
+    elapsedTime = runChunk() - startTime;
+    nbrOfChunks++;
+  } while (elapsedTime < kCalibrationTime);
+  _calibrationTime = elapsedTime;
+  _nbrOfCalibrationChunks = nbrOfChunks;
+  DEFERRED_LOG_INFO(kLogWorkloadCalibrated, nbrOfChunks,
+                    static_cast<int64_t>(elapsedTime.count()));
+}
+
+uint32_t SyntheticWorkload::getNbrOfChunksPerMs() const {
+  if (!isCalibrated()) {
+    return 0;
+  }
+  return static_cast<uint32_t>(static_cast<uint64_t>(_nbrOfCalibrationChunks) *
+                               1000 / _calibrationTime.count());
+}
+
+void SyntheticWorkload::consume(const std::chrono::microseconds &cpuTime) {
+  // calibrating here would stall the calling task for kCalibrationTime
+  MBED_ASSERT(isCalibrated());
+  if (!isCalibrated()) {
+    return;
+  }
+  // rounded to the nearest chunk
+  const uint64_t nbrOfChunks =
+      (static_cast<uint64_t>(cpuTime.count()) * _nbrOfCalibrationChunks +
+       _calibrationTime.count() / 2) /
+      _calibrationTime.count();
+  for (uint64_t chunkIndex = 0; chunkIndex < nbrOfChunks; chunkIndex++) {
+    runChunk();
+  }
+}
+
+std::chrono::microseconds SyntheticWorkload::runChunk() {
+  // a few multiplications and memory accesses, that the compiler cannot
+  // remove (volatile buffer), the state may be shared by several threads
+  // since it is only noise
+  for (size_t index = 0; index < kBufferSize; index++) {
+    _state = _state * 1664525U + 1013904223U;
+    _buffer[index] = _buffer[index] + _state;
+  }
+  return _timer.elapsed_time();
+}
+
+void TaskWorkloads::set(uint8_t taskIndex,
+                        const std::chrono::microseconds &wcet,
+                        uint8_t variationPercent) {
+  if (taskIndex >= advembsof::TaskLogger::kNbrOfTasks) {
+    return;
+  }
+  // calibrated here, before the tasks run
+  if (wcet != std::chrono::microseconds::zero() &&
+      !SyntheticWorkload::getInstance().isCalibrated()) {
+    SyntheticWorkload::getInstance().calibrate();
+  }
+  _workloads[taskIndex].wcet = wcet;
+  _workloads[taskIndex].variationPercent =
+      variationPercent > 100 ? 100 : variationPercent;
+}
+
+std::chrono::microseconds TaskWorkloads::run(uint8_t taskIndex) {
+  if (taskIndex >= advembsof::TaskLogger::kNbrOfTasks ||
+      _workloads[taskIndex].wcet == std::chrono::microseconds::zero()) {
+    return std::chrono::microseconds::zero();
+  }
+  // each task has its own state (the tasks may run in different threads)
+  Workload &workload = _workloads[taskIndex];
+  std::chrono::microseconds executionTime = workload.wcet;
+  if (workload.variationPercent != 0) {
+    workload.randomState = workload.randomState * 1664525U + 1013904223U;
+    // uniform in [0, variation], in 1/65536 of the wcet
+    const uint64_t variation =
+        static_cast<uint64_t>(workload.randomState >> 16) *
+        workload.variationPercent / 100;
+    executionTime -= std::chrono::microseconds(
+        static_cast<int64_t>(workload.wcet.count() * variation / 65536));
+  }
+  SyntheticWorkload::getInstance().consume(executionTime);
+  return executionTime;
+}
+
+} // namespace bike_computer
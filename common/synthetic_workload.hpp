@@ -0,0 +1,113 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file synthetic_workload.hpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Calibrated busy loop, for loading the CPU with a given execution
+ *        time
+ *
+ * Sleeping for the computation time of a task does not load the CPU. The
+ * SyntheticWorkload instead runs a busy loop made of chunks (some arithmetic
+ * on a buffer followed by a timer read). The number of chunks per msec is
+ * measured once against the timer, so that the loop consumes a given amount
+ * of CPU time: when the task is preempted, its execution takes longer, unlike
+ * with wait_us() on the target. On the host simulation, the timer read is
+ * what charges the CPU time of a chunk.
+ *
+ * The calibration takes kCalibrationTime and must run at boot, before the
+ * other threads are started (a preemption during the calibration makes the
+ * chunks look slower): TaskWorkloads::set() calibrates on its first call.
+ *
+ * TaskWorkloads gives each task of the bike system (advembsof::TaskLogger
+ * indices) a synthetic WCET, with an optional random variation.
+ *
+ * @date 2024-04-15
+ * @version 1.0.0
+ ***************************************************************************/
+
+#pragma once
+
+#include <chrono>
+
+#include "mbed.h"
+#include "task_logger.hpp"
+
+namespace bike_computer {
+
+class SyntheticWorkload {
+public:
+  static constexpr std::chrono::milliseconds kCalibrationTime{100};
+
+  static SyntheticWorkload &getInstance();
+
+  // make the class non copyable
+  SyntheticWorkload(SyntheticWorkload &) = delete;
+  SyntheticWorkload &operator=(SyntheticWorkload &) = delete;
+
+  // measures the duration of a chunk, must be called before consume()
+  void calibrate();
+  bool isCalibrated() const { return _nbrOfCalibrationChunks != 0; }
+  uint32_t getNbrOfChunksPerMs() const;
+
+  // busy loop consuming the given CPU time, returns at once if not calibrated
+  void consume(const std::chrono::microseconds &cpuTime);
+
+private:
+  SyntheticWorkload() = default;
+
+  // returns the timer value read at the end of the chunk
+  std::chrono::microseconds runChunk();
+
+  static constexpr size_t kBufferSize = 64;
+
+  Timer _timer;
+  // chunks run in the (measured) calibration time, kept as a ratio so that
+  // large chunks do not lose precision
+  uint32_t _nbrOfCalibrationChunks = 0;
+  std::chrono::microseconds _calibrationTime = std::chrono::microseconds::zero();
+  volatile uint32_t _buffer[kBufferSize] = {};
+  uint32_t _state = 1;
+};
+
+class TaskWorkloads {
+public:
+  TaskWorkloads() = default;
+
+  // make the class non copyable
+  TaskWorkloads(TaskWorkloads &) = delete;
+  TaskWorkloads &operator=(TaskWorkloads &) = delete;
+
+  // each run of the task consumes between wcet * (100 - variationPercent) /
+  // 100 and wcet of CPU time (uniform), a null wcet disables the workload,
+  // the SyntheticWorkload is calibrated on the first call with a workload
+  void set(uint8_t taskIndex, const std::chrono::microseconds &wcet,
+           uint8_t variationPercent = 0);
+
+  // called by the task, returns the consumed CPU time
+  std::chrono::microseconds run(uint8_t taskIndex);
+
+private:
+  struct Workload {
+    std::chrono::microseconds wcet = std::chrono::microseconds::zero();
+    uint8_t variationPercent = 0;
+    // random variations are reproducible from one run to the other
+    uint32_t randomState = 12345;
+  };
+
+  Workload _workloads[advembsof::TaskLogger::kNbrOfTasks];
+};
+
+} // namespace bike_computer
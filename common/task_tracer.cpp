@@ -0,0 +1,215 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file task_tracer.cpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Binary task tracer implementation
+ *
+ * @date 2024-02-12
+ * @version 1.0.0
+ ***************************************************************************/
+
+#include "task_tracer.hpp"
+
+#include <cstring>
+
+namespace bike_computer {
+
+constexpr uint8_t TaskTracer::kFrameMagic[4];
+
+TaskTracer &TaskTracer::getInstance() {
+  // statically allocated (the ring buffer is part of the instance)
+  static TaskTracer instance;
+  return instance;
+}
+
+void TaskTracer::enable(bool enable) {
+  if (enable) {
+    core_util_atomic_store_bool(&_isEnabled, false);
+    _ring.clear();
+    std::memset(_lastStartTime, 0, sizeof(_lastStartTime));
+    std::memset(_period, 0, sizeof(_period));
+    std::memset(_computationTime, 0, sizeof(_computationTime));
+    std::memset(_releasePeriod, 0, sizeof(_releasePeriod));
+    for (TaskStatistics &statistics : _statistics) {
+      statistics.releaseJitter.reset();
+      statistics.responseTime.reset();
+      statistics.executionTime.reset();
+      statistics.nbrOfDeadlineMisses = 0;
+    }
+  }
+  core_util_atomic_store_bool(&_isEnabled, enable);
+}
+
+void TaskTracer::setTaskRelease(uint8_t taskIndex,
+                                const std::chrono::microseconds &period,
+                                const std::chrono::microseconds &offset) {
+  if (taskIndex >= kNbrOfTasks || period.count() <= 0) {
+    return;
+  }
+  _releasePeriod[taskIndex] = period.count();
+  _release[taskIndex] = offset.count();
+}
+
+bool TaskTracer::record(uint8_t taskIndex, uint64_t startTime,
+                        uint64_t endTime) {
+  if (!core_util_atomic_load_bool(&_isEnabled) || taskIndex >= kNbrOfTasks) {
+    return false;
+  }
+
+  // statistics, each task is recorded from a single context
+  updateStatistics(taskIndex, startTime, endTime);
+  if (_onRecord) {
+    _onRecord(taskIndex, startTime, endTime);
+  }
+
+  uint32_t index = 0;
+  if (!_ring.reserve(index)) {
+    return false;
+  }
+  Record &record = _ring.getRecord(index);
+  record.taskIndex = taskIndex;
+  record.contextId = getContextId();
+  record.startTick = static_cast<uint32_t>(startTime);
+  record.endTick = static_cast<uint32_t>(endTime);
+  _ring.commit(index);
+  return true;
+}
+
+void TaskTracer::setOnRecord(
+    mbed::Callback<void(uint8_t taskIndex, uint64_t startTime, uint64_t endTime)>
+        onRecord) {
+  _onRecord = onRecord;
+}
+
+void TaskTracer::logPeriodAndExecutionTime(
+    Timer &timer, int taskIndex,
+    const std::chrono::microseconds &taskStartTime) {
+  record(static_cast<uint8_t>(taskIndex),
+         static_cast<uint64_t>(taskStartTime.count()),
+         static_cast<uint64_t>(timer.elapsed_time().count()));
+}
+
+std::chrono::microseconds TaskTracer::getPeriod(uint8_t taskIndex) const {
+  return std::chrono::microseconds(_period[taskIndex]);
+}
+
+std::chrono::microseconds
+TaskTracer::getComputationTime(uint8_t taskIndex) const {
+  return std::chrono::microseconds(_computationTime[taskIndex]);
+}
+
+const TaskTracer::TaskStatistics &
+TaskTracer::getTaskStatistics(uint8_t taskIndex) const {
+  return _statistics[taskIndex];
+}
+
+size_t TaskTracer::drain(uint8_t *buffer, size_t size) {
+  if (size < kFrameHeaderSize + kRecordSize) {
+    return 0;
+  }
+  return _ring.drain(
+      kFrameMagic, buffer, size,
+      [](const Record &record, uint8_t *recordBuffer, size_t room) -> size_t {
+        if (room < kRecordSize) {
+          return 0;
+        }
+        recordBuffer[0] = record.taskIndex;
+        recordBuffer[1] = record.contextId;
+        frame::putU16(recordBuffer + 2, 0);
+        frame::putU32(recordBuffer + 4, record.startTick);
+        frame::putU32(recordBuffer + 8, record.endTick);
+        return kRecordSize;
+      });
+}
+
+void TaskTracer::drainTo(mbed::FileHandle &fileHandle) {
+  // frames are sent by chunks of 32 records
+  static uint8_t frame[kFrameHeaderSize + 32 * kRecordSize];
+  size_t frameSize = 0;
+  while ((frameSize = drain(frame, sizeof(frame))) > 0) {
+    fileHandle.write(frame, frameSize);
+  }
+}
+
+uint32_t TaskTracer::getNbrOfPendingRecords() const {
+  return _ring.getNbrOfPendingRecords();
+}
+
+uint32_t TaskTracer::getNbrOfDroppedRecords() const {
+  return _ring.getNbrOfDroppedRecords();
+}
+
+void TaskTracer::updateStatistics(uint8_t taskIndex, uint64_t startTime,
+                                  uint64_t endTime) {
+  _period[taskIndex] =
+      static_cast<uint32_t>(startTime - _lastStartTime[taskIndex]);
+  _lastStartTime[taskIndex] = startTime;
+  _computationTime[taskIndex] = static_cast<uint32_t>(endTime - startTime);
+
+  TaskStatistics &statistics = _statistics[taskIndex];
+  statistics.executionTime.record(
+      std::chrono::microseconds(endTime - startTime));
+
+  uint64_t release = startTime;
+  const uint64_t period = _releasePeriod[taskIndex];
+  if (period != 0) {
+    // move to the ideal release nearest to the start time, usually a single
+    // step (without any division)
+    while (startTime >= _release[taskIndex] + period / 2) {
+      _release[taskIndex] += period;
+    }
+    const uint64_t idealRelease = _release[taskIndex];
+    const uint64_t jitter = startTime >= idealRelease
+                                ? startTime - idealRelease
+                                : idealRelease - startTime;
+    statistics.releaseJitter.record(std::chrono::microseconds(jitter));
+    // a task started before its ideal release responds from its start
+    if (idealRelease < release) {
+      release = idealRelease;
+    }
+    if (endTime > release + period) {
+      statistics.nbrOfDeadlineMisses++;
+    }
+  }
+  statistics.responseTime.record(
+      std::chrono::microseconds(endTime - release));
+}
+
+uint8_t TaskTracer::getContextId() {
+  if (core_util_is_isr_active()) {
+    return kIsrContextId;
+  }
+  const osThreadId_t threadId = ThisThread::get_id();
+  for (uint8_t contextId = 0; contextId < kMaxNbrOfContexts; contextId++) {
+    osThreadId_t contextThreadId = _contexts[contextId];
+    if (contextThreadId == threadId) {
+      return contextId;
+    }
+    // register the thread in the first free entry
+    if (contextThreadId == nullptr &&
+        core_util_atomic_cas_ptr(&_contexts[contextId], &contextThreadId,
+                                 threadId)) {
+      return contextId;
+    }
+    if (contextThreadId == threadId) {
+      return contextId;
+    }
+  }
+  return kUnknownContextId;
+}
+
+} // namespace bike_computer
@@ -0,0 +1,168 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file task_tracer.hpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Binary task tracer, replacement of the advembsof::TaskLogger text
+ *        output
+ *
+ * Each task invocation is stored as a compact binary record (task id,
+ * context id, start and end ticks in usecs) in a statically allocated
+ * lock-free ring buffer. Threads and ISRs may record concurrently in a few
+ * cycles, without formatting any text. The records are drained in bulk as
+ * binary frames (see task_trace_decoder.cpp for the format), e.g. over the
+ * serial port, and the last period / computation time of each task is kept
+ * for the tests (same interface as advembsof::TaskLogger).
+ *
+ * The release jitter, response time and execution time of each task are
+ * also accumulated in histograms (see latency_histogram.hpp). The jitter and
+ * response time are computed from the ideal releases (offset + k * period)
+ * given with setTaskRelease(), for tasks without release the response time
+ * is measured from the task start. Invocations that complete after the next
+ * ideal release (implicit deadline) are counted as deadline misses.
+ *
+ * The number of records is configured with "task-tracer-capacity" in
+ * mbed_app.json. When the buffer is full, new records are dropped and
+ * counted. Each record may also be passed to an observer (e.g. the Chrome
+ * trace export of the host simulation), in the context of the task.
+ *
+ * @date 2024-02-12
+ * @version 1.0.0
+ ***************************************************************************/
+
+#pragma once
+
+#include <chrono>
+
+#include "latency_histogram.hpp"
+#include "mbed.h"
+#include "mpsc_ring.hpp"
+#include "task_logger.hpp"
+
+#if !defined(MBED_CONF_APP_TASK_TRACER_CAPACITY)
+#define MBED_CONF_APP_TASK_TRACER_CAPACITY 256
+#endif
+
+namespace bike_computer {
+
+class TaskTracer {
+public:
+  static constexpr uint32_t kCapacity = MBED_CONF_APP_TASK_TRACER_CAPACITY;
+  static_assert((kCapacity & (kCapacity - 1)) == 0 && kCapacity > 0,
+                "task-tracer-capacity must be a power of 2");
+
+  static constexpr uint8_t kNbrOfTasks = advembsof::TaskLogger::kNbrOfTasks;
+  // context id of records made in interrupt handlers
+  static constexpr uint8_t kIsrContextId = 0xFF;
+  // maximal number of threads that are given a context id, records of
+  // additional threads use kUnknownContextId
+  static constexpr uint8_t kMaxNbrOfContexts = 16;
+  static constexpr uint8_t kUnknownContextId = 0xFE;
+
+  // binary frame format (little endian)
+  static constexpr uint8_t kFrameMagic[4] = {'T', 'T', 'R', 'C'};
+  // magic, number of records (u16), number of dropped records (u16)
+  static constexpr size_t kFrameHeaderSize = 8;
+  // task id (u8), context id (u8), reserved (u16), start (u32), end (u32)
+  static constexpr size_t kRecordSize = 12;
+
+  struct TaskStatistics {
+    LatencyHistogram releaseJitter;
+    LatencyHistogram responseTime;
+    LatencyHistogram executionTime;
+    uint32_t nbrOfDeadlineMisses = 0;
+  };
+
+  static TaskTracer &getInstance();
+
+  // make the class non copyable
+  TaskTracer(TaskTracer &) = delete;
+  TaskTracer &operator=(TaskTracer &) = delete;
+
+  // enabling the tracer clears all records, statistics and releases
+  void enable(bool enable);
+
+  // ideal releases of a periodic task, relative to the timer start
+  void setTaskRelease(uint8_t taskIndex,
+                      const std::chrono::microseconds &period,
+                      const std::chrono::microseconds &offset);
+
+  // record a task invocation, may be called from threads and ISRs (each task
+  // from a single context), times are relative to the timer start
+  bool record(uint8_t taskIndex, uint64_t startTime, uint64_t endTime);
+
+  // called for each record, from the recording thread or ISR
+  void setOnRecord(
+      mbed::Callback<void(uint8_t taskIndex, uint64_t startTime, uint64_t endTime)>
+          onRecord);
+
+  // same interface as advembsof::TaskLogger, the end tick is the current
+  // timer value
+  void
+  logPeriodAndExecutionTime(Timer &timer, // NOLINT(runtime/references)
+                            int taskIndex,
+                            const std::chrono::microseconds &taskStartTime);
+
+  // last period / computation time of each task
+  std::chrono::microseconds getPeriod(uint8_t taskIndex) const;
+  std::chrono::microseconds getComputationTime(uint8_t taskIndex) const;
+
+  // histograms of all invocations since the tracer was enabled
+  const TaskStatistics &getTaskStatistics(uint8_t taskIndex) const;
+
+  // encode as many pending records as possible into a frame, returns the
+  // frame size (0 if there is no pending record or the buffer is too small)
+  // must be called from a single thread
+  size_t drain(uint8_t *buffer, size_t size);
+
+  // drain all pending records into the file handle (e.g. the serial port)
+  void drainTo(mbed::FileHandle &fileHandle); // NOLINT(runtime/references)
+
+  uint32_t getNbrOfPendingRecords() const;
+  uint32_t getNbrOfDroppedRecords() const;
+
+private:
+  TaskTracer() = default;
+
+  struct Record {
+    uint8_t taskIndex;
+    uint8_t contextId;
+    uint32_t startTick;
+    uint32_t endTick;
+  };
+
+  uint8_t getContextId();
+  void updateStatistics(uint8_t taskIndex, uint64_t startTime,
+                        uint64_t endTime);
+
+  volatile bool _isEnabled = false;
+  mbed::Callback<void(uint8_t, uint64_t, uint64_t)> _onRecord;
+  MpscRing<Record, kCapacity> _ring;
+
+  // thread ids associated to the context ids
+  volatile osThreadId_t _contexts[kMaxNbrOfContexts] = {};
+
+  uint64_t _lastStartTime[kNbrOfTasks] = {};
+  uint32_t _period[kNbrOfTasks] = {};
+  uint32_t _computationTime[kNbrOfTasks] = {};
+
+  // release period (0 if the task has no release) and current release
+  uint64_t _releasePeriod[kNbrOfTasks] = {};
+  uint64_t _release[kNbrOfTasks] = {};
+  TaskStatistics _statistics[kNbrOfTasks];
+};
+
+} // namespace bike_computer
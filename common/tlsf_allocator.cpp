@@ -0,0 +1,231 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file tlsf_allocator.cpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Two-Level Segregated Fit allocator implementation
+ *
+ * @date 2024-06-10
+ * @version 1.0.0
+ ***************************************************************************/
+
+#include "tlsf_allocator.hpp"
+
+namespace bike_computer {
+
+// index of the most significant bit
+static uint32_t getMsbIndex(size_t value) {
+  return 31 - __builtin_clz(static_cast<uint32_t>(value));
+}
+
+// index of the least significant bit
+static uint32_t getLsbIndex(uint32_t value) { return __builtin_ctz(value); }
+
+static size_t alignUp(size_t value, size_t alignment) {
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+
+void TlsfAllocator::init(uint8_t *buffer, size_t size) {
+  _firstLevelBitmap = 0;
+  for (uint32_t firstLevel = 0; firstLevel < kNbrOfFirstLevels; firstLevel++) {
+    _secondLevelBitmaps[firstLevel] = 0;
+    for (Block *&freeList : _freeLists[firstLevel]) {
+      freeList = nullptr;
+    }
+  }
+  _firstBlock = nullptr;
+
+  const uintptr_t start =
+      alignUp(reinterpret_cast<uintptr_t>(buffer), kAlignment);
+  const uintptr_t end = reinterpret_cast<uintptr_t>(buffer) + size;
+  if (end < start + 2 * kBlockHeaderSize + kAlignment) {
+    return;
+  }
+  const size_t usableSize =
+      std::min<size_t>((end - start) & ~(kAlignment - 1), kMaxBufferSize);
+
+  // one free block followed by a used sentinel block of size 0
+  _firstBlock = reinterpret_cast<Block *>(start);
+  _firstBlock->previous = nullptr;
+  _firstBlock->size = usableSize - 2 * kBlockHeaderSize;
+  Block *sentinel = getNext(_firstBlock);
+  sentinel->previous = _firstBlock;
+  sentinel->size = 0;
+  insertFreeBlock(_firstBlock);
+}
+
+void *TlsfAllocator::allocate(size_t size) {
+  if (size == 0 || size >= kMaxBufferSize) {
+    return nullptr;
+  }
+  size = std::max(alignUp(size, kAlignment), kAlignment);
+  Block *block = findFreeBlock(size);
+  if (block == nullptr) {
+    return nullptr;
+  }
+  removeFreeBlock(block);
+
+  // the end of the block is returned to the free lists if large enough
+  const size_t remainingSize = getSize(block) - size;
+  if (remainingSize >= kBlockHeaderSize + kAlignment) {
+    block->size = size;
+    Block *remainingBlock = getNext(block);
+    remainingBlock->previous = block;
+    remainingBlock->size = remainingSize - kBlockHeaderSize;
+    getNext(remainingBlock)->previous = remainingBlock;
+    insertFreeBlock(remainingBlock);
+  }
+  return reinterpret_cast<uint8_t *>(block) + kBlockHeaderSize;
+}
+
+void TlsfAllocator::free(void *ptr) {
+  if (ptr == nullptr) {
+    return;
+  }
+  Block *block = reinterpret_cast<Block *>(static_cast<uint8_t *>(ptr) -
+                                           kBlockHeaderSize);
+  // merge with the next and the previous blocks if they are free
+  Block *next = getNext(block);
+  if (isFree(next)) {
+    removeFreeBlock(next);
+    block->size = getSize(block) + kBlockHeaderSize + getSize(next);
+    getNext(block)->previous = block;
+  }
+  Block *previous = block->previous;
+  if (previous != nullptr && isFree(previous)) {
+    removeFreeBlock(previous);
+    previous->size = getSize(previous) + kBlockHeaderSize + getSize(block);
+    getNext(previous)->previous = previous;
+    block = previous;
+  }
+  insertFreeBlock(block);
+}
+
+size_t TlsfAllocator::getLargestFreeBlock() const {
+  size_t largestSize = 0;
+  for (const Block *block = _firstBlock;
+       block != nullptr && (getSize(block) > 0 || isFree(block));
+       block = getNext(block)) {
+    if (isFree(block)) {
+      largestSize = std::max(largestSize, getSize(block));
+    }
+  }
+  if (largestSize < kSmallBlockSize) {
+    return largestSize;
+  }
+  // requests are rounded up to the next list, only the lower bound of the
+  // list of the largest block can be allocated
+  const uint32_t msbIndex = getMsbIndex(largestSize);
+  return largestSize & ~((1UL << (msbIndex - kSecondLevelBits)) - 1);
+}
+
+size_t TlsfAllocator::getFreeSize() const {
+  size_t freeSize = 0;
+  for (const Block *block = _firstBlock;
+       block != nullptr && (getSize(block) > 0 || isFree(block));
+       block = getNext(block)) {
+    if (isFree(block)) {
+      freeSize += getSize(block);
+    }
+  }
+  return freeSize;
+}
+
+TlsfAllocator::Block *TlsfAllocator::getNext(const Block *block) {
+  return reinterpret_cast<Block *>(
+      reinterpret_cast<uintptr_t>(block) + kBlockHeaderSize + getSize(block));
+}
+
+void TlsfAllocator::getListIndexes(size_t size, uint32_t &firstLevel,
+                                   uint32_t &secondLevel) {
+  if (size < kSmallBlockSize) {
+    firstLevel = 0;
+    secondLevel = static_cast<uint32_t>(size >> kAlignmentBits);
+    return;
+  }
+  const uint32_t msbIndex = getMsbIndex(size);
+  secondLevel = static_cast<uint32_t>(size >> (msbIndex - kSecondLevelBits)) ^
+                kNbrOfSecondLevels;
+  firstLevel = msbIndex - (kFirstLevelShift - 1);
+}
+
+TlsfAllocator::Block *TlsfAllocator::findFreeBlock(size_t size) {
+  // round up to the next list, so that all its blocks are large enough
+  if (size >= kSmallBlockSize) {
+    size += (1UL << (getMsbIndex(size) - kSecondLevelBits)) - 1;
+  }
+  uint32_t firstLevel = 0;
+  uint32_t secondLevel = 0;
+  getListIndexes(size, firstLevel, secondLevel);
+  if (firstLevel >= kNbrOfFirstLevels) {
+    return nullptr;
+  }
+
+  uint32_t secondLevelBitmap =
+      _secondLevelBitmaps[firstLevel] & (~0UL << secondLevel);
+  if (secondLevelBitmap == 0) {
+    // smallest non-empty list of a larger first level
+    const uint32_t firstLevelBitmap =
+        (firstLevel + 1 < 32) ? _firstLevelBitmap & (~0UL << (firstLevel + 1))
+                              : 0;
+    if (firstLevelBitmap == 0) {
+      return nullptr;
+    }
+    firstLevel = getLsbIndex(firstLevelBitmap);
+    secondLevelBitmap = _secondLevelBitmaps[firstLevel];
+  }
+  secondLevel = getLsbIndex(secondLevelBitmap);
+  return _freeLists[firstLevel][secondLevel];
+}
+
+void TlsfAllocator::insertFreeBlock(Block *block) {
+  uint32_t firstLevel = 0;
+  uint32_t secondLevel = 0;
+  getListIndexes(getSize(block), firstLevel, secondLevel);
+  Block *&freeList = _freeLists[firstLevel][secondLevel];
+  block->nextFree = freeList;
+  block->previousFree = nullptr;
+  if (freeList != nullptr) {
+    freeList->previousFree = block;
+  }
+  freeList = block;
+  _firstLevelBitmap |= 1UL << firstLevel;
+  _secondLevelBitmaps[firstLevel] |= 1UL << secondLevel;
+  block->size |= kFreeFlag;
+}
+
+void TlsfAllocator::removeFreeBlock(Block *block) {
+  block->size &= ~kFreeFlag;
+  uint32_t firstLevel = 0;
+  uint32_t secondLevel = 0;
+  getListIndexes(getSize(block), firstLevel, secondLevel);
+  if (block->previousFree != nullptr) {
+    block->previousFree->nextFree = block->nextFree;
+  } else {
+    _freeLists[firstLevel][secondLevel] = block->nextFree;
+  }
+  if (block->nextFree != nullptr) {
+    block->nextFree->previousFree = block->previousFree;
+  }
+  if (_freeLists[firstLevel][secondLevel] == nullptr) {
+    _secondLevelBitmaps[firstLevel] &= ~(1UL << secondLevel);
+    if (_secondLevelBitmaps[firstLevel] == 0) {
+      _firstLevelBitmap &= ~(1UL << firstLevel);
+    }
+  }
+}
+
+} // namespace bike_computer
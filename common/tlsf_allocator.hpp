@@ -0,0 +1,112 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file tlsf_allocator.hpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Two-Level Segregated Fit allocator on a caller provided buffer
+ *
+ * The free blocks are kept in segregated lists: the first level is the power
+ * of 2 of the block size and each power of 2 is split in 16 second level
+ * lists. Two bitmaps give the non-empty lists, so that allocate() and free()
+ * find a large enough block and merge the neighbours of a freed block in a
+ * bounded number of steps (a few count leading / trailing zeros), whatever
+ * the number of blocks. A block can be allocated from a list only if all
+ * blocks of the list are large enough, the requested size is thus rounded up
+ * to the next list (at most 1/16 of the size is lost).
+ *
+ * Each block starts with a header of two pointers (previous block in memory
+ * and size with a free flag), the free blocks also hold the links of their
+ * list. The allocator is not thread safe.
+ *
+ * @date 2024-06-10
+ * @version 1.0.0
+ ***************************************************************************/
+
+#pragma once
+
+#include "mbed.h"
+
+namespace bike_computer {
+
+class TlsfAllocator {
+public:
+  // payload alignment and minimal payload (the free list links)
+  static constexpr size_t kAlignment = 2 * sizeof(void *);
+  static constexpr size_t kBlockHeaderSize = 2 * sizeof(void *);
+  // largest buffer that can be managed
+  static constexpr size_t kMaxBufferSize = 1UL << 20;
+
+  TlsfAllocator() = default;
+
+  // make the class non copyable
+  TlsfAllocator(TlsfAllocator &) = delete;
+  TlsfAllocator &operator=(TlsfAllocator &) = delete;
+
+  // the buffer is managed as a single free block, all blocks allocated from
+  // a previous buffer are forgotten
+  void init(uint8_t *buffer, size_t size);
+
+  // returns nullptr if no free block is large enough
+  void *allocate(size_t size);
+  void free(void *ptr);
+
+  // largest size that can currently be allocated and total free size
+  size_t getLargestFreeBlock() const;
+  size_t getFreeSize() const;
+
+private:
+  static constexpr uint8_t kSecondLevelBits = 4;
+  static constexpr uint32_t kNbrOfSecondLevels = 1UL << kSecondLevelBits;
+  static constexpr uint8_t kAlignmentBits = (kAlignment == 8) ? 3 : 4;
+  // blocks smaller than kSmallBlockSize are all in the first level 0
+  static constexpr uint8_t kFirstLevelShift = kSecondLevelBits + kAlignmentBits;
+  static constexpr size_t kSmallBlockSize = 1UL << kFirstLevelShift;
+  static constexpr uint8_t kNbrOfFirstLevels = 20 - kFirstLevelShift + 1;
+  static_assert(kAlignment == (1UL << kAlignmentBits),
+                "the alignment must be 8 or 16 bytes");
+
+  struct Block {
+    // previous block in memory (nullptr for the first block)
+    Block *previous;
+    // payload size, kFreeFlag is set for free blocks
+    size_t size;
+    // links of the free list, in the payload of free blocks only
+    Block *nextFree;
+    Block *previousFree;
+  };
+  static constexpr size_t kFreeFlag = 1;
+
+  static size_t getSize(const Block *block) {
+    return block->size & ~kFreeFlag;
+  }
+  static bool isFree(const Block *block) {
+    return (block->size & kFreeFlag) != 0;
+  }
+  static Block *getNext(const Block *block);
+
+  static void getListIndexes(size_t size, uint32_t &firstLevel,
+                             uint32_t &secondLevel);
+  Block *findFreeBlock(size_t size);
+  void insertFreeBlock(Block *block);
+  void removeFreeBlock(Block *block);
+
+  uint32_t _firstLevelBitmap = 0;
+  uint32_t _secondLevelBitmaps[kNbrOfFirstLevels] = {};
+  Block *_freeLists[kNbrOfFirstLevels][kNbrOfSecondLevels] = {};
+  Block *_firstBlock = nullptr;
+};
+
+} // namespace bike_computer
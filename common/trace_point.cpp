@@ -0,0 +1,104 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file trace_point.cpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Compile-time trace points implementation (ring buffer)
+ *
+ * @date 2024-05-13
+ * @version 1.0.0
+ ***************************************************************************/
+
+#include "trace_point.hpp"
+
+namespace bike_computer {
+
+constexpr uint8_t TracePoints::kFrameMagic[4];
+
+TracePoints &TracePoints::getInstance() {
+  // statically allocated (the ring buffer is part of the instance)
+  static TracePoints instance;
+  return instance;
+}
+
+void TracePoints::enable(bool enable) {
+  if (enable) {
+    core_util_atomic_store_bool(&_isEnabled, false);
+    _ring.clear();
+    _timer.reset();
+    _timer.start();
+  }
+  core_util_atomic_store_bool(&_isEnabled, enable);
+}
+
+bool TracePoints::record(TracePointId id, uint32_t argument0,
+                         uint32_t argument1, uint32_t argument2) {
+  if (!core_util_atomic_load_bool(&_isEnabled)) {
+    return false;
+  }
+
+  uint32_t index = 0;
+  if (!_ring.reserve(index)) {
+    return false;
+  }
+  Record &record = _ring.getRecord(index);
+  record.id = id;
+  record.timestamp = static_cast<uint32_t>(_timer.elapsed_time().count());
+  record.arguments[0] = argument0;
+  record.arguments[1] = argument1;
+  record.arguments[2] = argument2;
+  _ring.commit(index);
+  return true;
+}
+
+size_t TracePoints::drain(uint8_t *buffer, size_t size) {
+  if (size < kFrameHeaderSize + kRecordSize) {
+    return 0;
+  }
+  return _ring.drain(
+      kFrameMagic, buffer, size,
+      [](const Record &record, uint8_t *recordBuffer, size_t room) -> size_t {
+        if (room < kRecordSize) {
+          return 0;
+        }
+        frame::putU16(recordBuffer, record.id);
+        frame::putU16(recordBuffer + 2, 0);
+        frame::putU32(recordBuffer + 4, record.timestamp);
+        for (uint8_t index = 0; index < kMaxNbrOfArguments; index++) {
+          frame::putU32(recordBuffer + 8 + 4 * index, record.arguments[index]);
+        }
+        return kRecordSize;
+      });
+}
+
+void TracePoints::drainTo(mbed::FileHandle &fileHandle) {
+  // frames are sent by chunks of 16 records
+  static uint8_t frame[kFrameHeaderSize + 16 * kRecordSize];
+  size_t frameSize = 0;
+  while ((frameSize = drain(frame, sizeof(frame))) > 0) {
+    fileHandle.write(frame, frameSize);
+  }
+}
+
+uint32_t TracePoints::getNbrOfPendingRecords() const {
+  return _ring.getNbrOfPendingRecords();
+}
+
+uint32_t TracePoints::getNbrOfDroppedRecords() const {
+  return _ring.getNbrOfDroppedRecords();
+}
+
+} // namespace bike_computer
@@ -0,0 +1,201 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file trace_point.hpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Compile-time trace points, replacement of tr_debug() on hot paths
+ *
+ * A trace point is a trace point id and up to 3 raw 32 bit arguments, e.g.
+ *
+ *   TRACE_POINT_DEBUG(SPEEDOMETER, kTracePointNewSpeed,
+ *                     TracePoints::toArgument(_currentSpeed));
+ *
+ * The level of each module is selected at compile time with
+ * "trace-point-level-<module>" in mbed_app.json (defaults to
+ * "trace-point-level", itself TRACE_POINT_LEVEL_NONE by default). The trace
+ * points of a disabled level are removed by the preprocessor: no code is
+ * generated and the arguments are not evaluated. The trace points of an
+ * enabled level are written as binary records (id, timestamp, arguments) in
+ * a statically allocated lock-free ring buffer, without any formatting, and
+ * may be written from threads and ISRs. The records are drained in binary
+ * frames, like the records of the TaskTracer, and printed on the host with
+ * the formats of log_formats.hpp (see host_simulation/tools/log_decoder.cpp).
+ *
+ * A new module is declared by defining its MBED_CONF_APP_TRACE_POINT_LEVEL_
+ * macro below (or in mbed_app.json), using an undeclared module does not
+ * compile.
+ *
+ * @date 2024-05-13
+ * @version 1.0.0
+ ***************************************************************************/
+
+#pragma once
+
+#include <cstring>
+
+#include "log_formats.hpp"
+#include "mbed.h"
+#include "mpsc_ring.hpp"
+
+#define TRACE_POINT_LEVEL_NONE 0
+#define TRACE_POINT_LEVEL_ERROR 1
+#define TRACE_POINT_LEVEL_WARN 2
+#define TRACE_POINT_LEVEL_INFO 3
+#define TRACE_POINT_LEVEL_DEBUG 4
+
+#if !defined(MBED_CONF_APP_TRACE_POINT_LEVEL)
+#define MBED_CONF_APP_TRACE_POINT_LEVEL TRACE_POINT_LEVEL_NONE
+#endif
+
+// modules
+#if !defined(MBED_CONF_APP_TRACE_POINT_LEVEL_SPEEDOMETER)
+#define MBED_CONF_APP_TRACE_POINT_LEVEL_SPEEDOMETER                           \
+  MBED_CONF_APP_TRACE_POINT_LEVEL
+#endif
+#if !defined(MBED_CONF_APP_TRACE_POINT_LEVEL_BIKE_SYSTEM)
+#define MBED_CONF_APP_TRACE_POINT_LEVEL_BIKE_SYSTEM                           \
+  MBED_CONF_APP_TRACE_POINT_LEVEL
+#endif
+#if !defined(MBED_CONF_APP_TRACE_POINT_LEVEL_MEMORY_FRAGMENTER)
+#define MBED_CONF_APP_TRACE_POINT_LEVEL_MEMORY_FRAGMENTER                     \
+  MBED_CONF_APP_TRACE_POINT_LEVEL
+#endif
+
+#if !defined(MBED_CONF_APP_TRACE_POINT_CAPACITY)
+#define MBED_CONF_APP_TRACE_POINT_CAPACITY 128
+#endif
+
+#define TRACE_POINT_ERROR(module, ...)                                        \
+  TRACE_POINT(module, TRACE_POINT_LEVEL_ERROR, __VA_ARGS__)
+#define TRACE_POINT_WARN(module, ...)                                         \
+  TRACE_POINT(module, TRACE_POINT_LEVEL_WARN, __VA_ARGS__)
+#define TRACE_POINT_INFO(module, ...)                                         \
+  TRACE_POINT(module, TRACE_POINT_LEVEL_INFO, __VA_ARGS__)
+#define TRACE_POINT_DEBUG(module, ...)                                        \
+  TRACE_POINT(module, TRACE_POINT_LEVEL_DEBUG, __VA_ARGS__)
+
+// the module level and the trace point level are expanded to digits, which
+// select TRACE_POINT_IF_0 (nothing) or TRACE_POINT_IF_1 (record)
+#define TRACE_POINT(module, level, ...)                                       \
+  TRACE_POINT_CAT(TRACE_POINT_IF_,                                            \
+                  TRACE_POINT_IS_ENABLED(                                     \
+                      MBED_CONF_APP_TRACE_POINT_LEVEL_##module, level))       \
+  (__VA_ARGS__)
+
+#define TRACE_POINT_IF_0(...)                                                 \
+  do {                                                                        \
+  } while (0)
+#define TRACE_POINT_IF_1(...)                                                 \
+  ::bike_computer::TracePoints::getInstance().record(__VA_ARGS__)
+
+#define TRACE_POINT_CAT(a, b) TRACE_POINT_CAT_(a, b)
+#define TRACE_POINT_CAT_(a, b) a##b
+#define TRACE_POINT_IS_ENABLED(moduleLevel, level)                            \
+  TRACE_POINT_CAT(TRACE_POINT_CAT(TRACE_POINT_ENABLED_, moduleLevel),         \
+                  TRACE_POINT_CAT(_, level))
+
+// TRACE_POINT_ENABLED_<module level>_<trace point level>
+#define TRACE_POINT_ENABLED_0_1 0
+#define TRACE_POINT_ENABLED_0_2 0
+#define TRACE_POINT_ENABLED_0_3 0
+#define TRACE_POINT_ENABLED_0_4 0
+#define TRACE_POINT_ENABLED_1_1 1
+#define TRACE_POINT_ENABLED_1_2 0
+#define TRACE_POINT_ENABLED_1_3 0
+#define TRACE_POINT_ENABLED_1_4 0
+#define TRACE_POINT_ENABLED_2_1 1
+#define TRACE_POINT_ENABLED_2_2 1
+#define TRACE_POINT_ENABLED_2_3 0
+#define TRACE_POINT_ENABLED_2_4 0
+#define TRACE_POINT_ENABLED_3_1 1
+#define TRACE_POINT_ENABLED_3_2 1
+#define TRACE_POINT_ENABLED_3_3 1
+#define TRACE_POINT_ENABLED_3_4 0
+#define TRACE_POINT_ENABLED_4_1 1
+#define TRACE_POINT_ENABLED_4_2 1
+#define TRACE_POINT_ENABLED_4_3 1
+#define TRACE_POINT_ENABLED_4_4 1
+
+namespace bike_computer {
+
+// ids of all trace points, the formats are in log_formats.hpp
+#define TRACE_POINT_ID(id, format) id,
+enum TracePointId : uint16_t {
+  kTracePointNone = 0,
+  TRACE_POINT_FORMATS(TRACE_POINT_ID) kNbrOfTracePoints
+};
+#undef TRACE_POINT_ID
+
+class TracePoints {
+public:
+  static constexpr uint32_t kCapacity = MBED_CONF_APP_TRACE_POINT_CAPACITY;
+  static_assert((kCapacity & (kCapacity - 1)) == 0 && kCapacity > 0,
+                "trace-point-capacity must be a power of 2");
+  static constexpr uint8_t kMaxNbrOfArguments = 3;
+
+  // binary frame format (little endian)
+  static constexpr uint8_t kFrameMagic[4] = {'T', 'P', 'N', 'T'};
+  // magic, number of records (u16), number of dropped records (u16)
+  static constexpr size_t kFrameHeaderSize = 8;
+  // id (u16), reserved (u16), timestamp in usecs (u32), arguments (3 x u32)
+  static constexpr size_t kRecordSize = 20;
+
+  static TracePoints &getInstance();
+
+  // make the class non copyable
+  TracePoints(TracePoints &) = delete;
+  TracePoints &operator=(TracePoints &) = delete;
+
+  // enabling the trace points clears all records and restarts the timestamps
+  void enable(bool enable);
+
+  // called by the trace point macros, may be called from threads and ISRs
+  bool record(TracePointId id, uint32_t argument0 = 0, uint32_t argument1 = 0,
+              uint32_t argument2 = 0);
+
+  // raw argument of a float (decoded on the host)
+  static uint32_t toArgument(float value) {
+    uint32_t argument = 0;
+    std::memcpy(&argument, &value, sizeof(argument));
+    return argument;
+  }
+
+  // encode as many pending records as possible into a frame, returns the
+  // frame size (0 if there is no pending record or the buffer is too small)
+  // must be called from a single thread
+  size_t drain(uint8_t *buffer, size_t size);
+
+  // drain all pending records into the file handle (e.g. the serial port)
+  void drainTo(mbed::FileHandle &fileHandle); // NOLINT(runtime/references)
+
+  uint32_t getNbrOfPendingRecords() const;
+  uint32_t getNbrOfDroppedRecords() const;
+
+private:
+  TracePoints() = default;
+
+  struct Record {
+    uint16_t id;
+    uint32_t timestamp;
+    uint32_t arguments[kMaxNbrOfArguments];
+  };
+
+  volatile bool _isEnabled = false;
+  Timer _timer;
+  MpscRing<Record, kCapacity> _ring;
+};
+
+} // namespace bike_computer
@@ -0,0 +1,392 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file architecture_benchmark.cpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Comparison of the bike system designs under the same scripted
+ *        joystick and reset input trace (virtual time)
+ *
+ * Usage: benchmark-architectures [repetitions of the input trace, default 4]
+ *                                [JSON report file, default architectures.json]
+ *
+ * The designs are static_scheduling (polling), static_scheduling_with_event
+ * (interrupt driven) and multi_tasking (event queue and rate monotonic
+ * threads). Each design runs alone and gets the same input trace: gear up,
+ * gear up, reset, gear down, gear down, one input every kInputPeriod, each
+ * button held for kPressDuration. The report gives for each design:
+ * - the reset response time, from the button press to the speedometer reset
+ * - the gear to display latency, from the joystick press to the first draw
+ *   of a new gear text
+ * - the inputs that got no response (missed)
+ * - the CPU idle percentage
+ * - the stack and heap high-water marks of the design (mbed_stats)
+ * - the flash and static RAM sizes of the design objects (allocated sections
+ *   of the ELF object files, the common objects are reported once)
+ * The sizes are those of the host build, they compare the designs but are
+ * not the sizes on target. The report goes to a file, since the designs
+ * log on the standard output.
+ *
+ * @date 2024-04-22
+ * @version 1.0.0
+ ***************************************************************************/
+
+#include <elf.h>
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "common/latency_histogram.hpp"
+#include "host_sim/virtual_kernel.hpp"
+#include "joystick.hpp"
+#include "mbed.h"
+#include "multi_tasking/bike_system.hpp"
+#include "static_scheduling/bike_system.hpp"
+#include "static_scheduling_with_event/bike_system.hpp"
+
+// a timer read costs virtual CPU time, the polling designs read timers in
+// busy loops and this cost keeps the simulation fast
+static constexpr std::chrono::microseconds kTimerReadCost = 10us;
+static constexpr std::chrono::milliseconds kStartupTime   = 1000ms;
+// longer than the display period of all designs, so that each response
+// is observed before the next input
+static constexpr std::chrono::milliseconds kInputPeriod   = 3000ms;
+static constexpr std::chrono::milliseconds kPressDuration = 150ms;
+
+enum class Input { kGearUp, kGearDown, kReset };
+static constexpr Input kInputTrace[] = {
+    Input::kGearUp, Input::kGearUp, Input::kReset, Input::kGearDown, Input::kGearDown};
+
+enum class Design { kPolling, kInterruptDriven, kEventQueue, kRateMonotonic };
+
+struct Result {
+    bike_computer::LatencyHistogram resetResponseTime;
+    bike_computer::LatencyHistogram gearToDisplayLatency;
+    uint32_t nbrOfMissedResets      = 0;
+    uint32_t nbrOfMissedGearPresses = 0;
+    uint64_t cpuIdlePercent         = 0;
+    uint32_t stackHighWater         = 0;
+    uint32_t stackReserved          = 0;
+    uint32_t heapHighWater          = 0;
+};
+
+struct Sizes {
+    uint64_t flash     = 0;
+    uint64_t staticRam = 0;
+};
+
+// input being observed, updated by the display and speedometer callbacks
+// (the virtual kernel runs one thread at a time)
+static std::chrono::microseconds pressTime = std::chrono::microseconds::zero();
+static bool isGearPending                  = false;
+static bool isResetPending                 = false;
+static std::string lastGearText;
+static Result* currentResult = nullptr;
+
+static void onDraw(advembsof::DisplayDevice::Field field, const char* text) {
+    if (field != advembsof::DisplayDevice::kGearField || lastGearText == text) {
+        return;
+    }
+    lastGearText = text;
+    if (isGearPending) {
+        currentResult->gearToDisplayLatency.record(host_sim::Kernel::instance().now() -
+                                                   pressTime);
+        isGearPending = false;
+    }
+}
+
+static void onSpeedometerReset() {
+    if (isResetPending) {
+        currentResult->resetResponseTime.record(host_sim::Kernel::instance().now() - pressTime);
+        isResetPending = false;
+    }
+}
+
+static void playInputTrace(uint32_t nbrOfRepetitions, Result& result) {
+    host_sim::Kernel& kernel = host_sim::Kernel::instance();
+    for (uint32_t repetition = 0; repetition < nbrOfRepetitions; repetition++) {
+        for (Input input : kInputTrace) {
+            const std::chrono::microseconds inputTime = kernel.now();
+            pressTime                                 = inputTime;
+            if (input == Input::kReset) {
+                isResetPending = true;
+                host_sim::setPinLevel(BUTTON1, 1);
+                ThisThread::sleep_for(kPressDuration);
+                host_sim::setPinLevel(BUTTON1, 0);
+            } else {
+                isGearPending = true;
+                disco::Joystick::getInstance().press(input == Input::kGearUp
+                                                         ? disco::Joystick::State::UpPressed
+                                                         : disco::Joystick::State::DownPressed);
+                ThisThread::sleep_for(kPressDuration);
+                disco::Joystick::getInstance().release();
+            }
+            kernel.sleepUntil(inputTime + kInputPeriod);
+            if (isResetPending) {
+                result.nbrOfMissedResets++;
+                isResetPending = false;
+            }
+            if (isGearPending) {
+                result.nbrOfMissedGearPresses++;
+                isGearPending = false;
+            }
+        }
+    }
+}
+
+// runs the input trace on a started design, main is above all its threads
+template <typename BikeSystem>
+static void observe(BikeSystem& bikeSystem,
+                    uint32_t nbrOfRepetitions,
+                    const mbed_stats_stack_t& baseStackStats,
+                    Result& result) {
+    bikeSystem.getSpeedometer().setOnResetCallback(callback(onSpeedometerReset));
+    ThisThread::sleep_for(kStartupTime);
+
+    mbed_stats_cpu_t startStats;
+    mbed_stats_cpu_get(&startStats);
+    playInputTrace(nbrOfRepetitions, result);
+    mbed_stats_cpu_t endStats;
+    mbed_stats_cpu_get(&endStats);
+    const uint64_t upTime   = endStats.uptime - startStats.uptime;
+    const uint64_t idleTime = endStats.idle_time - startStats.idle_time;
+    result.cpuIdlePercent   = (idleTime * 100) / upTime;
+
+    // before stopping, while the threads of the design still exist
+    mbed_stats_stack_t stackStats;
+    mbed_stats_stack_get(&stackStats);
+    result.stackHighWater = stackStats.max_size - baseStackStats.max_size;
+    result.stackReserved  = stackStats.reserved_size - baseStackStats.reserved_size;
+}
+
+static Result run(Design design, uint32_t nbrOfRepetitions) {
+    Result result;
+    currentResult = &result;
+    lastGearText.clear();
+    advembsof::DisplayDevice::setOnDraw(callback(onDraw));
+
+    host_sim::resetStatisticsPeaks();
+    mbed_stats_heap_t baseHeapStats;
+    mbed_stats_heap_get(&baseHeapStats);
+    mbed_stats_stack_t baseStackStats;
+    mbed_stats_stack_get(&baseStackStats);
+
+    Thread* thread = new Thread(osPriorityNormal, OS_STACK_SIZE, nullptr, "bikeSystem");
+    if (design == Design::kPolling) {
+        auto* bikeSystem = new static_scheduling::BikeSystem();
+        thread->start(callback(bikeSystem, &static_scheduling::BikeSystem::start));
+        observe(*bikeSystem, nbrOfRepetitions, baseStackStats, result);
+        thread->terminate();
+        delete bikeSystem;
+    } else if (design == Design::kInterruptDriven) {
+        auto* bikeSystem = new static_scheduling_with_event::BikeSystem();
+        thread->start(callback(bikeSystem, &static_scheduling_with_event::BikeSystem::start));
+        observe(*bikeSystem, nbrOfRepetitions, baseStackStats, result);
+        thread->terminate();
+        delete bikeSystem;
+    } else {
+        auto* bikeSystem = new multi_tasking::BikeSystem();
+        thread->start(callback(bikeSystem,
+                               design == Design::kEventQueue
+                                   ? &multi_tasking::BikeSystem::start
+                                   : &multi_tasking::BikeSystem::startWithRateMonotonicThreads));
+        observe(*bikeSystem, nbrOfRepetitions, baseStackStats, result);
+        bikeSystem->stop();
+        thread->terminate();
+        delete bikeSystem;
+    }
+    delete thread;
+
+    mbed_stats_heap_t heapStats;
+    mbed_stats_heap_get(&heapStats);
+    result.heapHighWater = heapStats.max_size - baseHeapStats.current_size;
+
+    advembsof::DisplayDevice::setOnDraw(nullptr);
+    currentResult = nullptr;
+    return result;
+}
+
+// adds the allocated sections of a relocatable ELF object: the sections with
+// content go to flash (including the initial values of .data), the writable
+// ones to RAM
+static bool addObjectSizes(const std::string& path, Sizes& sizes) {
+    std::ifstream file(path, std::ios::binary);
+    const std::vector<char> content((std::istreambuf_iterator<char>(file)),
+                                    std::istreambuf_iterator<char>());
+    if (content.size() < sizeof(Elf64_Ehdr) || std::memcmp(content.data(), ELFMAG, SELFMAG) != 0 ||
+        content[EI_CLASS] != ELFCLASS64) {
+        return false;
+    }
+    Elf64_Ehdr header;
+    std::memcpy(&header, content.data(), sizeof(header));
+    if (header.e_shoff + static_cast<uint64_t>(header.e_shnum) * sizeof(Elf64_Shdr) >
+        content.size()) {
+        return false;
+    }
+    for (uint16_t sectionIndex = 0; sectionIndex < header.e_shnum; sectionIndex++) {
+        Elf64_Shdr section;
+        std::memcpy(&section,
+                    content.data() + header.e_shoff + sectionIndex * sizeof(Elf64_Shdr),
+                    sizeof(section));
+        if ((section.sh_flags & SHF_ALLOC) == 0) {
+            continue;
+        }
+        if (section.sh_type != SHT_NOBITS) {
+            sizes.flash += section.sh_size;
+        }
+        if ((section.sh_flags & SHF_WRITE) != 0) {
+            sizes.staticRam += section.sh_size;
+        }
+    }
+    return true;
+}
+
+// sizes of the objects of the bike computer library in the given source
+// directory (e.g. "/multi_tasking/")
+static bool getSizes(const char* directory, Sizes& sizes) {
+    const std::string objects(ARCHITECTURE_OBJECTS);
+    bool hasObjects = false;
+    size_t start    = 0;
+    while (start < objects.size()) {
+        size_t end = objects.find(':', start);
+        if (end == std::string::npos) {
+            end = objects.size();
+        }
+        const std::string path = objects.substr(start, end - start);
+        if (path.find(directory) != std::string::npos) {
+            if (!addObjectSizes(path, sizes)) {
+                return false;
+            }
+            hasObjects = true;
+        }
+        start = end + 1;
+    }
+    return hasObjects;
+}
+
+static void printHistogram(FILE* report,
+                           const char* name,
+                           const bike_computer::LatencyHistogram& histogram,
+                           uint32_t nbrOfMissed) {
+    const bool isEmpty = histogram.getCount() == 0;
+    fprintf(report,
+            "      \"%s\": {\"count\": %" PRIu32 ", \"missed\": %" PRIu32 ", \"p50\": %" PRId64
+            ", \"p99\": %" PRId64 ", \"max\": %" PRId64 "},\n",
+            name,
+            histogram.getCount(),
+            nbrOfMissed,
+            isEmpty ? 0 : static_cast<int64_t>(histogram.getPercentile(50.0f).count()),
+            isEmpty ? 0 : static_cast<int64_t>(histogram.getPercentile(99.0f).count()),
+            isEmpty ? 0 : static_cast<int64_t>(histogram.getMax().count()));
+}
+
+int main(int argc, char* argv[]) {
+    const uint32_t nbrOfRepetitions =
+        static_cast<uint32_t>(argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 4);
+    const char* reportFileName = argc > 2 ? argv[2] : "architectures.json";
+    FILE* report               = fopen(reportFileName, "w");
+    if (report == nullptr) {
+        printf("Cannot open %s\n", reportFileName);
+        return 1;
+    }
+
+    host_sim::Kernel& kernel = host_sim::Kernel::instance();
+    kernel.setTimerReadCost(kTimerReadCost);
+    // above all threads of the designs, so that the inputs are injected at
+    // their scheduled time
+    kernel.setPriority(kernel.currentThread(), osPriorityRealtime);
+
+    struct {
+        Design design;
+        const char* name;
+        const char* directory;
+    } const designs[] = {
+        {Design::kPolling, "polling", "/static_scheduling/"},
+        {Design::kInterruptDriven, "interrupt driven", "/static_scheduling_with_event/"},
+        {Design::kEventQueue, "event queue", "/multi_tasking/"},
+        {Design::kRateMonotonic, "rate monotonic", "/multi_tasking/"}};
+
+    bool isConsistent = true;
+    Sizes commonSizes;
+    if (!getSizes("/common/", commonSizes)) {
+        isConsistent = false;
+    }
+    fprintf(report,
+            "{\n  \"repetitions\": %" PRIu32 ",\n  \"input_period_ms\": %" PRId64
+            ",\n  \"press_duration_ms\": %" PRId64 ",\n  \"timer_read_cost_us\": %" PRId64
+            ",\n  \"common\": {\"flash_bytes\": %" PRIu64 ", \"static_ram_bytes\": %" PRIu64
+            "},\n  \"designs\": [\n",
+            nbrOfRepetitions,
+            static_cast<int64_t>(kInputPeriod.count()),
+            static_cast<int64_t>(kPressDuration.count()),
+            static_cast<int64_t>(kTimerReadCost.count()),
+            commonSizes.flash,
+            commonSizes.staticRam);
+
+    const size_t nbrOfDesigns = sizeof(designs) / sizeof(designs[0]);
+    for (size_t designIndex = 0; designIndex < nbrOfDesigns; designIndex++) {
+        const auto& design = designs[designIndex];
+        const Result result = run(design.design, nbrOfRepetitions);
+        Sizes sizes;
+        if (!getSizes(design.directory, sizes)) {
+            isConsistent = false;
+        }
+
+        fprintf(report, "    {\n      \"name\": \"%s\",\n", design.name);
+        printHistogram(
+            report, "reset_response_time_us", result.resetResponseTime, result.nbrOfMissedResets);
+        printHistogram(report,
+                       "gear_to_display_latency_us",
+                       result.gearToDisplayLatency,
+                       result.nbrOfMissedGearPresses);
+        fprintf(report,
+                "      \"cpu_idle_percent\": %" PRIu64 ",\n      \"stack_high_water_bytes\": %" PRIu32
+                ",\n      \"stack_reserved_bytes\": %" PRIu32
+                ",\n      \"heap_high_water_bytes\": %" PRIu32 ",\n      \"flash_bytes\": %" PRIu64
+                ",\n      \"static_ram_bytes\": %" PRIu64 "\n    }%s\n",
+                result.cpuIdlePercent,
+                result.stackHighWater,
+                result.stackReserved,
+                result.heapHighWater,
+                sizes.flash,
+                sizes.staticRam,
+                designIndex + 1 < nbrOfDesigns ? "," : "");
+
+        // the designs that do not poll respond to every input
+        if (design.design != Design::kPolling &&
+            (result.nbrOfMissedResets != 0 || result.nbrOfMissedGearPresses != 0)) {
+            isConsistent = false;
+        }
+        if (result.stackHighWater == 0 || result.heapHighWater == 0) {
+            isConsistent = false;
+        }
+    }
+    fprintf(report, "  ]\n}\n");
+    fclose(report);
+    printf("Report written to %s\n", reportFileName);
+
+    if (!isConsistent) {
+        printf("Missed inputs or missing statistics\n");
+        return 1;
+    }
+    return 0;
+}
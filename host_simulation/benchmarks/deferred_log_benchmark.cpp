@@ -0,0 +1,263 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file deferred_log_benchmark.cpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Compares the deferred binary log lines with the mbed-trace lines
+ *
+ * Usage: benchmark-deferred-log [number of iterations, default 1000000]
+ *
+ * Two log lines of the BikeSystem and of the SyntheticWorkload are written
+ * with tr_warn() / tr_info() (as before the deferred log) and with the
+ * deferred log. The benchmark reports for each line:
+ * - the host time per line (the mbed-trace output goes to /dev/null, the
+ *   deferred log time includes draining the records into frames)
+ * - the bytes sent over the serial port per line (the text line, or the
+ *   binary record with its share of the frame header)
+ * - the worst case time per deferred line when the ring buffer is full,
+ *   with the drop newest and drop oldest policies (the 99.9th percentile
+ *   and the maximum, which includes host preemptions)
+ * The deferred records are then decoded with the host decoder and the
+ * benchmark fails if the text differs from the text printed by mbed-trace.
+ *
+ * This benchmark measures host time (not virtual time).
+ *
+ * @date 2024-05-20
+ * @version 1.0.0
+ ***************************************************************************/
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "common/deferred_log.hpp"
+#include "host_simulation/tools/log_decoder.hpp"
+#include "mbed.h"
+#include "mbed_trace.h"
+
+#define TRACE_GROUP "BikeSystem"
+
+using bike_computer::DeferredLog;
+
+using BenchmarkClock = std::chrono::steady_clock;
+
+// arguments of the log lines, volatile so that the compiler keeps them
+static volatile uint32_t frameIndex;
+static volatile uint32_t nbrOfOverruns;
+static volatile int64_t calibrationTime;
+
+// frames written by the deferred log, as they would be sent to the host
+static std::vector<uint8_t> capture;
+
+template <typename F>
+static double measure(uint32_t nbrOfIterations, F function) {
+    const auto startTime = BenchmarkClock::now();
+    for (uint32_t i = 0; i < nbrOfIterations; i++) {
+        function();
+    }
+    const auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        BenchmarkClock::now() - startTime);
+    return static_cast<double>(duration.count()) / nbrOfIterations;
+}
+
+// tr_warn() and tr_info() write to stdout, which is redirected to /dev/null
+template <typename F>
+static double measureTrace(uint32_t nbrOfIterations, F function) {
+    std::fflush(stdout);
+    const int savedStdout = dup(STDOUT_FILENO);
+    const int nullOutput  = open("/dev/null", O_WRONLY);
+    dup2(nullOutput, STDOUT_FILENO);
+    close(nullOutput);
+
+    const double time = measure(nbrOfIterations, function);
+
+    std::fflush(stdout);
+    dup2(savedStdout, STDOUT_FILENO);
+    close(savedStdout);
+    return time;
+}
+
+// the records are drained each time the ring buffer is full, the frames of
+// the last chunk are kept in the capture, returns the time and serial bytes
+// per line
+template <typename F>
+static double measureDeferredLog(uint32_t nbrOfIterations, F function, double* bytesPerLine) {
+    DeferredLog& deferredLog = DeferredLog::getInstance();
+    deferredLog.enable(true);
+    uint8_t frame[DeferredLog::kFrameHeaderSize +
+                  8 * (DeferredLog::kRecordHeaderSize + DeferredLog::kMaxPayloadSize)];
+    uint64_t nbrOfBytes = 0;
+    uint32_t iterations = 0;
+    const auto startTime = BenchmarkClock::now();
+    while (iterations < nbrOfIterations) {
+        const uint32_t chunk = std::min(nbrOfIterations - iterations, DeferredLog::kCapacity);
+        for (uint32_t i = 0; i < chunk; i++) {
+            function();
+        }
+        iterations += chunk;
+        const bool isLastChunk = (iterations == nbrOfIterations);
+        size_t frameSize       = 0;
+        while ((frameSize = deferredLog.drain(frame, sizeof(frame))) > 0) {
+            nbrOfBytes += frameSize;
+            if (isLastChunk) {
+                capture.insert(capture.end(), frame, frame + frameSize);
+            }
+        }
+    }
+    const auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        BenchmarkClock::now() - startTime);
+    *bytesPerLine = static_cast<double>(nbrOfBytes) / nbrOfIterations;
+    return static_cast<double>(duration.count()) / nbrOfIterations;
+}
+
+// time of each line logged into a full ring buffer, the records are drained
+// after each chunk so that both policies keep dropping
+static std::vector<int64_t> measureFullBuffer(uint32_t nbrOfIterations,
+                                              DeferredLog::DropPolicy dropPolicy) {
+    DeferredLog& deferredLog = DeferredLog::getInstance();
+    deferredLog.enable(true);
+    deferredLog.setDropPolicy(dropPolicy);
+    uint8_t frame[DeferredLog::kFrameHeaderSize +
+                  8 * (DeferredLog::kRecordHeaderSize + DeferredLog::kMaxPayloadSize)];
+    std::vector<int64_t> times;
+    times.reserve(nbrOfIterations);
+    while (times.size() < nbrOfIterations) {
+        while (deferredLog.getNbrOfPendingRecords() < DeferredLog::kCapacity) {
+            DEFERRED_LOG_WARN(bike_computer::kLogFrameOverrun, frameIndex, nbrOfOverruns);
+        }
+        for (uint32_t i = 0; i < DeferredLog::kCapacity && times.size() < nbrOfIterations; i++) {
+            const auto startTime = BenchmarkClock::now();
+            DEFERRED_LOG_WARN(bike_computer::kLogFrameOverrun, frameIndex, nbrOfOverruns);
+            times.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                BenchmarkClock::now() - startTime)
+                                .count());
+        }
+        while (deferredLog.drain(frame, sizeof(frame)) > 0) {
+        }
+    }
+    deferredLog.setDropPolicy(
+        static_cast<DeferredLog::DropPolicy>(MBED_CONF_APP_DEFERRED_LOG_DROP_POLICY));
+    std::sort(times.begin(), times.end());
+    return times;
+}
+
+static void frameOverrunWithTrace() {
+    tr_warn("Frame %" PRIu32 " overrun (%" PRIu32 " overruns)", frameIndex, nbrOfOverruns);
+}
+
+static void frameOverrunWithDeferredLog() {
+    DEFERRED_LOG_WARN(bike_computer::kLogFrameOverrun, frameIndex, nbrOfOverruns);
+}
+
+static void calibratedWithTrace() {
+    tr_info("Calibrated %" PRIu32 " chunks in %" PRId64 " usecs", frameIndex, calibrationTime);
+}
+
+static void calibratedWithDeferredLog() {
+    DEFERRED_LOG_INFO(bike_computer::kLogWorkloadCalibrated, frameIndex, calibrationTime);
+}
+
+int main(int argc, char* argv[]) {
+    const uint32_t nbrOfIterations = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+
+    frameIndex      = 3;
+    nbrOfOverruns   = 17;
+    calibrationTime = 100012;
+    mbed_trace_init();
+    mbed_trace_config_set(TRACE_ACTIVE_LEVEL_ALL);
+
+    // bytes of the mbed-trace lines, formatted as mbed-trace does on target
+    char overrunLine[128];
+    std::snprintf(overrunLine,
+                  sizeof(overrunLine),
+                  "[WARN][%s]: Frame %" PRIu32 " overrun (%" PRIu32 " overruns)",
+                  TRACE_GROUP,
+                  static_cast<uint32_t>(frameIndex),
+                  static_cast<uint32_t>(nbrOfOverruns));
+    char calibratedLine[128];
+    std::snprintf(calibratedLine,
+                  sizeof(calibratedLine),
+                  "[INFO][SyntheticWorkload]: Calibrated %" PRIu32 " chunks in %" PRId64 " usecs",
+                  static_cast<uint32_t>(frameIndex),
+                  static_cast<int64_t>(calibrationTime));
+    const std::vector<std::string> expectedLines = {overrunLine, calibratedLine};
+
+    double overrunBytes    = 0.0;
+    double calibratedBytes = 0.0;
+    const double overrunTraceTime    = measureTrace(nbrOfIterations, frameOverrunWithTrace);
+    const double overrunDeferredTime = measureDeferredLog(
+        nbrOfIterations, frameOverrunWithDeferredLog, &overrunBytes);
+    const double calibratedTraceTime    = measureTrace(nbrOfIterations, calibratedWithTrace);
+    const double calibratedDeferredTime = measureDeferredLog(
+        nbrOfIterations, calibratedWithDeferredLog, &calibratedBytes);
+
+    std::printf("%-36s %12s %14s\n", "Line", "ns per line", "Serial bytes");
+    std::printf("%-36s %12.2f %14zu\n",
+                "Frame overrun (mbed-trace)",
+                overrunTraceTime,
+                std::strlen(overrunLine) + 2);
+    std::printf(
+        "%-36s %12.2f %14.2f\n", "Frame overrun (deferred log)", overrunDeferredTime, overrunBytes);
+    std::printf("%-36s %12.2f %14zu\n",
+                "Workload calibrated (mbed-trace)",
+                calibratedTraceTime,
+                std::strlen(calibratedLine) + 2);
+    std::printf("%-36s %12.2f %14.2f\n",
+                "Workload calibrated (deferred log)",
+                calibratedDeferredTime,
+                calibratedBytes);
+    for (const DeferredLog::DropPolicy dropPolicy :
+         {DeferredLog::kDropNewest, DeferredLog::kDropOldest}) {
+        const std::vector<int64_t> times = measureFullBuffer(nbrOfIterations, dropPolicy);
+        std::printf("Full buffer (%s): %" PRId64 " ns per line (99.9%%), %" PRId64 " ns (max)\n",
+                    (dropPolicy == DeferredLog::kDropNewest) ? "drop newest" : "drop oldest",
+                    times[times.size() * 999 / 1000],
+                    times.back());
+    }
+    std::printf("Deferred log RAM: %zu bytes (ring buffer of %" PRIu32 " records)\n",
+                sizeof(DeferredLog),
+                DeferredLog::kCapacity);
+
+    // the decoded lines must match the mbed-trace lines
+    uint32_t nbrOfLines    = 0;
+    uint32_t nbrOfMismatch = 0;
+    log_decoder::CaptureDecoder decoder([&](uint32_t, const std::string& line) {
+        const std::string& expectedLine =
+            (line.find("Frame") != std::string::npos) ? expectedLines[0] : expectedLines[1];
+        if (line != expectedLine) {
+            if (nbrOfMismatch == 0) {
+                std::printf("Decoded line \"%s\" differs from \"%s\"\n",
+                            line.c_str(),
+                            expectedLine.c_str());
+            }
+            nbrOfMismatch++;
+        }
+        nbrOfLines++;
+    });
+    decoder.decode(capture.data(), capture.size());
+    std::printf("Decoded %" PRIu32 " lines, %" PRIu32 " mismatches, %" PRIu64 " dropped records\n",
+                nbrOfLines,
+                nbrOfMismatch,
+                decoder.getNbrOfDroppedRecords());
+    return (nbrOfLines > 0 && nbrOfMismatch == 0 && decoder.getNbrOfDroppedRecords() == 0) ? 0 : 1;
+}
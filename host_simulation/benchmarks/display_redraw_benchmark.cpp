@@ -0,0 +1,146 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file display_redraw_benchmark.cpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Compares full display redraws with the IncrementalDisplay on a
+ *        steady ride
+ *
+ * Usage: benchmark-display-redraw [nbr of display periods, default 100000]
+ *                                 [LCD cost per field draw in usecs,
+ *                                  default 10000]
+ *
+ * The ride is made of display periods of 1.6 secs at a constant gear and
+ * speed (25 km/h), with the distance increasing accordingly and the
+ * temperature slowly oscillating around 21.5 C with sensor noise. The number
+ * of LCD draws is counted by the simulated DisplayDevice, the LCD time is
+ * derived from the given cost per draw and the CPU time of the display layer
+ * itself (without LCD) is timed on the host.
+ *
+ * @date 2024-02-26
+ * @version 1.0.0
+ ***************************************************************************/
+
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "common/incremental_display.hpp"
+#include "display_device.hpp"
+
+static constexpr float kDisplayPeriodSecs = 1.6f;
+static constexpr float kSpeed             = 25.0f;
+static constexpr uint8_t kGear            = 5;
+
+struct DisplayState {
+    float distance;
+    float temperature;
+};
+
+// deterministic pseudo random generator (LCG)
+static uint32_t nextRandom() {
+    static uint32_t state = 12345;
+    state                 = state * 1664525U + 1013904223U;
+    return state >> 8;
+}
+
+static uint32_t getNbrOfDraws(const advembsof::DisplayDevice& displayDevice) {
+    uint32_t nbrOfDraws = 0;
+    for (uint8_t field = 0; field < advembsof::DisplayDevice::kNbrOfFields; field++) {
+        nbrOfDraws +=
+            displayDevice.getDrawCount(static_cast<advembsof::DisplayDevice::Field>(field));
+    }
+    return nbrOfDraws;
+}
+
+template <typename Display>
+static void display(Display& display, const DisplayState& state) {
+    display.displayGear(kGear);
+    display.displaySpeed(kSpeed);
+    display.displayDistance(state.distance);
+    display.displayTemperature(state.temperature);
+}
+
+template <typename Display>
+static double runPeriods(Display& displayLayer, const std::vector<DisplayState>& states) {
+    const auto startTime = std::chrono::steady_clock::now();
+    for (const DisplayState& state : states) {
+        display(displayLayer, state);
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+int main(int argc, char* argv[]) {
+    const uint32_t nbrOfPeriods = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+    const double drawCostUs     = argc > 2 ? std::strtod(argv[2], nullptr) : 10000.0;
+
+    std::vector<DisplayState> states(nbrOfPeriods);
+    for (uint32_t period = 0; period < nbrOfPeriods; period++) {
+        const float time      = period * kDisplayPeriodSecs;
+        const float noise     = static_cast<float>(nextRandom() % 1000) / 1000.0f - 0.5f;
+        states[period].distance    = kSpeed * time / 3600.0f;
+        states[period].temperature =
+            21.5f + 0.5f * std::sin(time / 600.0f) + 0.004f * noise;
+    }
+
+    advembsof::DisplayDevice fullDevice;
+    fullDevice.init();
+    const double fullTime = runPeriods(fullDevice, states);
+    const uint32_t fullDraws = getNbrOfDraws(fullDevice);
+
+    advembsof::DisplayDevice incrementalDevice;
+    incrementalDevice.init();
+    bike_computer::IncrementalDisplay incrementalDisplay(incrementalDevice);
+    const double incrementalTime = runPeriods(incrementalDisplay, states);
+    const uint32_t incrementalDraws = getNbrOfDraws(incrementalDevice);
+
+    printf("%" PRIu32 " display periods, LCD cost %.0f usecs per field draw\n",
+           nbrOfPeriods,
+           drawCostUs);
+    printf("full redraw:        %.3f draws/period, LCD %.1f ms/period, layer %.0f ns/period\n",
+           static_cast<double>(fullDraws) / nbrOfPeriods,
+           fullDraws * drawCostUs / 1000.0 / nbrOfPeriods,
+           fullTime * 1e9 / nbrOfPeriods);
+    printf("incremental redraw: %.3f draws/period, LCD %.1f ms/period, layer %.0f ns/period\n",
+           static_cast<double>(incrementalDraws) / nbrOfPeriods,
+           incrementalDraws * drawCostUs / 1000.0 / nbrOfPeriods,
+           incrementalTime * 1e9 / nbrOfPeriods);
+    static const char* const kFieldNames[] = {"gear", "speed", "distance", "temperature"};
+    for (uint8_t field = 0; field < bike_computer::IncrementalDisplay::kNbrOfFields; field++) {
+        const auto displayField = static_cast<bike_computer::IncrementalDisplay::Field>(field);
+        printf("  %-12s %8" PRIu32 " redraws %8" PRIu32 " skips\n",
+               kFieldNames[field],
+               incrementalDisplay.getNbrOfRedraws(displayField),
+               incrementalDisplay.getNbrOfSkips(displayField));
+    }
+
+    // the display content must be the same
+    for (uint8_t field = 0; field < advembsof::DisplayDevice::kNbrOfFields; field++) {
+        const auto deviceField = static_cast<advembsof::DisplayDevice::Field>(field);
+        if (std::strcmp(fullDevice.getText(deviceField), incrementalDevice.getText(deviceField)) !=
+            0) {
+            printf("Display content differs: \"%s\" / \"%s\"\n",
+                   fullDevice.getText(deviceField),
+                   incrementalDevice.getText(deviceField));
+            return 1;
+        }
+    }
+    return 0;
+}
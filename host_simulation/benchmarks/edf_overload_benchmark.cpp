@@ -0,0 +1,203 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file edf_overload_benchmark.cpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Deadline miss rate of the mbed EventQueue (release time order) and
+ *        of the EdfEventQueue under increasing utilization (virtual time)
+ *
+ * Usage: benchmark-edf-overload [duration in secs per run, default 60]
+ *
+ * Five periodic tasks with non harmonic periods and implicit deadlines are
+ * released synchronously, each task taking the same share of the total
+ * utilization (busy wait). A job misses its deadline when it completes more
+ * than one period after its release. The EdfEventQueue releases the jobs on
+ * the ideal grid (k * period), while equeue re-arms a late periodic event at
+ * the current tick: its later jobs are measured from the drifted releases and
+ * the skipped releases count as misses, as do the jobs still pending at the
+ * end of a run.
+ *
+ * Both dispatchers run the events to completion (non preemptive), so EDF may
+ * miss deadlines below 100% utilization when a long job blocks a short period
+ * task, and above 100% the misses spread to all the tasks (domino effect).
+ *
+ * @date 2024-03-25
+ * @version 1.0.0
+ ***************************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+
+#include "common/edf_event_queue.hpp"
+#include "mbed.h"
+
+static constexpr std::chrono::milliseconds kTaskPeriods[] = {20ms, 30ms, 50ms, 80ms, 130ms};
+static constexpr size_t kNbrOfTasks = sizeof(kTaskPeriods) / sizeof(kTaskPeriods[0]);
+static constexpr uint32_t kUtilizations[] = {50, 80, 95, 100, 105, 110, 120, 150};
+
+enum class Dispatcher { kEventQueue, kEdf };
+
+class SyntheticTask {
+   public:
+    void setup(Dispatcher dispatcher,
+               Timer* timer,
+               std::chrono::milliseconds duration,
+               std::chrono::milliseconds period,
+               std::chrono::microseconds wcet) {
+        _dispatcher      = dispatcher;
+        _timer           = timer;
+        _duration        = duration;
+        _period          = period;
+        _wcet            = wcet;
+        _release         = std::chrono::microseconds::zero();
+        _nbrOfJobs       = 0;
+        _nbrOfLateJobs   = 0;
+    }
+
+    void run() {
+        wait_us(static_cast<int>(_wcet.count()));
+        const auto completionTime = _timer->elapsed_time();
+        const auto deadline       = _release + _period;
+        if (deadline <= _duration) {
+            _nbrOfJobs++;
+            if (completionTime > deadline) {
+                _nbrOfLateJobs++;
+            }
+        }
+        // next release: equeue re-arms a late periodic event at the current
+        // tick, the following releases drift and the skipped ones are lost
+        _release = _release + _period;
+        if (_dispatcher == Dispatcher::kEventQueue) {
+            _release = std::max<std::chrono::microseconds>(
+                _release, std::chrono::duration_cast<std::chrono::milliseconds>(completionTime));
+        }
+    }
+
+    // number of releases on the ideal grid whose deadline falls within the run
+    uint32_t getNbrOfSlots() const { return static_cast<uint32_t>(_duration / _period); }
+
+    // late jobs, plus the slots without a completed job (jobs still pending at
+    // the end of the run or skipped releases)
+    uint32_t getNbrOfMisses() const { return _nbrOfLateJobs + getNbrOfSlots() - _nbrOfJobs; }
+
+   private:
+    Dispatcher _dispatcher = Dispatcher::kEventQueue;
+    Timer* _timer          = nullptr;
+    std::chrono::milliseconds _duration = std::chrono::milliseconds::zero();
+    std::chrono::milliseconds _period   = std::chrono::milliseconds::zero();
+    std::chrono::microseconds _wcet     = std::chrono::microseconds::zero();
+    std::chrono::microseconds _release  = std::chrono::microseconds::zero();
+    uint32_t _nbrOfJobs                 = 0;
+    uint32_t _nbrOfLateJobs             = 0;
+};
+
+struct Result {
+    uint32_t nbrOfJobs   = 0;
+    uint32_t nbrOfMisses = 0;
+    // highest miss rate of a single task
+    double worstTaskMissRate = 0.0;
+};
+
+static Result runDispatcher(Dispatcher dispatcher,
+                            uint32_t utilization,
+                            std::chrono::milliseconds duration) {
+    static SyntheticTask tasks[kNbrOfTasks];
+    Timer timer;
+    for (size_t taskIndex = 0; taskIndex < kNbrOfTasks; taskIndex++) {
+        const std::chrono::microseconds wcet(
+            std::chrono::microseconds(kTaskPeriods[taskIndex]).count() * utilization / 100 /
+            kNbrOfTasks);
+        tasks[taskIndex].setup(dispatcher, &timer, duration, kTaskPeriods[taskIndex], wcet);
+    }
+
+    // start on a tick, so that the msec releases of both dispatchers match
+    // the timer
+    ThisThread::sleep_until(Kernel::Clock::now() + 1ms);
+    timer.start();
+    if (dispatcher == Dispatcher::kEventQueue) {
+        EventQueue eventQueue;
+        for (SyntheticTask& task : tasks) {
+            Event<void()> event(&eventQueue, callback(&task, &SyntheticTask::run));
+            event.period(kTaskPeriods[&task - tasks]);
+            event.post();
+        }
+        eventQueue.dispatch_for(duration);
+    } else {
+        bike_computer::EdfEventQueue eventQueue;
+        static bike_computer::EdfEvent* events[kNbrOfTasks];
+        for (size_t taskIndex = 0; taskIndex < kNbrOfTasks; taskIndex++) {
+            events[taskIndex] = new bike_computer::EdfEvent(
+                &eventQueue, callback(&tasks[taskIndex], &SyntheticTask::run));
+            events[taskIndex]->period(kTaskPeriods[taskIndex]);
+            events[taskIndex]->post();
+        }
+        eventQueue.dispatch_for(duration);
+        for (bike_computer::EdfEvent* event : events) {
+            event->cancel();
+            delete event;
+        }
+    }
+
+    Result result;
+    for (const SyntheticTask& task : tasks) {
+        const uint32_t nbrOfJobs   = task.getNbrOfSlots();
+        const uint32_t nbrOfMisses = task.getNbrOfMisses();
+        result.nbrOfJobs += nbrOfJobs;
+        result.nbrOfMisses += nbrOfMisses;
+        const double missRate = static_cast<double>(nbrOfMisses) / nbrOfJobs;
+        if (missRate > result.worstTaskMissRate) {
+            result.worstTaskMissRate = missRate;
+        }
+    }
+    return result;
+}
+
+static double getMissRate(const Result& result) {
+    return 100.0 * result.nbrOfMisses / result.nbrOfJobs;
+}
+
+int main(int argc, char* argv[]) {
+    const std::chrono::seconds duration(argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 60);
+
+    printf("%" PRId64 " secs per run, periods 20/30/50/80/130 msecs\n",
+           static_cast<int64_t>(duration.count()));
+    printf("utilization  event queue misses (worst task)  edf misses (worst task)\n");
+    bool isEdfBetter = true;
+    for (uint32_t utilization : kUtilizations) {
+        const Result eventQueueResult =
+            runDispatcher(Dispatcher::kEventQueue, utilization, duration);
+        const Result edfResult = runDispatcher(Dispatcher::kEdf, utilization, duration);
+        printf("%10" PRIu32 "%%  %17.2f%% (%6.2f%%)  %16.2f%% (%6.2f%%)\n",
+               utilization,
+               getMissRate(eventQueueResult),
+               100.0 * eventQueueResult.worstTaskMissRate,
+               getMissRate(edfResult),
+               100.0 * edfResult.worstTaskMissRate);
+        // without overload, EDF must not miss more deadlines than the release
+        // time order
+        if (utilization <= 100 && edfResult.nbrOfMisses > eventQueueResult.nbrOfMisses) {
+            isEdfBetter = false;
+        }
+    }
+    if (!isEdfBetter) {
+        printf("Unexpected deadline misses with EDF up to 100%% utilization\n");
+        return 1;
+    }
+    return 0;
+}
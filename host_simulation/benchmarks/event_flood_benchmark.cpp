@@ -0,0 +1,182 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file event_flood_benchmark.cpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Compares one event per joystick press with the CoalescingMailbox
+ *        under a flood of ISR updates (virtual time)
+ *
+ * Usage: benchmark-event-flood [flood duration in msecs, default 9700]
+ *                              [update period in usecs, default 1000]
+ *
+ * An ISR (Ticker) changes a gear value at the given period during the flood,
+ * while the event thread dispatches both the value events and a display like
+ * event that keeps the thread busy for 200 msecs every 1600 msecs. The event
+ * queue has the default mbed size (32 events). For each mode, the benchmark
+ * reports the number of handler calls, the maximal number of value events
+ * in the queue, the number of posts that failed (full queue) and the delay
+ * between the last update and the handling of the final value. The default
+ * durations end the flood during a busy period of the event thread.
+ *
+ * @date 2024-03-04
+ * @version 1.0.0
+ ***************************************************************************/
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+
+#include "common/coalescing_mailbox.hpp"
+#include "mbed.h"
+
+static constexpr std::chrono::milliseconds kBusyPeriod = 1600ms;
+static constexpr std::chrono::milliseconds kBusyTime   = 200ms;
+
+enum class Mode { kEventPerUpdate, kCoalescing };
+
+struct Result {
+    uint32_t nbrOfUpdates       = 0;
+    uint32_t nbrOfHandlerCalls  = 0;
+    uint32_t maxQueueDepth      = 0;
+    uint32_t nbrOfFailedPosts   = 0;
+    uint8_t finalValue          = 0;
+    uint8_t lastHandledValue    = 0;
+    // from the last update to the last handler call
+    std::chrono::microseconds finalValueLatency = std::chrono::microseconds::zero();
+};
+
+class FloodRun {
+   public:
+    FloodRun(Mode mode, std::chrono::microseconds floodDuration, std::chrono::microseconds updatePeriod)
+        : _mode(mode),
+          _floodDuration(floodDuration),
+          _updatePeriod(updatePeriod),
+          _mailbox(_queue, callback(this, &FloodRun::onValue)) {}
+
+    Result run() {
+        Thread eventThread(osPriorityNormal, OS_STACK_SIZE, nullptr, "eventThread");
+        eventThread.start(callback(&_queue, &EventQueue::dispatch_forever));
+        _queue.call_every(kBusyPeriod, []() { wait_us(std::chrono::microseconds(kBusyTime).count()); });
+
+        _timer.start();
+        _ticker.attach(callback(this, &FloodRun::onUpdate), _updatePeriod);
+        ThisThread::sleep_for(std::chrono::duration_cast<std::chrono::milliseconds>(_floodDuration));
+        _ticker.detach();
+
+        // let the backlog drain
+        ThisThread::sleep_for(5s);
+        _queue.break_dispatch();
+        eventThread.join();
+
+        _result.finalValue        = _value;
+        _result.lastHandledValue  = _lastHandledValue;
+        _result.finalValueLatency = _lastHandledTime - _lastUpdateTime;
+        return _result;
+    }
+
+   private:
+    // ISR, random walk of the gear between 1 and 9
+    void onUpdate() {
+        _state = _state * 1664525U + 1013904223U;
+        if (((_state >> 16) & 1U) != 0) {
+            _value = _value < 9 ? _value + 1 : _value - 1;
+        } else {
+            _value = _value > 1 ? _value - 1 : _value + 1;
+        }
+        _result.nbrOfUpdates++;
+        _lastUpdateTime = _timer.elapsed_time();
+
+        const uint8_t value = _value;
+        bool isPosted       = true;
+        if (_mode == Mode::kEventPerUpdate) {
+            isPosted = _queue.call(callback(this, &FloodRun::onValue), value) != 0;
+        } else {
+            isPosted = _mailbox.post(value);
+        }
+        if (!isPosted) {
+            _result.nbrOfFailedPosts++;
+        }
+        // the periodic busy event is always in the queue
+        const uint32_t queueDepth = static_cast<uint32_t>(_queue.getPendingEvents()) - 1;
+        if (queueDepth > _result.maxQueueDepth) {
+            _result.maxQueueDepth = queueDepth;
+        }
+    }
+
+    // event thread
+    void onValue(const uint8_t& value) {
+        _result.nbrOfHandlerCalls++;
+        _lastHandledValue = value;
+        _lastHandledTime  = _timer.elapsed_time();
+    }
+
+    Mode _mode;
+    std::chrono::microseconds _floodDuration;
+    std::chrono::microseconds _updatePeriod;
+    EventQueue _queue;
+    bike_computer::CoalescingMailbox<uint8_t> _mailbox;
+    Ticker _ticker;
+    Timer _timer;
+    uint32_t _state = 12345;
+    volatile uint8_t _value = 1;
+    uint8_t _lastHandledValue = 0;
+    std::chrono::microseconds _lastUpdateTime  = std::chrono::microseconds::zero();
+    std::chrono::microseconds _lastHandledTime = std::chrono::microseconds::zero();
+    Result _result;
+};
+
+static void printResult(const char* name, const Result& result) {
+    printf("%-17s %8" PRIu32 " updates %8" PRIu32 " handler calls, max queue depth %4" PRIu32
+           ", %6" PRIu32 " failed posts, final value %" PRIu8 " handled %" PRIu8
+           " after %" PRId64 " usecs\n",
+           name,
+           result.nbrOfUpdates,
+           result.nbrOfHandlerCalls,
+           result.maxQueueDepth,
+           result.nbrOfFailedPosts,
+           result.finalValue,
+           result.lastHandledValue,
+           static_cast<int64_t>(result.finalValueLatency.count()));
+}
+
+int main(int argc, char* argv[]) {
+    const std::chrono::milliseconds floodDuration(argc > 1 ? std::strtoul(argv[1], nullptr, 10)
+                                                           : 9700);
+    const std::chrono::microseconds updatePeriod(argc > 2 ? std::strtoul(argv[2], nullptr, 10)
+                                                          : 1000);
+
+    printf("Flood of %" PRId64 " msecs, one update every %" PRId64 " usecs\n",
+           static_cast<int64_t>(floodDuration.count()),
+           static_cast<int64_t>(updatePeriod.count()));
+
+    static FloodRun eventPerUpdate(Mode::kEventPerUpdate, floodDuration, updatePeriod);
+    const Result eventPerUpdateResult = eventPerUpdate.run();
+    printResult("event per update", eventPerUpdateResult);
+
+    static FloodRun coalescing(Mode::kCoalescing, floodDuration, updatePeriod);
+    const Result coalescingResult = coalescing.run();
+    printResult("coalescing", coalescingResult);
+
+    // the mailbox must keep at most one event in the queue and always deliver
+    // the final value
+    if (coalescingResult.maxQueueDepth > 1 || coalescingResult.nbrOfFailedPosts != 0 ||
+        coalescingResult.lastHandledValue != coalescingResult.finalValue) {
+        printf("Unexpected coalescing result\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,71 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file fragmentation_benchmark.cpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Replays the allocation traces against the allocators on the host
+ *
+ * Usage: benchmark-fragmentation
+ *
+ * Prints the report of common/fragmentation_benchmark.hpp, the same report
+ * is printed on target by the fragmentation test suite. The worst alloc /
+ * free times are host nsecs and include host preemptions.
+ *
+ * The benchmark fails if the fixed blocks trace of the MemoryFragmenter
+ * does not fail on its last allocation with the first fit and the TLSF
+ * allocators (the freed blocks are not contiguous) or if one of them fails
+ * on the bursty event payloads.
+ *
+ * @date 2024-06-10
+ * @version 1.0.0
+ ***************************************************************************/
+
+#include <cinttypes>
+#include <cstdio>
+
+#include "common/fragmentation_benchmark.hpp"
+
+using bike_computer::FragmentationBenchmark;
+
+// statically allocated, as on target (the arena is part of the instance)
+static FragmentationBenchmark benchmark;
+
+int main() {
+    benchmark.run();
+    benchmark.printReport();
+
+    bool isOk = true;
+    // the block pools are not sized for the payload mix and may fail, they
+    // are not checked
+    for (const FragmentationBenchmark::Allocator allocator :
+         {FragmentationBenchmark::kFirstFitAllocator, FragmentationBenchmark::kTlsfAllocator}) {
+        const FragmentationBenchmark::Result& fixedBlocks =
+            benchmark.getResult(FragmentationBenchmark::kFixedBlocks, allocator);
+        if (fixedBlocks.nbrOfFailures != 1 || fixedBlocks.failureIndex != 12) {
+            std::printf("The fixed blocks trace should fail on its last allocation with %s\n",
+                        benchmark.getAllocatorName(allocator));
+            isOk = false;
+        }
+        const FragmentationBenchmark::Result& burstyPayloads =
+            benchmark.getResult(FragmentationBenchmark::kBurstyPayloads, allocator);
+        if (burstyPayloads.nbrOfFailures != 0) {
+            std::printf("The %s allocator failed on the bursty payloads\n",
+                        benchmark.getAllocatorName(allocator));
+            isOk = false;
+        }
+    }
+    return isOk ? 0 : 1;
+}
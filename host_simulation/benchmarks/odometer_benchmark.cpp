@@ -0,0 +1,159 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file odometer_benchmark.cpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Compares the fixed-point Odometer with the former float distance
+ *        computation of the Speedometer over a long simulated ride
+ *
+ * Usage: benchmark-odometer [ride duration in hours, default 10]
+ *
+ * The ride is made of distance updates every 400 ms (speed task period) with
+ * +/- 1 ms of jitter, and of a random gear size / pedal rotation time change
+ * every 5 minutes. Both implementations are compared to the exact distance
+ * and timed on the host.
+ *
+ * @date 2024-01-29
+ * @version 1.0.0
+ ***************************************************************************/
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "common/odometer.hpp"
+#include "common/speed_table.hpp"
+
+// same values as the Speedometer
+static constexpr uint8_t kTraySize              = 50;
+static constexpr float kWheelCircumference      = 2.1f;
+static constexpr uint32_t kWheelCircumferenceUm = 2100000;
+
+static constexpr std::chrono::microseconds kUpdatePeriod = 400000us;
+static constexpr std::chrono::microseconds kChangePeriod = 300s;
+
+struct Update {
+    // elapsed time since the previous update
+    std::chrono::microseconds elapsedTime;
+    uint8_t gearSize;
+    std::chrono::milliseconds pedalRotationTime;
+};
+
+// deterministic pseudo random generator (LCG)
+static uint32_t nextRandom() {
+    static uint32_t state = 12345;
+    state                 = state * 1664525U + 1013904223U;
+    return state >> 8;
+}
+
+static std::vector<Update> createRide(uint32_t nbrOfHours) {
+    std::vector<Update> ride;
+    const std::chrono::microseconds rideDuration = std::chrono::hours(nbrOfHours);
+    std::chrono::microseconds time               = std::chrono::microseconds::zero();
+    std::chrono::microseconds nextChange         = std::chrono::microseconds::zero();
+    uint8_t gearSize                             = bike_computer::kMaxGearSize;
+    auto pedalRotationTime                       = bike_computer::kInitialPedalRotationTime;
+    while (time < rideDuration) {
+        if (time >= nextChange) {
+            gearSize = bike_computer::kMinGearSize +
+                       nextRandom() % bike_computer::SpeedTable::kNbrOfGearSizes;
+            pedalRotationTime =
+                bike_computer::kMinPedalRotationTime +
+                (nextRandom() % bike_computer::SpeedTable::kNbrOfRotationTimes) *
+                    bike_computer::kDeltaPedalRotationTime;
+            nextChange += kChangePeriod;
+        }
+        const std::chrono::microseconds elapsedTime =
+            kUpdatePeriod + std::chrono::microseconds(nextRandom() % 2001) - 1000us;
+        ride.push_back({elapsedTime, gearSize, pedalRotationTime});
+        time += elapsedTime;
+    }
+    return ride;
+}
+
+// distance in km computed as in the former Speedometer implementation: the
+// elapsed time is truncated to milliseconds and the distance is accumulated
+// in a float
+static float floatDistance(const std::vector<Update>& ride) {
+    float totalDistance = 0.0f;
+    for (const Update& update : ride) {
+        const float speed = bike_computer::computeSpeed(
+            kTraySize, kWheelCircumference, update.gearSize, update.pedalRotationTime);
+        const std::chrono::microseconds elapsedTime =
+            std::chrono::duration_cast<std::chrono::milliseconds>(update.elapsedTime);
+        const float distance = speed * elapsedTime.count() / 3600000000.0;
+        totalDistance += distance;
+    }
+    return totalDistance;
+}
+
+static uint64_t odometerDistance(const std::vector<Update>& ride) {
+    bike_computer::Odometer odometer;
+    for (const Update& update : ride) {
+        odometer.setRate(kTraySize * kWheelCircumferenceUm,
+                         update.gearSize * update.pedalRotationTime.count() * 1000);
+        odometer.update(update.elapsedTime);
+    }
+    return odometer.getMicrometres();
+}
+
+// exact distance in m
+static long double exactDistance(const std::vector<Update>& ride) {
+    long double totalDistance = 0.0L;
+    for (const Update& update : ride) {
+        totalDistance += static_cast<long double>(update.elapsedTime.count()) * kTraySize *
+                         kWheelCircumferenceUm /
+                         (static_cast<long double>(update.gearSize) *
+                          update.pedalRotationTime.count() * 1000.0L) /
+                         1000000.0L;
+    }
+    return totalDistance;
+}
+
+// results are written to a volatile variable, so that the computation cannot
+// be optimized away
+static volatile double sink;
+
+template <typename F>
+static double updatesPerSecond(const std::vector<Update>& ride, F function) {
+    const auto startTime = std::chrono::steady_clock::now();
+    sink                 = function(ride);
+    const auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - startTime);
+    return ride.size() * 1e9 / duration.count();
+}
+
+int main(int argc, char* argv[]) {
+    const uint32_t nbrOfHours = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 10;
+
+    const std::vector<Update> ride = createRide(nbrOfHours);
+
+    const long double exact = exactDistance(ride);
+    const double floatPath  = floatDistance(ride) * 1000.0;
+    const double fixedPath  = odometerDistance(ride) / 1000000.0;
+
+    std::printf("Ride: %" PRIu32 " hours, %zu updates\n", nbrOfHours, ride.size());
+    std::printf("Exact distance:    %.6Lf m\n", exact);
+    std::printf("Float distance:    %.6f m (drift %.6Lf m)\n", floatPath, floatPath - exact);
+    std::printf("Odometer distance: %.6f m (drift %.6Lf m)\n", fixedPath, fixedPath - exact);
+    std::printf("Float path:    %.0f updates/s\n", updatesPerSecond(ride, floatDistance));
+    std::printf("Odometer path: %.0f updates/s\n", updatesPerSecond(ride, odometerDistance));
+
+    // the odometer truncates to the micrometre only
+    return ((exact - fixedPath) < 0.000001L && (exact - fixedPath) >= 0.0L) ? 0 : 1;
+}
@@ -0,0 +1,219 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file rate_monotonic_benchmark.cpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Compares the multi_tasking event queue design with the rate
+ *        monotonic thread per task mode under a slow LCD (virtual time)
+ *
+ * Usage: benchmark-rate-monotonic [duration in secs, default 60]
+ *                                 [LCD cost per field draw in usecs,
+ *                                  default 50000]
+ *
+ * The same input trace is applied to both designs: a joystick press (gear up
+ * or down) every 230 msecs and a reset every 1370 msecs, both from ISRs. The
+ * benchmark reports the reset response time (until the speedometer is
+ * reset), the gear latency (until the new gear is published, sampled every
+ * msec) and the response time and deadline misses of the periodic tasks as
+ * measured by the task tracer.
+ *
+ * @date 2024-03-18
+ * @version 1.0.0
+ ***************************************************************************/
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+
+#include "common/latency_histogram.hpp"
+#include "display_device.hpp"
+#include "mbed.h"
+#include "multi_tasking/bike_system.hpp"
+
+static constexpr std::chrono::milliseconds kGearPressPeriod = 230ms;
+static constexpr std::chrono::milliseconds kResetPeriod     = 1370ms;
+static constexpr std::chrono::milliseconds kGearSamplingPeriod = 1ms;
+
+enum class Mode { kEventQueue, kRateMonotonic };
+
+struct TaskResult {
+    std::chrono::microseconds responseTimeP99 = std::chrono::microseconds::zero();
+    std::chrono::microseconds maxResponseTime = std::chrono::microseconds::zero();
+    uint32_t nbrOfDeadlineMisses = 0;
+};
+
+struct Result {
+    bike_computer::LatencyHistogram resetResponseTime;
+    bike_computer::LatencyHistogram gearLatency;
+    TaskResult temperatureTask;
+    TaskResult displayTask;
+};
+
+class ModeRun {
+   public:
+    ModeRun(Mode mode, std::chrono::seconds duration) : _mode(mode), _duration(duration) {}
+
+    const Result& run() {
+        Thread systemThread(osPriorityNormal, OS_STACK_SIZE, nullptr, "systemThread");
+        if (_mode == Mode::kEventQueue) {
+            systemThread.start(callback(&_bikeSystem, &multi_tasking::BikeSystem::start));
+        } else {
+            systemThread.start(callback(&_bikeSystem,
+                                        &multi_tasking::BikeSystem::startWithRateMonotonicThreads));
+        }
+        Thread monitorThread(osPriorityRealtime, OS_STACK_SIZE, nullptr, "monitorThread");
+        monitorThread.start(callback(this, &ModeRun::monitorGear));
+
+        // let the bike system start
+        ThisThread::sleep_for(1s);
+        _bikeSystem.getSpeedometer().setOnResetCallback(callback(this, &ModeRun::onResetDone));
+        _timer.start();
+        _gearTicker.attach(callback(this, &ModeRun::onGearPress), kGearPressPeriod);
+        _resetTicker.attach(callback(this, &ModeRun::onResetPress), kResetPeriod);
+
+        ThisThread::sleep_for(_duration);
+
+        _gearTicker.detach();
+        _resetTicker.detach();
+        monitorThread.terminate();
+        _bikeSystem.stop();
+
+        const bike_computer::TaskTracer& taskTracer = _bikeSystem.getTaskLogger();
+        _result.temperatureTask =
+            getTaskResult(taskTracer, advembsof::TaskLogger::kTemperatureTaskIndex);
+        _result.displayTask = getTaskResult(taskTracer, advembsof::TaskLogger::kDisplayTask1Index);
+        return _result;
+    }
+
+   private:
+    static TaskResult getTaskResult(const bike_computer::TaskTracer& taskTracer,
+                                    uint8_t taskIndex) {
+        const bike_computer::TaskTracer::TaskStatistics& statistics =
+            taskTracer.getTaskStatistics(taskIndex);
+        TaskResult result;
+        result.responseTimeP99     = statistics.responseTime.getPercentile(99.0f);
+        result.maxResponseTime     = statistics.responseTime.getMax();
+        result.nbrOfDeadlineMisses = statistics.nbrOfDeadlineMisses;
+        return result;
+    }
+
+    // ISR, alternate gear up and down
+    void onGearPress() {
+        _isGearUp = !_isGearUp;
+        _expectedGear = _isGearUp ? bike_computer::kMinGear + 1 : bike_computer::kMinGear;
+        _gearPressTime = _timer.elapsed_time();
+        core_util_atomic_store_bool(&_isGearPending, true);
+        if (_isGearUp) {
+            _bikeSystem.getGearDevice().onUp();
+        } else {
+            _bikeSystem.getGearDevice().onDown();
+        }
+    }
+
+    // ISR
+    void onResetPress() {
+        _resetPressTime = _timer.elapsed_time();
+        _bikeSystem.onReset();
+    }
+
+    void onResetDone() {
+        _result.resetResponseTime.record(_timer.elapsed_time() - _resetPressTime);
+    }
+
+    // highest priority thread, samples the published gear
+    void monitorGear() {
+        while (true) {
+            ThisThread::sleep_for(kGearSamplingPeriod);
+            if (core_util_atomic_load_bool(&_isGearPending) &&
+                _bikeSystem.getCurrentGear() == _expectedGear) {
+                core_util_atomic_store_bool(&_isGearPending, false);
+                _result.gearLatency.record(_timer.elapsed_time() - _gearPressTime);
+            }
+        }
+    }
+
+    Mode _mode;
+    std::chrono::seconds _duration;
+    multi_tasking::BikeSystem _bikeSystem;
+    Timer _timer;
+    Ticker _gearTicker;
+    Ticker _resetTicker;
+    bool _isGearUp = false;
+    volatile uint8_t _expectedGear = bike_computer::kMinGear;
+    volatile bool _isGearPending = false;
+    std::chrono::microseconds _gearPressTime  = std::chrono::microseconds::zero();
+    std::chrono::microseconds _resetPressTime = std::chrono::microseconds::zero();
+    Result _result;
+};
+
+static void printLatency(const char* name, const bike_computer::LatencyHistogram& histogram) {
+    printf("  %-24s %6" PRIu32 " samples, p50 %8" PRId64 " p99 %8" PRId64 " max %8" PRId64
+           " usecs\n",
+           name,
+           histogram.getCount(),
+           static_cast<int64_t>(histogram.getPercentile(50.0f).count()),
+           static_cast<int64_t>(histogram.getPercentile(99.0f).count()),
+           static_cast<int64_t>(histogram.getMax().count()));
+}
+
+static void printTask(const char* name, const TaskResult& result) {
+    printf("  %-24s response p99 %8" PRId64 " max %8" PRId64 " usecs, %" PRIu32
+           " deadline misses\n",
+           name,
+           static_cast<int64_t>(result.responseTimeP99.count()),
+           static_cast<int64_t>(result.maxResponseTime.count()),
+           result.nbrOfDeadlineMisses);
+}
+
+static void printResult(const char* name, const Result& result) {
+    printf("%s\n", name);
+    printLatency("reset response time", result.resetResponseTime);
+    printLatency("gear latency (1 ms)", result.gearLatency);
+    printTask("temperature task", result.temperatureTask);
+    printTask("display task", result.displayTask);
+}
+
+int main(int argc, char* argv[]) {
+    const std::chrono::seconds duration(argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 60);
+    const std::chrono::microseconds drawCost(argc > 2 ? std::strtoul(argv[2], nullptr, 10)
+                                                      : 50000);
+
+    printf("%" PRId64 " secs, LCD cost %" PRId64 " usecs per field draw\n",
+           static_cast<int64_t>(duration.count()),
+           static_cast<int64_t>(drawCost.count()));
+    advembsof::DisplayDevice::setDrawCost(drawCost);
+
+    static ModeRun eventQueueRun(Mode::kEventQueue, duration);
+    const Result& eventQueueResult = eventQueueRun.run();
+    printResult("event queue", eventQueueResult);
+
+    static ModeRun rateMonotonicRun(Mode::kRateMonotonic, duration);
+    const Result& rateMonotonicResult = rateMonotonicRun.run();
+    printResult("rate monotonic threads", rateMonotonicResult);
+
+    // the event driven tasks must preempt the LCD refresh, without any
+    // deadline miss of the periodic tasks
+    if (rateMonotonicResult.resetResponseTime.getCount() == 0 ||
+        rateMonotonicResult.resetResponseTime.getMax() > drawCost ||
+        rateMonotonicResult.gearLatency.getMax() > drawCost ||
+        rateMonotonicResult.temperatureTask.nbrOfDeadlineMisses != 0 ||
+        rateMonotonicResult.displayTask.nbrOfDeadlineMisses != 0) {
+        printf("Unexpected rate monotonic result\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,460 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file scalability_benchmark.cpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Scalability of the scheduling backends with 1 to 256 synthetic
+ *        periodic tasks (virtual time), results as CSV
+ *
+ * Usage: benchmark-scalability [duration in msecs per run, default 4000]
+ *                              [max number of tasks, default 256]
+ *                              [csv file, default stdout]
+ *
+ * The backends are the ones of the bike system designs, with generated tasks
+ * instead of the six bike tasks:
+ * - super-loop: a single thread that runs, in table order, the tasks whose
+ *   release time is reached and then sleeps until the earliest next release
+ * - event queue: one periodic Event per task (mbed EventQueue)
+ * - edf: one periodic EdfEvent per task (EdfEventQueue)
+ * - rate monotonic: one thread per task, the shorter the period the higher
+ *   the priority. Above 40 distinct periods, the priority range (osPriorityLow
+ *   to osPriorityRealtime - 1) is exhausted and neighbouring periods share a
+ *   priority (no preemption among them)
+ *
+ * The periods are generated once (the first n tasks of each run are always
+ * the same), either harmonic (10 * 2^k msecs up to 1280 msecs) or not
+ * (log-uniform between 10 and 1000 msecs). The tasks are released together
+ * and each one takes the same share of the utilization (busy wait), with an
+ * implicit deadline. The misses are counted as in benchmark-edf-overload.
+ *
+ * For each backend, period set and number of tasks, one CSV row gives:
+ * - host_ns_per_event: host time of the dispatch phase at
+ *   kReferenceUtilization (without the creation of the events or threads)
+ *   divided by the number of jobs. The virtual time does not charge the scheduler
+ *   code, so that this is the cost of the host implementation (including the
+ *   simulated kernel and its thread switches): compare trends, not values
+ * - deadline_misses and jobs at kReferenceUtilization
+ * - ram_per_task_bytes: scheduler memory per task (host sizes, 64 bits
+ *   pointers), a thread counts its kThreadStackSize stack
+ * - breakdown_utilization_percent: highest utilization (bisection, 1%
+ *   resolution) without any deadline miss
+ *
+ * @date 2024-04-22
+ * @version 1.0.0
+ ***************************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include "common/edf_event_queue.hpp"
+#include "host_sim/virtual_kernel.hpp"
+#include "mbed.h"
+
+static constexpr size_t kMaxNbrOfTasks = 256;
+// asymptotic Liu and Layland bound (ln 2)
+static constexpr uint32_t kReferenceUtilization = 69;
+static constexpr uint32_t kThreadStackSize      = 1024;
+static constexpr int kLowestTaskPriority        = osPriorityLow;
+static constexpr int kNbrOfTaskPriorities       = osPriorityRealtime - osPriorityLow;
+static constexpr std::chrono::milliseconds kHarmonicPeriods[] = {
+    10ms, 20ms, 40ms, 80ms, 160ms, 320ms, 640ms, 1280ms};
+static constexpr std::chrono::milliseconds kMinPeriod = 10ms;
+static constexpr std::chrono::milliseconds kMaxPeriod = 1000ms;
+
+using HostClock    = std::chrono::steady_clock;
+using HostDuration = HostClock::duration;
+
+enum class Backend { kSuperLoop, kEventQueue, kEdf, kRateMonotonic };
+enum class PeriodSet { kHarmonic, kNonHarmonic };
+
+class SyntheticTask {
+   public:
+    void setup(const Timer* timer,
+               std::chrono::milliseconds duration,
+               std::chrono::milliseconds period,
+               std::chrono::microseconds wcet,
+               bool isReleaseClamped) {
+        _timer            = timer;
+        _duration         = duration;
+        _period           = period;
+        _wcet             = wcet;
+        _isReleaseClamped = isReleaseClamped;
+        _release          = std::chrono::microseconds::zero();
+        _nbrOfRuns        = 0;
+        _nbrOfJobs        = 0;
+        _nbrOfLateJobs    = 0;
+    }
+
+    // one job, released at getRelease()
+    void run() {
+        wait_us(static_cast<int>(_wcet.count()));
+        const auto completionTime = _timer->elapsed_time();
+        const auto deadline       = _release + _period;
+        _nbrOfRuns++;
+        if (deadline <= _duration) {
+            _nbrOfJobs++;
+            if (completionTime > deadline) {
+                _nbrOfLateJobs++;
+            }
+        }
+        // equeue re-arms a late periodic event at the current tick, the
+        // other backends keep the ideal releases
+        _release = _release + _period;
+        if (_isReleaseClamped) {
+            _release = std::max<std::chrono::microseconds>(
+                _release, std::chrono::duration_cast<std::chrono::milliseconds>(completionTime));
+        }
+    }
+
+    // thread function of the rate monotonic backend
+    void runPeriodically(Kernel::Clock::time_point startTime) {
+        while (getRelease() < _duration) {
+            ThisThread::sleep_until(startTime + getRelease());
+            run();
+        }
+    }
+
+    std::chrono::milliseconds getRelease() const {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(_release);
+    }
+
+    std::chrono::milliseconds getPeriod() const { return _period; }
+
+    uint32_t getNbrOfRuns() const { return _nbrOfRuns; }
+
+    // number of releases on the ideal grid whose deadline falls within the run
+    uint32_t getNbrOfSlots() const { return static_cast<uint32_t>(_duration / _period); }
+
+    // late jobs, plus the slots without a completed job
+    uint32_t getNbrOfMisses() const { return _nbrOfLateJobs + getNbrOfSlots() - _nbrOfJobs; }
+
+   private:
+    const Timer* _timer                 = nullptr;
+    std::chrono::milliseconds _duration = std::chrono::milliseconds::zero();
+    std::chrono::milliseconds _period   = std::chrono::milliseconds::zero();
+    std::chrono::microseconds _wcet     = std::chrono::microseconds::zero();
+    bool _isReleaseClamped              = false;
+    std::chrono::microseconds _release  = std::chrono::microseconds::zero();
+    uint32_t _nbrOfRuns                 = 0;
+    uint32_t _nbrOfJobs                 = 0;
+    uint32_t _nbrOfLateJobs             = 0;
+};
+
+struct RunResult {
+    uint32_t nbrOfJobs           = 0;
+    uint32_t nbrOfDeadlineMisses = 0;
+    uint64_t hostNsPerEvent      = 0;
+};
+
+static std::chrono::milliseconds periods[2][kMaxNbrOfTasks];
+static SyntheticTask tasks[kMaxNbrOfTasks];
+
+static void generatePeriods() {
+    uint32_t state = 12345;
+    for (size_t taskIndex = 0; taskIndex < kMaxNbrOfTasks; taskIndex++) {
+        state = state * 1664525U + 1013904223U;
+        const uint32_t random = state >> 16;
+        periods[static_cast<size_t>(PeriodSet::kHarmonic)][taskIndex] =
+            kHarmonicPeriods[random % (sizeof(kHarmonicPeriods) / sizeof(kHarmonicPeriods[0]))];
+        // log-uniform between kMinPeriod and kMaxPeriod
+        const double ratio =
+            static_cast<double>(kMaxPeriod.count()) / static_cast<double>(kMinPeriod.count());
+        const double period = kMinPeriod.count() * std::pow(ratio, random / 65536.0);
+        periods[static_cast<size_t>(PeriodSet::kNonHarmonic)][taskIndex] =
+            std::chrono::milliseconds(static_cast<int64_t>(std::lround(period)));
+    }
+}
+
+// rank of the period among the distinct periods, the longest period has rank 0
+static int getRateMonotonicPriority(size_t nbrOfTasks, size_t taskIndex) {
+    size_t nbrOfDistinctPeriods = 0;
+    size_t rank                 = 0;
+    for (size_t otherIndex = 0; otherIndex < nbrOfTasks; otherIndex++) {
+        bool isFirst = true;
+        for (size_t previousIndex = 0; previousIndex < otherIndex; previousIndex++) {
+            if (tasks[previousIndex].getPeriod() == tasks[otherIndex].getPeriod()) {
+                isFirst = false;
+                break;
+            }
+        }
+        if (isFirst) {
+            nbrOfDistinctPeriods++;
+            if (tasks[otherIndex].getPeriod() > tasks[taskIndex].getPeriod()) {
+                rank++;
+            }
+        }
+    }
+    if (nbrOfDistinctPeriods > static_cast<size_t>(kNbrOfTaskPriorities)) {
+        rank = rank * kNbrOfTaskPriorities / nbrOfDistinctPeriods;
+    }
+    return kLowestTaskPriority + static_cast<int>(rank);
+}
+
+static size_t getRamPerTask(Backend backend) {
+    switch (backend) {
+        case Backend::kSuperLoop:
+            // period, next release and task function
+            return sizeof(std::chrono::milliseconds) + sizeof(Kernel::Clock::time_point) +
+                   sizeof(mbed::Callback<void()>);
+        case Backend::kEventQueue:
+            // in the queue buffer
+            return EVENTS_EVENT_SIZE + sizeof(mbed::Callback<void()>);
+        case Backend::kEdf:
+            return sizeof(bike_computer::EdfEvent);
+        case Backend::kRateMonotonic:
+            return sizeof(Thread) + kThreadStackSize;
+    }
+    return 0;
+}
+
+// each backend returns the host time of its dispatch phase
+
+static HostDuration runSuperLoop(size_t nbrOfTasks,
+                                 Kernel::Clock::time_point startTime,
+                                 std::chrono::milliseconds duration) {
+    const auto hostStartTime                = HostClock::now();
+    const Kernel::Clock::time_point endTime = startTime + duration;
+    while (Kernel::Clock::now() < endTime) {
+        Kernel::Clock::time_point nextRelease = endTime;
+        for (size_t taskIndex = 0; taskIndex < nbrOfTasks; taskIndex++) {
+            if (startTime + tasks[taskIndex].getRelease() <= Kernel::Clock::now()) {
+                tasks[taskIndex].run();
+            }
+            nextRelease = std::min(nextRelease, startTime + tasks[taskIndex].getRelease());
+        }
+        if (nextRelease > Kernel::Clock::now()) {
+            ThisThread::sleep_until(nextRelease);
+        }
+    }
+    return HostClock::now() - hostStartTime;
+}
+
+static HostDuration runEventQueue(size_t nbrOfTasks, std::chrono::milliseconds duration) {
+    static constexpr size_t kEventSize = EVENTS_EVENT_SIZE + sizeof(mbed::Callback<void()>);
+    EventQueue eventQueue(kMaxNbrOfTasks * kEventSize);
+    for (size_t taskIndex = 0; taskIndex < nbrOfTasks; taskIndex++) {
+        // released right away, unlike call_every()
+        Event<void()> event(&eventQueue, callback(&tasks[taskIndex], &SyntheticTask::run));
+        event.period(tasks[taskIndex].getPeriod());
+        event.post();
+    }
+    const auto hostStartTime = HostClock::now();
+    eventQueue.dispatch_for(duration);
+    return HostClock::now() - hostStartTime;
+}
+
+static HostDuration runEdf(size_t nbrOfTasks, std::chrono::milliseconds duration) {
+    bike_computer::EdfEventQueue eventQueue;
+    static bike_computer::EdfEvent* events[kMaxNbrOfTasks];
+    for (size_t taskIndex = 0; taskIndex < nbrOfTasks; taskIndex++) {
+        events[taskIndex] = new bike_computer::EdfEvent(
+            &eventQueue, callback(&tasks[taskIndex], &SyntheticTask::run));
+        events[taskIndex]->period(tasks[taskIndex].getPeriod());
+        events[taskIndex]->post();
+    }
+    const auto hostStartTime = HostClock::now();
+    eventQueue.dispatch_for(duration);
+    const HostDuration hostTime = HostClock::now() - hostStartTime;
+    for (size_t taskIndex = 0; taskIndex < nbrOfTasks; taskIndex++) {
+        events[taskIndex]->cancel();
+        delete events[taskIndex];
+    }
+    return hostTime;
+}
+
+static HostDuration runRateMonotonic(size_t nbrOfTasks,
+                                     Kernel::Clock::time_point startTime,
+                                     std::chrono::milliseconds duration) {
+    static Thread* threads[kMaxNbrOfTasks];
+    for (size_t taskIndex = 0; taskIndex < nbrOfTasks; taskIndex++) {
+        threads[taskIndex] = new Thread(
+            static_cast<osPriority>(getRateMonotonicPriority(nbrOfTasks, taskIndex)),
+            kThreadStackSize,
+            nullptr,
+            "task");
+        threads[taskIndex]->start(
+            [taskIndex, startTime]() { tasks[taskIndex].runPeriodically(startTime); });
+    }
+    // main has the highest priority and stops overloaded threads, one tick
+    // after the end so that a job with a deadline at the end completes
+    const auto hostStartTime = HostClock::now();
+    ThisThread::sleep_until(startTime + duration + 1ms);
+    const HostDuration hostTime = HostClock::now() - hostStartTime;
+    for (size_t taskIndex = 0; taskIndex < nbrOfTasks; taskIndex++) {
+        threads[taskIndex]->terminate();
+        delete threads[taskIndex];
+    }
+    return hostTime;
+}
+
+static RunResult run(Backend backend,
+                     PeriodSet periodSet,
+                     size_t nbrOfTasks,
+                     uint32_t utilization,
+                     std::chrono::milliseconds duration) {
+    Timer timer;
+    for (size_t taskIndex = 0; taskIndex < nbrOfTasks; taskIndex++) {
+        const std::chrono::milliseconds period =
+            periods[static_cast<size_t>(periodSet)][taskIndex];
+        const std::chrono::microseconds wcet(std::chrono::microseconds(period).count() *
+                                             utilization / 100 / nbrOfTasks);
+        tasks[taskIndex].setup(
+            &timer, duration, period, wcet, backend == Backend::kEventQueue);
+    }
+
+    // start on a tick, so that the msec releases match the timer
+    ThisThread::sleep_until(Kernel::Clock::now() + 1ms);
+    const Kernel::Clock::time_point startTime = Kernel::Clock::now();
+    timer.start();
+    HostDuration hostTime = HostDuration::zero();
+    switch (backend) {
+        case Backend::kSuperLoop:
+            hostTime = runSuperLoop(nbrOfTasks, startTime, duration);
+            break;
+        case Backend::kEventQueue:
+            hostTime = runEventQueue(nbrOfTasks, duration);
+            break;
+        case Backend::kEdf:
+            hostTime = runEdf(nbrOfTasks, duration);
+            break;
+        case Backend::kRateMonotonic:
+            hostTime = runRateMonotonic(nbrOfTasks, startTime, duration);
+            break;
+    }
+
+    RunResult result;
+    uint32_t nbrOfRuns = 0;
+    for (size_t taskIndex = 0; taskIndex < nbrOfTasks; taskIndex++) {
+        result.nbrOfJobs += tasks[taskIndex].getNbrOfSlots();
+        result.nbrOfDeadlineMisses += tasks[taskIndex].getNbrOfMisses();
+        nbrOfRuns += tasks[taskIndex].getNbrOfRuns();
+    }
+    if (nbrOfRuns > 0) {
+        result.hostNsPerEvent =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(hostTime).count() / nbrOfRuns;
+    }
+    return result;
+}
+
+// highest utilization without deadline miss, assuming that the misses do not
+// decrease with the utilization
+static uint32_t getBreakdownUtilization(Backend backend,
+                                        PeriodSet periodSet,
+                                        size_t nbrOfTasks,
+                                        std::chrono::milliseconds duration) {
+    if (run(backend, periodSet, nbrOfTasks, 100, duration).nbrOfDeadlineMisses == 0) {
+        return 100;
+    }
+    uint32_t low  = 0;
+    uint32_t high = 100;
+    while (high - low > 1) {
+        const uint32_t middle = (low + high) / 2;
+        if (run(backend, periodSet, nbrOfTasks, middle, duration).nbrOfDeadlineMisses == 0) {
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+int main(int argc, char* argv[]) {
+    const std::chrono::milliseconds duration(argc > 1 ? std::strtoul(argv[1], nullptr, 10)
+                                                      : 4000);
+    const size_t maxNbrOfTasks =
+        std::min<size_t>(argc > 2 ? std::strtoul(argv[2], nullptr, 10) : kMaxNbrOfTasks,
+                         kMaxNbrOfTasks);
+    FILE* file = stdout;
+    if (argc > 3) {
+        file = std::fopen(argv[3], "w");
+        if (file == nullptr) {
+            printf("Cannot open %s\n", argv[3]);
+            return 1;
+        }
+    }
+
+    host_sim::Kernel& kernel = host_sim::Kernel::instance();
+    // the completion times are read without loading the CPU
+    kernel.setTimerReadCost(std::chrono::microseconds::zero());
+    // above all task threads, for stopping them
+    kernel.setPriority(kernel.currentThread(), osPriorityRealtime);
+    generatePeriods();
+
+    struct {
+        Backend backend;
+        const char* name;
+    } const backends[] = {{Backend::kSuperLoop, "super-loop"},
+                          {Backend::kEventQueue, "event-queue"},
+                          {Backend::kEdf, "edf"},
+                          {Backend::kRateMonotonic, "rate-monotonic"}};
+    struct {
+        PeriodSet periodSet;
+        const char* name;
+    } const periodSets[] = {{PeriodSet::kHarmonic, "harmonic"},
+                            {PeriodSet::kNonHarmonic, "non-harmonic"}};
+
+    fprintf(file,
+            "backend,periods,tasks,utilization_percent,host_ns_per_event,deadline_misses,jobs,"
+            "ram_per_task_bytes,breakdown_utilization_percent\n");
+    bool isConsistent = true;
+    for (const auto& backend : backends) {
+        for (const auto& periodSet : periodSets) {
+            for (size_t nbrOfTasks = 1; nbrOfTasks <= maxNbrOfTasks; nbrOfTasks *= 2) {
+                const RunResult result = run(backend.backend,
+                                             periodSet.periodSet,
+                                             nbrOfTasks,
+                                             kReferenceUtilization,
+                                             duration);
+                const uint32_t breakdownUtilization = getBreakdownUtilization(
+                    backend.backend, periodSet.periodSet, nbrOfTasks, duration);
+                fprintf(file,
+                        "%s,%s,%" PRIu32 ",%" PRIu32 ",%" PRIu64 ",%" PRIu32 ",%" PRIu32
+                        ",%" PRIu32 ",%" PRIu32 "\n",
+                        backend.name,
+                        periodSet.name,
+                        static_cast<uint32_t>(nbrOfTasks),
+                        kReferenceUtilization,
+                        result.hostNsPerEvent,
+                        result.nbrOfDeadlineMisses,
+                        result.nbrOfJobs,
+                        static_cast<uint32_t>(getRamPerTask(backend.backend)),
+                        breakdownUtilization);
+                fflush(file);
+                // a preemptive scheduler with harmonic periods (and enough
+                // priorities) meets all deadlines up to the reference
+                // utilization
+                if (backend.backend == Backend::kRateMonotonic &&
+                    periodSet.periodSet == PeriodSet::kHarmonic &&
+                    (result.nbrOfDeadlineMisses != 0 ||
+                     breakdownUtilization < kReferenceUtilization)) {
+                    isConsistent = false;
+                }
+            }
+        }
+    }
+    if (file != stdout) {
+        std::fclose(file);
+    }
+    if (!isConsistent) {
+        printf("Unexpected deadline misses of the rate monotonic threads\n");
+        return 1;
+    }
+    return 0;
+}
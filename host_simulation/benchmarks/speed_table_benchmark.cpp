@@ -0,0 +1,121 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file speed_table_benchmark.cpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Compares the speed computation with float arithmetic and the
+ *        compile-time speed table lookup used by the Speedometer
+ *
+ * Usage: benchmark-speed-table [number of iterations, default 10000000]
+ *
+ * This benchmark measures host time (not virtual time).
+ *
+ * @date 2024-01-22
+ * @version 1.0.0
+ ***************************************************************************/
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+
+#include "common/speed_table.hpp"
+#include "common/speedometer.hpp"
+
+// same values as the Speedometer (checked at startup)
+static constexpr uint8_t kTraySize           = 50;
+static constexpr float kWheelCircumference   = 2.1f;
+static constexpr bike_computer::SpeedTable kSpeedTable(kTraySize, kWheelCircumference);
+
+// inputs are read through volatile variables, so that the compiler cannot fold
+// the computations away
+static volatile uint8_t gearSizeInput;
+static volatile int64_t rotationTimeInput;
+static volatile float sink;
+
+using BenchmarkClock = std::chrono::steady_clock;
+
+template <typename F>
+static double measure(uint32_t nbrOfIterations, F function) {
+    const auto startTime = BenchmarkClock::now();
+    uint8_t gearSize     = bike_computer::kMinGearSize;
+    uint32_t timeIndex   = 0;
+    for (uint32_t i = 0; i < nbrOfIterations; i++) {
+        gearSizeInput     = gearSize;
+        rotationTimeInput = (bike_computer::kMinPedalRotationTime +
+                             timeIndex * bike_computer::kDeltaPedalRotationTime)
+                                .count();
+        sink = function(gearSizeInput, std::chrono::milliseconds(rotationTimeInput));
+        // walk through the whole domain
+        if (++timeIndex == bike_computer::SpeedTable::kNbrOfRotationTimes) {
+            timeIndex = 0;
+            gearSize  = (gearSize == bike_computer::kMaxGearSize)
+                            ? bike_computer::kMinGearSize
+                            : static_cast<uint8_t>(gearSize + 1);
+        }
+    }
+    const auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        BenchmarkClock::now() - startTime);
+    return static_cast<double>(duration.count()) / nbrOfIterations;
+}
+
+static float floatPath(uint8_t gearSize, const std::chrono::milliseconds& rotationTime) {
+    return bike_computer::computeSpeed(kTraySize, kWheelCircumference, gearSize, rotationTime);
+}
+
+static float tablePath(uint8_t gearSize, const std::chrono::milliseconds& rotationTime) {
+    const bike_computer::SpeedTable::Entry* entry = kSpeedTable.lookup(gearSize, rotationTime);
+    return entry->speed;
+}
+
+int main(int argc, char* argv[]) {
+    const uint32_t nbrOfIterations =
+        (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 10000000;
+
+    // check that the table matches the speedometer and the float computation
+    Timer timer;
+    bike_computer::Speedometer speedometer(timer);
+    if (speedometer.getTraySize() != kTraySize ||
+        speedometer.getWheelCircumference() != kWheelCircumference) {
+        std::printf("Speedometer constants differ from the benchmark constants\n");
+        return 1;
+    }
+    uint32_t nbrOfMismatches = 0;
+    for (uint8_t gearSize = bike_computer::kMinGearSize;
+         gearSize <= bike_computer::kMaxGearSize;
+         gearSize++) {
+        for (auto rotationTime = bike_computer::kMinPedalRotationTime;
+             rotationTime <= bike_computer::kMaxPedalRotationTime;
+             rotationTime += bike_computer::kDeltaPedalRotationTime) {
+            if (floatPath(gearSize, rotationTime) != tablePath(gearSize, rotationTime)) {
+                nbrOfMismatches++;
+            }
+        }
+    }
+
+    const double floatTime = measure(nbrOfIterations, floatPath);
+    const double tableTime = measure(nbrOfIterations, tablePath);
+
+    std::printf("Speed table: %u gear sizes x %" PRIu32 " rotation times (%zu bytes)\n",
+                bike_computer::SpeedTable::kNbrOfGearSizes,
+                bike_computer::SpeedTable::kNbrOfRotationTimes,
+                sizeof(kSpeedTable));
+    std::printf("Mismatches between table and float path: %" PRIu32 "\n", nbrOfMismatches);
+    std::printf("Float path: %.2f ns per computation\n", floatTime);
+    std::printf("Table path: %.2f ns per computation\n", tableTime);
+    std::printf("Speedup: %.2f\n", floatTime / tableTime);
+    return (nbrOfMismatches == 0) ? 0 : 1;
+}
@@ -0,0 +1,125 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file super_loop_cpu_benchmark.cpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Compares the CPU usage of the polling super-loop (static_scheduling)
+ *        with the interrupt driven one (static_scheduling_with_event)
+ *        (virtual time)
+ *
+ * Usage: benchmark-super-loop-cpu [number of major cycles, default 10]
+ *
+ * Both super-loops run the same cyclic schedule (major cycle of 1600 msecs)
+ * while the joystick is pressed every 170 msecs. The benchmark reports the
+ * CPU usage (from the kernel idle time) and the p99 release jitter of the
+ * gear and speed tasks, as measured by the task tracer.
+ *
+ * @date 2024-04-01
+ * @version 1.0.0
+ ***************************************************************************/
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+
+#include "joystick.hpp"
+#include "mbed.h"
+#include "static_scheduling/bike_system.hpp"
+#include "static_scheduling_with_event/bike_system.hpp"
+
+static constexpr std::chrono::milliseconds kMajorCycle    = 1600ms;
+static constexpr std::chrono::milliseconds kPressPeriod   = 170ms;
+static constexpr std::chrono::milliseconds kPressDuration = 20ms;
+
+struct Result {
+    uint64_t cpuUsage = 0;
+    std::chrono::microseconds gearJitterP99  = std::chrono::microseconds::zero();
+    std::chrono::microseconds speedJitterP99 = std::chrono::microseconds::zero();
+};
+
+// alternates gear up and pedal right presses, as a rider would
+static void pressJoystick(uint32_t nbrOfCycles) {
+    const auto endTime = Kernel::Clock::now() + kMajorCycle * nbrOfCycles;
+    bool isGearPress   = true;
+    while (Kernel::Clock::now() + kPressPeriod < endTime) {
+        ThisThread::sleep_for(kPressPeriod - kPressDuration);
+        disco::Joystick::getInstance().press(isGearPress ? disco::Joystick::State::UpPressed
+                                                         : disco::Joystick::State::RightPressed);
+        ThisThread::sleep_for(kPressDuration);
+        disco::Joystick::getInstance().release();
+        isGearPress = !isGearPress;
+    }
+    ThisThread::sleep_until(endTime);
+}
+
+template <typename BikeSystem>
+static Result run(uint32_t nbrOfCycles) {
+    static BikeSystem bikeSystem;
+    Thread thread(osPriorityNormal, OS_STACK_SIZE, nullptr, "superLoop");
+
+    mbed_stats_cpu_t startStats;
+    mbed_stats_cpu_get(&startStats);
+    thread.start(callback(&bikeSystem, &BikeSystem::start));
+    pressJoystick(nbrOfCycles);
+    mbed_stats_cpu_t endStats;
+    mbed_stats_cpu_get(&endStats);
+    thread.terminate();
+
+    Result result;
+    const uint64_t upTime   = endStats.uptime - startStats.uptime;
+    const uint64_t idleTime = endStats.idle_time - startStats.idle_time;
+    result.cpuUsage         = 100 - (idleTime * 100) / upTime;
+    const bike_computer::TaskTracer& taskTracer = bikeSystem.getTaskLogger();
+    result.gearJitterP99 = taskTracer.getTaskStatistics(advembsof::TaskLogger::kGearTaskIndex)
+                               .releaseJitter.getPercentile(99.0f);
+    result.speedJitterP99 = taskTracer.getTaskStatistics(advembsof::TaskLogger::kSpeedTaskIndex)
+                                .releaseJitter.getPercentile(99.0f);
+    return result;
+}
+
+static void printResult(const char* name, const Result& result) {
+    printf("%-18s CPU usage %3" PRIu64 "%%, release jitter p99 gear %6" PRId64
+           " usecs, speed %6" PRId64 " usecs\n",
+           name,
+           result.cpuUsage,
+           static_cast<int64_t>(result.gearJitterP99.count()),
+           static_cast<int64_t>(result.speedJitterP99.count()));
+}
+
+int main(int argc, char* argv[]) {
+    const uint32_t nbrOfCycles = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10;
+
+    printf("%" PRIu32 " major cycles of %" PRId64 " msecs, one press every %" PRId64
+           " msecs\n",
+           nbrOfCycles,
+           static_cast<int64_t>(kMajorCycle.count()),
+           static_cast<int64_t>(kPressPeriod.count()));
+
+    const Result pollingResult = run<static_scheduling::BikeSystem>(nbrOfCycles);
+    printResult("polling", pollingResult);
+    const Result interruptResult = run<static_scheduling_with_event::BikeSystem>(nbrOfCycles);
+    printResult("interrupt driven", interruptResult);
+
+    // the interrupt driven super-loop must keep the timing of the schedule
+    // while leaving most of the CPU idle
+    if (interruptResult.cpuUsage >= pollingResult.cpuUsage ||
+        interruptResult.gearJitterP99 > 2ms || interruptResult.speedJitterP99 > 2ms) {
+        printf("Unexpected interrupt driven super-loop result\n");
+        return 1;
+    }
+    return 0;
+}
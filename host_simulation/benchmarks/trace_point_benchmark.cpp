@@ -0,0 +1,237 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file trace_point_benchmark.cpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Compares the tr_debug() calls of Speedometer::computeDistance()
+ *        with the compile-time trace points
+ *
+ * Usage: benchmark-trace-point [number of iterations, default 1000000]
+ *
+ * The same distance update is built without trace, with tr_debug() (as
+ * before the trace points) and with a trace point of a disabled and of an
+ * enabled module. The benchmark reports for each variant:
+ * - the code size of the function (symbol table of the executable)
+ * - the host time per call (tr_debug() is measured with the debug level
+ *   active and with the level filtered at run time, the output goes to
+ *   /dev/null)
+ * - the bytes sent over the serial port per call (a text line or a binary
+ *   record), which dominates on target: 115200 bauds send 11.5 bytes/msec
+ * It fails if the disabled trace point changes the code of the function.
+ *
+ * This benchmark measures host time (not virtual time).
+ *
+ * @date 2024-05-13
+ * @version 1.0.0
+ ***************************************************************************/
+
+#include <elf.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "common/trace_point.hpp"
+#include "mbed.h"
+#include "mbed_trace.h"
+
+#define TRACE_GROUP "Speedometer"
+
+// modules of the benchmark
+#define MBED_CONF_APP_TRACE_POINT_LEVEL_BENCHMARK_ENABLED TRACE_POINT_LEVEL_DEBUG
+#define MBED_CONF_APP_TRACE_POINT_LEVEL_BENCHMARK_DISABLED TRACE_POINT_LEVEL_NONE
+
+using bike_computer::TracePoints;
+
+// state of the distance update, volatile so that the compiler keeps it
+static volatile uint64_t distanceUm;
+static volatile uint32_t rateUm;
+static volatile float currentSpeed;
+
+// the variants have C linkage, to be found by name in the symbol table
+extern "C" {
+
+__attribute__((noinline)) void distanceWithoutTrace() { distanceUm = distanceUm + rateUm; }
+
+__attribute__((noinline)) void distanceWithTrDebug() {
+    distanceUm = distanceUm + rateUm;
+    tr_debug("Total distance %" PRIu64 " um, speed %f", distanceUm, currentSpeed);
+}
+
+__attribute__((noinline)) void distanceWithDisabledTracePoint() {
+    distanceUm = distanceUm + rateUm;
+    TRACE_POINT_DEBUG(BENCHMARK_DISABLED,
+                      bike_computer::kTracePointDistance,
+                      static_cast<uint32_t>(distanceUm),
+                      static_cast<uint32_t>(distanceUm >> 32),
+                      TracePoints::toArgument(currentSpeed));
+}
+
+__attribute__((noinline)) void distanceWithEnabledTracePoint() {
+    distanceUm = distanceUm + rateUm;
+    TRACE_POINT_DEBUG(BENCHMARK_ENABLED,
+                      bike_computer::kTracePointDistance,
+                      static_cast<uint32_t>(distanceUm),
+                      static_cast<uint32_t>(distanceUm >> 32),
+                      TracePoints::toArgument(currentSpeed));
+}
+
+}  // extern "C"
+
+using BenchmarkClock = std::chrono::steady_clock;
+
+// size of a function in the symbol table of the executable, 0 if not found
+static uint64_t getFunctionSize(const char* name) {
+    std::ifstream file("/proc/self/exe", std::ios::binary);
+    const std::vector<char> content((std::istreambuf_iterator<char>(file)),
+                                    std::istreambuf_iterator<char>());
+    if (content.size() < sizeof(Elf64_Ehdr) || std::memcmp(content.data(), ELFMAG, SELFMAG) != 0 ||
+        content[EI_CLASS] != ELFCLASS64) {
+        return 0;
+    }
+    Elf64_Ehdr header;
+    std::memcpy(&header, content.data(), sizeof(header));
+    if (header.e_shoff + static_cast<uint64_t>(header.e_shnum) * sizeof(Elf64_Shdr) >
+        content.size()) {
+        return 0;
+    }
+    std::vector<Elf64_Shdr> sections(header.e_shnum);
+    std::memcpy(sections.data(), content.data() + header.e_shoff, header.e_shnum * sizeof(Elf64_Shdr));
+    for (const Elf64_Shdr& section : sections) {
+        if (section.sh_type != SHT_SYMTAB || section.sh_link >= sections.size()) {
+            continue;
+        }
+        const Elf64_Shdr& strings = sections[section.sh_link];
+        for (uint64_t offset = 0; offset + sizeof(Elf64_Sym) <= section.sh_size;
+             offset += sizeof(Elf64_Sym)) {
+            Elf64_Sym symbol;
+            std::memcpy(&symbol, content.data() + section.sh_offset + offset, sizeof(symbol));
+            if (ELF64_ST_TYPE(symbol.st_info) == STT_FUNC && symbol.st_name < strings.sh_size &&
+                std::strcmp(content.data() + strings.sh_offset + symbol.st_name, name) == 0) {
+                return symbol.st_size;
+            }
+        }
+    }
+    return 0;
+}
+
+template <typename F>
+static double measure(uint32_t nbrOfIterations, F function) {
+    const auto startTime = BenchmarkClock::now();
+    for (uint32_t i = 0; i < nbrOfIterations; i++) {
+        function();
+    }
+    const auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        BenchmarkClock::now() - startTime);
+    return static_cast<double>(duration.count()) / nbrOfIterations;
+}
+
+// records are drained out of the measure when the ring buffer is full
+static double measureEnabledTracePoint(uint32_t nbrOfIterations) {
+    TracePoints& tracePoints = TracePoints::getInstance();
+    uint8_t frame[TracePoints::kFrameHeaderSize + 32 * TracePoints::kRecordSize];
+    double totalTime    = 0.0;
+    uint32_t iterations = 0;
+    while (iterations < nbrOfIterations) {
+        const uint32_t chunk = std::min(nbrOfIterations - iterations, TracePoints::kCapacity);
+        totalTime += measure(chunk, distanceWithEnabledTracePoint) * chunk;
+        iterations += chunk;
+        while (tracePoints.drain(frame, sizeof(frame)) > 0) {
+        }
+    }
+    return totalTime / nbrOfIterations;
+}
+
+// tr_debug() writes to stdout, which is redirected to /dev/null
+static double measureTrDebug(uint32_t nbrOfIterations, uint8_t traceConfig) {
+    std::fflush(stdout);
+    const int savedStdout = dup(STDOUT_FILENO);
+    const int nullOutput  = open("/dev/null", O_WRONLY);
+    dup2(nullOutput, STDOUT_FILENO);
+    close(nullOutput);
+
+    mbed_trace_config_set(traceConfig);
+    const double time = measure(nbrOfIterations, distanceWithTrDebug);
+
+    std::fflush(stdout);
+    dup2(savedStdout, STDOUT_FILENO);
+    close(savedStdout);
+    return time;
+}
+
+int main(int argc, char* argv[]) {
+    const uint32_t nbrOfIterations = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+
+    distanceUm   = 0;
+    rateUm       = 1234567;
+    currentSpeed = 25.3f;
+    mbed_trace_init();
+    TracePoints::getInstance().enable(true);
+
+    // bytes of the tr_debug() line, formatted as mbed-trace does on target
+    char line[128];
+    const int lineLength = std::snprintf(line,
+                                         sizeof(line),
+                                         "[DBG ][%s]: Total distance %" PRIu64 " um, speed %.2f\r\n",
+                                         TRACE_GROUP,
+                                         static_cast<uint64_t>(distanceUm),
+                                         currentSpeed);
+
+    const double baselineTime      = measure(nbrOfIterations, distanceWithoutTrace);
+    const double trDebugTime       = measureTrDebug(nbrOfIterations, TRACE_ACTIVE_LEVEL_DEBUG);
+    const double trDebugFilterTime = measureTrDebug(nbrOfIterations, TRACE_ACTIVE_LEVEL_INFO);
+    const double disabledTime      = measure(nbrOfIterations, distanceWithDisabledTracePoint);
+    const double enabledTime       = measureEnabledTracePoint(nbrOfIterations);
+
+    const uint64_t baselineSize = getFunctionSize("distanceWithoutTrace");
+    const uint64_t trDebugSize  = getFunctionSize("distanceWithTrDebug");
+    const uint64_t disabledSize = getFunctionSize("distanceWithDisabledTracePoint");
+    const uint64_t enabledSize  = getFunctionSize("distanceWithEnabledTracePoint");
+
+    std::printf("%-30s %10s %12s %14s\n", "Variant", "Code size", "ns per call", "Serial bytes");
+    std::printf("%-30s %10" PRIu64 " %12.2f %14d\n", "No trace", baselineSize, baselineTime, 0);
+    std::printf("%-30s %10" PRIu64 " %12.2f %14d\n",
+                "tr_debug (debug level)",
+                trDebugSize,
+                trDebugTime,
+                lineLength);
+    std::printf(
+        "%-30s %10" PRIu64 " %12.2f %14d\n", "tr_debug (info level)", trDebugSize, trDebugFilterTime, 0);
+    std::printf(
+        "%-30s %10" PRIu64 " %12.2f %14d\n", "Trace point (disabled)", disabledSize, disabledTime, 0);
+    std::printf("%-30s %10" PRIu64 " %12.2f %14zu\n",
+                "Trace point (enabled)",
+                enabledSize,
+                enabledTime,
+                TracePoints::kRecordSize);
+    std::printf("Trace point RAM: %zu bytes (ring buffer of %" PRIu32 " records)\n",
+                sizeof(TracePoints),
+                TracePoints::kCapacity);
+
+    if (baselineSize == 0) {
+        std::printf("No symbol table, the code sizes are not checked\n");
+        return 0;
+    }
+    return (disabledSize == baselineSize) ? 0 : 1;
+}
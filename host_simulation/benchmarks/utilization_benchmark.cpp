@@ -0,0 +1,219 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file utilization_benchmark.cpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Behaviour of the bike system designs under a synthetic CPU load of
+ *        50, 80, 95 and 110% utilization (virtual time)
+ *
+ * Usage: benchmark-utilization [duration in secs per run, default 32]
+ *                              [random variation in percent, default 0]
+ *
+ * Each task gets a synthetic WCET (calibrated busy loop) such that the sum of
+ * WCET / period is the given utilization:
+ * - static_scheduling and static_scheduling_with_event: each task consumes
+ *   this fraction of its frame (the frames fill the major cycle)
+ * - multi_tasking (event queue and rate monotonic threads): the temperature
+ *   and display tasks, both with a period of 1600 msecs, share the load in
+ *   the same 1:2 ratio as their computation times
+ * The benchmark reports the CPU usage, the deadline misses counted by the
+ * task tracer, the frame overruns of the super-loops and the worst p99
+ * response time of the tasks. The polling devices of static_scheduling
+ * already busy wait for the whole computation time of their tasks, so that
+ * any synthetic load overruns its frames.
+ *
+ * A timer read costs kTimerReadCost of virtual CPU time, this sets the size
+ * of the workload chunks (100 usecs) and keeps the simulation fast.
+ *
+ * @date 2024-04-15
+ * @version 1.0.0
+ ***************************************************************************/
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+
+#include "common/synthetic_workload.hpp"
+#include "host_sim/virtual_kernel.hpp"
+#include "mbed.h"
+#include "multi_tasking/bike_system.hpp"
+#include "static_scheduling/bike_system.hpp"
+#include "static_scheduling_with_event/bike_system.hpp"
+
+static constexpr uint32_t kUtilizations[] = {50, 80, 95, 110};
+static constexpr std::chrono::microseconds kTimerReadCost = 100us;
+
+// frame of each task in the major cycle of the super-loops
+// Order is kGearTaskIndex, kSpeedTaskIndex, kTemperatureTaskIndex,
+//          kResetTaskIndex, kDisplayTask1Index, kDisplayTask2Index
+static constexpr std::chrono::microseconds kFrameTimes[] = {
+    100000us, 200000us, 100000us, 100000us, 200000us, 100000us};
+static constexpr std::chrono::microseconds kMultiTaskingPeriod = 1600000us;
+
+enum class Design { kPolling, kInterruptDriven, kEventQueue, kRateMonotonic };
+
+struct Result {
+    uint64_t cpuUsage            = 0;
+    uint32_t nbrOfDeadlineMisses = 0;
+    uint32_t nbrOfFrameOverruns  = 0;
+    std::chrono::microseconds worstResponseTimeP99 = std::chrono::microseconds::zero();
+};
+
+template <typename BikeSystem>
+static void setSuperLoopWorkloads(BikeSystem& bikeSystem,
+                                  uint32_t utilization,
+                                  uint8_t variationPercent) {
+    for (uint8_t taskIndex = 0; taskIndex < advembsof::TaskLogger::kNbrOfTasks; taskIndex++) {
+        bikeSystem.setTaskWorkload(
+            taskIndex, kFrameTimes[taskIndex] * utilization / 100, variationPercent);
+    }
+}
+
+static void setMultiTaskingWorkloads(multi_tasking::BikeSystem& bikeSystem,
+                                     uint32_t utilization,
+                                     uint8_t variationPercent) {
+    bikeSystem.setTaskWorkload(advembsof::TaskLogger::kTemperatureTaskIndex,
+                               kMultiTaskingPeriod * utilization / 300,
+                               variationPercent);
+    bikeSystem.setTaskWorkload(advembsof::TaskLogger::kDisplayTask1Index,
+                               kMultiTaskingPeriod * utilization * 2 / 300,
+                               variationPercent);
+}
+
+static void collectTaskStatistics(const bike_computer::TaskTracer& taskTracer, Result& result) {
+    for (uint8_t taskIndex = 0; taskIndex < advembsof::TaskLogger::kNbrOfTasks; taskIndex++) {
+        const bike_computer::TaskTracer::TaskStatistics& statistics =
+            taskTracer.getTaskStatistics(taskIndex);
+        result.nbrOfDeadlineMisses += statistics.nbrOfDeadlineMisses;
+        if (statistics.responseTime.getCount() > 0 &&
+            statistics.responseTime.getPercentile(99.0f) > result.worstResponseTimeP99) {
+            result.worstResponseTimeP99 = statistics.responseTime.getPercentile(99.0f);
+        }
+    }
+}
+
+static Result run(Design design,
+                  uint32_t utilization,
+                  uint8_t variationPercent,
+                  std::chrono::milliseconds duration) {
+    Thread thread(osPriorityNormal, OS_STACK_SIZE, nullptr, "bikeSystem");
+    Result result;
+
+    mbed_stats_cpu_t startStats;
+    mbed_stats_cpu_get(&startStats);
+    if (design == Design::kPolling) {
+        auto* bikeSystem = new static_scheduling::BikeSystem();
+        setSuperLoopWorkloads(*bikeSystem, utilization, variationPercent);
+        thread.start(callback(bikeSystem, &static_scheduling::BikeSystem::start));
+        ThisThread::sleep_for(duration);
+        thread.terminate();
+        collectTaskStatistics(bikeSystem->getTaskLogger(), result);
+        result.nbrOfFrameOverruns = bikeSystem->getNbrOfFrameOverruns();
+        delete bikeSystem;
+    } else if (design == Design::kInterruptDriven) {
+        auto* bikeSystem = new static_scheduling_with_event::BikeSystem();
+        setSuperLoopWorkloads(*bikeSystem, utilization, variationPercent);
+        thread.start(callback(bikeSystem, &static_scheduling_with_event::BikeSystem::start));
+        ThisThread::sleep_for(duration);
+        thread.terminate();
+        collectTaskStatistics(bikeSystem->getTaskLogger(), result);
+        result.nbrOfFrameOverruns = bikeSystem->getNbrOfFrameOverruns();
+        delete bikeSystem;
+    } else {
+        auto* bikeSystem = new multi_tasking::BikeSystem();
+        setMultiTaskingWorkloads(*bikeSystem, utilization, variationPercent);
+        thread.start(callback(bikeSystem,
+                              design == Design::kEventQueue
+                                  ? &multi_tasking::BikeSystem::start
+                                  : &multi_tasking::BikeSystem::startWithRateMonotonicThreads));
+        ThisThread::sleep_for(duration);
+        bikeSystem->stop();
+        thread.terminate();
+        collectTaskStatistics(bikeSystem->getTaskLogger(), result);
+        delete bikeSystem;
+    }
+    mbed_stats_cpu_t endStats;
+    mbed_stats_cpu_get(&endStats);
+
+    const uint64_t upTime   = endStats.uptime - startStats.uptime;
+    const uint64_t idleTime = endStats.idle_time - startStats.idle_time;
+    result.cpuUsage         = 100 - (idleTime * 100) / upTime;
+    return result;
+}
+
+static void printResult(const char* name, uint32_t utilization, const Result& result) {
+    printf("%-17s %4" PRIu32 "%%  CPU usage %3" PRIu64 "%%  deadline misses %4" PRIu32
+           "  frame overruns %4" PRIu32 "  worst response time p99 %8" PRId64 " usecs\n",
+           name,
+           utilization,
+           result.cpuUsage,
+           result.nbrOfDeadlineMisses,
+           result.nbrOfFrameOverruns,
+           static_cast<int64_t>(result.worstResponseTimeP99.count()));
+}
+
+int main(int argc, char* argv[]) {
+    const std::chrono::seconds duration(argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 32);
+    const uint8_t variationPercent =
+        static_cast<uint8_t>(argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 0);
+
+    // each workload chunk reads a timer, the virtual CPU time that it costs
+    // sets the chunk size (a larger cost keeps the simulation fast)
+    host_sim::Kernel& kernel = host_sim::Kernel::instance();
+    kernel.setTimerReadCost(kTimerReadCost);
+    // above all threads of the designs, so that main preempts an overloaded
+    // design (that never sleeps) for stopping it
+    kernel.setPriority(kernel.currentThread(), osPriorityRealtime);
+    // once, before the bike system threads are started
+    bike_computer::SyntheticWorkload::getInstance().calibrate();
+    printf("%" PRId64 " secs per run, %" PRIu8 "%% random variation, %" PRIu32
+           " workload chunks per msec\n",
+           static_cast<int64_t>(duration.count()),
+           variationPercent,
+           bike_computer::SyntheticWorkload::getInstance().getNbrOfChunksPerMs());
+
+    struct {
+        Design design;
+        const char* name;
+    } const designs[] = {{Design::kPolling, "polling"},
+                         {Design::kInterruptDriven, "interrupt driven"},
+                         {Design::kEventQueue, "event queue"},
+                         {Design::kRateMonotonic, "rate monotonic"}};
+
+    bool isConsistent = true;
+    for (const auto& design : designs) {
+        for (uint32_t utilization : kUtilizations) {
+            const Result result = run(design.design, utilization, variationPercent, duration);
+            printResult(design.name, utilization, result);
+            // below 100%, the designs that do not poll must meet all their
+            // deadlines, and the overload must be detected by the super-loop
+            if (design.design != Design::kPolling && utilization < 100 &&
+                (result.nbrOfDeadlineMisses != 0 || result.nbrOfFrameOverruns != 0)) {
+                isConsistent = false;
+            }
+            if (design.design == Design::kInterruptDriven && utilization > 100 &&
+                result.nbrOfFrameOverruns == 0) {
+                isConsistent = false;
+            }
+        }
+    }
+    if (!isConsistent) {
+        printf("Unexpected deadline misses or frame overruns\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,47 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file cpu_logger.hpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Host simulation replacement for advembsof::CPULogger
+ *
+ * The idle time is the virtual time during which no simulated thread was
+ * ready to run.
+ *
+ * @date 2024-01-15
+ * @version 1.0.0
+ ***************************************************************************/
+
+#pragma once
+
+#include "mbed.h"
+
+namespace advembsof {
+
+class CPULogger {
+   public:
+    explicit CPULogger(Timer& timer);  // NOLINT(runtime/references)
+
+    // print the CPU usage since the previous call
+    void printStats();
+
+   private:
+    Timer& _timer;
+    uint64_t _previousIdleTime = 0;
+    uint64_t _previousUpTime   = 0;
+};
+
+}  // namespace advembsof
@@ -0,0 +1,75 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file display_device.hpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Host simulation replacement for advembsof::DisplayDevice
+ *
+ * The fake display keeps the last text rendered for each field, counts the
+ * draw calls and charges a configurable CPU cost per draw to the calling
+ * thread. An observer may be notified of each draw.
+ *
+ * @date 2024-01-15
+ * @version 1.0.0
+ ***************************************************************************/
+
+#pragma once
+
+#include <chrono>
+
+#include "mbed.h"
+
+namespace disco {
+
+enum class ReturnCode { Ok = 0, Error = 1, Busy = 2, Timeout = 3 };
+
+}  // namespace disco
+
+namespace advembsof {
+
+class DisplayDevice {
+   public:
+    enum Field { kGearField = 0, kSpeedField, kDistanceField, kTemperatureField, kNbrOfFields };
+
+    DisplayDevice() = default;
+
+    // make the class non copyable
+    DisplayDevice(DisplayDevice&)            = delete;
+    DisplayDevice& operator=(DisplayDevice&) = delete;
+
+    disco::ReturnCode init();
+
+    void displayGear(uint8_t gear);
+    void displaySpeed(float speed);
+    void displayDistance(float distance);
+    void displayTemperature(float temperature);
+
+    // simulation only: inspection and cost model
+    const char* getText(Field field) const;
+    uint32_t getDrawCount(Field field) const;
+    static void setDrawCost(std::chrono::microseconds cost);
+    // called on each draw of any display, in the context of the drawing task
+    static void setOnDraw(mbed::Callback<void(Field field, const char* text)> onDraw);
+
+   private:
+    void draw(Field field, const char* text);
+
+    static constexpr uint8_t kMaxTextLength = 32;
+    char _text[kNbrOfFields][kMaxTextLength]  = {};
+    uint32_t _drawCount[kNbrOfFields]         = {};
+};
+
+}  // namespace advembsof
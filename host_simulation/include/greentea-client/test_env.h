@@ -0,0 +1,36 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file test_env.h
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Host simulation replacement for the greentea client
+ *
+ * The greentea timeout is applied to the virtual time: a suite that runs
+ * longer than its timeout in simulated time is aborted.
+ *
+ * @date 2024-01-15
+ * @version 1.0.0
+ ***************************************************************************/
+
+#pragma once
+
+namespace host_sim {
+
+void greenteaSetup(int timeout, const char* hostTestName);
+
+}  // namespace host_sim
+
+#define GREENTEA_SETUP(timeout, host_test) host_sim::greenteaSetup(timeout, host_test)
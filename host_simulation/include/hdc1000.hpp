@@ -0,0 +1,43 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file hdc1000.hpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Host simulation replacement for the advembsof::HDC1000 sensor driver
+ *
+ * @date 2024-01-15
+ * @version 1.0.0
+ ***************************************************************************/
+
+#pragma once
+
+#include "mbed.h"
+
+namespace advembsof {
+
+class HDC1000 {
+   public:
+    HDC1000(PinName sda, PinName scl, PinName dataReadyPin);
+
+    bool probe();
+    float getTemperature();
+    float getHumidity();
+
+    // simulation only: values returned by the sensor
+    static void setAmbient(float temperature, float humidity);
+};
+
+}  // namespace advembsof
@@ -0,0 +1,92 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file chrome_trace.hpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Chrome Trace Event export of the host simulation (virtual time)
+ *
+ * When the HOST_SIM_CHROME_TRACE environment variable gives a file name,
+ * the kernel writes a trace that can be opened with ui.perfetto.dev or
+ * chrome://tracing. There is one track per:
+ * - thread, with a slice each time the thread runs
+ * - interrupt source (Ticker, InterruptIn pin, joystick), with a slice per
+ *   interrupt
+ * - event queue, with a slice per dispatched event
+ * - task of the bike_computer::TaskTracer, with a slice per invocation
+ * The file uses the JSON array format, events are written as they happen,
+ * so that the trace of a simulation that aborts is still readable.
+ *
+ * @date 2024-05-06
+ * @version 1.0.0
+ ***************************************************************************/
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace host_sim {
+
+class ChromeTrace {
+   public:
+    // each group is shown as a process, with one track per thread, source...
+    enum class Group : uint32_t { kThreads = 1, kInterrupts, kEventQueues, kTasks };
+
+    // opens the file given by HOST_SIM_CHROME_TRACE, if any
+    static ChromeTrace& instance();
+
+    // make the class non copyable
+    ChromeTrace(ChromeTrace&)            = delete;
+    ChromeTrace& operator=(ChromeTrace&) = delete;
+
+    bool open(const char* fileName);
+    void close();
+    bool isEnabled() const { return _file != nullptr; }
+
+    // a new track, e.g. for each thread (returns 0 if the trace is disabled)
+    uint32_t addTrack(Group group, const std::string& name);
+    // the track with the given name, created on first use
+    uint32_t getTrack(Group group, const std::string& name);
+
+    // slices, times are virtual times
+    void begin(Group group, uint32_t track, const char* name, std::chrono::microseconds time);
+    void end(Group group, uint32_t track, std::chrono::microseconds time);
+    void complete(Group group,
+                  uint32_t track,
+                  const char* name,
+                  std::chrono::microseconds start,
+                  std::chrono::microseconds end);
+
+   private:
+    ChromeTrace() = default;
+
+    void writeEvent(const std::string& event);
+    // called with _mutex held
+    uint32_t addTrackLocked(Group group, const std::string& name);
+    void writeEventLocked(const std::string& event);
+
+    std::mutex _mutex;
+    FILE* _file         = nullptr;
+    bool _isFirstEvent  = true;
+    uint32_t _lastTrack = 0;
+    std::map<std::pair<Group, std::string>, uint32_t> _namedTracks;
+};
+
+}  // namespace host_sim
@@ -0,0 +1,141 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file drivers.hpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Host replacement for the mbed-os drivers (timers, tickers and
+ *        interrupt inputs), all driven by the virtual kernel clock
+ *
+ * @date 2024-01-15
+ * @version 1.0.0
+ ***************************************************************************/
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#include "host_sim/platform.hpp"
+
+namespace host_sim {
+
+// drive the level of an input pin, which fires the matching rise/fall
+// interrupts of all InterruptIn instances attached to this pin
+void setPinLevel(PinName pin, int level);
+int getPinLevel(PinName pin);
+
+}  // namespace host_sim
+
+namespace mbed {
+
+class Timer {
+   public:
+    Timer() = default;
+
+    void start();
+    void stop();
+    void reset();
+
+    // each read charges the timer read cost to the running thread
+    std::chrono::microseconds elapsed_time() const;
+    int read_us() const;
+    int read_ms() const;
+    float read() const;
+
+   private:
+    bool _running                          = false;
+    std::chrono::microseconds _startTime   = std::chrono::microseconds::zero();
+    std::chrono::microseconds _accumulated = std::chrono::microseconds::zero();
+};
+
+using LowPowerTimer = Timer;
+
+class InterruptIn {
+   public:
+    explicit InterruptIn(PinName pin);
+    InterruptIn(PinName pin, PinMode mode);
+    ~InterruptIn();
+
+    // make the class non copyable
+    InterruptIn(InterruptIn&)            = delete;
+    InterruptIn& operator=(InterruptIn&) = delete;
+
+    int read();
+    operator int();  // NOLINT(runtime/explicit)
+
+    void rise(Callback<void()> func);
+    void fall(Callback<void()> func);
+    void mode(PinMode pull);
+    void enable_irq();
+    void disable_irq();
+
+   private:
+    friend void host_sim::setPinLevel(PinName pin, int level);
+
+    PinName _pin;
+    bool _irqEnabled = true;
+    Callback<void()> _rise;
+    Callback<void()> _fall;
+};
+
+class Ticker {
+   public:
+    Ticker() = default;
+    ~Ticker();
+
+    // make the class non copyable
+    Ticker(Ticker&)            = delete;
+    Ticker& operator=(Ticker&) = delete;
+
+    template <typename Rep, typename Period>
+    void attach(Callback<void()> func, std::chrono::duration<Rep, Period> period) {
+        attachPeriod(func,
+                     std::chrono::duration_cast<std::chrono::microseconds>(period),
+                     true);
+    }
+    void detach();
+
+   protected:
+    void attachPeriod(Callback<void()> func,
+                      std::chrono::microseconds period,
+                      bool periodic);
+
+   private:
+    void schedule(std::chrono::microseconds at);
+
+    Callback<void()> _function;
+    std::chrono::microseconds _period = std::chrono::microseconds::zero();
+    bool _periodic                    = true;
+    uint32_t _alarmId                 = 0;
+};
+
+using LowPowerTicker = Ticker;
+
+class Timeout : public Ticker {
+   public:
+    template <typename Rep, typename Period>
+    void attach(Callback<void()> func, std::chrono::duration<Rep, Period> delay) {
+        attachPeriod(
+            func, std::chrono::duration_cast<std::chrono::microseconds>(delay), false);
+    }
+};
+
+using LowPowerTimeout = Timeout;
+
+// busy wait, consumes CPU time of the running thread
+void wait_us(int us);
+
+}  // namespace mbed
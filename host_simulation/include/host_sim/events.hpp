@@ -0,0 +1,186 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file events.hpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Host replacement for the mbed-os EventQueue and Event classes
+ *
+ * Events are ordered by target time with a millisecond tick like equeue, and
+ * periodic events are re-armed relative to their previous target. The queue
+ * honours its byte capacity, so that a full queue fails to post (returns 0)
+ * the same way as on target.
+ *
+ * @date 2024-01-15
+ * @version 1.0.0
+ ***************************************************************************/
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "host_sim/platform.hpp"
+#include "host_sim/virtual_kernel.hpp"
+
+// memory footprint of an event without arguments on a 32 bits target
+#define EVENTS_EVENT_SIZE (8 * sizeof(void*) + sizeof(mbed::Callback<void()>))
+#define EVENTS_QUEUE_SIZE (32 * EVENTS_EVENT_SIZE)
+
+namespace events {
+
+class EventQueue {
+   public:
+    explicit EventQueue(unsigned size = EVENTS_QUEUE_SIZE, unsigned char* buffer = nullptr);
+    ~EventQueue();
+
+    // make the class non copyable
+    EventQueue(EventQueue&)            = delete;
+    EventQueue& operator=(EventQueue&) = delete;
+
+    void dispatch_forever();
+    void dispatch_for(std::chrono::milliseconds ms);
+    void dispatch(int ms = -1);
+    void break_dispatch();
+
+    bool cancel(int id);
+    std::chrono::milliseconds time_left(int id);
+
+    template <typename F, typename... ArgTs>
+    int call(F f, ArgTs... args) {
+        return postCall(std::chrono::microseconds::zero(), kNotPeriodic, f, args...);
+    }
+
+    template <typename Rep, typename Period, typename F, typename... ArgTs>
+    int call_in(std::chrono::duration<Rep, Period> ms, F f, ArgTs... args) {
+        return postCall(std::chrono::duration_cast<std::chrono::microseconds>(ms),
+                        kNotPeriodic,
+                        f,
+                        args...);
+    }
+
+    template <typename Rep, typename Period, typename F, typename... ArgTs>
+    int call_every(std::chrono::duration<Rep, Period> ms, F f, ArgTs... args) {
+        const auto period = std::chrono::duration_cast<std::chrono::microseconds>(ms);
+        return postCall(period, period, f, args...);
+    }
+
+    // used by Event<> for posting a bound callback, size is the number of
+    // bytes the event uses in the queue buffer
+    int post(std::chrono::microseconds delay,
+             std::chrono::microseconds period,
+             std::function<void()> function,
+             std::size_t size);
+
+    // number of events currently pending in the queue
+    std::size_t getPendingEvents() const;
+
+    static constexpr std::chrono::microseconds kNotPeriodic{-1};
+
+   private:
+    struct PendingEvent {
+        int id;
+        std::chrono::microseconds target;
+        std::chrono::microseconds period;
+        std::function<void()> function;
+        std::size_t size;
+    };
+
+    template <typename F, typename... ArgTs>
+    int postCall(std::chrono::microseconds delay,
+                 std::chrono::microseconds period,
+                 F f,
+                 ArgTs... args) {
+        using Arguments = std::tuple<std::decay_t<ArgTs>...>;
+        Arguments arguments(args...);
+        return post(
+            delay,
+            period,
+            [f, arguments]() mutable {
+                host_sim::applyTuple(f, arguments, std::index_sequence_for<ArgTs...>());
+            },
+            EVENTS_EVENT_SIZE + sizeof(Arguments));
+    }
+
+    void enqueue(PendingEvent&& event);
+    void dispatchUntil(std::chrono::microseconds deadline);
+
+    std::size_t _capacity;
+    std::size_t _used = 0;
+    int _nextId       = 1;
+    bool _breakDispatch = false;
+    std::list<PendingEvent> _events;
+    // track of the queue in the Chrome trace (0 if not traced yet)
+    uint32_t _traceTrack = 0;
+    host_sim::WaitList _dispatchers;
+};
+
+template <typename F>
+class Event;
+
+template <typename... ArgTs>
+class Event<void(ArgTs...)> {
+   public:
+    template <typename F>
+    Event(EventQueue* q, F f) : _queue(q), _callback(f) {}
+
+    template <typename Rep, typename Period>
+    void delay(std::chrono::duration<Rep, Period> delay) {
+        _delay = std::chrono::duration_cast<std::chrono::microseconds>(delay);
+    }
+
+    template <typename Rep, typename Period>
+    void period(std::chrono::duration<Rep, Period> period) {
+        _period = std::chrono::duration_cast<std::chrono::microseconds>(period);
+    }
+
+    int post(ArgTs... args) const {
+        using Arguments = std::tuple<std::decay_t<ArgTs>...>;
+        Arguments arguments(args...);
+        mbed::Callback<void(ArgTs...)> callback = _callback;
+        _id = _queue->post(
+            _delay,
+            _period,
+            [callback, arguments]() mutable {
+                host_sim::applyTuple(
+                    callback, arguments, std::index_sequence_for<ArgTs...>());
+            },
+            EVENTS_EVENT_SIZE + sizeof(Arguments));
+        return _id;
+    }
+
+    void call(ArgTs... args) const {
+        int id = post(args...);
+        MBED_ASSERT(id != 0);
+    }
+
+    void operator()(ArgTs... args) const { call(args...); }
+
+    void cancel() const { _queue->cancel(_id); }
+
+   private:
+    EventQueue* _queue;
+    mbed::Callback<void(ArgTs...)> _callback;
+    std::chrono::microseconds _delay  = std::chrono::microseconds::zero();
+    std::chrono::microseconds _period = EventQueue::kNotPeriodic;
+    mutable int _id                   = 0;
+};
+
+}  // namespace events
@@ -0,0 +1,337 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file platform.hpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Host replacement for the mbed-os platform layer (callbacks, atomics,
+ *        pins, statistics)
+ *
+ * @date 2024-01-15
+ * @version 1.0.0
+ ***************************************************************************/
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include <sys/types.h>
+#include <unistd.h>
+
+// pins used by the bike computer
+enum PinName {
+    PA_0,
+    PC_6,
+    PC_13,
+    PD_12,
+    PD_13,
+    PK_2,
+    PK_3,
+    PK_4,
+    PK_5,
+    PK_6,
+    BUTTON1 = PC_13,
+    NC      = -1
+};
+
+enum PinMode { PullNone = 0, PullUp = 1, PullDown = 2, PullDefault = PullNone };
+
+#define MBED_ASSERT(expr)                                                       \
+    do {                                                                        \
+        if (!(expr)) {                                                          \
+            host_sim::assertionFailed(#expr, __FILE__, __LINE__);               \
+        }                                                                       \
+    } while (0)
+
+#define MBED_UNUSED __attribute__((__unused__))
+#define MBED_FORCEINLINE inline __attribute__((always_inline))
+#define MBED_NOINLINE __attribute__((noinline))
+#define MBED_ALIGN(N) __attribute__((aligned(N)))
+#define MBED_STATIC_ASSERT(expr, msg) static_assert(expr, msg)
+
+namespace host_sim {
+
+[[noreturn]] void assertionFailed(const char* expr, const char* file, int line);
+
+// std::apply is C++17 only
+template <typename F, typename Tuple, std::size_t... I>
+void applyTuple(F& f, Tuple& args, std::index_sequence<I...>) {
+    f(std::get<I>(args)...);
+}
+
+}  // namespace host_sim
+
+namespace mbed {
+
+template <typename F>
+class Callback;
+
+template <typename R, typename... ArgTs>
+class Callback<R(ArgTs...)> {
+   public:
+    Callback() = default;
+    Callback(std::nullptr_t) {}  // NOLINT(runtime/explicit)
+
+    Callback(R (*func)(ArgTs...)) {  // NOLINT(runtime/explicit)
+        if (func != nullptr) {
+            _function = func;
+        }
+    }
+
+    template <typename T, typename U>
+    Callback(U* obj, R (T::*method)(ArgTs...))
+        : _function([obj, method](ArgTs... args) -> R {
+              return (obj->*method)(std::forward<ArgTs>(args)...);
+          }) {}
+
+    template <typename T, typename U>
+    Callback(const U* obj, R (T::*method)(ArgTs...) const)
+        : _function([obj, method](ArgTs... args) -> R {
+              return (obj->*method)(std::forward<ArgTs>(args)...);
+          }) {}
+
+    template <typename F,
+              typename = std::enable_if_t<
+                  !std::is_same<std::decay_t<F>, Callback>::value &&
+                  !std::is_pointer<std::decay_t<F>>::value &&
+                  std::is_convertible<decltype(std::declval<F&>()(std::declval<ArgTs>()...)),
+                                      R>::value>>
+    Callback(F func) : _function(std::move(func)) {}  // NOLINT(runtime/explicit)
+
+    R call(ArgTs... args) const { return _function(std::forward<ArgTs>(args)...); }
+    R operator()(ArgTs... args) const { return _function(std::forward<ArgTs>(args)...); }
+    explicit operator bool() const { return static_cast<bool>(_function); }
+
+   private:
+    std::function<R(ArgTs...)> _function;
+};
+
+template <typename R, typename... ArgTs>
+Callback<R(ArgTs...)> callback(R (*func)(ArgTs...) = nullptr) {
+    return Callback<R(ArgTs...)>(func);
+}
+
+template <typename R, typename... ArgTs>
+Callback<R(ArgTs...)> callback(const Callback<R(ArgTs...)>& func) {
+    return func;
+}
+
+template <typename T, typename U, typename R, typename... ArgTs>
+Callback<R(ArgTs...)> callback(U* obj, R (T::*method)(ArgTs...)) {
+    return Callback<R(ArgTs...)>(obj, method);
+}
+
+template <typename T, typename U, typename R, typename... ArgTs>
+Callback<R(ArgTs...)> callback(const U* obj, R (T::*method)(ArgTs...) const) {
+    return Callback<R(ArgTs...)>(obj, method);
+}
+
+// critical sections are not needed in the simulation: interrupts only run at
+// kernel scheduling points
+}  // namespace mbed
+
+// true when called from a simulated interrupt handler
+bool core_util_is_isr_active();
+
+// Simulated threads never run concurrently, so that critical sections are only
+// needed when host threads share data with the simulation (e.g. in stress
+// tests). They are implemented with a global recursive lock.
+void core_util_critical_section_enter();
+void core_util_critical_section_exit();
+
+namespace mbed {
+
+class CriticalSectionLock {
+   public:
+    CriticalSectionLock() { core_util_critical_section_enter(); }
+    ~CriticalSectionLock() { core_util_critical_section_exit(); }
+
+    // make the class non copyable
+    CriticalSectionLock(CriticalSectionLock&)            = delete;
+    CriticalSectionLock& operator=(CriticalSectionLock&) = delete;
+
+    static void enable() { core_util_critical_section_enter(); }
+    static void disable() { core_util_critical_section_exit(); }
+};
+
+}  // namespace mbed
+
+// atomic operations, mapped on the compiler builtins
+#define HOST_SIM_ATOMIC_OPS(SUFFIX, TYPE)                                              \
+    inline TYPE core_util_atomic_load_##SUFFIX(const volatile TYPE* valuePtr) {        \
+        return __atomic_load_n(valuePtr, __ATOMIC_SEQ_CST);                            \
+    }                                                                                  \
+    inline void core_util_atomic_store_##SUFFIX(volatile TYPE* valuePtr, TYPE value) { \
+        __atomic_store_n(valuePtr, value, __ATOMIC_SEQ_CST);                           \
+    }                                                                                  \
+    inline TYPE core_util_atomic_exchange_##SUFFIX(volatile TYPE* valuePtr,           \
+                                                    TYPE desiredValue) {               \
+        return __atomic_exchange_n(valuePtr, desiredValue, __ATOMIC_SEQ_CST);          \
+    }                                                                                  \
+    inline bool core_util_atomic_cas_##SUFFIX(                                         \
+        volatile TYPE* ptr, TYPE* expectedCurrentValue, TYPE desiredValue) {           \
+        return __atomic_compare_exchange_n(ptr,                                        \
+                                           expectedCurrentValue,                       \
+                                           desiredValue,                               \
+                                           false,                                      \
+                                           __ATOMIC_SEQ_CST,                           \
+                                           __ATOMIC_SEQ_CST);                          \
+    }
+
+#define HOST_SIM_ATOMIC_ARITH_OPS(SUFFIX, TYPE)                                    \
+    HOST_SIM_ATOMIC_OPS(SUFFIX, TYPE)                                              \
+    inline TYPE core_util_atomic_incr_##SUFFIX(volatile TYPE* valuePtr,           \
+                                                TYPE delta) {                      \
+        return __atomic_add_fetch(valuePtr, delta, __ATOMIC_SEQ_CST);              \
+    }                                                                              \
+    inline TYPE core_util_atomic_decr_##SUFFIX(volatile TYPE* valuePtr,           \
+                                                TYPE delta) {                      \
+        return __atomic_sub_fetch(valuePtr, delta, __ATOMIC_SEQ_CST);              \
+    }                                                                              \
+    inline TYPE core_util_atomic_fetch_add_##SUFFIX(volatile TYPE* valuePtr,      \
+                                                     TYPE arg) {                   \
+        return __atomic_fetch_add(valuePtr, arg, __ATOMIC_SEQ_CST);                \
+    }                                                                              \
+    inline TYPE core_util_atomic_fetch_sub_##SUFFIX(volatile TYPE* valuePtr,      \
+                                                     TYPE arg) {                   \
+        return __atomic_fetch_sub(valuePtr, arg, __ATOMIC_SEQ_CST);                \
+    }                                                                              \
+    inline TYPE core_util_atomic_fetch_or_##SUFFIX(volatile TYPE* valuePtr,       \
+                                                    TYPE arg) {                    \
+        return __atomic_fetch_or(valuePtr, arg, __ATOMIC_SEQ_CST);                 \
+    }                                                                              \
+    inline TYPE core_util_atomic_fetch_and_##SUFFIX(volatile TYPE* valuePtr,      \
+                                                     TYPE arg) {                   \
+        return __atomic_fetch_and(valuePtr, arg, __ATOMIC_SEQ_CST);                \
+    }
+
+HOST_SIM_ATOMIC_OPS(bool, bool)
+HOST_SIM_ATOMIC_ARITH_OPS(u8, uint8_t)
+HOST_SIM_ATOMIC_ARITH_OPS(u16, uint16_t)
+HOST_SIM_ATOMIC_ARITH_OPS(u32, uint32_t)
+HOST_SIM_ATOMIC_ARITH_OPS(u64, uint64_t)
+HOST_SIM_ATOMIC_ARITH_OPS(s8, int8_t)
+HOST_SIM_ATOMIC_ARITH_OPS(s16, int16_t)
+HOST_SIM_ATOMIC_ARITH_OPS(s32, int32_t)
+HOST_SIM_ATOMIC_ARITH_OPS(s64, int64_t)
+
+#undef HOST_SIM_ATOMIC_ARITH_OPS
+#undef HOST_SIM_ATOMIC_OPS
+
+inline void* core_util_atomic_load_ptr(void* const volatile* valuePtr) {
+    return __atomic_load_n(valuePtr, __ATOMIC_SEQ_CST);
+}
+
+inline bool core_util_atomic_cas_ptr(void* volatile* ptr,
+                                     void** expectedCurrentValue,
+                                     void* desiredValue) {
+    return __atomic_compare_exchange_n(
+        ptr, expectedCurrentValue, desiredValue, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+template <typename T>
+T core_util_atomic_load(const volatile T* valuePtr) {
+    return __atomic_load_n(valuePtr, __ATOMIC_SEQ_CST);
+}
+
+template <typename T>
+void core_util_atomic_store(volatile T* valuePtr, T value) {
+    __atomic_store_n(valuePtr, value, __ATOMIC_SEQ_CST);
+}
+
+template <typename T>
+T core_util_atomic_exchange(volatile T* valuePtr, T desiredValue) {
+    return __atomic_exchange_n(valuePtr, desiredValue, __ATOMIC_SEQ_CST);
+}
+
+template <typename T>
+bool core_util_atomic_compare_exchange_strong(volatile T* ptr,
+                                              T* expectedCurrentValue,
+                                              T desiredValue) {
+    return __atomic_compare_exchange_n(
+        ptr, expectedCurrentValue, desiredValue, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+template <typename T>
+T core_util_atomic_incr(volatile T* valuePtr, T delta) {
+    return __atomic_add_fetch(valuePtr, delta, __ATOMIC_SEQ_CST);
+}
+
+template <typename T>
+T core_util_atomic_decr(volatile T* valuePtr, T delta) {
+    return __atomic_sub_fetch(valuePtr, delta, __ATOMIC_SEQ_CST);
+}
+
+template <typename T>
+T core_util_atomic_fetch_add(volatile T* valuePtr, T arg) {
+    return __atomic_fetch_add(valuePtr, arg, __ATOMIC_SEQ_CST);
+}
+
+namespace mbed {
+
+// minimal FileHandle, only writing is supported
+class FileHandle {
+   public:
+    virtual ~FileHandle() = default;
+    virtual ssize_t write(const void* buffer, size_t size) = 0;
+};
+
+// file handle of a host file descriptor (e.g. STDOUT_FILENO)
+FileHandle* mbed_file_handle(int fd);
+
+}  // namespace mbed
+
+// runtime statistics (see mbed_stats.h)
+struct mbed_stats_cpu_t {
+    uint64_t uptime;
+    uint64_t idle_time;
+    uint64_t sleep_time;
+    uint64_t deep_sleep_time;
+};
+
+struct mbed_stats_heap_t {
+    uint32_t current_size;
+    uint32_t max_size;
+    uint32_t total_size;
+    uint32_t reserved_size;
+    uint32_t alloc_cnt;
+    uint32_t alloc_fail_cnt;
+    uint32_t overhead_size;
+};
+
+struct mbed_stats_stack_t {
+    uint32_t thread_id;
+    uint32_t max_size;
+    uint32_t reserved_size;
+    uint32_t stack_cnt;
+};
+
+void mbed_stats_cpu_get(mbed_stats_cpu_t* stats);
+void mbed_stats_heap_get(mbed_stats_heap_t* stats);
+void mbed_stats_stack_get(mbed_stats_stack_t* stats);
+
+namespace host_sim {
+
+// simulation only: the high-water marks of the heap and stack statistics
+// restart from the current usage (e.g. between the runs of a benchmark)
+void resetStatisticsPeaks();
+
+}  // namespace host_sim
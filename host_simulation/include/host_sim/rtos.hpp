@@ -0,0 +1,233 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file rtos.hpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Host replacement for the mbed-os rtos layer (threads, mutexes,
+ *        semaphores, event flags) on top of the virtual kernel
+ *
+ * @date 2024-01-15
+ * @version 1.0.0
+ ***************************************************************************/
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <list>
+
+#include "host_sim/platform.hpp"
+#include "host_sim/virtual_kernel.hpp"
+
+// CMSIS-RTOS2 definitions used by the application code
+enum osPriority_t {
+    osPriorityNone         = 0,
+    osPriorityIdle         = 1,
+    osPriorityLow          = 8,
+    osPriorityBelowNormal  = 16,
+    osPriorityNormal       = 24,
+    osPriorityAboveNormal  = 32,
+    osPriorityHigh         = 40,
+    osPriorityRealtime     = 48,
+    osPriorityISR          = 56,
+    osPriorityError        = -1,
+    osPriorityReserved     = 0x7FFFFFFF
+};
+using osPriority   = osPriority_t;
+using osStatus     = int32_t;
+using osThreadId_t = void*;
+
+static constexpr osStatus osOK             = 0;
+static constexpr osStatus osError          = -1;
+static constexpr osStatus osErrorTimeout   = -2;
+static constexpr osStatus osErrorResource  = -3;
+static constexpr osStatus osErrorParameter = -4;
+
+static constexpr uint32_t osWaitForever       = 0xFFFFFFFFU;
+static constexpr uint32_t osFlagsErrorTimeout = 0xFFFFFFFEU;
+
+#ifndef OS_STACK_SIZE
+#define OS_STACK_SIZE 4096
+#endif
+
+namespace rtos {
+
+namespace Kernel {
+
+// the rtos clock has a millisecond resolution
+struct Clock {
+    using duration     = std::chrono::milliseconds;
+    using rep          = duration::rep;
+    using period       = duration::period;
+    using time_point   = std::chrono::time_point<Clock>;
+    using duration_u32 = std::chrono::duration<uint32_t, period>;
+    static constexpr bool is_steady = true;
+    static time_point now();
+};
+
+uint64_t get_ms_count();
+
+}  // namespace Kernel
+
+class Thread {
+   public:
+    enum State {
+        Inactive,
+        Ready,
+        Running,
+        WaitingDelay,
+        WaitingJoin,
+        WaitingThreadFlag,
+        WaitingEventFlag,
+        WaitingMutex,
+        WaitingSemaphore,
+        WaitingMemoryPool,
+        WaitingMessageGet,
+        WaitingMessagePut,
+        WaitingInterval,
+        WaitingOr,
+        WaitingAnd,
+        WaitingMailbox,
+        Deleted,
+    };
+
+    explicit Thread(osPriority priority       = osPriorityNormal,
+                    uint32_t stack_size       = OS_STACK_SIZE,
+                    unsigned char* stack_mem = nullptr,
+                    const char* name          = nullptr);
+    ~Thread();
+
+    // make the class non copyable
+    Thread(Thread&)            = delete;
+    Thread& operator=(Thread&) = delete;
+
+    osStatus start(mbed::Callback<void()> task);
+    osStatus join();
+    osStatus terminate();
+    osStatus set_priority(osPriority priority);
+    osPriority get_priority() const;
+    State get_state() const;
+    const char* get_name() const;
+    osThreadId_t get_id() const;
+    uint32_t stack_size() const;
+
+   private:
+    host_sim::SimThread* _thread;
+    bool _started = false;
+    uint32_t _stackSize;
+    // allocated from the heap when not given, as on the target (the host
+    // thread runs on its own stack)
+    unsigned char* _allocatedStack = nullptr;
+};
+
+namespace ThisThread {
+
+void sleep_for(Kernel::Clock::duration_u32 rel_time);
+void sleep_for(uint32_t millisec);
+void sleep_until(Kernel::Clock::time_point abs_time);
+void yield();
+osThreadId_t get_id();
+const char* get_name();
+
+}  // namespace ThisThread
+
+// recursive mutex, ownership is handed over directly to the first waiter
+class Mutex {
+   public:
+    Mutex() = default;
+    explicit Mutex(const char* name) {}
+
+    // make the class non copyable
+    Mutex(Mutex&)            = delete;
+    Mutex& operator=(Mutex&) = delete;
+
+    void lock();
+    bool trylock();
+    bool trylock_for(Kernel::Clock::duration_u32 rel_time);
+    void unlock();
+    osThreadId_t get_owner();
+
+   private:
+    host_sim::SimThread* _owner = nullptr;
+    uint32_t _count             = 0;
+    host_sim::WaitList _waiters;
+};
+
+class Semaphore {
+   public:
+    explicit Semaphore(int32_t count = 0, uint16_t max_count = 0xFFFF);
+
+    // make the class non copyable
+    Semaphore(Semaphore&)            = delete;
+    Semaphore& operator=(Semaphore&) = delete;
+
+    void acquire();
+    bool try_acquire();
+    bool try_acquire_for(Kernel::Clock::duration_u32 rel_time);
+    bool try_acquire_until(Kernel::Clock::time_point abs_time);
+    osStatus release();
+
+   private:
+    bool acquireUntil(std::chrono::microseconds deadline);
+
+    int32_t _count;
+    uint16_t _maxCount;
+    host_sim::WaitList _waiters;
+};
+
+class EventFlags {
+   public:
+    EventFlags() = default;
+    explicit EventFlags(const char* name) {}
+
+    // make the class non copyable
+    EventFlags(EventFlags&)            = delete;
+    EventFlags& operator=(EventFlags&) = delete;
+
+    uint32_t set(uint32_t flags);
+    uint32_t clear(uint32_t flags = 0x7FFFFFFF);
+    uint32_t get() const;
+    uint32_t wait_all(uint32_t flags    = 0,
+                      uint32_t millisec = osWaitForever,
+                      bool clear        = true);
+    uint32_t wait_any(uint32_t flags    = 0,
+                      uint32_t millisec = osWaitForever,
+                      bool clear        = true);
+    uint32_t wait_all_for(uint32_t flags, Kernel::Clock::duration_u32 rel_time, bool clear = true);
+    uint32_t wait_any_for(uint32_t flags, Kernel::Clock::duration_u32 rel_time, bool clear = true);
+
+   private:
+    struct Request {
+        host_sim::SimThread* thread;
+        uint32_t flags;
+        bool all;
+        bool clear;
+        bool done;
+        uint32_t result;
+    };
+
+    bool isSatisfied(const Request& request) const;
+    uint32_t wait(uint32_t flags,
+                  bool all,
+                  bool clear,
+                  std::chrono::microseconds deadline);
+
+    uint32_t _flags = 0;
+    std::list<Request*> _requests;
+    host_sim::WaitList _waiters;
+};
+
+}  // namespace rtos
@@ -0,0 +1,180 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file virtual_kernel.hpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Virtual time kernel used by the host simulation build
+ *
+ * Every simulated thread is backed by a std::thread, but only one of them
+ * runs at a time: the kernel hands the CPU over at blocking points (sleep,
+ * wait on a kernel object, join) and on priority preemption, exactly like a
+ * single core RTOS. The virtual clock only moves when all threads are blocked
+ * (idle time) or when the running thread consumes CPU time explicitly (timer
+ * reads, busy waits). A 20 s run of the bike system therefore completes in a
+ * few milliseconds of wall-clock time and is fully deterministic.
+ *
+ * @date 2024-01-15
+ * @version 1.0.0
+ ***************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <vector>
+
+namespace host_sim {
+
+struct SimThread;
+
+// list of threads blocked on a kernel object, ordered by priority
+class WaitList {
+   public:
+    bool empty() const { return _waiters.empty(); }
+
+   private:
+    friend class Kernel;
+    std::list<SimThread*> _waiters;
+};
+
+// thrown in a terminated thread at its next scheduling point for unwinding it
+struct ThreadTerminated {};
+
+class Kernel {
+   public:
+    static constexpr std::chrono::microseconds kForever =
+        std::chrono::microseconds::max();
+
+    // the kernel is created on first use and never destroyed
+    static Kernel& instance();
+
+    // current virtual time since kernel creation, does not take the kernel
+    // mutex (it is read from the memory trace callback, which may run while
+    // the kernel allocates)
+    std::chrono::microseconds now();
+
+    // advance the virtual time as if the running thread executed code for the
+    // given duration (timed events falling in this window are handled on the
+    // way and may preempt the running thread)
+    void consume(std::chrono::microseconds duration);
+
+    // CPU time charged on each Timer read, this is what lets polling loops
+    // reach their deadline
+    void setTimerReadCost(std::chrono::microseconds cost);
+    std::chrono::microseconds getTimerReadCost() const;
+
+    // thread management
+    SimThread* createThread(int priority, const char* name, uint32_t stackSize);
+    void startThread(SimThread* thread, std::function<void()> entry);
+    void terminateThread(SimThread* thread);
+    void joinThread(SimThread* thread);
+    void destroyThread(SimThread* thread);
+    SimThread* currentThread();
+    int getPriority(const SimThread* thread) const;
+    void setPriority(SimThread* thread, int priority);
+    const char* getName(const SimThread* thread) const;
+    bool isFinished(const SimThread* thread);
+
+    // block the running thread on waitList (may be nullptr) until it is woken
+    // up or until deadline expires, returns false upon timeout
+    bool wait(WaitList* waitList, std::chrono::microseconds deadline);
+    void sleepUntil(std::chrono::microseconds deadline);
+    void yield();
+
+    // wake up the first thread waiting on waitList, returns the woken thread;
+    // waking up never switches threads by itself, kernel objects call
+    // reschedule() once their own state is consistent
+    SimThread* wakeOne(WaitList& waitList);
+    void wakeAll(WaitList& waitList);
+    void wakeThread(SimThread* thread);
+    void reschedule();
+
+    // run a callback in interrupt context: no preemption happens before the
+    // callback returns, a higher priority thread made ready by the callback
+    // then preempts the interrupted thread (source names the interrupt in
+    // the Chrome trace)
+    void runIsr(const std::function<void()>& isr, const char* source = "Interrupt");
+    bool isInIsr() const;
+
+    // timer interrupts, fired when the virtual time reaches "at"
+    uint32_t addAlarm(std::chrono::microseconds at,
+                      std::function<void()> isr,
+                      const char* source = "Timer");
+    void cancelAlarm(uint32_t alarmId);
+
+    // abort the simulation when the virtual time reaches deadline
+    void setWatchdog(std::chrono::microseconds deadline, const char* reason);
+
+    // time spent with no ready thread since kernel creation
+    std::chrono::microseconds getIdleTime();
+
+    // stacks of the live threads: the usage of a thread is sampled each time
+    // it enters the kernel (host stack frames), the reserved size is the one
+    // given to its Thread
+    struct StackStatistics {
+        uint32_t maxSize;
+        uint32_t reservedSize;
+        uint32_t count;
+    };
+    StackStatistics getStackStatistics();
+    void resetStackPeaks();
+
+   private:
+    Kernel();
+
+    struct Alarm {
+        uint32_t id;
+        std::chrono::microseconds at;
+        std::function<void()> isr;
+        const char* source;
+    };
+
+    void insertReady(SimThread* thread, bool atFront);
+    void insertWaiter(WaitList& waitList, SimThread* thread);
+    void makeReady(SimThread* thread);
+    SimThread* popReady();
+    void preemptIfNeeded(std::unique_lock<std::mutex>& lock);
+    void switchAway(std::unique_lock<std::mutex>& lock, SimThread* self);
+    void advanceTo(std::chrono::microseconds time);
+    std::chrono::microseconds nextTimedEvent() const;
+    void processTimedEvents(std::unique_lock<std::mutex>& lock);
+    void checkTerminated(SimThread* self);
+    void sampleStack(SimThread* thread);
+    void threadMain(SimThread* thread, std::function<void()> entry);
+    [[noreturn]] void deadlock();
+
+    std::mutex _mutex;
+    std::chrono::microseconds _now = std::chrono::microseconds::zero();
+    // copy of _now for now()
+    std::atomic<int64_t> _nowCount{0};
+    std::chrono::microseconds _idleTime = std::chrono::microseconds::zero();
+    std::chrono::microseconds _timerReadCost{1};
+    std::chrono::microseconds _watchdogDeadline = kForever;
+    const char* _watchdogReason = nullptr;
+    SimThread* _running = nullptr;
+    std::list<SimThread*> _ready;
+    std::vector<SimThread*> _threads;
+    std::vector<Alarm> _alarms;
+    uint32_t _nextAlarmId = 1;
+    uint32_t _isrNesting = 0;
+};
+
+}  // namespace host_sim
@@ -0,0 +1,74 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file joystick.hpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Host simulation replacement for the disco::Joystick wrapper
+ *
+ * A press is injected with press(), which sets the polled state and runs the
+ * matching callback in interrupt context; release() goes back to NonePressed.
+ *
+ * @date 2024-01-15
+ * @version 1.0.0
+ ***************************************************************************/
+
+#pragma once
+
+#include "mbed.h"
+
+namespace disco {
+
+class Joystick {
+   public:
+    enum class State {
+        NonePressed = 0,
+        SelPressed,
+        DownPressed,
+        LeftPressed,
+        RightPressed,
+        UpPressed
+    };
+
+    static Joystick& getInstance();
+
+    // make the class non copyable
+    Joystick(Joystick&)            = delete;
+    Joystick& operator=(Joystick&) = delete;
+
+    State getState() const;
+
+    void setSelCallback(mbed::Callback<void()> cb);
+    void setUpCallback(mbed::Callback<void()> cb);
+    void setDownCallback(mbed::Callback<void()> cb);
+    void setLeftCallback(mbed::Callback<void()> cb);
+    void setRightCallback(mbed::Callback<void()> cb);
+
+    // simulation only: input injection
+    void press(State state);
+    void release();
+
+   private:
+    Joystick() = default;
+
+    volatile State _state = State::NonePressed;
+    mbed::Callback<void()> _selCallback;
+    mbed::Callback<void()> _upCallback;
+    mbed::Callback<void()> _downCallback;
+    mbed::Callback<void()> _leftCallback;
+    mbed::Callback<void()> _rightCallback;
+};
+
+}  // namespace disco
@@ -0,0 +1,45 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file mbed.h
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Host simulation replacement for mbed.h
+ *
+ * Only the subset of mbed-os used by the bike computer is provided.
+ *
+ * @date 2024-01-15
+ * @version 1.0.0
+ ***************************************************************************/
+
+#pragma once
+
+#include <cinttypes>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+#include "host_sim/drivers.hpp"
+#include "host_sim/events.hpp"
+#include "host_sim/platform.hpp"
+#include "host_sim/rtos.hpp"
+
+using namespace mbed;                // NOLINT(build/namespaces)
+using namespace rtos;                // NOLINT(build/namespaces)
+using namespace events;              // NOLINT(build/namespaces)
+using namespace std::chrono_literals;  // NOLINT(build/namespaces)
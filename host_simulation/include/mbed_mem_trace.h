@@ -0,0 +1,44 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file mbed_mem_trace.h
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Host simulation replacement for the mbed-os memory tracing
+ *
+ * The replaced global operators new and delete (see mbed_shim.cpp) are
+ * reported as malloc and free, like on target where they call malloc() and
+ * free(), with the address of the code calling new or delete. As on target,
+ * the callback is not called again for the allocations made by the callback
+ * itself.
+ *
+ * @date 2024-06-03
+ * @version 1.0.0
+ ***************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+
+#define MBED_MEM_TRACE_MALLOC 0
+#define MBED_MEM_TRACE_REALLOC 1
+#define MBED_MEM_TRACE_CALLOC 2
+#define MBED_MEM_TRACE_FREE 3
+
+// op, result of the operation, caller address, then the arguments of the
+// operation (size for malloc, pointer for free)
+typedef void (*mbed_mem_trace_cb_t)(uint8_t op, void* res, void* caller, ...);
+
+void mbed_mem_trace_set_callback(mbed_mem_trace_cb_t callback);
@@ -0,0 +1,67 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file task_logger.hpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Host simulation replacement for advembsof::TaskLogger
+ *
+ * Same interface and same measurements as the advembsof library version.
+ *
+ * @date 2024-01-15
+ * @version 1.0.0
+ ***************************************************************************/
+
+#pragma once
+
+#include <chrono>
+
+#include "mbed.h"
+
+namespace advembsof {
+
+class TaskLogger {
+   public:
+    // task indexes
+    static constexpr uint8_t kGearTaskIndex        = 0;
+    static constexpr uint8_t kSpeedTaskIndex       = 1;
+    static constexpr uint8_t kTemperatureTaskIndex = 2;
+    static constexpr uint8_t kResetTaskIndex       = 3;
+    static constexpr uint8_t kDisplayTask1Index    = 4;
+    static constexpr uint8_t kDisplayTask2Index    = 5;
+    static constexpr uint8_t kNbrOfTasks           = 6;
+
+    TaskLogger() = default;
+
+    // enable/disable logging
+    void enable(bool enable);
+
+    // method called at the end of each task for logging task period and
+    // computation time
+    void logPeriodAndExecutionTime(Timer& timer,  // NOLINT(runtime/references)
+                                   int taskIndex,
+                                   const std::chrono::microseconds& taskStartTime);
+
+    std::chrono::microseconds getPeriod(uint8_t taskIndex) const;
+    std::chrono::microseconds getComputationTime(uint8_t taskIndex) const;
+
+   private:
+    bool _isEnabled = false;
+    std::chrono::microseconds _taskStartTime[kNbrOfTasks]   = {};
+    std::chrono::microseconds _periodTime[kNbrOfTasks]      = {};
+    std::chrono::microseconds _computationTime[kNbrOfTasks] = {};
+};
+
+}  // namespace advembsof
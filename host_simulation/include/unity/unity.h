@@ -0,0 +1,140 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file unity.h
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Host simulation replacement for the unity assertions used by the
+ *        greentea test suites
+ *
+ * A failed assertion throws, the exception is caught by utest::v1::Harness
+ * which reports the current case as failed and moves to the next one.
+ *
+ * @date 2024-01-15
+ * @version 1.0.0
+ ***************************************************************************/
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace unity {
+
+struct AssertionFailure {
+    std::string message;
+};
+
+[[noreturn]] void fail(const char* file, int line, const std::string& message);
+
+void assertUnsignedWithin(uint64_t delta,
+                          uint64_t expected,
+                          uint64_t actual,
+                          const char* file,
+                          int line);
+void assertSignedWithin(int64_t delta, int64_t expected, int64_t actual, const char* file, int line);
+void assertFloatWithin(double delta, double expected, double actual, const char* file, int line);
+void assertEqualSigned(int64_t expected, int64_t actual, const char* file, int line);
+void assertEqualUnsigned(uint64_t expected, uint64_t actual, const char* file, int line);
+
+}  // namespace unity
+
+#define TEST_FAIL_MESSAGE(message) unity::fail(__FILE__, __LINE__, message)
+#define TEST_FAIL() TEST_FAIL_MESSAGE("failed")
+
+#define TEST_ASSERT_MESSAGE(condition, message) \
+    do {                                        \
+        if (!(condition)) {                     \
+            TEST_FAIL_MESSAGE(message);         \
+        }                                       \
+    } while (0)
+#define TEST_ASSERT(condition) TEST_ASSERT_MESSAGE(condition, "Expression evaluated to FALSE")
+#define TEST_ASSERT_TRUE(condition) TEST_ASSERT_MESSAGE(condition, "Expected TRUE was FALSE")
+#define TEST_ASSERT_FALSE(condition) TEST_ASSERT_MESSAGE(!(condition), "Expected FALSE was TRUE")
+#define TEST_ASSERT_TRUE_MESSAGE(condition, message) TEST_ASSERT_MESSAGE(condition, message)
+#define TEST_ASSERT_NULL(pointer) TEST_ASSERT_MESSAGE((pointer) == nullptr, "Expected NULL")
+#define TEST_ASSERT_NOT_NULL(pointer) TEST_ASSERT_MESSAGE((pointer) != nullptr, "Expected non-NULL")
+
+#define TEST_ASSERT_EQUAL_INT(expected, actual) \
+    unity::assertEqualSigned(static_cast<int64_t>(expected), static_cast<int64_t>(actual), __FILE__, __LINE__)
+#define TEST_ASSERT_EQUAL(expected, actual) TEST_ASSERT_EQUAL_INT(expected, actual)
+#define TEST_ASSERT_EQUAL_INT32(expected, actual) TEST_ASSERT_EQUAL_INT(expected, actual)
+#define TEST_ASSERT_EQUAL_INT64(expected, actual) TEST_ASSERT_EQUAL_INT(expected, actual)
+#define TEST_ASSERT_EQUAL_UINT(expected, actual)            \
+    unity::assertEqualUnsigned(static_cast<uint64_t>(expected), \
+                               static_cast<uint64_t>(actual),   \
+                               __FILE__,                        \
+                               __LINE__)
+#define TEST_ASSERT_EQUAL_UINT8(expected, actual) TEST_ASSERT_EQUAL_UINT(expected, actual)
+#define TEST_ASSERT_EQUAL_UINT16(expected, actual) TEST_ASSERT_EQUAL_UINT(expected, actual)
+#define TEST_ASSERT_EQUAL_UINT32(expected, actual) TEST_ASSERT_EQUAL_UINT(expected, actual)
+#define TEST_ASSERT_EQUAL_UINT64(expected, actual) TEST_ASSERT_EQUAL_UINT(expected, actual)
+#define TEST_ASSERT_EQUAL_MEMORY(expected, actual, len) \
+    TEST_ASSERT_MESSAGE(std::memcmp((expected), (actual), (len)) == 0, "Memory mismatch")
+
+#define TEST_ASSERT_UINT_WITHIN(delta, expected, actual)    \
+    unity::assertUnsignedWithin(static_cast<uint64_t>(delta),    \
+                                static_cast<uint64_t>(expected), \
+                                static_cast<uint64_t>(actual),   \
+                                __FILE__,                        \
+                                __LINE__)
+#define TEST_ASSERT_UINT8_WITHIN(delta, expected, actual) \
+    TEST_ASSERT_UINT_WITHIN(delta, expected, actual)
+#define TEST_ASSERT_UINT32_WITHIN(delta, expected, actual) \
+    TEST_ASSERT_UINT_WITHIN(delta, expected, actual)
+#define TEST_ASSERT_UINT64_WITHIN(delta, expected, actual) \
+    TEST_ASSERT_UINT_WITHIN(delta, expected, actual)
+#define TEST_ASSERT_INT_WITHIN(delta, expected, actual)  \
+    unity::assertSignedWithin(static_cast<int64_t>(delta),    \
+                              static_cast<int64_t>(expected), \
+                              static_cast<int64_t>(actual),   \
+                              __FILE__,                       \
+                              __LINE__)
+#define TEST_ASSERT_INT32_WITHIN(delta, expected, actual) \
+    TEST_ASSERT_INT_WITHIN(delta, expected, actual)
+#define TEST_ASSERT_INT64_WITHIN(delta, expected, actual) \
+    TEST_ASSERT_INT_WITHIN(delta, expected, actual)
+
+#define TEST_ASSERT_FLOAT_WITHIN(delta, expected, actual)  \
+    unity::assertFloatWithin(static_cast<double>(delta),    \
+                             static_cast<double>(expected), \
+                             static_cast<double>(actual),   \
+                             __FILE__,                      \
+                             __LINE__)
+#define TEST_ASSERT_EQUAL_FLOAT(expected, actual) \
+    TEST_ASSERT_FLOAT_WITHIN(std::fabs(static_cast<double>(expected)) * 1e-5, expected, actual)
+
+#define TEST_ASSERT_LESS_OR_EQUAL(threshold, actual) \
+    TEST_ASSERT_MESSAGE((actual) <= (threshold), "Expected less or equal")
+#define TEST_ASSERT_LESS_OR_EQUAL_UINT32(threshold, actual) \
+    TEST_ASSERT_LESS_OR_EQUAL(threshold, actual)
+#define TEST_ASSERT_LESS_OR_EQUAL_UINT64(threshold, actual) \
+    TEST_ASSERT_LESS_OR_EQUAL(threshold, actual)
+#define TEST_ASSERT_LESS_THAN(threshold, actual) \
+    TEST_ASSERT_MESSAGE((actual) < (threshold), "Expected less than")
+#define TEST_ASSERT_LESS_THAN_UINT32(threshold, actual) TEST_ASSERT_LESS_THAN(threshold, actual)
+#define TEST_ASSERT_GREATER_OR_EQUAL(threshold, actual) \
+    TEST_ASSERT_MESSAGE((actual) >= (threshold), "Expected greater or equal")
+#define TEST_ASSERT_GREATER_OR_EQUAL_UINT32(threshold, actual) \
+    TEST_ASSERT_GREATER_OR_EQUAL(threshold, actual)
+#define TEST_ASSERT_GREATER_THAN(threshold, actual) \
+    TEST_ASSERT_MESSAGE((actual) > (threshold), "Expected greater than")
+#define TEST_ASSERT_GREATER_THAN_UINT32(threshold, actual) \
+    TEST_ASSERT_GREATER_THAN(threshold, actual)
+
+#define TEST_ASSERT_EQUAL_STRING(expected, actual) \
+    TEST_ASSERT_MESSAGE(std::strcmp((expected), (actual)) == 0, "Strings differ")
@@ -0,0 +1,80 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file utest.h
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Host simulation replacement for the utest harness
+ *
+ * @date 2024-01-15
+ * @version 1.0.0
+ ***************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace utest {
+namespace v1 {
+
+enum status_t { STATUS_CONTINUE = 0, STATUS_ABORT = 1 };
+
+struct control_t {
+    int repeat;
+};
+
+static constexpr control_t CaseNext = {0};
+
+using test_setup_handler_t = status_t (*)(const size_t number_of_cases);
+
+class Case {
+   public:
+    Case(const char* description, void (*handler)());
+    Case(const char* description, control_t (*handler)(const size_t call_count));
+
+    const char* getDescription() const;
+    void run() const;
+
+   private:
+    const char* _description;
+    void (*_handler)();
+    control_t (*_controlHandler)(const size_t call_count);
+};
+
+class Specification {
+   public:
+    template <size_t N>
+    Specification(test_setup_handler_t setup_handler, const Case (&cases)[N])
+        : _setupHandler(setup_handler), _cases(cases, cases + N) {}
+
+    test_setup_handler_t getSetupHandler() const { return _setupHandler; }
+    const std::vector<Case>& getCases() const { return _cases; }
+
+   private:
+    test_setup_handler_t _setupHandler;
+    std::vector<Case> _cases;
+};
+
+class Harness {
+   public:
+    // run all cases, returns true when all of them passed
+    static bool run(const Specification& specification);
+};
+
+status_t greentea_test_setup_handler(const size_t number_of_cases);
+
+}  // namespace v1
+}  // namespace utest
@@ -0,0 +1,60 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file main.cpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Host simulation entry point: runs the multi-tasking bike system for
+ *        a given number of virtual seconds and prints the task statistics
+ *
+ * Usage: bike_computer_sim [virtual seconds, default 20]
+ *
+ * @date 2024-01-15
+ * @version 1.0.0
+ ***************************************************************************/
+
+#include <chrono>
+#include <cstdlib>
+
+#include "mbed.h"
+#include "mbed_trace.h"
+#include "multi_tasking/bike_system.hpp"
+
+#if defined(MBED_CONF_MBED_TRACE_ENABLE)
+#define TRACE_GROUP "MAIN"
+#endif  // MBED_CONF_MBED_TRACE_ENABLE
+
+int main(int argc, char* argv[]) {
+#if defined(MBED_CONF_MBED_TRACE_ENABLE)
+    mbed_trace_init();
+#endif
+    const uint32_t runTime = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 20;
+
+    const auto wallStart = std::chrono::steady_clock::now();
+
+    multi_tasking::BikeSystem bikeSystem;
+    Thread thread(osPriorityNormal, OS_STACK_SIZE, nullptr, "bikeSystem");
+    thread.start(callback(&bikeSystem, &multi_tasking::BikeSystem::start));
+
+    ThisThread::sleep_for(std::chrono::seconds(runTime));
+
+    bikeSystem.stop();
+    thread.terminate();
+
+    const auto wallTime = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - wallStart);
+    tr_info("Simulated %" PRIu32 " secs in %lld msecs", runTime, static_cast<long long>(wallTime.count()));
+    return 0;
+}
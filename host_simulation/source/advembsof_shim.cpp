@@ -0,0 +1,304 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file advembsof_shim.cpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Host implementation of the advembsof and disco library subset and of
+ *        mbed-trace
+ *
+ * @date 2024-01-15
+ * @version 1.0.0
+ ***************************************************************************/
+
+#include <cinttypes>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "cpu_logger.hpp"
+#include "display_device.hpp"
+#include "hdc1000.hpp"
+#include "joystick.hpp"
+#include "mbed.h"
+#include "mbed_trace.h"
+#include "memory_logger.hpp"
+#include "task_logger.hpp"
+
+#define TRACE_GROUP "TaskLogger"
+
+// mbed-trace
+
+static bool traceInitialized = false;
+static uint8_t traceConfig   = TRACE_ACTIVE_LEVEL_ALL;
+
+int mbed_trace_init(void) {
+    traceInitialized = true;
+    const char* level = std::getenv("HOST_SIM_TRACE_LEVEL");
+    if (level != nullptr) {
+        if (std::strcmp(level, "debug") == 0) {
+            traceConfig = TRACE_ACTIVE_LEVEL_DEBUG;
+        } else if (std::strcmp(level, "info") == 0) {
+            traceConfig = TRACE_ACTIVE_LEVEL_INFO;
+        } else if (std::strcmp(level, "warn") == 0) {
+            traceConfig = TRACE_ACTIVE_LEVEL_WARN;
+        } else if (std::strcmp(level, "error") == 0) {
+            traceConfig = TRACE_ACTIVE_LEVEL_ERROR;
+        } else {
+            traceConfig = TRACE_ACTIVE_LEVEL_NONE;
+        }
+    }
+    return 0;
+}
+
+void mbed_trace_free(void) { traceInitialized = false; }
+
+void mbed_trace_config_set(uint8_t config) { traceConfig = config; }
+
+uint8_t mbed_trace_config_get(void) { return traceConfig; }
+
+void mbed_tracef(uint8_t dlevel, const char* grp, const char* fmt, ...) {
+    if (!traceInitialized || (dlevel & traceConfig) == 0) {
+        return;
+    }
+    const char* prefix = "CMD ";
+    switch (dlevel) {
+        case TRACE_LEVEL_DEBUG:
+            prefix = "DBG ";
+            break;
+        case TRACE_LEVEL_INFO:
+            prefix = "INFO";
+            break;
+        case TRACE_LEVEL_WARN:
+            prefix = "WARN";
+            break;
+        case TRACE_LEVEL_ERROR:
+            prefix = "ERR ";
+            break;
+        default:
+            break;
+    }
+    std::printf("[%s][%-4s]: ", prefix, grp);
+    va_list args;
+    va_start(args, fmt);
+    std::vfprintf(stdout, fmt, args);
+    va_end(args);
+    std::printf("\n");
+}
+
+namespace advembsof {
+
+// TaskLogger
+
+static const char* const kTaskDescriptors[TaskLogger::kNbrOfTasks] = {
+    "Gear", "Speed", "Temperature", "Reset", "Display(1)", "Display(2)"};
+
+void TaskLogger::enable(bool enable) { _isEnabled = enable; }
+
+void TaskLogger::logPeriodAndExecutionTime(Timer& timer,
+                                           int taskIndex,
+                                           const std::chrono::microseconds& taskStartTime) {
+    if (!_isEnabled || taskIndex < 0 || taskIndex >= kNbrOfTasks) {
+        return;
+    }
+    const std::chrono::microseconds periodTime = taskStartTime - _taskStartTime[taskIndex];
+    _taskStartTime[taskIndex]                  = taskStartTime;
+    const std::chrono::microseconds executionTime = timer.elapsed_time() - taskStartTime;
+    _periodTime[taskIndex]                        = periodTime;
+    _computationTime[taskIndex]                   = executionTime;
+    tr_debug("%s task: period %" PRIu64 " usecs execution time %" PRIu64
+             " usecs start time %" PRIu64 " usecs",
+             kTaskDescriptors[taskIndex],
+             static_cast<uint64_t>(periodTime.count()),
+             static_cast<uint64_t>(executionTime.count()),
+             static_cast<uint64_t>(taskStartTime.count()));
+}
+
+std::chrono::microseconds TaskLogger::getPeriod(uint8_t taskIndex) const {
+    return _periodTime[taskIndex];
+}
+
+std::chrono::microseconds TaskLogger::getComputationTime(uint8_t taskIndex) const {
+    return _computationTime[taskIndex];
+}
+
+// CPULogger
+
+CPULogger::CPULogger(Timer& timer) : _timer(timer) {}
+
+void CPULogger::printStats() {
+    mbed_stats_cpu_t stats;
+    mbed_stats_cpu_get(&stats);
+    const uint64_t diffUpTime   = stats.uptime - _previousUpTime;
+    const uint64_t diffIdleTime = stats.idle_time - _previousIdleTime;
+    _previousUpTime             = stats.uptime;
+    _previousIdleTime           = stats.idle_time;
+    if (diffUpTime == 0) {
+        return;
+    }
+    const uint64_t idle = (diffIdleTime * 100) / diffUpTime;
+    std::printf("Idle: %" PRIu64 "%% Usage: %" PRIu64 "%%\n", idle, 100 - idle);
+}
+
+// MemoryLogger
+
+void MemoryLogger::getAndPrintStatistics() {
+    getAndPrintHeapStatistics();
+    getAndPrintStackStatistics();
+}
+
+void MemoryLogger::getAndPrintHeapStatistics() {
+    mbed_stats_heap_t heapInfo;
+    mbed_stats_heap_get(&heapInfo);
+    std::printf("Heap: current %" PRIu32 " max %" PRIu32 " reserved %" PRIu32 "\n",
+                heapInfo.current_size,
+                heapInfo.max_size,
+                heapInfo.reserved_size);
+}
+
+void MemoryLogger::getAndPrintStackStatistics() {
+    mbed_stats_stack_t stackInfo;
+    mbed_stats_stack_get(&stackInfo);
+    std::printf("Stack: max %" PRIu32 " reserved %" PRIu32 "\n",
+                stackInfo.max_size,
+                stackInfo.reserved_size);
+}
+
+void MemoryLogger::printRuntimeMemoryMap() {}
+
+// DisplayDevice
+
+static std::chrono::microseconds displayDrawCost = std::chrono::microseconds::zero();
+static mbed::Callback<void(DisplayDevice::Field, const char*)> displayOnDraw;
+
+disco::ReturnCode DisplayDevice::init() { return disco::ReturnCode::Ok; }
+
+void DisplayDevice::displayGear(uint8_t gear) {
+    char text[kMaxTextLength];
+    std::snprintf(text, sizeof(text), "Gear: %d", gear);
+    draw(kGearField, text);
+}
+
+void DisplayDevice::displaySpeed(float speed) {
+    char text[kMaxTextLength];
+    std::snprintf(text, sizeof(text), "Speed: %.2f km/h", static_cast<double>(speed));
+    draw(kSpeedField, text);
+}
+
+void DisplayDevice::displayDistance(float distance) {
+    char text[kMaxTextLength];
+    std::snprintf(text, sizeof(text), "Distance: %.2f km", static_cast<double>(distance));
+    draw(kDistanceField, text);
+}
+
+void DisplayDevice::displayTemperature(float temperature) {
+    char text[kMaxTextLength];
+    std::snprintf(text, sizeof(text), "Temperature: %.2f C", static_cast<double>(temperature));
+    draw(kTemperatureField, text);
+}
+
+const char* DisplayDevice::getText(Field field) const { return _text[field]; }
+
+uint32_t DisplayDevice::getDrawCount(Field field) const { return _drawCount[field]; }
+
+void DisplayDevice::setDrawCost(std::chrono::microseconds cost) { displayDrawCost = cost; }
+
+void DisplayDevice::setOnDraw(mbed::Callback<void(Field field, const char* text)> onDraw) {
+    displayOnDraw = onDraw;
+}
+
+void DisplayDevice::draw(Field field, const char* text) {
+    std::snprintf(_text[field], kMaxTextLength, "%s", text);
+    _drawCount[field]++;
+    if (displayDrawCost > std::chrono::microseconds::zero()) {
+        host_sim::Kernel::instance().consume(displayDrawCost);
+    }
+    if (displayOnDraw) {
+        displayOnDraw(field, _text[field]);
+    }
+}
+
+// HDC1000
+
+static float ambientTemperature = 21.5f;
+static float ambientHumidity    = 45.0f;
+
+HDC1000::HDC1000(PinName sda, PinName scl, PinName dataReadyPin) {}
+
+bool HDC1000::probe() { return true; }
+
+float HDC1000::getTemperature() { return ambientTemperature; }
+
+float HDC1000::getHumidity() { return ambientHumidity; }
+
+void HDC1000::setAmbient(float temperature, float humidity) {
+    ambientTemperature = temperature;
+    ambientHumidity    = humidity;
+}
+
+}  // namespace advembsof
+
+namespace disco {
+
+// Joystick
+
+Joystick& Joystick::getInstance() {
+    static Joystick instance;
+    return instance;
+}
+
+Joystick::State Joystick::getState() const { return _state; }
+
+void Joystick::setSelCallback(mbed::Callback<void()> cb) { _selCallback = cb; }
+
+void Joystick::setUpCallback(mbed::Callback<void()> cb) { _upCallback = cb; }
+
+void Joystick::setDownCallback(mbed::Callback<void()> cb) { _downCallback = cb; }
+
+void Joystick::setLeftCallback(mbed::Callback<void()> cb) { _leftCallback = cb; }
+
+void Joystick::setRightCallback(mbed::Callback<void()> cb) { _rightCallback = cb; }
+
+void Joystick::press(State state) {
+    _state = state;
+    mbed::Callback<void()> cb;
+    switch (state) {
+        case State::SelPressed:
+            cb = _selCallback;
+            break;
+        case State::UpPressed:
+            cb = _upCallback;
+            break;
+        case State::DownPressed:
+            cb = _downCallback;
+            break;
+        case State::LeftPressed:
+            cb = _leftCallback;
+            break;
+        case State::RightPressed:
+            cb = _rightCallback;
+            break;
+        default:
+            break;
+    }
+    if (cb) {
+        host_sim::Kernel::instance().runIsr([&cb]() { cb(); }, "Joystick");
+    }
+}
+
+void Joystick::release() { _state = State::NonePressed; }
+
+}  // namespace disco
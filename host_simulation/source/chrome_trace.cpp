@@ -0,0 +1,190 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file chrome_trace.cpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Chrome Trace Event export implementation (host simulation)
+ *
+ * @date 2024-05-06
+ * @version 1.0.0
+ ***************************************************************************/
+
+#include "host_sim/chrome_trace.hpp"
+
+#include <cinttypes>
+#include <cstdlib>
+
+#include "host_sim/virtual_kernel.hpp"
+#include "mbed.h"
+#include "task_tracer.hpp"
+
+namespace host_sim {
+
+static const char* const kGroupNames[] = {"", "Threads", "Interrupts", "Event queues", "Tasks"};
+static const char* const kTaskNames[bike_computer::TaskTracer::kNbrOfTasks] = {
+    "Gear", "Speed", "Temperature", "Reset", "Display(1)", "Display(2)"};
+
+static std::string escape(const std::string& text) {
+    std::string escaped;
+    for (char character : text) {
+        if (character == '"' || character == '\\') {
+            escaped += '\\';
+        }
+        escaped += (static_cast<unsigned char>(character) < 0x20) ? ' ' : character;
+    }
+    return escaped;
+}
+
+// task invocations are recorded when they end, with times relative to the
+// timer of the bike system
+static void onTaskRecord(uint8_t taskIndex, uint64_t startTime, uint64_t endTime) {
+    if (taskIndex >= bike_computer::TaskTracer::kNbrOfTasks) {
+        return;
+    }
+    ChromeTrace& trace = ChromeTrace::instance();
+    const auto now     = Kernel::instance().now();
+    trace.complete(ChromeTrace::Group::kTasks,
+                   trace.getTrack(ChromeTrace::Group::kTasks, kTaskNames[taskIndex]),
+                   kTaskNames[taskIndex],
+                   now - std::chrono::microseconds(endTime - startTime),
+                   now);
+}
+
+ChromeTrace& ChromeTrace::instance() {
+    // never destroyed, like the kernel, the file is closed at exit
+    static ChromeTrace* trace = []() {
+        ChromeTrace* instance = new ChromeTrace();
+        const char* fileName  = std::getenv("HOST_SIM_CHROME_TRACE");
+        if (fileName != nullptr && fileName[0] != '\0') {
+            instance->open(fileName);
+        }
+        return instance;
+    }();
+    return *trace;
+}
+
+bool ChromeTrace::open(const char* fileName) {
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (_file != nullptr) {
+            return false;
+        }
+        _file = std::fopen(fileName, "w");
+        if (_file == nullptr) {
+            std::fprintf(stderr, "host_sim: cannot open the trace file %s\n", fileName);
+            return false;
+        }
+        std::fputs("[", _file);
+        _isFirstEvent = true;
+    }
+    for (uint32_t group = static_cast<uint32_t>(Group::kThreads);
+         group <= static_cast<uint32_t>(Group::kTasks);
+         group++) {
+        writeEvent("{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":" + std::to_string(group) +
+                   ",\"args\":{\"name\":\"" + kGroupNames[group] + "\"}}");
+    }
+    bike_computer::TaskTracer::getInstance().setOnRecord(mbed::callback(onTaskRecord));
+    static bool isCloseRegistered = false;
+    if (!isCloseRegistered) {
+        isCloseRegistered = true;
+        std::atexit([]() { ChromeTrace::instance().close(); });
+    }
+    return true;
+}
+
+void ChromeTrace::close() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (_file == nullptr) {
+        return;
+    }
+    std::fputs("\n]\n", _file);
+    std::fclose(_file);
+    _file = nullptr;
+}
+
+uint32_t ChromeTrace::addTrack(Group group, const std::string& name) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    return addTrackLocked(group, name);
+}
+
+uint32_t ChromeTrace::getTrack(Group group, const std::string& name) {
+    // a single lock, so that concurrent first uses create a single track
+    std::unique_lock<std::mutex> lock(_mutex);
+    auto it = _namedTracks.find(std::make_pair(group, name));
+    if (it != _namedTracks.end()) {
+        return it->second;
+    }
+    const uint32_t track = addTrackLocked(group, name);
+    if (track != 0) {
+        _namedTracks.emplace(std::make_pair(group, name), track);
+    }
+    return track;
+}
+
+void ChromeTrace::begin(Group group,
+                        uint32_t track,
+                        const char* name,
+                        std::chrono::microseconds time) {
+    writeEvent("{\"ph\":\"B\",\"name\":\"" + escape(name) +
+               "\",\"pid\":" + std::to_string(static_cast<uint32_t>(group)) +
+               ",\"tid\":" + std::to_string(track) + ",\"ts\":" + std::to_string(time.count()) +
+               "}");
+}
+
+void ChromeTrace::end(Group group, uint32_t track, std::chrono::microseconds time) {
+    writeEvent("{\"ph\":\"E\",\"pid\":" + std::to_string(static_cast<uint32_t>(group)) +
+               ",\"tid\":" + std::to_string(track) + ",\"ts\":" + std::to_string(time.count()) +
+               "}");
+}
+
+void ChromeTrace::complete(Group group,
+                           uint32_t track,
+                           const char* name,
+                           std::chrono::microseconds start,
+                           std::chrono::microseconds end) {
+    writeEvent("{\"ph\":\"X\",\"name\":\"" + escape(name) +
+               "\",\"pid\":" + std::to_string(static_cast<uint32_t>(group)) +
+               ",\"tid\":" + std::to_string(track) + ",\"ts\":" + std::to_string(start.count()) +
+               ",\"dur\":" + std::to_string((end - start).count()) + "}");
+}
+
+void ChromeTrace::writeEvent(const std::string& event) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    writeEventLocked(event);
+}
+
+uint32_t ChromeTrace::addTrackLocked(Group group, const std::string& name) {
+    if (_file == nullptr) {
+        return 0;
+    }
+    const uint32_t track = ++_lastTrack;
+    writeEventLocked("{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":" +
+                     std::to_string(static_cast<uint32_t>(group)) +
+                     ",\"tid\":" + std::to_string(track) + ",\"args\":{\"name\":\"" +
+                     escape(name) + "\"}}");
+    return track;
+}
+
+void ChromeTrace::writeEventLocked(const std::string& event) {
+    if (_file == nullptr) {
+        return;
+    }
+    std::fputs(_isFirstEvent ? "\n" : ",\n", _file);
+    std::fputs(event.c_str(), _file);
+    _isFirstEvent = false;
+}
+
+}  // namespace host_sim
@@ -0,0 +1,781 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file mbed_shim.cpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Host implementation of the mbed-os subset (drivers, rtos, events)
+ *
+ * @date 2024-01-15
+ * @version 1.0.0
+ ***************************************************************************/
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "host_sim/chrome_trace.hpp"
+#include "mbed.h"
+#include "mbed_mem_trace.h"
+
+namespace host_sim {
+
+void assertionFailed(const char* expr, const char* file, int line) {
+    std::printf("host_sim: assertion \"%s\" failed at %s:%d\n", expr, file, line);
+    std::fflush(stdout);
+    std::abort();
+}
+
+// interrupt inputs attached to each pin and current pin levels
+static std::multimap<PinName, mbed::InterruptIn*>& interruptInputs() {
+    static std::multimap<PinName, mbed::InterruptIn*> inputs;
+    return inputs;
+}
+
+static std::map<PinName, int>& pinLevels() {
+    static std::map<PinName, int> levels;
+    return levels;
+}
+
+void setPinLevel(PinName pin, int level) {
+    const int previousLevel = getPinLevel(pin);
+    pinLevels()[pin]        = level;
+    if (previousLevel == level) {
+        return;
+    }
+    std::vector<mbed::Callback<void()>> handlers;
+    auto range = interruptInputs().equal_range(pin);
+    for (auto it = range.first; it != range.second; ++it) {
+        mbed::InterruptIn* input = it->second;
+        const mbed::Callback<void()>& handler = (level != 0) ? input->_rise : input->_fall;
+        if (input->_irqEnabled && handler) {
+            handlers.push_back(handler);
+        }
+    }
+    const std::string source = "InterruptIn " + std::to_string(static_cast<int>(pin));
+    for (const auto& handler : handlers) {
+        Kernel::instance().runIsr([&handler]() { handler(); }, source.c_str());
+    }
+}
+
+int getPinLevel(PinName pin) {
+    auto it = pinLevels().find(pin);
+    return (it != pinLevels().end()) ? it->second : 0;
+}
+
+}  // namespace host_sim
+
+static std::recursive_mutex& criticalSectionMutex() {
+    static std::recursive_mutex mutex;
+    return mutex;
+}
+
+bool core_util_is_isr_active() { return host_sim::Kernel::instance().isInIsr(); }
+
+void core_util_critical_section_enter() { criticalSectionMutex().lock(); }
+
+void core_util_critical_section_exit() { criticalSectionMutex().unlock(); }
+
+void mbed_stats_cpu_get(mbed_stats_cpu_t* stats) {
+    host_sim::Kernel& kernel = host_sim::Kernel::instance();
+    stats->uptime            = kernel.now().count();
+    stats->idle_time         = kernel.getIdleTime().count();
+    stats->sleep_time        = stats->idle_time;
+    stats->deep_sleep_time   = 0;
+}
+
+// heap statistics: the global operator new and delete are replaced for
+// counting the allocations (including the ones of the simulation and of the
+// host library), each block starts with a header holding its size. The
+// allocations are also reported to the memory trace callback, with the
+// address of the caller of new or delete.
+namespace {
+
+constexpr size_t kHeapHeaderSize = alignof(std::max_align_t);
+
+std::atomic<uint32_t> heapCurrentSize{0};
+std::atomic<uint32_t> heapMaxSize{0};
+std::atomic<uint32_t> heapTotalSize{0};
+std::atomic<uint32_t> heapAllocCount{0};
+std::atomic<uint32_t> heapAllocFailCount{0};
+
+std::atomic<mbed_mem_trace_cb_t> memTraceCallback{nullptr};
+// set while the callback runs, so that its own allocations are not traced
+thread_local bool isInMemTraceCallback = false;
+
+template <typename... Args>
+void traceMemory(uint8_t op, void* result, void* caller, Args... arguments) {
+    const mbed_mem_trace_cb_t callback = memTraceCallback.load();
+    if (callback == nullptr || isInMemTraceCallback) {
+        return;
+    }
+    isInMemTraceCallback = true;
+    callback(op, result, caller, arguments...);
+    isInMemTraceCallback = false;
+}
+
+void* heapAllocate(size_t size, void* caller) noexcept {
+    void* block = std::malloc(size + kHeapHeaderSize);
+    if (block == nullptr) {
+        heapAllocFailCount++;
+        traceMemory(MBED_MEM_TRACE_MALLOC, nullptr, caller, size);
+        return nullptr;
+    }
+    *static_cast<size_t*>(block) = size;
+    const uint32_t currentSize   = heapCurrentSize.fetch_add(size) + size;
+    uint32_t maxSize             = heapMaxSize.load();
+    while (currentSize > maxSize && !heapMaxSize.compare_exchange_weak(maxSize, currentSize)) {
+    }
+    heapTotalSize += size;
+    heapAllocCount++;
+    void* ptr = static_cast<unsigned char*>(block) + kHeapHeaderSize;
+    traceMemory(MBED_MEM_TRACE_MALLOC, ptr, caller, size);
+    return ptr;
+}
+
+void heapFree(void* ptr, void* caller) noexcept {
+    if (ptr == nullptr) {
+        return;
+    }
+    traceMemory(MBED_MEM_TRACE_FREE, nullptr, caller, ptr);
+    void* block = static_cast<unsigned char*>(ptr) - kHeapHeaderSize;
+    heapCurrentSize -= *static_cast<size_t*>(block);
+    heapAllocCount--;
+    std::free(block);
+}
+
+void* heapAllocateOrThrow(size_t size, void* caller) {
+    void* ptr = heapAllocate(size, caller);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+}  // namespace
+
+#define HEAP_CALLER __builtin_return_address(0)
+
+void* operator new(size_t size) { return heapAllocateOrThrow(size, HEAP_CALLER); }
+void* operator new[](size_t size) { return heapAllocateOrThrow(size, HEAP_CALLER); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return heapAllocate(size, HEAP_CALLER);
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return heapAllocate(size, HEAP_CALLER);
+}
+void operator delete(void* ptr) noexcept { heapFree(ptr, HEAP_CALLER); }
+void operator delete[](void* ptr) noexcept { heapFree(ptr, HEAP_CALLER); }
+void operator delete(void* ptr, size_t) noexcept { heapFree(ptr, HEAP_CALLER); }
+void operator delete[](void* ptr, size_t) noexcept { heapFree(ptr, HEAP_CALLER); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { heapFree(ptr, HEAP_CALLER); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { heapFree(ptr, HEAP_CALLER); }
+
+void mbed_mem_trace_set_callback(mbed_mem_trace_cb_t callback) { memTraceCallback = callback; }
+
+void mbed_stats_heap_get(mbed_stats_heap_t* stats) {
+    // the host heap has no reserved size
+    *stats = mbed_stats_heap_t{heapCurrentSize.load(),
+                               heapMaxSize.load(),
+                               heapTotalSize.load(),
+                               0,
+                               heapAllocCount.load(),
+                               heapAllocFailCount.load(),
+                               heapAllocCount.load() * static_cast<uint32_t>(kHeapHeaderSize)};
+}
+
+void mbed_stats_stack_get(mbed_stats_stack_t* stats) {
+    const host_sim::Kernel::StackStatistics statistics =
+        host_sim::Kernel::instance().getStackStatistics();
+    *stats = mbed_stats_stack_t{0, statistics.maxSize, statistics.reservedSize, statistics.count};
+}
+
+namespace host_sim {
+
+void resetStatisticsPeaks() {
+    heapMaxSize = heapCurrentSize.load();
+    Kernel::instance().resetStackPeaks();
+}
+
+}  // namespace host_sim
+
+namespace mbed {
+
+// FileHandle
+
+namespace {
+
+class HostFileHandle : public FileHandle {
+   public:
+    explicit HostFileHandle(int fd) : _fd(fd) {}
+
+    ssize_t write(const void* buffer, size_t size) override {
+        std::fflush(stdout);
+        return ::write(_fd, buffer, size);
+    }
+
+   private:
+    int _fd;
+};
+
+}  // namespace
+
+FileHandle* mbed_file_handle(int fd) {
+    static HostFileHandle stdoutHandle(STDOUT_FILENO);
+    static HostFileHandle stderrHandle(STDERR_FILENO);
+    if (fd == STDOUT_FILENO) {
+        return &stdoutHandle;
+    }
+    if (fd == STDERR_FILENO) {
+        return &stderrHandle;
+    }
+    return nullptr;
+}
+
+// Timer
+
+void Timer::start() {
+    if (!_running) {
+        _startTime = host_sim::Kernel::instance().now();
+        _running   = true;
+    }
+}
+
+void Timer::stop() {
+    if (_running) {
+        _accumulated += host_sim::Kernel::instance().now() - _startTime;
+        _running = false;
+    }
+}
+
+void Timer::reset() {
+    _accumulated = std::chrono::microseconds::zero();
+    _startTime   = host_sim::Kernel::instance().now();
+}
+
+std::chrono::microseconds Timer::elapsed_time() const {
+    host_sim::Kernel& kernel = host_sim::Kernel::instance();
+    kernel.consume(kernel.getTimerReadCost());
+    if (_running) {
+        return _accumulated + (kernel.now() - _startTime);
+    }
+    return _accumulated;
+}
+
+int Timer::read_us() const { return static_cast<int>(elapsed_time().count()); }
+
+int Timer::read_ms() const {
+    return static_cast<int>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(elapsed_time()).count());
+}
+
+float Timer::read() const { return static_cast<float>(elapsed_time().count()) / 1000000.0f; }
+
+// InterruptIn
+
+InterruptIn::InterruptIn(PinName pin) : _pin(pin) {
+    host_sim::interruptInputs().insert(std::make_pair(pin, this));
+}
+
+InterruptIn::InterruptIn(PinName pin, PinMode mode) : InterruptIn(pin) {}
+
+InterruptIn::~InterruptIn() {
+    auto range = host_sim::interruptInputs().equal_range(_pin);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second == this) {
+            host_sim::interruptInputs().erase(it);
+            break;
+        }
+    }
+}
+
+int InterruptIn::read() { return host_sim::getPinLevel(_pin); }
+
+InterruptIn::operator int() { return read(); }
+
+void InterruptIn::rise(Callback<void()> func) { _rise = func; }
+
+void InterruptIn::fall(Callback<void()> func) { _fall = func; }
+
+void InterruptIn::mode(PinMode pull) {}
+
+void InterruptIn::enable_irq() { _irqEnabled = true; }
+
+void InterruptIn::disable_irq() { _irqEnabled = false; }
+
+// Ticker
+
+Ticker::~Ticker() { detach(); }
+
+void Ticker::detach() {
+    if (_alarmId != 0) {
+        host_sim::Kernel::instance().cancelAlarm(_alarmId);
+        _alarmId = 0;
+    }
+}
+
+void Ticker::attachPeriod(Callback<void()> func,
+                          std::chrono::microseconds period,
+                          bool periodic) {
+    detach();
+    _function = func;
+    _period   = std::max(period, std::chrono::microseconds(1));
+    _periodic = periodic;
+    schedule(host_sim::Kernel::instance().now() + _period);
+}
+
+void Ticker::schedule(std::chrono::microseconds at) {
+    _alarmId = host_sim::Kernel::instance().addAlarm(
+        at,
+        [this, at]() {
+            _alarmId = 0;
+            if (_periodic) {
+                schedule(at + _period);
+            }
+            _function();
+        },
+        "Ticker");
+}
+
+void wait_us(int us) { host_sim::Kernel::instance().consume(std::chrono::microseconds(us)); }
+
+}  // namespace mbed
+
+namespace rtos {
+
+// Kernel
+
+Kernel::Clock::time_point Kernel::Clock::now() {
+    return time_point(std::chrono::duration_cast<duration>(host_sim::Kernel::instance().now()));
+}
+
+uint64_t Kernel::get_ms_count() { return Clock::now().time_since_epoch().count(); }
+
+// Thread
+
+Thread::Thread(osPriority priority,
+               uint32_t stack_size,
+               unsigned char* stack_mem,
+               const char* name)
+    : _thread(host_sim::Kernel::instance().createThread(priority, name, stack_size)),
+      _stackSize(stack_size) {
+    if (stack_mem == nullptr) {
+        _allocatedStack = new unsigned char[stack_size];
+    }
+}
+
+Thread::~Thread() {
+    host_sim::Kernel& kernel = host_sim::Kernel::instance();
+    if (_started) {
+        kernel.terminateThread(_thread);
+    }
+    kernel.destroyThread(_thread);
+    delete[] _allocatedStack;
+}
+
+osStatus Thread::start(mbed::Callback<void()> task) {
+    if (_started) {
+        return osErrorParameter;
+    }
+    _started = true;
+    host_sim::Kernel::instance().startThread(_thread, [task]() { task(); });
+    return osOK;
+}
+
+osStatus Thread::join() {
+    host_sim::Kernel::instance().joinThread(_thread);
+    return osOK;
+}
+
+osStatus Thread::terminate() {
+    host_sim::Kernel::instance().terminateThread(_thread);
+    return osOK;
+}
+
+osStatus Thread::set_priority(osPriority priority) {
+    host_sim::Kernel::instance().setPriority(_thread, priority);
+    return osOK;
+}
+
+osPriority Thread::get_priority() const {
+    return static_cast<osPriority>(host_sim::Kernel::instance().getPriority(_thread));
+}
+
+Thread::State Thread::get_state() const {
+    host_sim::Kernel& kernel = host_sim::Kernel::instance();
+    if (kernel.isFinished(_thread)) {
+        return Deleted;
+    }
+    if (!_started) {
+        return Inactive;
+    }
+    return (kernel.currentThread() == _thread) ? Running : Ready;
+}
+
+const char* Thread::get_name() const { return host_sim::Kernel::instance().getName(_thread); }
+
+osThreadId_t Thread::get_id() const { return _thread; }
+
+uint32_t Thread::stack_size() const { return _stackSize; }
+
+// ThisThread
+
+void ThisThread::sleep_for(Kernel::Clock::duration_u32 rel_time) {
+    host_sim::Kernel& kernel = host_sim::Kernel::instance();
+    if (rel_time.count() == 0) {
+        kernel.yield();
+        return;
+    }
+    kernel.sleepUntil(kernel.now() + std::chrono::milliseconds(rel_time.count()));
+}
+
+void ThisThread::sleep_for(uint32_t millisec) {
+    sleep_for(Kernel::Clock::duration_u32(millisec));
+}
+
+void ThisThread::sleep_until(Kernel::Clock::time_point abs_time) {
+    host_sim::Kernel::instance().sleepUntil(abs_time.time_since_epoch());
+}
+
+void ThisThread::yield() { host_sim::Kernel::instance().yield(); }
+
+osThreadId_t ThisThread::get_id() { return host_sim::Kernel::instance().currentThread(); }
+
+const char* ThisThread::get_name() {
+    host_sim::Kernel& kernel = host_sim::Kernel::instance();
+    return kernel.getName(kernel.currentThread());
+}
+
+// Mutex
+
+void Mutex::lock() {
+    host_sim::Kernel& kernel     = host_sim::Kernel::instance();
+    host_sim::SimThread* current = kernel.currentThread();
+    if (_owner == nullptr) {
+        _owner = current;
+        _count = 1;
+    } else if (_owner == current) {
+        _count++;
+    } else {
+        // ownership is handed over by unlock()
+        kernel.wait(&_waiters, host_sim::Kernel::kForever);
+    }
+}
+
+bool Mutex::trylock() { return trylock_for(Kernel::Clock::duration_u32(0)); }
+
+bool Mutex::trylock_for(Kernel::Clock::duration_u32 rel_time) {
+    host_sim::Kernel& kernel     = host_sim::Kernel::instance();
+    host_sim::SimThread* current = kernel.currentThread();
+    if (_owner == nullptr) {
+        _owner = current;
+        _count = 1;
+        return true;
+    }
+    if (_owner == current) {
+        _count++;
+        return true;
+    }
+    return kernel.wait(&_waiters, kernel.now() + std::chrono::milliseconds(rel_time.count()));
+}
+
+void Mutex::unlock() {
+    MBED_ASSERT(_count > 0);
+    if (--_count > 0) {
+        return;
+    }
+    host_sim::Kernel& kernel = host_sim::Kernel::instance();
+    _owner                   = kernel.wakeOne(_waiters);
+    _count                   = (_owner != nullptr) ? 1 : 0;
+    kernel.reschedule();
+}
+
+osThreadId_t Mutex::get_owner() { return _owner; }
+
+// Semaphore
+
+Semaphore::Semaphore(int32_t count, uint16_t max_count)
+    : _count(count), _maxCount(max_count) {}
+
+void Semaphore::acquire() { acquireUntil(host_sim::Kernel::kForever); }
+
+bool Semaphore::try_acquire() {
+    if (_count > 0) {
+        _count--;
+        return true;
+    }
+    return false;
+}
+
+bool Semaphore::try_acquire_for(Kernel::Clock::duration_u32 rel_time) {
+    return acquireUntil(host_sim::Kernel::instance().now() +
+                        std::chrono::milliseconds(rel_time.count()));
+}
+
+bool Semaphore::try_acquire_until(Kernel::Clock::time_point abs_time) {
+    return acquireUntil(abs_time.time_since_epoch());
+}
+
+bool Semaphore::acquireUntil(std::chrono::microseconds deadline) {
+    if (try_acquire()) {
+        return true;
+    }
+    // the token is handed over by release()
+    return host_sim::Kernel::instance().wait(&_waiters, deadline);
+}
+
+osStatus Semaphore::release() {
+    host_sim::Kernel& kernel = host_sim::Kernel::instance();
+    if (kernel.wakeOne(_waiters) == nullptr) {
+        if (_count >= _maxCount) {
+            return osErrorResource;
+        }
+        _count++;
+    }
+    kernel.reschedule();
+    return osOK;
+}
+
+// EventFlags
+
+uint32_t EventFlags::set(uint32_t flags) {
+    host_sim::Kernel& kernel = host_sim::Kernel::instance();
+    _flags |= flags;
+    const uint32_t result = _flags;
+    for (Request* request : _requests) {
+        if (!request->done && isSatisfied(*request)) {
+            request->done   = true;
+            request->result = _flags;
+            if (request->clear) {
+                _flags &= ~request->flags;
+            }
+            kernel.wakeThread(request->thread);
+        }
+    }
+    kernel.reschedule();
+    return result;
+}
+
+uint32_t EventFlags::clear(uint32_t flags) {
+    const uint32_t previous = _flags;
+    _flags &= ~flags;
+    return previous;
+}
+
+uint32_t EventFlags::get() const { return _flags; }
+
+uint32_t EventFlags::wait_all(uint32_t flags, uint32_t millisec, bool clear) {
+    return wait(flags,
+                true,
+                clear,
+                (millisec == osWaitForever)
+                    ? host_sim::Kernel::kForever
+                    : host_sim::Kernel::instance().now() + std::chrono::milliseconds(millisec));
+}
+
+uint32_t EventFlags::wait_any(uint32_t flags, uint32_t millisec, bool clear) {
+    return wait(flags,
+                false,
+                clear,
+                (millisec == osWaitForever)
+                    ? host_sim::Kernel::kForever
+                    : host_sim::Kernel::instance().now() + std::chrono::milliseconds(millisec));
+}
+
+uint32_t EventFlags::wait_all_for(uint32_t flags,
+                                  Kernel::Clock::duration_u32 rel_time,
+                                  bool clear) {
+    return wait_all(flags, rel_time.count(), clear);
+}
+
+uint32_t EventFlags::wait_any_for(uint32_t flags,
+                                  Kernel::Clock::duration_u32 rel_time,
+                                  bool clear) {
+    return wait_any(flags, rel_time.count(), clear);
+}
+
+bool EventFlags::isSatisfied(const Request& request) const {
+    return request.all ? ((_flags & request.flags) == request.flags)
+                       : ((_flags & request.flags) != 0);
+}
+
+uint32_t EventFlags::wait(uint32_t flags,
+                          bool all,
+                          bool clear,
+                          std::chrono::microseconds deadline) {
+    host_sim::Kernel& kernel = host_sim::Kernel::instance();
+    Request request{kernel.currentThread(), flags, all, clear, false, 0};
+    if (isSatisfied(request)) {
+        const uint32_t result = _flags;
+        if (clear) {
+            _flags &= ~flags;
+        }
+        return result;
+    }
+    _requests.push_back(&request);
+    try {
+        kernel.wait(&_waiters, deadline);
+    } catch (const host_sim::ThreadTerminated&) {
+        _requests.remove(&request);
+        throw;
+    }
+    _requests.remove(&request);
+    return request.done ? request.result : osFlagsErrorTimeout;
+}
+
+}  // namespace rtos
+
+namespace events {
+
+constexpr std::chrono::microseconds EventQueue::kNotPeriodic;
+
+EventQueue::EventQueue(unsigned size, unsigned char* buffer) : _capacity(size) {}
+
+EventQueue::~EventQueue() {}
+
+void EventQueue::dispatch_forever() { dispatchUntil(host_sim::Kernel::kForever); }
+
+void EventQueue::dispatch_for(std::chrono::milliseconds ms) {
+    dispatchUntil(host_sim::Kernel::instance().now() + ms);
+}
+
+void EventQueue::dispatch(int ms) {
+    if (ms < 0) {
+        dispatch_forever();
+    } else {
+        dispatch_for(std::chrono::milliseconds(ms));
+    }
+}
+
+void EventQueue::break_dispatch() {
+    _breakDispatch = true;
+    host_sim::Kernel& kernel = host_sim::Kernel::instance();
+    kernel.wakeAll(_dispatchers);
+    kernel.reschedule();
+}
+
+bool EventQueue::cancel(int id) {
+    for (auto it = _events.begin(); it != _events.end(); ++it) {
+        if (it->id == id) {
+            _used -= it->size;
+            _events.erase(it);
+            return true;
+        }
+    }
+    return false;
+}
+
+std::chrono::milliseconds EventQueue::time_left(int id) {
+    const auto now = host_sim::Kernel::instance().now();
+    for (const auto& event : _events) {
+        if (event.id == id) {
+            return std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::max(event.target - now, std::chrono::microseconds::zero()));
+        }
+    }
+    return std::chrono::milliseconds(-1);
+}
+
+int EventQueue::post(std::chrono::microseconds delay,
+                     std::chrono::microseconds period,
+                     std::function<void()> function,
+                     std::size_t size) {
+    if (_used + size > _capacity) {
+        return 0;
+    }
+    host_sim::Kernel& kernel = host_sim::Kernel::instance();
+    // equeue works with a millisecond tick
+    const auto tick = std::chrono::duration_cast<std::chrono::milliseconds>(kernel.now());
+    const int id    = _nextId++;
+    _used += size;
+    enqueue(PendingEvent{id, tick + delay, period, std::move(function), size});
+    kernel.wakeAll(_dispatchers);
+    kernel.reschedule();
+    return id;
+}
+
+std::size_t EventQueue::getPendingEvents() const { return _events.size(); }
+
+void EventQueue::enqueue(PendingEvent&& event) {
+    auto it = std::find_if(_events.begin(), _events.end(), [&event](const PendingEvent& e) {
+        return e.target > event.target;
+    });
+    _events.insert(it, std::move(event));
+}
+
+void EventQueue::dispatchUntil(std::chrono::microseconds deadline) {
+    host_sim::Kernel& kernel = host_sim::Kernel::instance();
+    _breakDispatch           = false;
+    while (true) {
+        if (_breakDispatch) {
+            _breakDispatch = false;
+            return;
+        }
+        const auto now = kernel.now();
+        if (!_events.empty() && _events.front().target <= now) {
+            PendingEvent event = std::move(_events.front());
+            _events.pop_front();
+            host_sim::ChromeTrace& trace = host_sim::ChromeTrace::instance();
+            if (trace.isEnabled() && _traceTrack == 0) {
+                // the queue is named after the thread that dispatches it
+                _traceTrack = trace.addTrack(
+                    host_sim::ChromeTrace::Group::kEventQueues,
+                    std::string("EventQueue (") + kernel.getName(kernel.currentThread()) + ")");
+            }
+            if (_traceTrack != 0) {
+                trace.begin(host_sim::ChromeTrace::Group::kEventQueues,
+                            _traceTrack,
+                            event.period >= std::chrono::microseconds::zero() ? "periodic event"
+                                                                               : "event",
+                            now);
+            }
+            event.function();
+            if (_traceTrack != 0) {
+                trace.end(host_sim::ChromeTrace::Group::kEventQueues, _traceTrack, kernel.now());
+            }
+            if (event.period >= std::chrono::microseconds::zero()) {
+                // re-arm relative to the previous target, late events are
+                // clamped to the current tick
+                const auto tick =
+                    std::chrono::duration_cast<std::chrono::milliseconds>(kernel.now());
+                event.target = std::max<std::chrono::microseconds>(event.target + event.period,
+                                                                   tick);
+                enqueue(std::move(event));
+            } else {
+                _used -= event.size;
+            }
+            // like equeue, the timeout is also checked between dispatches,
+            // so that an overloaded queue returns
+            if (kernel.now() >= deadline) {
+                return;
+            }
+            continue;
+        }
+        if (now >= deadline) {
+            return;
+        }
+        const auto next = _events.empty() ? deadline : std::min(_events.front().target, deadline);
+        kernel.wait(&_dispatchers, next);
+    }
+}
+
+}  // namespace events
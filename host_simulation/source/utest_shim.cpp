@@ -0,0 +1,159 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file utest_shim.cpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Host implementation of the greentea, unity and utest subset
+ *
+ * @date 2024-01-15
+ * @version 1.0.0
+ ***************************************************************************/
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "greentea-client/test_env.h"
+#include "mbed.h"
+#include "unity/unity.h"
+#include "utest/utest.h"
+
+namespace host_sim {
+
+void greenteaSetup(int timeout, const char* hostTestName) {
+    std::printf("{{__timeout;%d}}\n{{__host_test_name;%s}}\n", timeout, hostTestName);
+    Kernel::instance().setWatchdog(Kernel::instance().now() + std::chrono::seconds(timeout),
+                                   "greentea timeout");
+}
+
+}  // namespace host_sim
+
+namespace unity {
+
+void fail(const char* file, int line, const std::string& message) {
+    throw AssertionFailure{std::string(file) + ":" + std::to_string(line) + ": " + message};
+}
+
+void assertUnsignedWithin(uint64_t delta,
+                          uint64_t expected,
+                          uint64_t actual,
+                          const char* file,
+                          int line) {
+    const uint64_t difference = (actual > expected) ? actual - expected : expected - actual;
+    if (difference > delta) {
+        fail(file,
+             line,
+             "Values not within delta " + std::to_string(delta) + ", expected " +
+                 std::to_string(expected) + " was " + std::to_string(actual));
+    }
+}
+
+void assertSignedWithin(int64_t delta, int64_t expected, int64_t actual, const char* file, int line) {
+    const int64_t difference = (actual > expected) ? actual - expected : expected - actual;
+    if (difference > delta) {
+        fail(file,
+             line,
+             "Values not within delta " + std::to_string(delta) + ", expected " +
+                 std::to_string(expected) + " was " + std::to_string(actual));
+    }
+}
+
+void assertFloatWithin(double delta, double expected, double actual, const char* file, int line) {
+    if (!(std::fabs(actual - expected) <= delta)) {
+        fail(file,
+             line,
+             "Values not within delta " + std::to_string(delta) + ", expected " +
+                 std::to_string(expected) + " was " + std::to_string(actual));
+    }
+}
+
+void assertEqualSigned(int64_t expected, int64_t actual, const char* file, int line) {
+    if (expected != actual) {
+        fail(file,
+             line,
+             "Expected " + std::to_string(expected) + " was " + std::to_string(actual));
+    }
+}
+
+void assertEqualUnsigned(uint64_t expected, uint64_t actual, const char* file, int line) {
+    if (expected != actual) {
+        fail(file,
+             line,
+             "Expected " + std::to_string(expected) + " was " + std::to_string(actual));
+    }
+}
+
+}  // namespace unity
+
+namespace utest {
+namespace v1 {
+
+Case::Case(const char* description, void (*handler)())
+    : _description(description), _handler(handler), _controlHandler(nullptr) {}
+
+Case::Case(const char* description, control_t (*handler)(const size_t call_count))
+    : _description(description), _handler(nullptr), _controlHandler(handler) {}
+
+const char* Case::getDescription() const { return _description; }
+
+void Case::run() const {
+    if (_handler != nullptr) {
+        _handler();
+    } else {
+        _controlHandler(0);
+    }
+}
+
+bool Harness::run(const Specification& specification) {
+    const auto& cases = specification.getCases();
+    if (specification.getSetupHandler()(cases.size()) != STATUS_CONTINUE) {
+        return false;
+    }
+    size_t nbrOfFailures = 0;
+    for (const Case& testCase : cases) {
+        std::printf("{{__testcase_start;%s}}\n", testCase.getDescription());
+        const auto startTime = host_sim::Kernel::instance().now();
+        bool passed          = true;
+        try {
+            testCase.run();
+        } catch (const unity::AssertionFailure& failure) {
+            std::printf(":%s:FAIL: %s\n", testCase.getDescription(), failure.message.c_str());
+            passed = false;
+        }
+        const auto duration = host_sim::Kernel::instance().now() - startTime;
+        std::printf("{{__testcase_finish;%s;%d;%d}} (%" PRId64 " ms virtual time)\n",
+                    testCase.getDescription(),
+                    passed ? 1 : 0,
+                    passed ? 0 : 1,
+                    static_cast<int64_t>(duration.count() / 1000));
+        if (!passed) {
+            nbrOfFailures++;
+        }
+    }
+    std::printf("{{__testcase_summary;%zu;%zu}}\n", cases.size() - nbrOfFailures, nbrOfFailures);
+    std::printf("{{end;%s}}\n", (nbrOfFailures == 0) ? "success" : "failure");
+    std::fflush(stdout);
+    return nbrOfFailures == 0;
+}
+
+status_t greentea_test_setup_handler(const size_t number_of_cases) {
+    std::printf("{{__testcase_count;%zu}}\n", number_of_cases);
+    return STATUS_CONTINUE;
+}
+
+}  // namespace v1
+}  // namespace utest
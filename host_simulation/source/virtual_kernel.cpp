@@ -0,0 +1,578 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file virtual_kernel.cpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Virtual time kernel implementation (host simulation)
+ *
+ * @date 2024-01-15
+ * @version 1.0.0
+ ***************************************************************************/
+
+#include "host_sim/virtual_kernel.hpp"
+
+#include "host_sim/chrome_trace.hpp"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+namespace host_sim {
+
+// same value as osPriorityNormal
+static constexpr int kMainThreadPriority = 24;
+
+struct SimThread {
+    enum class State { Inactive, Ready, Running, Blocked, Deleted };
+
+    int priority;
+    std::string name;
+    uint32_t stackSize;
+    State state = State::Inactive;
+    std::condition_variable cv;
+    std::chrono::microseconds wakeAt = Kernel::kForever;
+    WaitList* waitList = nullptr;
+    bool timedOut      = false;
+    bool killed        = false;
+    bool unwinding     = false;
+    WaitList joiners;
+    std::thread osThread;
+    // first frame of the host thread and deepest sampled frame
+    const char* stackBase  = nullptr;
+    uint32_t maxStackUsage = 0;
+    // track of the thread in the Chrome trace (0 if not traced)
+    uint32_t traceTrack = 0;
+};
+
+// the slices of the Chrome trace are written with the kernel lock held, so
+// that they are in the order of the virtual time
+static void traceRunning(const SimThread* thread, bool isRunning, std::chrono::microseconds time) {
+    ChromeTrace& trace = ChromeTrace::instance();
+    if (!trace.isEnabled() || thread->traceTrack == 0) {
+        return;
+    }
+    if (isRunning) {
+        trace.begin(ChromeTrace::Group::kThreads, thread->traceTrack, "running", time);
+    } else {
+        trace.end(ChromeTrace::Group::kThreads, thread->traceTrack, time);
+    }
+}
+
+static uint32_t traceInterrupt(const char* source, std::chrono::microseconds time) {
+    ChromeTrace& trace = ChromeTrace::instance();
+    if (!trace.isEnabled()) {
+        return 0;
+    }
+    const uint32_t track = trace.getTrack(ChromeTrace::Group::kInterrupts, source);
+    trace.begin(ChromeTrace::Group::kInterrupts, track, source, time);
+    return track;
+}
+
+static void traceInterruptEnd(uint32_t track, std::chrono::microseconds time) {
+    if (track != 0) {
+        ChromeTrace::instance().end(ChromeTrace::Group::kInterrupts, track, time);
+    }
+}
+
+constexpr std::chrono::microseconds Kernel::kForever;
+
+Kernel& Kernel::instance() {
+    // never destroyed on purpose: simulated threads may still be blocked when
+    // the process exits
+    static Kernel* kernel = new Kernel();
+    return *kernel;
+}
+
+Kernel::Kernel() {
+    // the thread creating the kernel becomes the simulated main thread
+    SimThread* mainThread = new SimThread();
+    mainThread->priority  = kMainThreadPriority;
+    mainThread->name      = "main";
+    mainThread->stackSize = 0;
+    mainThread->state     = SimThread::State::Running;
+    mainThread->traceTrack =
+        ChromeTrace::instance().addTrack(ChromeTrace::Group::kThreads, mainThread->name);
+    _threads.push_back(mainThread);
+    _running = mainThread;
+    traceRunning(mainThread, true, _now);
+}
+
+std::chrono::microseconds Kernel::now() {
+    return std::chrono::microseconds(_nowCount.load());
+}
+
+void Kernel::consume(std::chrono::microseconds duration) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (_isrNesting > 0) {
+        // interrupts cannot be preempted, time is simply charged
+        advanceTo(_now + duration);
+        return;
+    }
+    checkTerminated(_running);
+    SimThread* self = _running;
+    sampleStack(self);
+    while (duration > std::chrono::microseconds::zero()) {
+        const auto next = nextTimedEvent();
+        if (next > _now + duration) {
+            advanceTo(_now + duration);
+            break;
+        }
+        if (next > _now) {
+            duration -= next - _now;
+            advanceTo(next);
+        }
+        processTimedEvents(lock);
+        preemptIfNeeded(lock);
+        checkTerminated(self);
+    }
+}
+
+void Kernel::setTimerReadCost(std::chrono::microseconds cost) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _timerReadCost = cost;
+}
+
+std::chrono::microseconds Kernel::getTimerReadCost() const { return _timerReadCost; }
+
+SimThread* Kernel::createThread(int priority, const char* name, uint32_t stackSize) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    SimThread* thread = new SimThread();
+    thread->priority  = priority;
+    thread->name      = (name != nullptr) ? name : "unnamed";
+    thread->stackSize = stackSize;
+    thread->traceTrack = ChromeTrace::instance().addTrack(ChromeTrace::Group::kThreads, thread->name);
+    _threads.push_back(thread);
+    return thread;
+}
+
+void Kernel::startThread(SimThread* thread, std::function<void()> entry) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    thread->osThread = std::thread(&Kernel::threadMain, this, thread, std::move(entry));
+    thread->state    = SimThread::State::Ready;
+    insertReady(thread, false);
+    preemptIfNeeded(lock);
+}
+
+void Kernel::terminateThread(SimThread* thread) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (thread == _running) {
+        thread->killed    = true;
+        thread->unwinding = true;
+        throw ThreadTerminated();
+    }
+    if (thread->state == SimThread::State::Inactive) {
+        thread->state = SimThread::State::Deleted;
+        return;
+    }
+    if (thread->state == SimThread::State::Deleted) {
+        return;
+    }
+    thread->killed = true;
+    if (thread->state == SimThread::State::Blocked && thread->waitList != nullptr) {
+        thread->waitList->_waiters.remove(thread);
+    }
+    // let the terminated thread unwind right away, so that termination is
+    // synchronous as seen from the caller
+    _ready.remove(thread);
+    thread->state    = SimThread::State::Ready;
+    thread->wakeAt   = kForever;
+    thread->waitList = nullptr;
+    _ready.push_front(thread);
+
+    SimThread* self = _running;
+    self->state     = SimThread::State::Blocked;
+    self->wakeAt    = kForever;
+    self->waitList  = &thread->joiners;
+    insertWaiter(thread->joiners, self);
+    switchAway(lock, self);
+}
+
+void Kernel::joinThread(SimThread* thread) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (thread->state == SimThread::State::Inactive ||
+        thread->state == SimThread::State::Deleted) {
+        return;
+    }
+    SimThread* self = _running;
+    self->state     = SimThread::State::Blocked;
+    self->wakeAt    = kForever;
+    self->waitList  = &thread->joiners;
+    insertWaiter(thread->joiners, self);
+    switchAway(lock, self);
+}
+
+void Kernel::destroyThread(SimThread* thread) {
+    if (thread->osThread.joinable()) {
+        thread->osThread.join();
+    }
+    std::unique_lock<std::mutex> lock(_mutex);
+    _threads.erase(std::remove(_threads.begin(), _threads.end(), thread),
+                   _threads.end());
+    delete thread;
+}
+
+SimThread* Kernel::currentThread() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    return _running;
+}
+
+int Kernel::getPriority(const SimThread* thread) const { return thread->priority; }
+
+void Kernel::setPriority(SimThread* thread, int priority) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    thread->priority = priority;
+    if (thread->state == SimThread::State::Ready) {
+        _ready.remove(thread);
+        insertReady(thread, false);
+    }
+    preemptIfNeeded(lock);
+}
+
+const char* Kernel::getName(const SimThread* thread) const { return thread->name.c_str(); }
+
+bool Kernel::isFinished(const SimThread* thread) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    return thread->state == SimThread::State::Deleted;
+}
+
+bool Kernel::wait(WaitList* waitList, std::chrono::microseconds deadline) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    SimThread* self = _running;
+    checkTerminated(self);
+    sampleStack(self);
+    if (deadline <= _now) {
+        return false;
+    }
+    self->state    = SimThread::State::Blocked;
+    self->wakeAt   = deadline;
+    self->timedOut = false;
+    self->waitList = waitList;
+    if (waitList != nullptr) {
+        insertWaiter(*waitList, self);
+    }
+    switchAway(lock, self);
+    checkTerminated(self);
+    return !self->timedOut;
+}
+
+void Kernel::sleepUntil(std::chrono::microseconds deadline) { wait(nullptr, deadline); }
+
+void Kernel::yield() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    SimThread* self = _running;
+    checkTerminated(self);
+    sampleStack(self);
+    self->state = SimThread::State::Ready;
+    insertReady(self, false);
+    switchAway(lock, self);
+    checkTerminated(self);
+}
+
+SimThread* Kernel::wakeOne(WaitList& waitList) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (waitList._waiters.empty()) {
+        return nullptr;
+    }
+    SimThread* thread = waitList._waiters.front();
+    waitList._waiters.pop_front();
+    makeReady(thread);
+    return thread;
+}
+
+void Kernel::wakeAll(WaitList& waitList) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (!waitList._waiters.empty()) {
+        SimThread* thread = waitList._waiters.front();
+        waitList._waiters.pop_front();
+        makeReady(thread);
+    }
+}
+
+void Kernel::wakeThread(SimThread* thread) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (thread->state != SimThread::State::Blocked) {
+        return;
+    }
+    if (thread->waitList != nullptr) {
+        thread->waitList->_waiters.remove(thread);
+    }
+    makeReady(thread);
+}
+
+void Kernel::reschedule() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    preemptIfNeeded(lock);
+}
+
+void Kernel::runIsr(const std::function<void()>& isr, const char* source) {
+    uint32_t traceTrack = 0;
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _isrNesting++;
+        traceTrack = traceInterrupt(source, _now);
+    }
+    isr();
+    std::unique_lock<std::mutex> lock(_mutex);
+    traceInterruptEnd(traceTrack, _now);
+    _isrNesting--;
+    preemptIfNeeded(lock);
+}
+
+bool Kernel::isInIsr() const { return _isrNesting > 0; }
+
+uint32_t Kernel::addAlarm(std::chrono::microseconds at,
+                          std::function<void()> isr,
+                          const char* source) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    const uint32_t alarmId = _nextAlarmId++;
+    _alarms.push_back(Alarm{alarmId, at, std::move(isr), source});
+    return alarmId;
+}
+
+void Kernel::cancelAlarm(uint32_t alarmId) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _alarms.erase(std::remove_if(_alarms.begin(),
+                                 _alarms.end(),
+                                 [alarmId](const Alarm& alarm) { return alarm.id == alarmId; }),
+                  _alarms.end());
+}
+
+void Kernel::setWatchdog(std::chrono::microseconds deadline, const char* reason) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _watchdogDeadline = deadline;
+    _watchdogReason   = reason;
+}
+
+std::chrono::microseconds Kernel::getIdleTime() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    return _idleTime;
+}
+
+Kernel::StackStatistics Kernel::getStackStatistics() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    StackStatistics statistics = {0, 0, 0};
+    for (const SimThread* thread : _threads) {
+        if (thread->state == SimThread::State::Deleted) {
+            continue;
+        }
+        statistics.maxSize += thread->maxStackUsage;
+        statistics.reservedSize += thread->stackSize;
+        statistics.count++;
+    }
+    return statistics;
+}
+
+void Kernel::resetStackPeaks() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    for (SimThread* thread : _threads) {
+        thread->maxStackUsage = 0;
+    }
+}
+
+void Kernel::insertReady(SimThread* thread, bool atFront) {
+    // highest priority first, FIFO among equal priorities (a preempted thread
+    // goes back in front of its priority level)
+    auto it = _ready.begin();
+    while (it != _ready.end() &&
+           ((*it)->priority > thread->priority ||
+            (!atFront && (*it)->priority == thread->priority))) {
+        ++it;
+    }
+    _ready.insert(it, thread);
+}
+
+void Kernel::insertWaiter(WaitList& waitList, SimThread* thread) {
+    auto it = waitList._waiters.begin();
+    while (it != waitList._waiters.end() && (*it)->priority >= thread->priority) {
+        ++it;
+    }
+    waitList._waiters.insert(it, thread);
+}
+
+void Kernel::makeReady(SimThread* thread) {
+    thread->state    = SimThread::State::Ready;
+    thread->wakeAt   = kForever;
+    thread->waitList = nullptr;
+    insertReady(thread, false);
+}
+
+SimThread* Kernel::popReady() {
+    if (_ready.empty()) {
+        return nullptr;
+    }
+    SimThread* thread = _ready.front();
+    _ready.pop_front();
+    return thread;
+}
+
+void Kernel::preemptIfNeeded(std::unique_lock<std::mutex>& lock) {
+    if (_isrNesting > 0 || _ready.empty()) {
+        return;
+    }
+    SimThread* self = _running;
+    if (self->state != SimThread::State::Running ||
+        _ready.front()->priority <= self->priority) {
+        return;
+    }
+    self->state = SimThread::State::Ready;
+    insertReady(self, true);
+    switchAway(lock, self);
+}
+
+void Kernel::switchAway(std::unique_lock<std::mutex>& lock, SimThread* self) {
+    traceRunning(self, false, _now);
+    SimThread* next = popReady();
+    while (next == nullptr) {
+        // no ready thread: the CPU is idle until the next timed event
+        const auto nextEvent = nextTimedEvent();
+        if (nextEvent == kForever) {
+            deadlock();
+        }
+        if (nextEvent > _now) {
+            _idleTime += nextEvent - _now;
+            advanceTo(nextEvent);
+        }
+        processTimedEvents(lock);
+        next = popReady();
+    }
+    next->state = SimThread::State::Running;
+    _running    = next;
+    traceRunning(next, true, _now);
+    if (next == self) {
+        return;
+    }
+    next->cv.notify_one();
+    if (self->state == SimThread::State::Deleted) {
+        return;
+    }
+    self->cv.wait(lock, [this, self]() { return _running == self; });
+}
+
+void Kernel::advanceTo(std::chrono::microseconds time) {
+    _now = time;
+    _nowCount.store(_now.count());
+    if (_now >= _watchdogDeadline) {
+        std::printf("host_sim: watchdog expired at %" PRId64 " us (%s)\n",
+                    static_cast<int64_t>(_now.count()),
+                    _watchdogReason != nullptr ? _watchdogReason : "no reason");
+        std::fflush(stdout);
+        std::_Exit(EXIT_FAILURE);
+    }
+}
+
+std::chrono::microseconds Kernel::nextTimedEvent() const {
+    auto next = kForever;
+    for (const SimThread* thread : _threads) {
+        if (thread->state == SimThread::State::Blocked) {
+            next = std::min(next, thread->wakeAt);
+        }
+    }
+    for (const Alarm& alarm : _alarms) {
+        next = std::min(next, alarm.at);
+    }
+    return next;
+}
+
+void Kernel::processTimedEvents(std::unique_lock<std::mutex>& lock) {
+    for (SimThread* thread : _threads) {
+        if (thread->state == SimThread::State::Blocked && thread->wakeAt <= _now) {
+            if (thread->waitList != nullptr) {
+                thread->waitList->_waiters.remove(thread);
+            }
+            thread->timedOut = true;
+            makeReady(thread);
+        }
+    }
+    while (true) {
+        auto due = std::min_element(
+            _alarms.begin(), _alarms.end(), [](const Alarm& lhs, const Alarm& rhs) {
+                return lhs.at < rhs.at || (lhs.at == rhs.at && lhs.id < rhs.id);
+            });
+        if (due == _alarms.end() || due->at > _now) {
+            break;
+        }
+        std::function<void()> isr = std::move(due->isr);
+        const char* source        = due->source;
+        _alarms.erase(due);
+        _isrNesting++;
+        const uint32_t traceTrack = traceInterrupt(source, _now);
+        lock.unlock();
+        isr();
+        lock.lock();
+        traceInterruptEnd(traceTrack, _now);
+        _isrNesting--;
+    }
+}
+
+void Kernel::checkTerminated(SimThread* self) {
+    if (self->killed && !self->unwinding) {
+        self->unwinding = true;
+        throw ThreadTerminated();
+    }
+}
+
+void Kernel::sampleStack(SimThread* thread) {
+    // the main thread has no known base
+    if (thread->stackBase == nullptr) {
+        return;
+    }
+    const char marker = 0;
+    const uintptr_t usage =
+        reinterpret_cast<uintptr_t>(thread->stackBase) - reinterpret_cast<uintptr_t>(&marker);
+    thread->maxStackUsage = std::max(thread->maxStackUsage, static_cast<uint32_t>(usage));
+}
+
+void Kernel::threadMain(SimThread* thread, std::function<void()> entry) {
+    char stackBase = 0;
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        thread->stackBase = &stackBase;
+        thread->cv.wait(lock, [this, thread]() { return _running == thread; });
+    }
+    try {
+        if (!thread->killed) {
+            entry();
+        }
+    } catch (const ThreadTerminated&) {
+        // thread terminated, stack is now unwound
+    }
+    std::unique_lock<std::mutex> lock(_mutex);
+    thread->state = SimThread::State::Deleted;
+    while (!thread->joiners._waiters.empty()) {
+        SimThread* joiner = thread->joiners._waiters.front();
+        thread->joiners._waiters.pop_front();
+        makeReady(joiner);
+    }
+    switchAway(lock, thread);
+}
+
+void Kernel::deadlock() {
+    std::printf("host_sim: deadlock at %" PRId64 " us, no thread can run anymore\n",
+                static_cast<int64_t>(_now.count()));
+    for (const SimThread* thread : _threads) {
+        std::printf("  thread \"%s\" priority %d state %d\n",
+                    thread->name.c_str(),
+                    thread->priority,
+                    static_cast<int>(thread->state));
+    }
+    std::fflush(stdout);
+    std::_Exit(EXIT_FAILURE);
+}
+
+}  // namespace host_sim
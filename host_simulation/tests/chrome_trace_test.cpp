@@ -0,0 +1,125 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file chrome_trace_test.cpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Host test of the Chrome trace export of the simulation
+ *
+ * A thread dispatches an event queue fed by a Ticker and by the joystick
+ * interrupt, and the test checks that the trace file has a track for each
+ * of them, with balanced slices.
+ *
+ * @date 2024-05-06
+ * @version 1.0.0
+ ***************************************************************************/
+
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include "common/task_tracer.hpp"
+#include "greentea-client/test_env.h"
+#include "host_sim/chrome_trace.hpp"
+#include "joystick.hpp"
+#include "mbed.h"
+#include "unity/unity.h"
+#include "utest/utest.h"
+
+using namespace utest::v1;
+
+static constexpr const char* kTraceFileName = "chrome_trace_test.json";
+
+static uint32_t countOccurrences(const std::string& text, const std::string& pattern) {
+    uint32_t count = 0;
+    for (size_t position = text.find(pattern); position != std::string::npos;
+         position      = text.find(pattern, position + pattern.size())) {
+        count++;
+    }
+    return count;
+}
+
+static void test_tracks_and_slices() {
+    host_sim::ChromeTrace& trace = host_sim::ChromeTrace::instance();
+    TEST_ASSERT_TRUE(trace.open(kTraceFileName));
+    TEST_ASSERT_TRUE(trace.isEnabled());
+    bike_computer::TaskTracer::getInstance().enable(true);
+
+    EventQueue eventQueue;
+    Thread thread(osPriorityNormal, OS_STACK_SIZE, nullptr, "worker");
+    thread.start(callback(&eventQueue, &EventQueue::dispatch_forever));
+
+    uint32_t nbrOfTicks = 0;
+    Ticker ticker;
+    ticker.attach(
+        [&eventQueue, &nbrOfTicks]() {
+            nbrOfTicks++;
+            eventQueue.call([]() { wait_us(100); });
+        },
+        10ms);
+    disco::Joystick::getInstance().setUpCallback([&eventQueue]() {
+        eventQueue.call([]() {
+            bike_computer::TaskTracer::getInstance().record(
+                advembsof::TaskLogger::kGearTaskIndex, 0, 200);
+        });
+    });
+    ThisThread::sleep_for(35ms);
+    disco::Joystick::getInstance().press(disco::Joystick::State::UpPressed);
+    disco::Joystick::getInstance().release();
+    ThisThread::sleep_for(10ms);
+
+    ticker.detach();
+    disco::Joystick::getInstance().setUpCallback(nullptr);
+    thread.terminate();
+    bike_computer::TaskTracer::getInstance().enable(false);
+    trace.close();
+    TEST_ASSERT_FALSE(trace.isEnabled());
+
+    std::ifstream file(kTraceFileName);
+    const std::string content((std::istreambuf_iterator<char>(file)),
+                              std::istreambuf_iterator<char>());
+    TEST_ASSERT_TRUE(!content.empty() && content.front() == '[');
+    TEST_ASSERT_TRUE(content.find("\n]\n") == content.size() - 3);
+
+    // one track per thread, interrupt source, event queue and task
+    TEST_ASSERT_EQUAL_UINT32(1, countOccurrences(content, "\"args\":{\"name\":\"worker\"}"));
+    TEST_ASSERT_EQUAL_UINT32(
+        1, countOccurrences(content, "\"args\":{\"name\":\"EventQueue (worker)\"}"));
+    TEST_ASSERT_EQUAL_UINT32(1, countOccurrences(content, "\"args\":{\"name\":\"Ticker\"}"));
+    TEST_ASSERT_EQUAL_UINT32(1, countOccurrences(content, "\"args\":{\"name\":\"Joystick\"}"));
+    TEST_ASSERT_EQUAL_UINT32(1, countOccurrences(content, "\"args\":{\"name\":\"Gear\"}"));
+
+    // a slice per interrupt and per dispatched event
+    TEST_ASSERT_EQUAL_UINT32(nbrOfTicks, countOccurrences(content, "\"name\":\"Ticker\",\"pid\""));
+    TEST_ASSERT_EQUAL_UINT32(1, countOccurrences(content, "\"name\":\"Joystick\",\"pid\""));
+    TEST_ASSERT_EQUAL_UINT32(nbrOfTicks + 1, countOccurrences(content, "\"name\":\"event\""));
+    TEST_ASSERT_EQUAL_UINT32(1, countOccurrences(content, "\"ph\":\"X\",\"name\":\"Gear\""));
+    TEST_ASSERT_EQUAL_UINT32(countOccurrences(content, "\"ph\":\"B\",\"name\":\"event\""),
+                             countOccurrences(content, "\"ph\":\"E\",\"pid\":3"));
+    TEST_ASSERT_EQUAL_UINT32(countOccurrences(content, "\"ph\":\"B\",\"name\":\"Ticker\"") +
+                                 countOccurrences(content, "\"ph\":\"B\",\"name\":\"Joystick\""),
+                             countOccurrences(content, "\"ph\":\"E\",\"pid\":2"));
+}
+
+static utest::v1::status_t greentea_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(60, "default_auto");
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+static Case cases[] = {Case("test tracks and slices", test_tracks_and_slices)};
+
+static Specification specification(greentea_setup, cases);
+
+int main() { return !Harness::run(specification); }
@@ -0,0 +1,210 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file task_tracer_test.cpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Host test of the binary task tracer
+ *
+ * Several host threads (truly concurrent, outside of the virtual kernel)
+ * record task invocations while a consumer thread drains frames, and the
+ * test checks that every record is either received intact and in order or
+ * counted as dropped.
+ *
+ * @date 2024-02-12
+ * @version 1.0.0
+ ***************************************************************************/
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "common/task_tracer.hpp"
+#include "greentea-client/test_env.h"
+#include "mbed.h"
+#include "unity/unity.h"
+#include "utest/utest.h"
+
+using namespace utest::v1;
+
+using bike_computer::TaskTracer;
+using bike_computer::frame::getU16;
+using bike_computer::frame::getU32;
+
+static constexpr uint32_t kNbrOfProducers         = 4;
+static constexpr uint32_t kNbrOfRecordsPerProducer = 200000;
+static constexpr uint32_t kEndTickPattern          = 0x5A5A5A5A;
+
+static void test_frame_format() {
+    TaskTracer& tracer = TaskTracer::getInstance();
+    tracer.enable(true);
+
+    TEST_ASSERT_TRUE(tracer.record(advembsof::TaskLogger::kSpeedTaskIndex, 1000, 1250));
+    TEST_ASSERT_TRUE(tracer.record(advembsof::TaskLogger::kSpeedTaskIndex, 1400, 1700));
+    // invalid task index
+    TEST_ASSERT_FALSE(tracer.record(TaskTracer::kNbrOfTasks, 0, 0));
+    TEST_ASSERT_EQUAL_UINT32(2, tracer.getNbrOfPendingRecords());
+
+    // the last period and computation time are available as with TaskLogger
+    TEST_ASSERT_EQUAL(400, tracer.getPeriod(advembsof::TaskLogger::kSpeedTaskIndex).count());
+    TEST_ASSERT_EQUAL(
+        300, tracer.getComputationTime(advembsof::TaskLogger::kSpeedTaskIndex).count());
+
+    // too small for a single record
+    uint8_t frame[TaskTracer::kFrameHeaderSize + 4 * TaskTracer::kRecordSize];
+    TEST_ASSERT_EQUAL(0, tracer.drain(frame, TaskTracer::kFrameHeaderSize));
+
+    const size_t frameSize = tracer.drain(frame, sizeof(frame));
+    TEST_ASSERT_EQUAL(TaskTracer::kFrameHeaderSize + 2 * TaskTracer::kRecordSize, frameSize);
+    TEST_ASSERT_EQUAL_MEMORY(TaskTracer::kFrameMagic, frame, sizeof(TaskTracer::kFrameMagic));
+    TEST_ASSERT_EQUAL_UINT16(2, getU16(frame + 4));
+    TEST_ASSERT_EQUAL_UINT16(0, getU16(frame + 6));
+    const uint8_t* record = frame + TaskTracer::kFrameHeaderSize + TaskTracer::kRecordSize;
+    TEST_ASSERT_EQUAL_UINT8(advembsof::TaskLogger::kSpeedTaskIndex, record[0]);
+    TEST_ASSERT_EQUAL_UINT32(1400, getU32(record + 4));
+    TEST_ASSERT_EQUAL_UINT32(1700, getU32(record + 8));
+
+    // nothing left
+    TEST_ASSERT_EQUAL(0, tracer.drain(frame, sizeof(frame)));
+    TEST_ASSERT_EQUAL_UINT32(0, tracer.getNbrOfPendingRecords());
+}
+
+static void test_full_buffer_drops_records() {
+    TaskTracer& tracer = TaskTracer::getInstance();
+    tracer.enable(true);
+
+    for (uint32_t index = 0; index < TaskTracer::kCapacity; index++) {
+        TEST_ASSERT_TRUE(tracer.record(advembsof::TaskLogger::kGearTaskIndex, index, index));
+    }
+    TEST_ASSERT_FALSE(tracer.record(advembsof::TaskLogger::kGearTaskIndex, 0, 0));
+    TEST_ASSERT_FALSE(tracer.record(advembsof::TaskLogger::kGearTaskIndex, 0, 0));
+    TEST_ASSERT_EQUAL_UINT32(2, tracer.getNbrOfDroppedRecords());
+
+    // the drops are reported in the next frame
+    uint8_t frame[TaskTracer::kFrameHeaderSize + TaskTracer::kRecordSize];
+    TEST_ASSERT_EQUAL(sizeof(frame), tracer.drain(frame, sizeof(frame)));
+    TEST_ASSERT_EQUAL_UINT16(2, getU16(frame + 6));
+    TEST_ASSERT_EQUAL(sizeof(frame), tracer.drain(frame, sizeof(frame)));
+    TEST_ASSERT_EQUAL_UINT16(0, getU16(frame + 6));
+
+    // a released slot can be used again
+    TEST_ASSERT_TRUE(tracer.record(advembsof::TaskLogger::kGearTaskIndex, 0, 0));
+
+    // re-enabling clears everything
+    tracer.enable(true);
+    TEST_ASSERT_EQUAL_UINT32(0, tracer.getNbrOfPendingRecords());
+    TEST_ASSERT_EQUAL_UINT32(0, tracer.getNbrOfDroppedRecords());
+
+    // nothing is recorded when disabled
+    tracer.enable(false);
+    TEST_ASSERT_FALSE(tracer.record(advembsof::TaskLogger::kGearTaskIndex, 0, 0));
+}
+
+static void test_concurrent_producers_and_consumer() {
+    TaskTracer& tracer = TaskTracer::getInstance();
+    tracer.enable(true);
+
+    std::atomic<bool> producersDone(false);
+    uint32_t nbrOfReceivedRecords[kNbrOfProducers] = {};
+    uint32_t nbrOfReportedDrops                    = 0;
+    uint32_t nbrOfCorruptedRecords                 = 0;
+
+    // each producer records a distinct task with increasing start ticks
+    std::thread consumer([&]() {
+        uint8_t frame[TaskTracer::kFrameHeaderSize + 64 * TaskTracer::kRecordSize];
+        int64_t lastStartTick[kNbrOfProducers];
+        for (int64_t& tick : lastStartTick) {
+            tick = -1;
+        }
+        while (true) {
+            // read the flag before draining, for not missing the last records
+            const bool done        = producersDone.load();
+            const size_t frameSize = tracer.drain(frame, sizeof(frame));
+            if (frameSize == 0) {
+                if (done) {
+                    break;
+                }
+                std::this_thread::yield();
+                continue;
+            }
+            const uint16_t nbrOfRecords = getU16(frame + 4);
+            nbrOfReportedDrops += getU16(frame + 6);
+            const uint8_t* record = frame + TaskTracer::kFrameHeaderSize;
+            for (uint16_t index = 0; index < nbrOfRecords; index++) {
+                const uint8_t producer   = record[0];
+                const uint32_t startTick = getU32(record + 4);
+                const uint32_t endTick   = getU32(record + 8);
+                if (producer >= kNbrOfProducers || endTick != (startTick ^ kEndTickPattern) ||
+                    static_cast<int64_t>(startTick) <= lastStartTick[producer]) {
+                    nbrOfCorruptedRecords++;
+                } else {
+                    lastStartTick[producer] = startTick;
+                    nbrOfReceivedRecords[producer]++;
+                }
+                record += TaskTracer::kRecordSize;
+            }
+        }
+    });
+
+    std::vector<std::thread> producers;
+    for (uint32_t producer = 0; producer < kNbrOfProducers; producer++) {
+        producers.emplace_back([&tracer, producer]() {
+            for (uint32_t tick = 0; tick < kNbrOfRecordsPerProducer; tick++) {
+                tracer.record(static_cast<uint8_t>(producer), tick, tick ^ kEndTickPattern);
+                // leave the consumer a chance to keep up, for also testing
+                // concurrent draining and not only drops
+                if ((tick % 64) == 0) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (std::thread& producer : producers) {
+        producer.join();
+    }
+    producersDone = true;
+    consumer.join();
+
+    uint32_t nbrOfRecords = 0;
+    for (uint32_t count : nbrOfReceivedRecords) {
+        nbrOfRecords += count;
+    }
+    printf("%" PRIu32 " records received, %" PRIu32 " dropped, %" PRIu32 " corrupted\n",
+           nbrOfRecords,
+           tracer.getNbrOfDroppedRecords(),
+           nbrOfCorruptedRecords);
+    TEST_ASSERT_EQUAL_UINT32(0, nbrOfCorruptedRecords);
+    TEST_ASSERT_EQUAL_UINT32(kNbrOfProducers * kNbrOfRecordsPerProducer,
+                             nbrOfRecords + tracer.getNbrOfDroppedRecords());
+    TEST_ASSERT_EQUAL_UINT32(tracer.getNbrOfDroppedRecords(), nbrOfReportedDrops);
+    TEST_ASSERT_EQUAL_UINT32(0, tracer.getNbrOfPendingRecords());
+    tracer.enable(false);
+}
+
+static utest::v1::status_t greentea_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(60, "default_auto");
+
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+// List of test cases in this file
+static Case cases[] = {
+    Case("test frame format", test_frame_format),
+    Case("test full buffer drops records", test_full_buffer_drops_records),
+    Case("test concurrent producers and consumer", test_concurrent_producers_and_consumer)};
+
+static Specification specification(greentea_setup, cases);
+
+int main() { return !Harness::run(specification); }
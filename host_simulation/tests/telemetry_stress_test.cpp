@@ -0,0 +1,135 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file telemetry_stress_test.cpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Host stress test of the telemetry snapshot sequence lock
+ *
+ * Several host threads (truly concurrent, outside of the virtual kernel)
+ * publish snapshots whose fields are all derived from a single value, while
+ * other threads read them and check that no torn snapshot is ever observed.
+ *
+ * @date 2024-02-05
+ * @version 1.0.0
+ ***************************************************************************/
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "common/seq_lock.hpp"
+#include "greentea-client/test_env.h"
+#include "mbed.h"
+#include "multi_tasking/telemetry_snapshot.hpp"
+#include "unity/unity.h"
+#include "utest/utest.h"
+
+using namespace utest::v1;
+
+static constexpr uint32_t kNbrOfWriters         = 4;
+static constexpr uint32_t kNbrOfReaders         = 4;
+static constexpr uint32_t kNbrOfWritesPerWriter = 200000;
+
+// all fields are derived from value (values are below 2^24 and thus exact
+// as float)
+static multi_tasking::TelemetrySnapshot makeSnapshot(uint32_t value) {
+    multi_tasking::TelemetrySnapshot snapshot = {};
+    snapshot.gear                             = static_cast<uint8_t>(value);
+    snapshot.gearSize                         = static_cast<uint8_t>(value >> 8);
+    snapshot.speed                            = static_cast<float>(value);
+    snapshot.distance                         = static_cast<float>(value * 2);
+    snapshot.temperature                      = static_cast<float>(value * 3);
+    snapshot.resetCount                       = value;
+    return snapshot;
+}
+
+static bool isConsistent(const multi_tasking::TelemetrySnapshot& snapshot) {
+    const uint32_t value = snapshot.resetCount;
+    return snapshot.gear == static_cast<uint8_t>(value) &&
+           snapshot.gearSize == static_cast<uint8_t>(value >> 8) &&
+           snapshot.speed == static_cast<float>(value) &&
+           snapshot.distance == static_cast<float>(value * 2) &&
+           snapshot.temperature == static_cast<float>(value * 3);
+}
+
+static void test_concurrent_writers_and_readers() {
+    bike_computer::SeqLock<multi_tasking::TelemetrySnapshot> telemetry;
+    telemetry.write(makeSnapshot(0));
+
+    std::atomic<bool> writersDone(false);
+    std::atomic<uint32_t> nbrOfTornSnapshots(0);
+    std::atomic<uint64_t> nbrOfReads(0);
+
+    std::vector<std::thread> readers;
+    for (uint32_t reader = 0; reader < kNbrOfReaders; reader++) {
+        readers.emplace_back([&]() {
+            uint64_t reads = 0;
+            while (!writersDone.load()) {
+                if (!isConsistent(telemetry.read())) {
+                    nbrOfTornSnapshots++;
+                }
+                reads++;
+            }
+            nbrOfReads += reads;
+        });
+    }
+
+    std::vector<std::thread> writers;
+    for (uint32_t writer = 0; writer < kNbrOfWriters; writer++) {
+        writers.emplace_back([&telemetry, writer]() {
+            for (uint32_t index = 0; index < kNbrOfWritesPerWriter; index++) {
+                const uint32_t value = (writer * kNbrOfWritesPerWriter + index) & 0xFFFFFF;
+                if ((index & 1U) == 0) {
+                    telemetry.write(makeSnapshot(value));
+                } else {
+                    // read-modify-write of all fields
+                    telemetry.update([value](multi_tasking::TelemetrySnapshot& snapshot) {
+                        snapshot = makeSnapshot(value);
+                    });
+                }
+            }
+        });
+    }
+
+    for (std::thread& writer : writers) {
+        writer.join();
+    }
+    writersDone = true;
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+
+    printf("%" PRIu64 " reads during %" PRIu32 " writes, %" PRIu32 " torn snapshots\n",
+           nbrOfReads.load(),
+           kNbrOfWriters * kNbrOfWritesPerWriter,
+           nbrOfTornSnapshots.load());
+    TEST_ASSERT_EQUAL_UINT32(0, nbrOfTornSnapshots.load());
+    TEST_ASSERT_TRUE(isConsistent(telemetry.read()));
+}
+
+static utest::v1::status_t greentea_setup(const size_t number_of_cases) {
+    GREENTEA_SETUP(60, "default_auto");
+
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+// List of test cases in this file
+static Case cases[] = {
+    Case("test concurrent writers and readers", test_concurrent_writers_and_readers)};
+
+static Specification specification(greentea_setup, cases);
+
+int main() { return !Harness::run(specification); }
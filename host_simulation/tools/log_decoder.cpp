@@ -0,0 +1,68 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file log_decoder.cpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Host decoder of the deferred log and trace point output
+ *
+ * Reads a capture of the serial output (file or stdin) and prints the text
+ * of each deferred log line and trace point, in the order of the capture,
+ * with its timestamp in usecs (see log_decoder.hpp for the formats).
+ *
+ * Usage: log_decoder [capture file]
+ *
+ * @date 2024-05-20
+ * @version 1.0.0
+ ***************************************************************************/
+
+#include "log_decoder.hpp"
+
+#include <cinttypes>
+#include <cstdio>
+#include <vector>
+
+int main(int argc, char* argv[]) {
+    FILE* file = stdin;
+    if (argc > 1) {
+        file = fopen(argv[1], "rb");
+        if (file == nullptr) {
+            fprintf(stderr, "Cannot open %s\n", argv[1]);
+            return 1;
+        }
+    }
+    std::vector<uint8_t> capture;
+    uint8_t chunk[4096];
+    size_t size = 0;
+    while ((size = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        capture.insert(capture.end(), chunk, chunk + size);
+    }
+    if (file != stdin) {
+        fclose(file);
+    }
+
+    log_decoder::CaptureDecoder decoder([](uint32_t timestamp, const std::string& line) {
+        printf("[%10" PRIu32 "]%s\n", timestamp, line.c_str());
+    });
+    decoder.decode(capture.data(), capture.size());
+
+    printf("%" PRIu64 " log lines, %" PRIu64 " trace points, %" PRIu64
+           " dropped records, %" PRIu64 " unknown records\n",
+           decoder.getNbrOfLogRecords(),
+           decoder.getNbrOfTracePointRecords(),
+           decoder.getNbrOfDroppedRecords(),
+           decoder.getNbrOfUnknownRecords());
+    return 0;
+}
@@ -0,0 +1,407 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file log_decoder.hpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Host decoder of the deferred log and trace point frames
+ *
+ * The text of each record is reconstructed from the format strings of
+ * common/log_formats.hpp, which are only compiled on the host. Each
+ * conversion of the format takes the next argument of the record: the
+ * deferred log arguments carry their type, the trace point arguments are
+ * 32 bit words (two words for 64 bit conversions, a float for %f).
+ * Conversions are printed with the width of the argument, so that a
+ * format decodes the same way whatever the size of long on the host.
+ *
+ * Frame formats (little endian), see deferred_log.hpp and trace_point.hpp:
+ *   "DLOG", number of records (u16), number of dropped records (u16)
+ *   then for each record: id (u16), level (u8), payload size (u8),
+ *   timestamp (u32, usecs), payload (type (u8) and value of each argument)
+ *
+ *   "TPNT", number of records (u16), number of dropped records (u16)
+ *   then for each record: id (u16), reserved (u16), timestamp (u32, usecs),
+ *   3 arguments (u32)
+ *
+ * The task tracer frames ("TTRC") are skipped, like any byte outside of a
+ * frame.
+ *
+ * @date 2024-05-20
+ * @version 1.0.0
+ ***************************************************************************/
+
+#pragma once
+
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <string>
+
+#include "common/log_formats.hpp"
+
+namespace log_decoder {
+
+static constexpr uint8_t kDeferredLogMagic[4] = {'D', 'L', 'O', 'G'};
+static constexpr uint8_t kTracePointMagic[4]  = {'T', 'P', 'N', 'T'};
+static constexpr uint8_t kTaskTracerMagic[4]  = {'T', 'T', 'R', 'C'};
+static constexpr size_t kFrameHeaderSize          = 8;
+static constexpr size_t kLogRecordHeaderSize      = 8;
+static constexpr size_t kTracePointRecordSize     = 20;
+static constexpr size_t kTaskTracerRecordSize     = 12;
+static constexpr uint8_t kTruncatedFlag           = 0x80;
+static constexpr uint8_t kNbrOfTracePointArguments = 3;
+
+// argument types of the deferred log payload
+enum ArgumentType : uint8_t { kUint32 = 1, kInt32, kUint64, kInt64, kFloat, kString };
+
+struct LogFormat {
+    const char* group;
+    const char* format;
+};
+
+// ids start at 1 (0 is kTracePointNone / kLogNone)
+#define LOG_DECODER_TRACE_POINT_FORMAT(id, format) format,
+static const char* const kTracePointFormats[] = {
+    nullptr, TRACE_POINT_FORMATS(LOG_DECODER_TRACE_POINT_FORMAT)};
+#undef LOG_DECODER_TRACE_POINT_FORMAT
+
+#define LOG_DECODER_LOG_FORMAT(id, group, format) {group, format},
+static const LogFormat kLogFormats[] = {{nullptr, nullptr},
+                                        DEFERRED_LOG_FORMATS(LOG_DECODER_LOG_FORMAT)};
+#undef LOG_DECODER_LOG_FORMAT
+
+static const char* const kLevelNames[] = {"CMD ", "ERR ", "WARN", "INFO", "DBG "};
+
+static inline uint16_t getU16(const uint8_t* buffer) {
+    return static_cast<uint16_t>(buffer[0] | (buffer[1] << 8));
+}
+
+static inline uint32_t getU32(const uint8_t* buffer) {
+    return getU16(buffer) | (static_cast<uint32_t>(getU16(buffer + 2)) << 16);
+}
+
+static inline uint64_t getU64(const uint8_t* buffer) {
+    return getU32(buffer) | (static_cast<uint64_t>(getU32(buffer + 4)) << 32);
+}
+
+static inline float toFloat(uint32_t bits) {
+    float value = 0.0f;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+struct Argument {
+    // raw words of the trace points have both a signed and unsigned value
+    enum Kind { kMissing, kSigned, kUnsigned, kRaw, kFloating, kText } kind = kMissing;
+    int64_t signedValue     = 0;
+    uint64_t unsignedValue  = 0;
+    double floatingValue    = 0.0;
+    std::string text;
+};
+
+// arguments of a deferred log record, each with its type
+class LogArgumentReader {
+   public:
+    LogArgumentReader(const uint8_t* payload, size_t size) : _payload(payload), _size(size) {}
+
+    Argument next(bool, bool) {
+        Argument argument;
+        if (_offset >= _size) {
+            return argument;
+        }
+        const uint8_t type      = _payload[_offset];
+        const uint8_t* value    = _payload + _offset + 1;
+        const size_t valueSize  = _size - _offset - 1;
+        size_t size             = 0;
+        switch (type) {
+            case kUint32:
+            case kInt32:
+            case kFloat:
+                size = 4;
+                break;
+            case kUint64:
+            case kInt64:
+                size = 8;
+                break;
+            case kString:
+                size = (valueSize > 0) ? 1 + value[0] : 1;
+                break;
+            default:
+                // unknown type, the rest of the payload is lost
+                _offset = _size;
+                return argument;
+        }
+        if (size > valueSize) {
+            _offset = _size;
+            return argument;
+        }
+        if (type == kUint32 || type == kUint64) {
+            argument.kind          = Argument::kUnsigned;
+            argument.unsignedValue = (size == 4) ? getU32(value) : getU64(value);
+        } else if (type == kInt32) {
+            argument.kind        = Argument::kSigned;
+            argument.signedValue = static_cast<int32_t>(getU32(value));
+        } else if (type == kInt64) {
+            argument.kind        = Argument::kSigned;
+            argument.signedValue = static_cast<int64_t>(getU64(value));
+        } else if (type == kFloat) {
+            argument.kind          = Argument::kFloating;
+            argument.floatingValue = toFloat(getU32(value));
+        } else {
+            argument.kind = Argument::kText;
+            argument.text.assign(reinterpret_cast<const char*>(value + 1), size - 1);
+        }
+        _offset += 1 + size;
+        return argument;
+    }
+
+   private:
+    const uint8_t* _payload;
+    size_t _size;
+    size_t _offset = 0;
+};
+
+// arguments of a trace point record, read as the conversions require
+class TracePointArgumentReader {
+   public:
+    explicit TracePointArgumentReader(const uint32_t* words) : _words(words) {}
+
+    Argument next(bool isFloating, bool is64Bit) {
+        Argument argument;
+        const uint8_t nbrOfWords = is64Bit ? 2 : 1;
+        if (_index + nbrOfWords > kNbrOfTracePointArguments) {
+            return argument;
+        }
+        if (isFloating) {
+            argument.kind          = Argument::kFloating;
+            argument.floatingValue = toFloat(_words[_index]);
+        } else {
+            argument.kind          = Argument::kRaw;
+            argument.unsignedValue = _words[_index];
+            if (is64Bit) {
+                argument.unsignedValue |= static_cast<uint64_t>(_words[_index + 1]) << 32;
+            }
+            argument.signedValue = is64Bit ? static_cast<int64_t>(argument.unsignedValue)
+                                           : static_cast<int32_t>(_words[_index]);
+        }
+        _index += nbrOfWords;
+        return argument;
+    }
+
+   private:
+    const uint32_t* _words;
+    uint8_t _index = 0;
+};
+
+// printf-like formatting of the arguments given by the reader
+template <typename Reader>
+std::string format(const char* format, Reader& reader) {
+    std::string text;
+    char buffer[128];
+    for (const char* character = format; *character != '\0'; character++) {
+        if (*character != '%') {
+            text += *character;
+            continue;
+        }
+        if (character[1] == '%') {
+            text += '%';
+            character++;
+            continue;
+        }
+        // flags, width and precision are kept, the length is given by the
+        // argument
+        std::string specification = "%";
+        const char* cursor        = character + 1;
+        while (*cursor != '\0' && std::strchr("-+ #0123456789.", *cursor) != nullptr) {
+            specification += *cursor++;
+        }
+        std::string length;
+        while (*cursor != '\0' && std::strchr("hlLqjzt", *cursor) != nullptr) {
+            length += *cursor++;
+        }
+        const char conversion = *cursor;
+        if (conversion == '\0') {
+            text += character;
+            break;
+        }
+        character = cursor;
+
+        const bool isFloating = std::strchr("fFeEgGaA", conversion) != nullptr;
+        const bool is64Bit    = length == "ll" || length == "q" || length == "j" ||
+                             (length == "l" && sizeof(long) == 8) ||
+                             ((length == "z" || length == "t") && sizeof(size_t) == 8);
+        const Argument argument = reader.next(isFloating, is64Bit);
+        if (argument.kind == Argument::kMissing) {
+            text += "<?>";
+            continue;
+        }
+
+        if (isFloating) {
+            const double value = (argument.kind == Argument::kFloating)
+                                     ? argument.floatingValue
+                                 : (argument.kind == Argument::kSigned)
+                                     ? static_cast<double>(argument.signedValue)
+                                     : static_cast<double>(argument.unsignedValue);
+            std::snprintf(buffer, sizeof(buffer), (specification + conversion).c_str(), value);
+        } else if (conversion == 's') {
+            std::snprintf(buffer, sizeof(buffer), (specification + 's').c_str(), argument.text.c_str());
+        } else if (conversion == 'c') {
+            std::snprintf(buffer,
+                          sizeof(buffer),
+                          (specification + 'c').c_str(),
+                          (argument.kind == Argument::kSigned)
+                              ? static_cast<int>(argument.signedValue)
+                              : static_cast<int>(argument.unsignedValue));
+        } else if (conversion == 'd' || conversion == 'i') {
+            const long long value = (argument.kind == Argument::kSigned ||
+                                     argument.kind == Argument::kRaw)
+                                        ? static_cast<long long>(argument.signedValue)
+                                        : static_cast<long long>(argument.unsignedValue);
+            std::snprintf(buffer, sizeof(buffer), (specification + "ll" + conversion).c_str(), value);
+        } else {
+            // u, o, x, X and p (printed as an hexadecimal address)
+            const unsigned long long value =
+                (argument.kind == Argument::kSigned)
+                    ? static_cast<unsigned long long>(argument.signedValue)
+                    : static_cast<unsigned long long>(argument.unsignedValue);
+            if (conversion == 'p') {
+                std::snprintf(buffer, sizeof(buffer), "0x%llx", value);
+            } else {
+                std::snprintf(
+                    buffer, sizeof(buffer), (specification + "ll" + conversion).c_str(), value);
+            }
+        }
+        text += buffer;
+    }
+    return text;
+}
+
+// extracts the deferred log and trace point records of a capture
+class CaptureDecoder {
+   public:
+    // called with the timestamp and the text of each record, e.g.
+    // "[INFO][BikeSystem]: Starting with rate monotonic threads"
+    using OnLine = std::function<void(uint32_t timestamp, const std::string& line)>;
+
+    explicit CaptureDecoder(OnLine onLine) : _onLine(onLine) {}
+
+    void decode(const uint8_t* capture, size_t size) {
+        size_t offset = 0;
+        while (offset + kFrameHeaderSize <= size) {
+            const uint8_t* frame  = capture + offset;
+            const size_t nbrBytes = size - offset;
+            size_t frameSize      = 0;
+            if (std::memcmp(frame, kDeferredLogMagic, 4) == 0) {
+                frameSize = decodeLogFrame(frame, nbrBytes);
+            } else if (std::memcmp(frame, kTracePointMagic, 4) == 0) {
+                frameSize = decodeTracePointFrame(frame, nbrBytes);
+            } else if (std::memcmp(frame, kTaskTracerMagic, 4) == 0) {
+                frameSize = kFrameHeaderSize + getU16(frame + 4) * kTaskTracerRecordSize;
+                frameSize = (frameSize <= nbrBytes) ? frameSize : 0;
+            }
+            if (frameSize == 0) {
+                offset++;
+                continue;
+            }
+            offset += frameSize;
+        }
+    }
+
+    uint64_t getNbrOfLogRecords() const { return _nbrOfLogRecords; }
+    uint64_t getNbrOfTracePointRecords() const { return _nbrOfTracePointRecords; }
+    uint64_t getNbrOfDroppedRecords() const { return _nbrOfDroppedRecords; }
+    uint64_t getNbrOfUnknownRecords() const { return _nbrOfUnknownRecords; }
+
+   private:
+    // returns the frame size, 0 if the frame is not complete
+    size_t decodeLogFrame(const uint8_t* frame, size_t size) {
+        const uint16_t nbrOfRecords = getU16(frame + 4);
+        size_t frameSize            = kFrameHeaderSize;
+        // check the whole frame before decoding it
+        for (uint16_t index = 0; index < nbrOfRecords; index++) {
+            if (frameSize + kLogRecordHeaderSize > size) {
+                return 0;
+            }
+            frameSize += kLogRecordHeaderSize + frame[frameSize + 3];
+        }
+        if (frameSize > size) {
+            return 0;
+        }
+        _nbrOfDroppedRecords += getU16(frame + 6);
+
+        const uint8_t* record = frame + kFrameHeaderSize;
+        for (uint16_t index = 0; index < nbrOfRecords; index++) {
+            const uint16_t id         = getU16(record);
+            const uint8_t level       = record[2] & ~kTruncatedFlag;
+            const uint8_t payloadSize = record[3];
+            const uint32_t timestamp  = getU32(record + 4);
+            if (id == 0 || id >= sizeof(kLogFormats) / sizeof(kLogFormats[0])) {
+                _nbrOfUnknownRecords++;
+            } else {
+                _nbrOfLogRecords++;
+                LogArgumentReader reader(record + kLogRecordHeaderSize, payloadSize);
+                std::string line = std::string("[") +
+                                   (level < sizeof(kLevelNames) / sizeof(kLevelNames[0])
+                                        ? kLevelNames[level]
+                                        : "????") +
+                                   "][" + kLogFormats[id].group +
+                                   "]: " + log_decoder::format(kLogFormats[id].format, reader);
+                if ((record[2] & kTruncatedFlag) != 0) {
+                    line += " <truncated>";
+                }
+                _onLine(timestamp, line);
+            }
+            record += kLogRecordHeaderSize + payloadSize;
+        }
+        return frameSize;
+    }
+
+    size_t decodeTracePointFrame(const uint8_t* frame, size_t size) {
+        const uint16_t nbrOfRecords = getU16(frame + 4);
+        const size_t frameSize      = kFrameHeaderSize + nbrOfRecords * kTracePointRecordSize;
+        if (frameSize > size) {
+            return 0;
+        }
+        _nbrOfDroppedRecords += getU16(frame + 6);
+
+        const uint8_t* record = frame + kFrameHeaderSize;
+        for (uint16_t index = 0; index < nbrOfRecords; index++, record += kTracePointRecordSize) {
+            const uint16_t id = getU16(record);
+            if (id == 0 || id >= sizeof(kTracePointFormats) / sizeof(kTracePointFormats[0])) {
+                _nbrOfUnknownRecords++;
+                continue;
+            }
+            _nbrOfTracePointRecords++;
+            uint32_t words[kNbrOfTracePointArguments];
+            for (uint8_t word = 0; word < kNbrOfTracePointArguments; word++) {
+                words[word] = getU32(record + 8 + 4 * word);
+            }
+            TracePointArgumentReader reader(words);
+            _onLine(getU32(record + 4),
+                    "[TP  ]: " + log_decoder::format(kTracePointFormats[id], reader));
+        }
+        return frameSize;
+    }
+
+    OnLine _onLine;
+    uint64_t _nbrOfLogRecords        = 0;
+    uint64_t _nbrOfTracePointRecords = 0;
+    uint64_t _nbrOfDroppedRecords    = 0;
+    uint64_t _nbrOfUnknownRecords    = 0;
+};
+
+}  // namespace log_decoder
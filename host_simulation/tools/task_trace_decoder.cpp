@@ -0,0 +1,294 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file task_trace_decoder.cpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Host decoder of the binary task tracer output
+ *
+ * Reads a capture of the serial output (file or stdin), extracts the task
+ * tracer frames and prints, for each task, the number of invocations and
+ * the min/avg/max period and computation time. Bytes outside of frames
+ * (e.g. text traces) are skipped.
+ *
+ * Frame format (little endian):
+ *   "TTRC", number of records (u16), number of dropped records (u16)
+ *   then for each record: task id (u8), context id (u8), reserved (u16),
+ *   start tick (u32, usecs), end tick (u32, usecs)
+ *
+ * With --chrome, the records are also converted to a Chrome Trace Event
+ * file (JSON array format) that can be opened with ui.perfetto.dev or
+ * chrome://tracing, with the same task tracks as the Chrome trace of the
+ * host simulation and one track per context (thread or ISR) that ran them.
+ * The 32 bits ticks are unwrapped, assuming less than 35 minutes between
+ * two consecutive records.
+ *
+ * Usage: task_trace_decoder [--chrome trace file] [capture file]
+ *
+ * @date 2024-02-12
+ * @version 1.0.0
+ ***************************************************************************/
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+static constexpr uint8_t kFrameMagic[4]  = {'T', 'T', 'R', 'C'};
+static constexpr uint8_t kIsrContextId     = 0xFF;
+static constexpr uint8_t kUnknownContextId = 0xFE;
+static constexpr size_t kFrameHeaderSize = 8;
+static constexpr size_t kRecordSize      = 12;
+static constexpr uint8_t kNbrOfTasks     = 6;
+static const char* const kTaskDescriptors[kNbrOfTasks] = {
+    "Gear", "Speed", "Temperature", "Reset", "Display(1)", "Display(2)"};
+
+struct Statistics {
+    uint64_t count = 0;
+    uint32_t min   = UINT32_MAX;
+    uint32_t max   = 0;
+    uint64_t sum   = 0;
+
+    void add(uint32_t value) {
+        count++;
+        min = std::min(min, value);
+        max = std::max(max, value);
+        sum += value;
+    }
+
+    void print(const char* name) const {
+        if (count == 0) {
+            printf("  %-12s -\n", name);
+            return;
+        }
+        printf("  %-12s min %8" PRIu32 " avg %8" PRIu64 " max %8" PRIu32 " usecs\n",
+               name,
+               min,
+               sum / count,
+               max);
+    }
+};
+
+struct TaskStatistics {
+    uint64_t nbrOfInvocations = 0;
+    bool hasStarted           = false;
+    uint32_t lastStartTick    = 0;
+    Statistics period;
+    Statistics computationTime;
+};
+
+static uint16_t getU16(const uint8_t* buffer) {
+    return static_cast<uint16_t>(buffer[0] | (buffer[1] << 8));
+}
+
+static uint32_t getU32(const uint8_t* buffer) {
+    return getU16(buffer) | (static_cast<uint32_t>(getU16(buffer + 2)) << 16);
+}
+
+// Chrome Trace Event output, with the process and track ids of the host
+// simulation export (see host_sim/chrome_trace.hpp)
+class ChromeTraceWriter {
+   public:
+    static constexpr uint32_t kThreadsPid    = 1;
+    static constexpr uint32_t kInterruptsPid = 2;
+    static constexpr uint32_t kTasksPid      = 4;
+
+    explicit ChromeTraceWriter(FILE* file) : _file(file) {
+        fputs("[", _file);
+        writeName("process_name", kThreadsPid, 0, "Threads");
+        writeName("process_name", kInterruptsPid, 0, "Interrupts");
+        writeName("process_name", kTasksPid, 0, "Tasks");
+        for (uint8_t taskIndex = 0; taskIndex < kNbrOfTasks; taskIndex++) {
+            writeName("thread_name", kTasksPid, getTaskTrack(taskIndex), kTaskDescriptors[taskIndex]);
+        }
+    }
+
+    ~ChromeTraceWriter() { fputs("\n]\n", _file); }
+
+    void addRecord(uint8_t taskIndex, uint8_t contextId, uint32_t startTick, uint32_t endTick) {
+        // ticks are 32 bits usecs
+        if (_hasRecords && startTick < _lastStartTick && _lastStartTick - startTick > 0x80000000U) {
+            _epoch += 1ULL << 32;
+        }
+        _hasRecords          = true;
+        _lastStartTick       = startTick;
+        const uint64_t start = _epoch + startTick;
+        const uint32_t duration = endTick - startTick;
+
+        if (!_isContextNamed[contextId]) {
+            _isContextNamed[contextId] = true;
+            char name[32];
+            if (contextId == kIsrContextId) {
+                snprintf(name, sizeof(name), "ISR");
+            } else if (contextId == kUnknownContextId) {
+                snprintf(name, sizeof(name), "Unknown thread");
+            } else {
+                snprintf(name, sizeof(name), "Thread context %u", contextId);
+            }
+            writeName("thread_name", getContextPid(contextId), getContextTrack(contextId), name);
+        }
+        writeSlice(getContextPid(contextId),
+                   getContextTrack(contextId),
+                   kTaskDescriptors[taskIndex],
+                   start,
+                   duration);
+        writeSlice(kTasksPid, getTaskTrack(taskIndex), kTaskDescriptors[taskIndex], start, duration);
+    }
+
+   private:
+    static uint32_t getContextPid(uint8_t contextId) {
+        return contextId == kIsrContextId ? kInterruptsPid : kThreadsPid;
+    }
+    // track ids are unique over all processes
+    static uint32_t getContextTrack(uint8_t contextId) { return 1U + contextId; }
+    static uint32_t getTaskTrack(uint8_t taskIndex) { return 0x101U + taskIndex; }
+
+    void writeName(const char* kind, uint32_t pid, uint32_t tid, const char* name) {
+        fprintf(_file,
+                "%s\n{\"ph\":\"M\",\"name\":\"%s\",\"pid\":%" PRIu32 ",\"tid\":%" PRIu32
+                ",\"args\":{\"name\":\"%s\"}}",
+                _isFirstEvent ? "" : ",",
+                kind,
+                pid,
+                tid,
+                name);
+        _isFirstEvent = false;
+    }
+
+    void writeSlice(
+        uint32_t pid, uint32_t tid, const char* name, uint64_t start, uint32_t duration) {
+        fprintf(_file,
+                ",\n{\"ph\":\"X\",\"name\":\"%s\",\"pid\":%" PRIu32 ",\"tid\":%" PRIu32
+                ",\"ts\":%" PRIu64 ",\"dur\":%" PRIu32 "}",
+                name,
+                pid,
+                tid,
+                start,
+                duration);
+    }
+
+    FILE* _file;
+    bool _isFirstEvent          = true;
+    bool _hasRecords            = false;
+    uint32_t _lastStartTick     = 0;
+    uint64_t _epoch             = 0;
+    bool _isContextNamed[256]   = {};
+};
+
+int main(int argc, char* argv[]) {
+    const char* captureFileName = nullptr;
+    const char* chromeFileName  = nullptr;
+    for (int index = 1; index < argc; index++) {
+        if (std::strcmp(argv[index], "--chrome") == 0 && index + 1 < argc) {
+            chromeFileName = argv[++index];
+        } else {
+            captureFileName = argv[index];
+        }
+    }
+
+    FILE* file = stdin;
+    if (captureFileName != nullptr) {
+        file = fopen(captureFileName, "rb");
+        if (file == nullptr) {
+            fprintf(stderr, "Cannot open %s\n", captureFileName);
+            return 1;
+        }
+    }
+    FILE* chromeFile = nullptr;
+    if (chromeFileName != nullptr) {
+        chromeFile = fopen(chromeFileName, "w");
+        if (chromeFile == nullptr) {
+            fprintf(stderr, "Cannot open %s\n", chromeFileName);
+            return 1;
+        }
+    }
+    std::unique_ptr<ChromeTraceWriter> chromeTrace;
+    if (chromeFile != nullptr) {
+        chromeTrace.reset(new ChromeTraceWriter(chromeFile));
+    }
+
+    std::vector<uint8_t> capture;
+    uint8_t chunk[4096];
+    size_t size = 0;
+    while ((size = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        capture.insert(capture.end(), chunk, chunk + size);
+    }
+    if (file != stdin) {
+        fclose(file);
+    }
+
+    TaskStatistics tasks[kNbrOfTasks];
+    uint64_t nbrOfFrames         = 0;
+    uint64_t nbrOfDroppedRecords = 0;
+    uint64_t nbrOfInvalidRecords = 0;
+    size_t offset                = 0;
+    while (offset + kFrameHeaderSize <= capture.size()) {
+        if (std::memcmp(&capture[offset], kFrameMagic, sizeof(kFrameMagic)) != 0) {
+            offset++;
+            continue;
+        }
+        const uint16_t nbrOfRecords = getU16(&capture[offset + 4]);
+        const size_t frameSize      = kFrameHeaderSize + nbrOfRecords * kRecordSize;
+        if (offset + frameSize > capture.size()) {
+            // truncated capture
+            break;
+        }
+        nbrOfFrames++;
+        nbrOfDroppedRecords += getU16(&capture[offset + 6]);
+        const uint8_t* record = &capture[offset + kFrameHeaderSize];
+        for (uint16_t index = 0; index < nbrOfRecords; index++, record += kRecordSize) {
+            const uint8_t taskIndex = record[0];
+            if (taskIndex >= kNbrOfTasks) {
+                nbrOfInvalidRecords++;
+                continue;
+            }
+            const uint32_t startTick = getU32(record + 4);
+            const uint32_t endTick   = getU32(record + 8);
+            TaskStatistics& task     = tasks[taskIndex];
+            task.nbrOfInvocations++;
+            if (task.hasStarted) {
+                task.period.add(startTick - task.lastStartTick);
+            }
+            task.hasStarted    = true;
+            task.lastStartTick = startTick;
+            task.computationTime.add(endTick - startTick);
+            if (chromeTrace) {
+                chromeTrace->addRecord(taskIndex, record[1], startTick, endTick);
+            }
+        }
+        offset += frameSize;
+    }
+    if (chromeTrace) {
+        chromeTrace.reset();
+        fclose(chromeFile);
+    }
+
+    printf("%" PRIu64 " frames, %" PRIu64 " dropped records, %" PRIu64 " invalid records\n",
+           nbrOfFrames,
+           nbrOfDroppedRecords,
+           nbrOfInvalidRecords);
+    for (uint8_t taskIndex = 0; taskIndex < kNbrOfTasks; taskIndex++) {
+        const TaskStatistics& task = tasks[taskIndex];
+        printf("%s task: %" PRIu64 " invocations\n",
+               kTaskDescriptors[taskIndex],
+               task.nbrOfInvocations);
+        task.period.print("period");
+        task.computationTime.print("computation");
+    }
+    return 0;
+}
@@ -4,6 +4,7 @@
  */
 
 #include "mbed.h"
+#include "deferred_log.hpp"
 #include "mbed_trace.h"
 #include "multi_tasking/bike_system.hpp"
 #include "FlashIAPBlockDevice.h"
@@ -26,9 +27,9 @@ int main() {
     update_client::USBSerialUC usbSerialUpdateClient(flashIAPBlockDevice);
     update_client::UCErrorCode rc = usbSerialUpdateClient.start();
     if (rc != update_client::UCErrorCode::UC_ERR_NONE) {
-        tr_error("Cannot initialize update client: %d", rc);
+        DEFERRED_LOG_ERROR(bike_computer::kLogUpdateClientInitFailed, static_cast<int>(rc));
     } else {
-        tr_info("Update client started");
+        DEFERRED_LOG_INFO(bike_computer::kLogUpdateClientStarted);
     }
   multi_tasking::BikeSystem bikeSystem;
   bikeSystem.start();
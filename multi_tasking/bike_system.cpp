@@ -27,10 +27,8 @@
 #include <chrono>
 #include <cstdio>
 
-#include "mbed_trace.h"
-#if MBED_CONF_MBED_TRACE_ENABLE
-#define TRACE_GROUP "BikeSystem"
-#endif  // MBED_CONF_MBED_TRACE_ENABLE
+#include "deferred_log.hpp"
+#include "trace_point.hpp"
 
 namespace multi_tasking {
 
@@ -40,23 +38,93 @@ static constexpr std::chrono::milliseconds kDisplayTaskComputationTime     = 200
 static constexpr std::chrono::milliseconds kTemperatureTaskPeriod          = 1600ms;
 static constexpr std::chrono::milliseconds kTemperatureTaskDelay           = 1100ms;
 static constexpr std::chrono::milliseconds kTemperatureTaskComputationTime = 100ms;
-#include "task_logger.hpp" // Include the header file for the TaskLogger class
+#include "task_logger.hpp" // Include the header file for the task indexes
 
 static constexpr std::chrono::milliseconds kMajorCycleDuration = 1600ms;
 
+// event driven tasks of the rate monotonic mode, described by the minimal
+// inter-arrival time of their events and their computation time
+static constexpr std::chrono::milliseconds kResetMinInterArrivalTime    = 100ms;
+static constexpr std::chrono::milliseconds kResetComputationTime        = 1ms;
+static constexpr std::chrono::milliseconds kJoystickMinInterArrivalTime = 50ms;
+static constexpr std::chrono::milliseconds kJoystickComputationTime     = 1ms;
+
+enum RateMonotonicTaskIndex : size_t {
+    kResetRateMonotonicTask = 0,
+    kJoystickRateMonotonicTask,
+    kTemperatureRateMonotonicTask,
+    kDisplayRateMonotonicTask
+};
+static constexpr bike_computer::RateMonotonicTask kRateMonotonicTasks[] = {
+    {kResetMinInterArrivalTime, kResetComputationTime},
+    {kJoystickMinInterArrivalTime, kJoystickComputationTime},
+    {kTemperatureTaskPeriod, kTemperatureTaskComputationTime},
+    {kDisplayTaskPeriod, kDisplayTaskComputationTime},
+};
+static_assert(bike_computer::isBelowHyperbolicBound(kRateMonotonicTasks),
+              "The rate monotonic tasks are not guaranteed to meet their deadlines");
+
+// all threads of the rate monotonic mode preempt the main thread, which is
+// left with the background work
+static constexpr int kLowestRateMonotonicPriority = osPriorityAboveNormal;
+static_assert(bike_computer::getHighestRateMonotonicPriority(kRateMonotonicTasks,
+                                                             kLowestRateMonotonicPriority) <
+                  osPriorityHigh,
+              "Too many rate monotonic tasks");
+
+static constexpr osPriority getRateMonotonicPriority(size_t taskIndex) {
+    return static_cast<osPriority>(bike_computer::getRateMonotonicPriority(
+        kRateMonotonicTasks, taskIndex, kLowestRateMonotonicPriority));
+}
+
+// a single BikeSystem runs at a time, no thread stack is allocated on the
+// heap once the system is started
+static constexpr uint32_t kRateMonotonicStackSize = 2048;
+MBED_ALIGN(8) static unsigned char eventThreadStack[OS_STACK_SIZE];
+MBED_ALIGN(8) static unsigned char resetThreadStack[kRateMonotonicStackSize];
+MBED_ALIGN(8) static unsigned char joystickThreadStack[kRateMonotonicStackSize];
+MBED_ALIGN(8) static unsigned char temperatureThreadStack[kRateMonotonicStackSize];
+MBED_ALIGN(8) static unsigned char displayThreadStack[kRateMonotonicStackSize];
+MBED_ALIGN(8) static unsigned char logDrainStack[bike_computer::LogDrain::kStackSize];
+
 BikeSystem::BikeSystem()
-    : _eventThread(osPriorityNormal, OS_STACK_SIZE, nullptr, "isrThread"),
+    : _eventQueue(sizeof(_eventQueueBuffer), _eventQueueBuffer),
+      _eventQueueForISRs(sizeof(_eventQueueForISRsBuffer), _eventQueueForISRsBuffer),
+      _eventThread(osPriorityNormal, OS_STACK_SIZE, eventThreadStack, "isrThread"),
+      _resetThread(getRateMonotonicPriority(kResetRateMonotonicTask),
+                   kRateMonotonicStackSize,
+                   resetThreadStack,
+                   "resetThread"),
+      _joystickThread(getRateMonotonicPriority(kJoystickRateMonotonicTask),
+                      kRateMonotonicStackSize,
+                      joystickThreadStack,
+                      "joystickThread"),
+      _temperatureThread(getRateMonotonicPriority(kTemperatureRateMonotonicTask),
+                         kRateMonotonicStackSize,
+                         temperatureThreadStack,
+                         "temperatureThread"),
+      _displayThread(getRateMonotonicPriority(kDisplayRateMonotonicTask),
+                     kRateMonotonicStackSize,
+                     displayThreadStack,
+                     "displayThread"),
       _speedometer(_timer),
       _gearDevice(_eventQueue, callback(this, &BikeSystem::onGearChanged)),
       _pedalDevice(_eventQueue, callback(this, &BikeSystem::onRotationSpeedChanged)),
-      _resetDevice(callback(this, &BikeSystem::onReset))
+      _resetDevice(callback(this, &BikeSystem::onReset)),
+      _incrementalDisplay(_displayDevice),
+      _logDrain(logDrainStack)
       //_memoryLogger() // Initialize _memoryLogger in the constructor initializer list
 {
     _speedometer.setGearSize(bike_computer::kMaxGearSize - 1);
+
+    TelemetrySnapshot telemetry = {};
+    telemetry.gear              = bike_computer::kMinGear;
+    telemetry.gearSize          = bike_computer::kMaxGearSize - bike_computer::kMinGear;
+    _telemetry.write(telemetry);
 }
       
 void BikeSystem::start() {
-    tr_info("Starting Super-Loop without event handling");
+    DEFERRED_LOG_INFO(bike_computer::kLogStartingSuperLoop);
 
     init();
 
@@ -78,45 +146,120 @@ void BikeSystem::start() {
 
 }
 
+void BikeSystem::startWithRateMonotonicThreads() {
+    DEFERRED_LOG_INFO(bike_computer::kLogStartingRateMonotonicThreads);
+
+    init();
+
+    // the event driven tasks dispatch the event queues posted by the ISRs
+    _resetThread.start(callback(&_eventQueueForISRs, &EventQueue::dispatch_forever));
+    _joystickThread.start(callback(&_eventQueue, &EventQueue::dispatch_forever));
+    _temperatureThread.start(callback(this, &BikeSystem::temperatureThreadTask));
+    _displayThread.start(callback(this, &BikeSystem::displayThreadTask));
+
+    _memoryLogger.getAndPrintStatistics();
+
+    // the main thread is left idle, the records are sent by the log drain
+    auto nextRelease = _releaseEpoch;
+    while (!core_util_atomic_load_bool(&_stopFlag)) {
+        nextRelease += kMajorCycleDuration;
+        ThisThread::sleep_until(nextRelease);
+    }
+}
 
 void BikeSystem::onReset() {
-    _resetTime = _timer.elapsed_time();
-    _eventQueueForISRs.call(callback(this, &BikeSystem::resetTask));
+    const std::chrono::microseconds resetTime = _timer.elapsed_time();
+    const uint32_t traceId = _latencyTracer.begin(bike_computer::LatencyTracer::kResetChain);
+    // constant time allocation, the pool is exhausted only when the queue is full
+    ResetEvent* resetEvent = _resetEventPool.allocate(ResetEvent{traceId, resetTime});
+    if (resetEvent == nullptr) {
+        core_util_atomic_incr_u32(&_nbrOfDroppedResetEvents, 1);
+    } else if (_eventQueueForISRs.call(callback(this, &BikeSystem::resetTask), resetEvent) ==
+               0) {
+        _resetEventPool.free(resetEvent);
+        core_util_atomic_incr_u32(&_nbrOfDroppedResetEvents, 1);
+    }
     core_util_atomic_store_bool(&_resetFlag, true);
 }
 
 
 void BikeSystem::stop() { 
     _eventThread.terminate();
+    _resetThread.terminate();
+    _joystickThread.terminate();
+    _temperatureThread.terminate();
+    _displayThread.terminate();
     core_util_atomic_store_bool(&_stopFlag, true); 
+#if !defined(MBED_TEST_MODE)
+    _logDrain.stop();
+#endif
+}
+
+void BikeSystem::setTaskWorkload(uint8_t taskIndex,
+                                 const std::chrono::microseconds& wcet,
+                                 uint8_t variationPercent) {
+    _taskWorkloads.set(taskIndex, wcet, variationPercent);
 }
 
 #if defined(MBED_TEST_MODE)
-const advembsof::TaskLogger& BikeSystem::getTaskLogger() { return _taskLogger; }
+const bike_computer::TaskTracer& BikeSystem::getTaskLogger() { return _taskTracer; }
+const bike_computer::LatencyTracer& BikeSystem::getLatencyTracer() { return _latencyTracer; }
 bike_computer::Speedometer& BikeSystem::getSpeedometer() { return _speedometer; }
 GearDevice& BikeSystem::getGearDevice() { return _gearDevice; }
-uint8_t BikeSystem::getCurrentGear() const { return _currentGear; }
+uint8_t BikeSystem::getCurrentGear() const { return _telemetry.read().gear; }
+TelemetrySnapshot BikeSystem::getTelemetry() const { return _telemetry.read(); }
+const bike_computer::IncrementalDisplay& BikeSystem::getIncrementalDisplay() const {
+    return _incrementalDisplay;
+}
+uint32_t BikeSystem::getNbrOfDroppedEvents() const {
+    return _gearDevice.getNbrOfDroppedEvents() + _pedalDevice.getNbrOfDroppedEvents() +
+           core_util_atomic_load_u32(&_nbrOfDroppedResetEvents);
+}
+
+BikeSystem::ResetEventPoolStatistics BikeSystem::getResetEventPoolStatistics() const {
+    return _resetEventPool.getStatistics();
+}
 #endif  // defined(MBED_TEST_MODE)
 
 
 void BikeSystem::init() {
     // start the timer
     _timer.start();
+    _releaseEpoch = Kernel::Clock::now();
 
     // initialize the lcd display
     disco::ReturnCode rc = _displayDevice.init();
     if (rc != disco::ReturnCode::Ok) {
-        tr_error("Failed to initialized the lcd display: %d", static_cast<int>(rc));
+        DEFERRED_LOG_ERROR(bike_computer::kLogDisplayInitFailed, static_cast<int>(rc));
     }
 
+    // everything must be drawn again on the initialized display
+    _incrementalDisplay.invalidate();
+
     // initialize the sensor device
     bool present = _sensorDevice.init();
     if (!present) {
-        tr_error("Sensor not present or initialization failed");
+        DEFERRED_LOG_ERROR(bike_computer::kLogSensorInitFailed);
     }
 
     // enable/disable task logging
-    _taskLogger.enable(true);
+    _taskTracer.enable(true);
+    _latencyTracer.enable(true);
+    bike_computer::TracePoints::getInstance().enable(true);
+
+#if !defined(MBED_TEST_MODE)
+    // binary frames, written directly to the console file handle (no text
+    // formatting or newline conversion)
+    _logDrain.start(*mbed::mbed_file_handle(STDOUT_FILENO));
+#endif
+
+    // ideal releases of the periodic tasks, for the jitter and response time
+    // statistics (the other tasks are event driven)
+    _taskTracer.setTaskRelease(advembsof::TaskLogger::kTemperatureTaskIndex,
+                               kTemperatureTaskPeriod,
+                               kTemperatureTaskDelay);
+    _taskTracer.setTaskRelease(
+        advembsof::TaskLogger::kDisplayTask1Index, kDisplayTaskPeriod, kDisplayTaskDelay);
 }
 
 /*void BikeSystem::gearTask() {
@@ -125,7 +268,7 @@ void BikeSystem::init() {
     _currentGear     = _gearDevice.getCurrentGear();
     _currentGearSize = _gearDevice.getCurrentGearSize();
 
-    _taskLogger.logPeriodAndExecutionTime(
+    _taskTracer.logPeriodAndExecutionTime(
         _timer, advembsof::TaskLogger::kGearTaskIndex, taskStartTime);
 }
 
@@ -139,35 +282,54 @@ void BikeSystem::speedDistanceTask() {
     _currentSpeed    = _speedometer.getCurrentSpeed();
     _traveledDistance = _speedometer.getDistance();
 
-    _taskLogger.logPeriodAndExecutionTime(
+    _taskTracer.logPeriodAndExecutionTime(
         _timer, advembsof::TaskLogger::kSpeedTaskIndex, taskStartTime);  
 }*/
 
 void BikeSystem::temperatureTask() {
     auto taskStartTime = _timer.elapsed_time();
+    _taskWorkloads.run(advembsof::TaskLogger::kTemperatureTaskIndex);
 
-    _currentTemperature = _sensorDevice.readTemperature();
+    const float temperature = _sensorDevice.readTemperature();
+    _telemetry.update(
+        [temperature](TelemetrySnapshot& telemetry) { telemetry.temperature = temperature; });
 
-    _taskLogger.logPeriodAndExecutionTime(
+    _taskTracer.logPeriodAndExecutionTime(
         _timer, advembsof::TaskLogger::kTemperatureTaskIndex, taskStartTime);
 }
 
-void BikeSystem::resetTask() {
+void BikeSystem::resetTask(ResetEvent* resetEvent) {
+    const ResetEvent event = *resetEvent;
+    _resetEventPool.free(resetEvent);
+    const uint32_t traceId = event.traceId;
+
+    _latencyTracer.mark(bike_computer::LatencyTracer::kResetChain,
+                        traceId,
+                        bike_computer::LatencyTracer::kDispatchStage);
+    _taskWorkloads.run(advembsof::TaskLogger::kResetTaskIndex);
 #if !defined(MBED_TEST_MODE)
     auto taskStartTime = _timer.elapsed_time();
 
     if (core_util_atomic_load_bool(&_resetFlag)) {
-        tr_info("Reset task: response time is %" PRIu64 " usecs",
-                (_timer.elapsed_time() - _resetTime).count());
+        DEFERRED_LOG_INFO(bike_computer::kLogResetResponseTime,
+                          (_timer.elapsed_time() - event.resetTime).count());
         _speedometer.reset();
 
         core_util_atomic_store_bool(&_resetFlag, false);
     }
 
-    _taskLogger.logPeriodAndExecutionTime(
+    _taskTracer.logPeriodAndExecutionTime(
         _timer, advembsof::TaskLogger::kResetTaskIndex, taskStartTime);
 #endif  // !defined(MBED_TEST_MODE)
     _speedometer.reset();
+    _latencyTracer.mark(bike_computer::LatencyTracer::kResetChain,
+                        traceId,
+                        bike_computer::LatencyTracer::kUpdateStage);
+    _telemetry.update([traceId](TelemetrySnapshot& telemetry) {
+        telemetry.distance     = 0.0f;
+        telemetry.resetCount++;
+        telemetry.resetTraceId = traceId;
+    });
 }
 
 
@@ -179,26 +341,77 @@ void BikeSystem::displayTask() {
     _memoryLogger.printRuntimeMemoryMap();
 
     auto taskStartTime = _timer.elapsed_time();
-    auto _currentSpeed = _speedometer.getCurrentSpeed();
-    auto _traveledDistance = _speedometer.getDistance();
+    _taskWorkloads.run(advembsof::TaskLogger::kDisplayTask1Index);
+
+    // publish the distance, unless a reset happened while computing it
+    const uint32_t resetCount = _telemetry.read().resetCount;
+    _speedometerMutex.lock();
+    const float distance = _speedometer.getDistance();
+    _speedometerMutex.unlock();
+    _telemetry.update([resetCount, distance](TelemetrySnapshot& telemetry) {
+        if (telemetry.resetCount == resetCount) {
+            telemetry.distance = distance;
+        }
+    });
+
+    // display a consistent copy of the bike state
+    const TelemetrySnapshot telemetry = _telemetry.read();
+    _incrementalDisplay.displayGear(telemetry.gear);
+    _incrementalDisplay.displaySpeed(telemetry.speed);
+    _incrementalDisplay.displayDistance(telemetry.distance);
+    _incrementalDisplay.displayTemperature(telemetry.temperature);
+    // the inputs traced up to this snapshot are now displayed
+    _latencyTracer.complete(bike_computer::LatencyTracer::kGearChain, telemetry.gearTraceId);
+    _latencyTracer.complete(bike_computer::LatencyTracer::kResetChain, telemetry.resetTraceId);
+
+    _taskTracer.logPeriodAndExecutionTime(
+        _timer, advembsof::TaskLogger::kDisplayTask1Index, taskStartTime);
 
-    _displayDevice.displayGear(_currentGear);
-    _displayDevice.displaySpeed(_currentSpeed);
-    _displayDevice.displayDistance(_traveledDistance);
-    _displayDevice.displayTemperature(_currentTemperature);
+}
 
-    _taskLogger.logPeriodAndExecutionTime(
-        _timer, advembsof::TaskLogger::kDisplayTask1Index, taskStartTime);
+void BikeSystem::temperatureThreadTask() {
+    runPeriodicTask(&BikeSystem::temperatureTask, kTemperatureTaskDelay, kTemperatureTaskPeriod);
+}
 
+void BikeSystem::displayThreadTask() {
+    runPeriodicTask(&BikeSystem::displayTask, kDisplayTaskDelay, kDisplayTaskPeriod);
+}
+
+void BikeSystem::runPeriodicTask(void (BikeSystem::*task)(),
+                                 const std::chrono::milliseconds& offset,
+                                 const std::chrono::milliseconds& period) {
+    // releases are absolute, so that wake-up latencies do not accumulate
+    auto release = _releaseEpoch + offset;
+    while (true) {
+        ThisThread::sleep_until(release);
+        (this->*task)();
+        release += period;
+    }
 }
 
-void BikeSystem::onGearChanged(uint8_t currentGear, uint8_t currentGearSize) {
-    _currentGear = currentGear;
+void BikeSystem::onGearChanged(uint8_t currentGear, uint8_t currentGearSize, uint32_t traceId) {
+    _taskWorkloads.run(advembsof::TaskLogger::kGearTaskIndex);
+    _speedometerMutex.lock();
     _speedometer.setGearSize(currentGearSize);
+    const float speed = _speedometer.getCurrentSpeed();
+    _speedometerMutex.unlock();
+    _latencyTracer.mark(
+        bike_computer::LatencyTracer::kGearChain, traceId, bike_computer::LatencyTracer::kUpdateStage);
+    _telemetry.update([currentGear, currentGearSize, speed, traceId](TelemetrySnapshot& telemetry) {
+        telemetry.gear        = currentGear;
+        telemetry.gearSize    = currentGearSize;
+        telemetry.speed       = speed;
+        telemetry.gearTraceId = traceId;
+    });
 }
 
 void BikeSystem::onRotationSpeedChanged(const std::chrono::milliseconds& pedalRotationTime){
+     _taskWorkloads.run(advembsof::TaskLogger::kSpeedTaskIndex);
+     _speedometerMutex.lock();
      _speedometer.setCurrentRotationTime(pedalRotationTime);
+     const float speed = _speedometer.getCurrentSpeed();
+     _speedometerMutex.unlock();
+     _telemetry.update([speed](TelemetrySnapshot& telemetry) { telemetry.speed = speed; });
 }
 
 
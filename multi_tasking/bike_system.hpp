@@ -31,8 +31,14 @@
 #include "memory_logger.hpp"
 
 // from common
+#include "block_pool.hpp"
+#include "incremental_display.hpp"
+#include "latency_tracer.hpp"
+#include "log_drain.hpp"
 #include "sensor_device.hpp"
 #include "speedometer.hpp"
+#include "synthetic_workload.hpp"
+#include "task_tracer.hpp"
 
 // local
 #include "gear_device.hpp"
@@ -40,11 +46,30 @@
 #include "reset_device.hpp"
 
 #include "memory_leak.hpp"
+#include "rate_monotonic.hpp"
+#include "seq_lock.hpp"
+#include "telemetry_snapshot.hpp"
 
 namespace multi_tasking {
 
 class BikeSystem {
    public:
+    // the event queues use buffers of this instance with a compile-time
+    // capacity, so that posting from an ISR never allocates memory (on target,
+    // a periodic Event holds one event and posts another one)
+    static constexpr size_t kNbrOfPeriodicEvents       = 3;
+    static constexpr size_t kEventQueueCapacity        = 16;
+    static constexpr size_t kEventQueueForISRsCapacity = 4;
+
+    // payload of a reset event, allocated from a block pool in onReset() and
+    // freed by the reset task
+    struct ResetEvent {
+        uint32_t traceId;
+        std::chrono::microseconds resetTime;
+    };
+    using ResetEventPool = bike_computer::BlockPool<ResetEvent, kEventQueueForISRsCapacity>;
+    using ResetEventPoolStatistics = ResetEventPool::Statistics;
+
     // constructor
     BikeSystem();
 
@@ -58,14 +83,31 @@ class BikeSystem {
     // method called in main() for starting the system with the event
     void startWithEventQueue();
 
+    // method called in main() for starting the system with one thread per
+    // task, with rate monotonic priorities
+    void startWithRateMonotonicThreads();
+
     // method called for stopping the system
     void stop();
 
+    // gives a task (advembsof::TaskLogger index) a synthetic execution time
+    // that loads the CPU, before the system is started (the workload is
+    // calibrated on the first call)
+    void setTaskWorkload(uint8_t taskIndex,
+                         const std::chrono::microseconds& wcet,
+                         uint8_t variationPercent = 0);
+
 #if defined(MBED_TEST_MODE)
-    const advembsof::TaskLogger& getTaskLogger();
+    const bike_computer::TaskTracer& getTaskLogger();
+    const bike_computer::LatencyTracer& getLatencyTracer();
     bike_computer::Speedometer& getSpeedometer();
     GearDevice& getGearDevice();
     uint8_t getCurrentGear() const;
+    TelemetrySnapshot getTelemetry() const;
+    const bike_computer::IncrementalDisplay& getIncrementalDisplay() const;
+    // number of events that could not be posted since the system started
+    uint32_t getNbrOfDroppedEvents() const;
+    ResetEventPoolStatistics getResetEventPoolStatistics() const;
 #endif  // defined(MBED_TEST_MODE)
 
     // these methods must be made public for test purposes only
@@ -81,49 +123,82 @@ class BikeSystem {
    private:
     // private methods
     void init();
-    void onGearChanged(uint8_t currentGear, uint8_t currentGearSize);
+    void onGearChanged(uint8_t currentGear, uint8_t currentGearSize, uint32_t traceId);
     void onRotationSpeedChanged(const std::chrono::milliseconds& pedalRotationTime);
     void gearTask();  
     void speedDistanceTask(); 
     void temperatureTask();
-    void resetTask();
+    void resetTask(ResetEvent* resetEvent);
     void displayTask();
+    // thread functions of the rate monotonic mode
+    void temperatureThreadTask();
+    void displayThreadTask();
+    void runPeriodicTask(void (BikeSystem::*task)(),
+                         const std::chrono::milliseconds& offset,
+                         const std::chrono::milliseconds& period);
     //void cpuTask();
 
+    // largest event, posted callbacks take at most a std::chrono::milliseconds
+    static constexpr size_t kEventSize = EVENTS_EVENT_SIZE + sizeof(std::chrono::milliseconds);
+    static_assert(kEventQueueCapacity > 2 * kNbrOfPeriodicEvents,
+                  "The event queue must have room for joystick events");
+    unsigned char _eventQueueBuffer[kEventQueueCapacity * kEventSize];
+    unsigned char _eventQueueForISRsBuffer[kEventQueueForISRsCapacity * kEventSize];
     EventQueue _eventQueue;
     EventQueue _eventQueueForISRs;
+    // reset events that could not be posted
+    volatile uint32_t _nbrOfDroppedResetEvents = 0;
+    // one payload per reset event the queue can hold, the reset events
+    // posted from the ISR never use the heap
+    ResetEventPool _resetEventPool;
 
     Thread _eventThread;
 
+    // threads of the rate monotonic mode, with statically allocated stacks:
+    // reset events, joystick events (gear and pedal) and periodic tasks
+    Thread _resetThread;
+    Thread _joystickThread;
+    Thread _temperatureThread;
+    Thread _displayThread;
+    // ideal releases of the periodic threads are relative to this time
+    Kernel::Clock::time_point _releaseEpoch;
+
     // stop flag, used for stopping the super-loop (set in stop())
     bool _stopFlag = false;
-     // used for computing the reset response time
-    std::chrono::microseconds _resetTime = std::chrono::microseconds::zero();
     // reset flag (set in onReset)
     volatile bool _resetFlag = false;
     // timer instance used for loggint task time and used by ResetDevice
     Timer _timer;
     // data member that represents the device for manipulating the gear
     GearDevice _gearDevice;
-    uint8_t _currentGear = bike_computer::kMinGear;
-    uint8_t _currentGearSize = bike_computer::kMinGearSize;
     // data member that represents the device for manipulating the pedal rotation
     // speed/time
     PedalDevice _pedalDevice;
-    float _currentSpeed = 0.0f;
-    float _traveledDistance = 0.0f;
     // data member that represents the device used for resetting
     ResetDevice _resetDevice;
     // data member that represents the device display
     advembsof::DisplayDevice _displayDevice;
+    // only redraws the display fields whose text changed
+    bike_computer::IncrementalDisplay _incrementalDisplay;
     // data member that represents the device for counting wheel rotations
     bike_computer::Speedometer _speedometer;
+    // the speedometer is updated by the joystick and display tasks, which run
+    // in different threads (the RTX mutex inherits the priority of waiters)
+    Mutex _speedometerMutex;
     // data member that represents the sensor device
     bike_computer::SensorDevice _sensorDevice;
-    float _currentTemperature = 0.0f;
+    // state shared by the tasks, readers copy it without locking
+    bike_computer::SeqLock<TelemetrySnapshot> _telemetry;
 
     // used for logging task info
-    advembsof::TaskLogger _taskLogger;
+    bike_computer::TaskTracer& _taskTracer = bike_computer::TaskTracer::getInstance();
+    // used for tracing the latency from the inputs to the display
+    bike_computer::LatencyTracer& _latencyTracer = bike_computer::LatencyTracer::getInstance();
+    // synthetic execution time of each task (none by default)
+    bike_computer::TaskWorkloads _taskWorkloads;
+    // sends the pending log and trace records over the serial port, at the
+    // lowest priority
+    bike_computer::LogDrain _logDrain;
 
     
     
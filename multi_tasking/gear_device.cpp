@@ -36,11 +36,11 @@
 
 namespace multi_tasking {
 
-GearDevice::GearDevice(EventQueue& eventQueue, mbed::Callback<void(uint8_t, uint8_t)> cb)
-    : _eventQueue(eventQueue), _cb(cb) {
+GearDevice::GearDevice(EventQueue& eventQueue, mbed::Callback<void(uint8_t, uint8_t, uint32_t)> cb)
+    : _cb(cb), _mailbox(eventQueue, callback(this, &GearDevice::onGearEvent)) {
     disco::Joystick::getInstance().setUpCallback(callback(this, &GearDevice::onUp));
     disco::Joystick::getInstance().setDownCallback(callback(this, &GearDevice::onDown));
-    postEvent();
+    postEvent(bike_computer::LatencyTracer::kNoTrace);
 }
 
 uint8_t GearDevice::getCurrentGear() { return core_util_atomic_load_u8(&_currentGear); }
@@ -48,7 +48,7 @@ uint8_t GearDevice::getCurrentGear() { return core_util_atomic_load_u8(&_current
 void GearDevice::onUp() {
     if (_currentGear < bike_computer::kMaxGear) {
         _currentGear++;
-        postEvent();
+        postEvent(_latencyTracer.begin(bike_computer::LatencyTracer::kGearChain));
     }
     //if (_currentGear < bike_computer::kMaxGear) {
     //    core_util_atomic_incr_u8(&_currentGear, 1);
@@ -58,7 +58,7 @@ void GearDevice::onUp() {
 void GearDevice::onDown() {
     if (_currentGear > bike_computer::kMinGear) {
         _currentGear--;
-        postEvent();
+        postEvent(_latencyTracer.begin(bike_computer::LatencyTracer::kGearChain));
     }
     //if (_currentGear < bike_computer::kMaxGear) {
     //    core_util_atomic_decr_u8(&_currentGear, 1);
@@ -69,9 +69,25 @@ uint8_t GearDevice::getCurrentGearSize() const {
     return bike_computer::kMaxGearSize - core_util_atomic_load_u8(&_currentGear);
 }
 
-void GearDevice::postEvent() {
-    Event<void(uint8_t, uint8_t)> newGearEvent(&_eventQueue, _cb);
-    newGearEvent.post(_currentGear, bike_computer::kMaxGearSize - _currentGear);
+uint32_t GearDevice::getNbrOfDroppedEvents() const {
+    return _mailbox.getNbrOfDroppedEvents();
+}
+
+uint32_t GearDevice::getNbrOfCoalescedEvents() const {
+    return _mailbox.getNbrOfCoalescedValues();
+}
+
+void GearDevice::postEvent(uint32_t traceId) {
+    // called from ISR, gear changes are coalesced until the event is handled
+    // (the trace of a coalesced change is superseded by the newer one)
+    _mailbox.post(GearEvent{core_util_atomic_load_u8(&_currentGear), traceId});
+}
+
+void GearDevice::onGearEvent(const GearEvent& gearEvent) {
+    _latencyTracer.mark(bike_computer::LatencyTracer::kGearChain,
+                        gearEvent.traceId,
+                        bike_computer::LatencyTracer::kDispatchStage);
+    _cb(gearEvent.gear, bike_computer::kMaxGearSize - gearEvent.gear, gearEvent.traceId);
 }
 
 }  // namespace multi_tasking
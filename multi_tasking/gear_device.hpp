@@ -24,15 +24,18 @@
 
 #pragma once
 
+#include "coalescing_mailbox.hpp"
 #include "constants.hpp"
+#include "latency_tracer.hpp"
 #include "mbed.h"
 
 namespace multi_tasking {
 
 class GearDevice {
    public:
+    // the callback gets the gear, the gear size and the latency trace id
     GearDevice(EventQueue& eventQueue,  // NOLINT(runtime/references)
-               mbed::Callback<void(uint8_t, uint8_t)> cb);
+               mbed::Callback<void(uint8_t, uint8_t, uint32_t)> cb);
     // make the class non copyable
     GearDevice(GearDevice&)            = delete;
     GearDevice& operator=(GearDevice&) = delete;
@@ -44,15 +47,29 @@ class GearDevice {
     void onUp();
     void onDown();
 
+    // number of gear events that could not be posted (full event queue)
+    uint32_t getNbrOfDroppedEvents() const;
+    // number of gear changes collapsed into a newer one before being handled
+    uint32_t getNbrOfCoalescedEvents() const;
+
 
    private:
+    // gear posted by the ISRs, with the trace started by the press
+    struct GearEvent {
+        uint8_t gear;
+        uint32_t traceId;
+    };
+
     // data members
     volatile uint8_t _currentGear = bike_computer::kMinGear;
 
-    EventQueue& _eventQueue;
-    mbed::Callback<void(uint8_t, uint8_t)> _cb;
+    mbed::Callback<void(uint8_t, uint8_t, uint32_t)> _cb;
+    // only the newest gear is delivered to the event queue
+    bike_computer::CoalescingMailbox<GearEvent> _mailbox;
+    bike_computer::LatencyTracer& _latencyTracer = bike_computer::LatencyTracer::getInstance();
 
-    void postEvent();
+    void postEvent(uint32_t traceId);
+    void onGearEvent(const GearEvent& gearEvent);
 
 };
 
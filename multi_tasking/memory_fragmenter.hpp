@@ -2,7 +2,9 @@
 
 #include "mbed.h"
 #include "memory_logger.hpp"
-#include "mbed_trace.h"
+#include "deferred_log.hpp"
+#include "fragmentation_benchmark.hpp"
+#include "trace_point.hpp"
 
 namespace multi_tasking {
 
@@ -11,6 +13,11 @@ class MemoryFragmenter {
     // create a memory leak in the constructor itself
     MemoryFragmenter() {}
 
+    // replays the fixed blocks trace of the fragmentation benchmark with the
+    // available heap as budget: 8 blocks sharing the heap are allocated, the
+    // even ones are freed and the allocation of a slightly bigger block fails
+    // because of the fragmentation (see common/fragmentation_benchmark.hpp for
+    // the other traces and allocators)
     void fragmentMemory() {
         // create a memory logger
         advembsof::MemoryLogger memorLogger;
@@ -20,66 +27,77 @@ class MemoryFragmenter {
         mbed_stats_heap_get(&heapInfo);
         uint32_t availableSize =
             heapInfo.reserved_size - heapInfo.current_size - heapInfo.overhead_size;
-        tr_debug("Available heap size is %" PRIu32 " (reserved %" PRIu32 ")",
-                 availableSize,
-                 heapInfo.reserved_size);
+        TRACE_POINT_DEBUG(MEMORY_FRAGMENTER,
+                          bike_computer::kTracePointAvailableHeap,
+                          availableSize,
+                          heapInfo.reserved_size);
 
-        // divide the available size by 8 blocks that we allocate
-        uint32_t blockSize = (availableSize - kMarginSpace) / kNbrOfBlocks;
-        tr_debug("Allocating blocks of size %" PRIu32 "", blockSize);
-        char* pBlockArray[kNbrOfBlocks] = {NULL};
-        for (uint32_t blockIndex = 0; blockIndex < kNbrOfBlocks; blockIndex++) {
-            pBlockArray[blockIndex] = new char[blockSize];
-            if (pBlockArray[blockIndex] == NULL) {
-                tr_error("Cannot allocate block memory for index %" PRIu32 "",
-                         blockIndex);
+        bike_computer::FragmentationBenchmark::Operation operations[kNbrOfOperations];
+        const size_t nbrOfOperations = bike_computer::FragmentationBenchmark::makeTrace(
+            bike_computer::FragmentationBenchmark::kFixedBlocks,
+            availableSize,
+            operations,
+            kNbrOfOperations);
+        TRACE_POINT_DEBUG(
+            MEMORY_FRAGMENTER, bike_computer::kTracePointAllocatingBlocks, operations[0].size);
+
+        // the blocks are allocated with malloc(), which returns nullptr when
+        // the heap is exhausted (new stops the program on target)
+        bike_computer::HeapAllocator heapAllocator;
+        heapAllocator.reset(nullptr, availableSize);
+        void* blocks[kNbrOfBlocks]        = {nullptr};
+        uint32_t blockSizes[kNbrOfBlocks] = {0};
+        for (size_t index = 0; index < nbrOfOperations; index++) {
+            const bike_computer::FragmentationBenchmark::Operation& operation =
+                operations[index];
+            // the heap statistics after the allocations and after the frees
+            if (index > 0 && (operation.size == 0) != (operations[index - 1].size == 0)) {
+                if (operation.size == 0) {
+                    TRACE_POINT_DEBUG(MEMORY_FRAGMENTER,
+                                      bike_computer::kTracePointHeapAfterAllocation);
+                } else {
+                    TRACE_POINT_DEBUG(MEMORY_FRAGMENTER,
+                                      bike_computer::kTracePointHeapAfterDeallocation);
+                }
+                memorLogger.getAndPrintHeapStatistics();
             }
-            tr_debug("Allocated block index  %" PRIu32 " of size  %" PRIu32
-                     " at address 0x%08" PRIx32 "",
-                     blockIndex,
-                     blockSize,
-                     (uint32_t)pBlockArray[blockIndex]);
-            // copy to member variable to prevent them from being optimized away
-            for (uint32_t index = 0; index < kArraySize; index++) {
-                _doubleArray[index] += (double)pBlockArray[blockIndex][index];
+
+            if (operation.size == 0) {
+                // the allocation of the slot may have failed
+                if (blocks[operation.slot] != nullptr) {
+                    heapAllocator.free(blocks[operation.slot], blockSizes[operation.slot]);
+                    blocks[operation.slot] = nullptr;
+                }
+                continue;
             }
+            blocks[operation.slot] = heapAllocator.allocate(operation.size);
+            if (blocks[operation.slot] == nullptr) {
+                DEFERRED_LOG_ERROR(bike_computer::kLogBlockAllocationFailed,
+                                   static_cast<uint32_t>(operation.slot));
+                continue;
+            }
+            blockSizes[operation.slot] = operation.size;
+            TRACE_POINT_DEBUG(
+                MEMORY_FRAGMENTER,
+                bike_computer::kTracePointAllocatedBlock,
+                static_cast<uint32_t>(operation.slot),
+                operation.size,
+                static_cast<uint32_t>(reinterpret_cast<uintptr_t>(blocks[operation.slot])));
         }
-        // the full heap (or almost) should be allocated
-        tr_debug("Heap statistics after full allocation:");
-        memorLogger.getAndPrintHeapStatistics();
-        // delete only the even blocks
-        for (uint32_t blockIndex = 0; blockIndex < kNbrOfBlocks; blockIndex += 2) {
-            delete[] pBlockArray[blockIndex];
-            pBlockArray[blockIndex] = NULL;
-        }
-        // we should have half of the heap space free
-        tr_debug("Heap statistics after half deallocation:");
-        memorLogger.getAndPrintHeapStatistics();
 
-        // trying to allocated one block that is slightly bigger
-        // without fragmentation, this allocation should succeed
-        heapInfo = {0};
-        mbed_stats_heap_get(&heapInfo);
-        availableSize =
-            heapInfo.reserved_size - heapInfo.current_size - heapInfo.overhead_size;
-        tr_debug("Available heap size is  %" PRIu32 " (reserved  %" PRIu32 ")",
-                 availableSize,
-                 heapInfo.reserved_size);
-        blockSize += 8;
-        // this allocation will fail
-        tr_debug("Allocating 1 block of size %" PRIu32 " should succeed !", blockSize);
-        pBlockArray[0] = new char[blockSize];
-        // copy to member variable to prevent them from being optimized away
-        for (uint32_t index = 0; index < kArraySize; index++) {
-            _doubleArray[index] += (double)pBlockArray[0][index];
+        for (uint8_t slot = 0; slot < kNbrOfBlocks; slot++) {
+            if (blocks[slot] != nullptr) {
+                heapAllocator.free(blocks[slot], blockSizes[slot]);
+            }
         }
+        memorLogger.getAndPrintHeapStatistics();
     }
 
    private:
-    static constexpr uint8_t kNbrOfBlocks  = 8;
-    static constexpr uint16_t kMarginSpace = 1024;
-    static constexpr uint8_t kArraySize    = 100;
-    double _doubleArray[kArraySize]        = {0};
+    // slots of the fixed blocks trace
+    static constexpr uint8_t kNbrOfBlocks = 8;
+    // 8 allocations, 4 frees and the bigger allocation
+    static constexpr uint8_t kNbrOfOperations = 13;
 };
 
 }  // namespace multi_tasking
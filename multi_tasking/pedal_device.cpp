@@ -29,7 +29,7 @@ static constexpr std::chrono::microseconds kTaskRunTime = 200000us;
 
 PedalDevice::PedalDevice(EventQueue& eventQueue,
                          mbed::Callback<void(const std::chrono::milliseconds&)> cb)
-    : _eventQueue(eventQueue), _cb(cb) {
+    : _mailbox(eventQueue, cb) {
     disco::Joystick::getInstance().setLeftCallback(callback(this, &PedalDevice::onLeft));
     disco::Joystick::getInstance().setRightCallback(callback(this, &PedalDevice::onRight));
     postEvent();
@@ -72,10 +72,19 @@ void PedalDevice::onRight() {
     }
 }
 
+uint32_t PedalDevice::getNbrOfDroppedEvents() const {
+    return _mailbox.getNbrOfDroppedEvents();
+}
+
+uint32_t PedalDevice::getNbrOfCoalescedEvents() const {
+    return _mailbox.getNbrOfCoalescedValues();
+}
+
 void PedalDevice::postEvent() {
-    Event<void(const std::chrono::milliseconds&)> newRotationTimeEvent(&_eventQueue, _cb);
     _currentRotationTime = bike_computer::kMinPedalRotationTime + _currentStep * bike_computer::kDeltaPedalRotationTime;
-    newRotationTimeEvent.post(_currentRotationTime);
+    // called from ISR, rotation time changes are coalesced until the event is
+    // handled
+    _mailbox.post(_currentRotationTime);
 }
 
 }  // namespace multi_tasking
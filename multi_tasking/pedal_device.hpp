@@ -24,6 +24,7 @@
 
 #pragma once
 
+#include "coalescing_mailbox.hpp"
 #include "constants.hpp"
 #include "mbed.h"
 
@@ -40,6 +41,12 @@ class PedalDevice {
     // method called for updating the bike system
     std::chrono::milliseconds getCurrentRotationTime();
 
+    // number of rotation events that could not be posted (full event queue)
+    uint32_t getNbrOfDroppedEvents() const;
+    // number of rotation time changes collapsed into a newer one before being
+    // handled
+    uint32_t getNbrOfCoalescedEvents() const;
+
    private:
     // private methods
     void onLeft();
@@ -57,8 +64,8 @@ class PedalDevice {
             .count() /
         bike_computer::kDeltaPedalRotationTime.count());
     
-    EventQueue& _eventQueue;
-    mbed::Callback<void(const std::chrono::milliseconds&)> _cb;
+    // only the newest rotation time is delivered to the event queue
+    bike_computer::CoalescingMailbox<std::chrono::milliseconds> _mailbox;
     void postEvent();
     std::chrono::milliseconds _currentRotationTime;
 
@@ -0,0 +1,52 @@
+// Copyright 2024 Adrien Rey
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/****************************************************************************
+ * @file telemetry_snapshot.hpp
+ * @author Adrien Rey <adrien.rey@hevs.ch>
+ *
+ * @brief Bike system state shared between the tasks (multi-tasking)
+ *
+ * The snapshot is published through a bike_computer::SeqLock, so that
+ * readers always get a consistent copy without taking a mutex.
+ *
+ * @date 2024-02-05
+ * @version 1.0.0
+ ***************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+
+namespace multi_tasking {
+
+struct TelemetrySnapshot {
+    uint8_t gear;
+    uint8_t gearSize;
+    // speed in km / h
+    float speed;
+    // traveled distance in km
+    float distance;
+    // temperature in degrees
+    float temperature;
+    // incremented on each reset, used for discarding distances computed
+    // before a reset
+    uint32_t resetCount;
+    // latency traces of the last gear change and reset, completed once
+    // displayed (see bike_computer::LatencyTracer)
+    uint32_t gearTraceId;
+    uint32_t resetTraceId;
+};
+
+}  // namespace multi_tasking
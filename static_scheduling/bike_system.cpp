@@ -26,10 +26,8 @@
 
 #include <chrono>
 
-#include "mbed_trace.h"
-#if MBED_CONF_MBED_TRACE_ENABLE
-#define TRACE_GROUP "BikeSystem"
-#endif // MBED_CONF_MBED_TRACE_ENABLE
+#include "deferred_log.hpp"
+#include "trace_point.hpp"
 
 namespace static_scheduling {
 
@@ -56,51 +54,108 @@ static constexpr std::chrono::milliseconds kCPUTaskPeriod = 1600ms;
 static constexpr std::chrono::milliseconds kCPUTaskDelay = 1200ms;
 static constexpr std::chrono::milliseconds kCPUTaskComputationTime = 400ms;
 
+#if !defined(MBED_CONF_PLATFORM_STDIO_BAUD_RATE)
+#define MBED_CONF_PLATFORM_STDIO_BAUD_RATE 9600
+#endif
+
+// the cycle has no free frame, the cpu task runs in the idle end of the
+// display task 1 frame (the drawing takes less than the frame, which is padded
+// with a sleep), when kCPUTaskDrainTime is left. It sends the pending records
+// in frames of at most kCPUTaskFrameSize bytes, as long as they fit in 3/4 of
+// what the serial port sends in kCPUTaskDrainTime (10 bits per byte), the rest
+// of the time is left for the statistics line. The remaining records are sent
+// in the next cycles.
+static constexpr std::chrono::milliseconds kCPUTaskDrainTime = 50ms;
+static_assert(kCPUTaskDrainTime < kDisplayTask1ComputationTime,
+              "The cpu task does not fit in the display task 1 frame");
+static constexpr size_t kCPUTaskFrameSize = 128;
+static constexpr size_t kCPUTaskByteBudget =
+    static_cast<size_t>(MBED_CONF_PLATFORM_STDIO_BAUD_RATE / 10 *
+                        kCPUTaskDrainTime.count() / 1000 * 3 / 4);
+static_assert(kCPUTaskByteBudget >= kCPUTaskFrameSize,
+              "The cpu task cannot send a single frame in its drain time");
+
+// clang-format off
+constexpr bike_computer::CyclicTask<BikeSystem> BikeSystem::kTaskTable[] = {
+  // period                  offset                    computation time                   function
+  {kGearTaskPeriod,          kGearTaskDelay,           kGearTaskComputationTime,          &BikeSystem::gearTask},
+  {kSpeedDistanceTaskPeriod, kSpeedDistanceTaskDelay,  kSpeedDistanceTaskComputationTime, &BikeSystem::speedDistanceTask},
+  {kDisplayTask1Period,      kDisplayTask1Delay,       kDisplayTask1ComputationTime,      &BikeSystem::displayTask1},
+  {kResetTaskPeriod,         kResetTaskDelay,          kResetTaskComputationTime,         &BikeSystem::resetTask},
+  {kTemperatureTaskPeriod,   kTemperatureTaskDelay,    kTemperatureTaskComputationTime,   &BikeSystem::temperatureTask},
+  {kDisplayTask2Period,      kDisplayTask2Delay,       kDisplayTask2ComputationTime,      &BikeSystem::displayTask2},
+};
+// clang-format on
+
+constexpr bike_computer::CyclicSchedule<BikeSystem::kMaxNbrOfFrames>
+    BikeSystem::kSchedule =
+        bike_computer::makeCyclicSchedule<BikeSystem::kMaxNbrOfFrames>(
+            BikeSystem::kTaskTable);
+
 BikeSystem::BikeSystem()
-    : _gearDevice(_timer), _pedalDevice(_timer), _resetDevice(_timer),
-      _speedometer(_timer), _cpuLogger(_timer) {}
+    : _periodicRelease(kMajorCycleDuration), _gearDevice(_timer),
+      _pedalDevice(_timer), _resetDevice(_timer),
+      _incrementalDisplay(_displayDevice), _speedometer(_timer),
+      _cpuLogger(_timer) {}
 
 void BikeSystem::start() {
-  tr_info("Starting Super-Loop without event handling");
+  // the task table must be feasible as a cyclic schedule
+  static_assert(kSchedule.error !=
+                    bike_computer::CyclicScheduleError::InvalidTask,
+                "A task has an invalid period or offset");
+  static_assert(kSchedule.error !=
+                    bike_computer::CyclicScheduleError::TooManyFrames,
+                "The major cycle has more than kMaxNbrOfFrames frames");
+  static_assert(kSchedule.error !=
+                    bike_computer::CyclicScheduleError::Overlap,
+                "Two tasks overlap in the major cycle");
+  static_assert(kSchedule.error !=
+                    bike_computer::CyclicScheduleError::DeadlineMiss,
+                "A task does not complete before its next release");
+  static_assert(kSchedule.majorCycle == kMajorCycleDuration,
+                "Unexpected major cycle duration");
+
+  DEFERRED_LOG_INFO(bike_computer::kLogStartingSuperLoop);
 
   init();
 
+  // the frames are released at absolute times from the start of each major
+  // cycle, so that a late frame does not shift the following ones
+  _periodicRelease.start();
+  auto cycleStartTime = _timer.elapsed_time();
   while (true) {
-    auto startTime = _timer.elapsed_time();
-
-    gearTask();
-    speedDistanceTask();
-    displayTask1();
-    speedDistanceTask();
-    resetTask();
-    gearTask();
-    speedDistanceTask();
-    temperatureTask();
-    displayTask2();
-    speedDistanceTask();
-    resetTask();
-
-    // register the time at the end of the cyclic schedule period and print the
-    // elapsed time for the period
-    std::chrono::microseconds endTime = _timer.elapsed_time();
-    const auto cycle = std::chrono::duration_cast<std::chrono::milliseconds>(
-        endTime - startTime);
-    tr_debug("Repeating cycle time is %" PRIu64 " milliseconds", cycle.count());
+    for (size_t frameIndex = 0; frameIndex < kSchedule.nbrOfFrames;
+         frameIndex++) {
+      const auto &frame = kSchedule.frames[frameIndex];
+      if (!_periodicRelease.sleepUntil(frame.startTime)) {
+        DEFERRED_LOG_WARN(bike_computer::kLogFrameOverrun,
+                          static_cast<uint32_t>(frameIndex),
+                          _periodicRelease.getNbrOfOverruns());
+      }
+      (this->*kTaskTable[frame.taskIndex].function)();
+    }
 
-    bool stopFlag = false;
-    core_util_atomic_load(&stopFlag);
-    if (stopFlag) {
+    if (core_util_atomic_load_bool(&_stopFlag)) {
       break;
     }
 
-#if !defined(MBED_TEST_MODE)
-    _cpuLogger.printStats();
-#endif
+    if (!_periodicRelease.sleepUntilNextPeriod()) {
+      DEFERRED_LOG_WARN(bike_computer::kLogMajorCycleOverrun,
+                        _periodicRelease.getNbrOfOverruns());
+    }
+
+    // print the time elapsed between the starts of two cycles
+    const std::chrono::microseconds nextCycleStartTime = _timer.elapsed_time();
+    const auto cycle = std::chrono::duration_cast<std::chrono::milliseconds>(
+        nextCycleStartTime - cycleStartTime);
+    cycleStartTime = nextCycleStartTime;
+    TRACE_POINT_DEBUG(BIKE_SYSTEM, bike_computer::kTracePointCycleTime,
+                      static_cast<uint32_t>(cycle.count()));
   }
 }
 
 void BikeSystem::startWithEventQueue() {
-  tr_info("Starting Super-Loop with event handling");
+  DEFERRED_LOG_INFO(bike_computer::kLogStartingSuperLoopWithEvents);
 
   init();
 
@@ -152,8 +207,24 @@ void BikeSystem::startWithEventQueue() {
 
 void BikeSystem::stop() { core_util_atomic_store_bool(&_stopFlag, true); }
 
+void BikeSystem::setTaskWorkload(uint8_t taskIndex,
+                                 const std::chrono::microseconds &wcet,
+                                 uint8_t variationPercent) {
+  _taskWorkloads.set(taskIndex, wcet, variationPercent);
+}
+
 #if defined(MBED_TEST_MODE)
-const advembsof::TaskLogger &BikeSystem::getTaskLogger() { return _taskLogger; }
+const bike_computer::TaskTracer &BikeSystem::getTaskLogger() {
+  return _taskTracer;
+}
+
+bike_computer::Speedometer &BikeSystem::getSpeedometer() {
+  return _speedometer;
+}
+
+uint32_t BikeSystem::getNbrOfFrameOverruns() const {
+  return _periodicRelease.getNbrOfOverruns();
+}
 #endif // defined(MBED_TEST_MODE)
 
 void BikeSystem::init() {
@@ -163,34 +234,55 @@ void BikeSystem::init() {
   // initialize the lcd display
   disco::ReturnCode rc = _displayDevice.init();
   if (rc != disco::ReturnCode::Ok) {
-    tr_error("Failed to initialized the lcd display: %d", static_cast<int>(rc));
+    DEFERRED_LOG_ERROR(bike_computer::kLogDisplayInitFailed,
+                       static_cast<int>(rc));
   }
 
+  // everything must be drawn again on the initialized display
+  _incrementalDisplay.invalidate();
+
   // initialize the sensor device
   bool present = _sensorDevice.init();
   if (!present) {
-    tr_error("Sensor not present or initialization failed");
+    DEFERRED_LOG_ERROR(bike_computer::kLogSensorInitFailed);
   }
 
   // enable/disable task logging
-  _taskLogger.enable(true);
+  _taskTracer.enable(true);
+  bike_computer::TracePoints::getInstance().enable(true);
+
+  // ideal releases, for the jitter and response time statistics
+  _taskTracer.setTaskRelease(advembsof::TaskLogger::kGearTaskIndex,
+                             kGearTaskPeriod, kGearTaskDelay);
+  _taskTracer.setTaskRelease(advembsof::TaskLogger::kSpeedTaskIndex,
+                             kSpeedDistanceTaskPeriod, kSpeedDistanceTaskDelay);
+  _taskTracer.setTaskRelease(advembsof::TaskLogger::kTemperatureTaskIndex,
+                             kTemperatureTaskPeriod, kTemperatureTaskDelay);
+  _taskTracer.setTaskRelease(advembsof::TaskLogger::kResetTaskIndex,
+                             kResetTaskPeriod, kResetTaskDelay);
+  _taskTracer.setTaskRelease(advembsof::TaskLogger::kDisplayTask1Index,
+                             kDisplayTask1Period, kDisplayTask1Delay);
+  _taskTracer.setTaskRelease(advembsof::TaskLogger::kDisplayTask2Index,
+                             kDisplayTask2Period, kDisplayTask2Delay);
 }
 
 void BikeSystem::gearTask() {
   // gear task
   auto taskStartTime = _timer.elapsed_time();
+  _taskWorkloads.run(advembsof::TaskLogger::kGearTaskIndex);
 
   // no need to protect access to data members (single threaded)
   _currentGear = _gearDevice.getCurrentGear();
   _currentGearSize = _gearDevice.getCurrentGearSize();
 
-  _taskLogger.logPeriodAndExecutionTime(
+  _taskTracer.logPeriodAndExecutionTime(
       _timer, advembsof::TaskLogger::kGearTaskIndex, taskStartTime);
 }
 
 void BikeSystem::speedDistanceTask() {
   // speed and distance task
   auto taskStartTime = _timer.elapsed_time();
+  _taskWorkloads.run(advembsof::TaskLogger::kSpeedTaskIndex);
 
   const auto pedalRotationTime = _pedalDevice.getCurrentRotationTime();
   _speedometer.setCurrentRotationTime(pedalRotationTime);
@@ -199,64 +291,109 @@ void BikeSystem::speedDistanceTask() {
   _currentSpeed = _speedometer.getCurrentSpeed();
   _traveledDistance = _speedometer.getDistance();
 
-  _taskLogger.logPeriodAndExecutionTime(
+  _taskTracer.logPeriodAndExecutionTime(
       _timer, advembsof::TaskLogger::kSpeedTaskIndex, taskStartTime);
 }
 
 void BikeSystem::temperatureTask() {
   auto taskStartTime = _timer.elapsed_time();
+  // the computation time is simulated until an absolute time, so that the
+  // wake-up latency does not accumulate
+  const auto taskReleaseTime = Kernel::Clock::now();
+  _taskWorkloads.run(advembsof::TaskLogger::kTemperatureTaskIndex);
 
   // no need to protect access to data members (single threaded)
   _currentTemperature = _sensorDevice.readTemperature();
 
-  ThisThread::sleep_for(std::chrono::duration_cast<std::chrono::milliseconds>(
-      kTemperatureTaskComputationTime -
-      (_timer.elapsed_time() - taskStartTime)));
+  ThisThread::sleep_until(taskReleaseTime + kTemperatureTaskComputationTime);
 
-  _taskLogger.logPeriodAndExecutionTime(
+  _taskTracer.logPeriodAndExecutionTime(
       _timer, advembsof::TaskLogger::kTemperatureTaskIndex, taskStartTime);
 }
 
 void BikeSystem::resetTask() {
   auto taskStartTime = _timer.elapsed_time();
+  _taskWorkloads.run(advembsof::TaskLogger::kResetTaskIndex);
 
   if (_resetDevice.checkReset()) {
     std::chrono::microseconds responseTime =
         _timer.elapsed_time() - _resetDevice.getPressTime();
-    tr_info("Reset task: response time is %" PRIu64 " usecs",
-            responseTime.count());
+    DEFERRED_LOG_INFO(bike_computer::kLogResetResponseTime,
+                      responseTime.count());
     _speedometer.reset();
   }
 
-  _taskLogger.logPeriodAndExecutionTime(
+  _taskTracer.logPeriodAndExecutionTime(
       _timer, advembsof::TaskLogger::kResetTaskIndex, taskStartTime);
 }
 
 void BikeSystem::displayTask1() {
   auto taskStartTime = _timer.elapsed_time();
+  const auto taskReleaseTime = Kernel::Clock::now();
+  _taskWorkloads.run(advembsof::TaskLogger::kDisplayTask1Index);
+
+  _incrementalDisplay.displayGear(_currentGear);
+  _incrementalDisplay.displaySpeed(_currentSpeed);
+  _incrementalDisplay.displayDistance(_traveledDistance);
 
-  _displayDevice.displayGear(_currentGear);
-  _displayDevice.displaySpeed(_currentSpeed);
-  _displayDevice.displayDistance(_traveledDistance);
+  // the cpu task runs in the idle end of the frame (see kCPUTaskDrainTime)
+  if (Kernel::Clock::now() + kCPUTaskDrainTime <=
+      taskReleaseTime + kDisplayTask1ComputationTime) {
+    cpuTask();
+  }
 
-  ThisThread::sleep_for(std::chrono::duration_cast<std::chrono::milliseconds>(
-      kDisplayTask1ComputationTime - (_timer.elapsed_time() - taskStartTime)));
+  ThisThread::sleep_until(taskReleaseTime + kDisplayTask1ComputationTime);
 
-  _taskLogger.logPeriodAndExecutionTime(
+  _taskTracer.logPeriodAndExecutionTime(
       _timer, advembsof::TaskLogger::kDisplayTask1Index, taskStartTime);
 }
 
 void BikeSystem::displayTask2() {
   auto taskStartTime = _timer.elapsed_time();
+  const auto taskReleaseTime = Kernel::Clock::now();
+  _taskWorkloads.run(advembsof::TaskLogger::kDisplayTask2Index);
 
-  _displayDevice.displayTemperature(_currentTemperature);
+  _incrementalDisplay.displayTemperature(_currentTemperature);
 
-  ThisThread::sleep_for(std::chrono::duration_cast<std::chrono::milliseconds>(
-      kDisplayTask2ComputationTime - (_timer.elapsed_time() - taskStartTime)));
+  ThisThread::sleep_until(taskReleaseTime + kDisplayTask2ComputationTime);
 
-  _taskLogger.logPeriodAndExecutionTime(
+  _taskTracer.logPeriodAndExecutionTime(
       _timer, advembsof::TaskLogger::kDisplayTask2Index, taskStartTime);
 }
 
-void BikeSystem::cpuTask() { _cpuLogger.printStats(); }
+// sends frames of records until the byte budget is spent, returns the number
+// of bytes sent
+template <typename Source>
+static size_t drainFrames(Source &source, // NOLINT(runtime/references)
+                          size_t byteBudget) {
+  static uint8_t frame[kCPUTaskFrameSize];
+  size_t nbrOfBytes = 0;
+  while (byteBudget - nbrOfBytes >= sizeof(frame)) {
+    const size_t frameSize = source.drain(frame, sizeof(frame));
+    if (frameSize == 0) {
+      break;
+    }
+#if defined(MBED_TEST_MODE)
+    // the frames would corrupt the test output, the time needed for sending
+    // them is consumed instead
+    wait_us(static_cast<int>(frameSize * 10 * 1000000 /
+                             MBED_CONF_PLATFORM_STDIO_BAUD_RATE));
+#else
+    mbed::mbed_file_handle(STDOUT_FILENO)->write(frame, frameSize);
+#endif
+    nbrOfBytes += frameSize;
+  }
+  return nbrOfBytes;
+}
+
+void BikeSystem::cpuTask() {
+#if !defined(MBED_TEST_MODE)
+  _cpuLogger.printStats();
+#endif
+  size_t nbrOfBytes = drainFrames(_taskTracer, kCPUTaskByteBudget);
+  nbrOfBytes += drainFrames(bike_computer::TracePoints::getInstance(),
+                            kCPUTaskByteBudget - nbrOfBytes);
+  drainFrames(bike_computer::DeferredLog::getInstance(),
+              kCPUTaskByteBudget - nbrOfBytes);
+}
 } // namespace static_scheduling
@@ -30,8 +30,13 @@
 #include "task_logger.hpp"
 
 // from common
+#include "cyclic_schedule.hpp"
+#include "incremental_display.hpp"
+#include "periodic_release.hpp"
 #include "sensor_device.hpp"
 #include "speedometer.hpp"
+#include "synthetic_workload.hpp"
+#include "task_tracer.hpp"
 
 // local
 #include "gear_device.hpp"
@@ -58,8 +63,17 @@ public:
   // method called for stopping the system
   void stop();
 
+  // gives a task (advembsof::TaskLogger index) a synthetic execution time
+  // that loads the CPU, before the system is started (the workload is
+  // calibrated on the first call)
+  void setTaskWorkload(uint8_t taskIndex, const std::chrono::microseconds &wcet,
+                       uint8_t variationPercent = 0);
+
 #if defined(MBED_TEST_MODE)
-  const advembsof::TaskLogger &getTaskLogger();
+  const bike_computer::TaskTracer &getTaskLogger();
+  bike_computer::Speedometer &getSpeedometer();
+  // number of frames released after their start time
+  uint32_t getNbrOfFrameOverruns() const;
 #endif // defined(MBED_TEST_MODE)
 
 private:
@@ -74,8 +88,17 @@ private:
   void displayTask();
   void cpuTask();
 
+  // periodic tasks of the super-loop, the frames of the major cycle are
+  // generated and checked at compile time from this table (see
+  // bike_system.cpp), adding a task only requires a new entry
+  static constexpr size_t kMaxNbrOfFrames = 16;
+  static const bike_computer::CyclicTask<BikeSystem> kTaskTable[];
+  static const bike_computer::CyclicSchedule<kMaxNbrOfFrames> kSchedule;
+
   // stop flag, used for stopping the super-loop (set in stop())
   bool _stopFlag = false;
+  // releases the frames of the super-loop at absolute times
+  bike_computer::PeriodicRelease _periodicRelease;
   // timer instance used for loggint task time and used by ResetDevice
   Timer _timer;
   // data member that represents the device for manipulating the gear
@@ -91,6 +114,8 @@ private:
   ResetDevice _resetDevice;
   // data member that represents the device display
   advembsof::DisplayDevice _displayDevice;
+  // only redraws the display fields whose text changed
+  bike_computer::IncrementalDisplay _incrementalDisplay;
   // data member that represents the device for counting wheel rotations
   bike_computer::Speedometer _speedometer;
   // data member that represents the sensor device
@@ -98,7 +123,10 @@ private:
   float _currentTemperature = 0.0f;
 
   // used for logging task info
-  advembsof::TaskLogger _taskLogger;
+  bike_computer::TaskTracer &_taskTracer =
+      bike_computer::TaskTracer::getInstance();
+  // synthetic execution time of each task (none by default)
+  bike_computer::TaskWorkloads _taskWorkloads;
 
   // cpulogger to see use of cpu
   advembsof::CPULogger _cpuLogger;
@@ -26,10 +26,8 @@
 
 #include <chrono>
 
-#include "mbed_trace.h"
-#if MBED_CONF_MBED_TRACE_ENABLE
-#define TRACE_GROUP "BikeSystem"
-#endif // MBED_CONF_MBED_TRACE_ENABLE
+#include "deferred_log.hpp"
+#include "trace_point.hpp"
 
 namespace static_scheduling_with_event {
 
@@ -57,52 +55,74 @@ static constexpr std::chrono::milliseconds kCPUTaskPeriod = 1600ms;
 static constexpr std::chrono::milliseconds kCPUTaskDelay = 1200ms;
 static constexpr std::chrono::milliseconds kCPUTaskComputationTime = 100ms;
 
+static constexpr std::chrono::milliseconds kMajorCycleDuration = 1600ms;
+
+// clang-format off
+constexpr bike_computer::CyclicTask<BikeSystem> BikeSystem::kTaskTable[] = {
+  // period                  offset                    computation time                   function
+  {kGearTaskPeriod,          kGearTaskDelay,           kGearTaskComputationTime,          &BikeSystem::gearTask},
+  {kSpeedDistanceTaskPeriod, kSpeedDistanceTaskDelay,  kSpeedDistanceTaskComputationTime, &BikeSystem::speedDistanceTask},
+  {kDisplayTask1Period,      kDisplayTask1Delay,       kDisplayTask1ComputationTime,      &BikeSystem::displayTask1},
+  {kResetTaskPeriod,         kResetTaskDelay,          kResetTaskComputationTime,         &BikeSystem::resetTask},
+  {kTemperatureTaskPeriod,   kTemperatureTaskDelay,    kTemperatureTaskComputationTime,   &BikeSystem::temperatureTask},
+  {kDisplayTask2Period,      kDisplayTask2Delay,       kDisplayTask2ComputationTime,      &BikeSystem::displayTask2},
+};
+// clang-format on
+
+constexpr bike_computer::CyclicSchedule<BikeSystem::kMaxNbrOfFrames>
+    BikeSystem::kSchedule =
+        bike_computer::makeCyclicSchedule<BikeSystem::kMaxNbrOfFrames>(
+            BikeSystem::kTaskTable);
+
 BikeSystem::BikeSystem()
-    : _gearDevice(), _pedalDevice(),
-      _resetDevice(callback(this, &BikeSystem::onReset)), _speedometer(_timer),
+    : _periodicRelease(kMajorCycleDuration), _gearDevice(), _pedalDevice(),
+      _resetDevice(callback(this, &BikeSystem::onReset)),
+      _incrementalDisplay(_displayDevice), _speedometer(_timer),
       _cpuLogger(_timer) {}
 
 void BikeSystem::start() {
-  tr_info("Starting Super-Loop without event handling");
+  static_assert(kSchedule.error == bike_computer::CyclicScheduleError::None,
+                "The task table is not a feasible cyclic schedule");
+  static_assert(kSchedule.majorCycle == kMajorCycleDuration,
+                "Unexpected major cycle duration");
+
+  DEFERRED_LOG_INFO(bike_computer::kLogStartingSuperLoop);
 
   init();
 
+  // the devices latch the inputs in ISRs, so that the tasks only contain
+  // their actual work and the thread sleeps until the start of the next frame
+  // instead of polling
+  _periodicRelease.start();
   while (true) {
-    auto startTime = _timer.elapsed_time();
-
-    gearTask();
-    speedDistanceTask();
-    displayTask1();
-    speedDistanceTask();
-    resetTask();
-    gearTask();
-    speedDistanceTask();
-    temperatureTask();
-    displayTask2();
-    speedDistanceTask();
-    resetTask();
-
-    // register the time at the end of the cyclic schedule period and print the
-    // elapsed time for the period
-    std::chrono::microseconds endTime = _timer.elapsed_time();
-    const auto cycle = std::chrono::duration_cast<std::chrono::milliseconds>(
-        endTime - startTime);
-    tr_debug("Repeating cycle time is %" PRIu64 " milliseconds", cycle.count());
-
-    bool stopFlag = false;
-    core_util_atomic_load(&stopFlag);
-    if (stopFlag) {
+    for (size_t frameIndex = 0; frameIndex < kSchedule.nbrOfFrames;
+         frameIndex++) {
+      const auto &frame = kSchedule.frames[frameIndex];
+      if (!_periodicRelease.sleepUntil(frame.startTime)) {
+        DEFERRED_LOG_WARN(bike_computer::kLogFrameOverrun,
+                          static_cast<uint32_t>(frameIndex),
+                          _periodicRelease.getNbrOfOverruns());
+      }
+      (this->*kTaskTable[frame.taskIndex].function)();
+    }
+
+    if (core_util_atomic_load_bool(&_stopFlag)) {
       break;
     }
 
 #if !defined(MBED_TEST_MODE)
-    _cpuLogger.printStats();
+    cpuTask();
 #endif
+
+    if (!_periodicRelease.sleepUntilNextPeriod()) {
+      DEFERRED_LOG_WARN(bike_computer::kLogMajorCycleOverrun,
+                        _periodicRelease.getNbrOfOverruns());
+    }
   }
 }
 
 void BikeSystem::startWithEventQueue() {
-  tr_info("Starting Super-Loop with event handling");
+  DEFERRED_LOG_INFO(bike_computer::kLogStartingSuperLoopWithEvents);
 
   init();
 
@@ -152,6 +172,61 @@ void BikeSystem::startWithEventQueue() {
   eventQueue.dispatch_forever();
 }
 
+void BikeSystem::startWithEdfEventQueue() {
+  DEFERRED_LOG_INFO(bike_computer::kLogStartingSuperLoopWithEdf);
+
+  init();
+
+  // the deadlines are implicit (equal to the periods)
+  bike_computer::EdfEventQueue eventQueue;
+
+  bike_computer::EdfEvent gearEvent(&eventQueue,
+                                    callback(this, &BikeSystem::gearTask));
+  gearEvent.delay(kGearTaskDelay);
+  gearEvent.period(kGearTaskPeriod);
+  gearEvent.post();
+
+  bike_computer::EdfEvent speedDistanceEvent(
+      &eventQueue, callback(this, &BikeSystem::speedDistanceTask));
+  speedDistanceEvent.delay(kSpeedDistanceTaskDelay);
+  speedDistanceEvent.period(kSpeedDistanceTaskPeriod);
+  speedDistanceEvent.post();
+
+  bike_computer::EdfEvent display1Event(
+      &eventQueue, callback(this, &BikeSystem::displayTask1));
+  display1Event.delay(kDisplayTask1Delay);
+  display1Event.period(kDisplayTask1Period);
+  display1Event.post();
+
+  bike_computer::EdfEvent resetEvent(&eventQueue,
+                                     callback(this, &BikeSystem::resetTask));
+  resetEvent.delay(kResetTaskDelay);
+  resetEvent.period(kResetTaskPeriod);
+  resetEvent.post();
+
+  bike_computer::EdfEvent temperatureEvent(
+      &eventQueue, callback(this, &BikeSystem::temperatureTask));
+  temperatureEvent.delay(kTemperatureTaskDelay);
+  temperatureEvent.period(kTemperatureTaskPeriod);
+  temperatureEvent.post();
+
+  bike_computer::EdfEvent display2Event(
+      &eventQueue, callback(this, &BikeSystem::displayTask2));
+  display2Event.delay(kDisplayTask2Delay);
+  display2Event.period(kDisplayTask2Period);
+  display2Event.post();
+
+#if !defined(MBED_TEST_MODE)
+  bike_computer::EdfEvent cpuEvent(&eventQueue,
+                                   callback(this, &BikeSystem::cpuTask));
+  cpuEvent.delay(kCPUTaskDelay);
+  cpuEvent.period(kCPUTaskPeriod);
+  cpuEvent.post();
+#endif
+
+  eventQueue.dispatch_forever();
+}
+
 void BikeSystem::onReset() {
   _resetTime = _timer.elapsed_time();
   core_util_atomic_store_bool(&_resetFlag, true);
@@ -159,8 +234,24 @@ void BikeSystem::onReset() {
 
 void BikeSystem::stop() { core_util_atomic_store_bool(&_stopFlag, true); }
 
+void BikeSystem::setTaskWorkload(uint8_t taskIndex,
+                                 const std::chrono::microseconds &wcet,
+                                 uint8_t variationPercent) {
+  _taskWorkloads.set(taskIndex, wcet, variationPercent);
+}
+
 #if defined(MBED_TEST_MODE)
-const advembsof::TaskLogger &BikeSystem::getTaskLogger() { return _taskLogger; }
+const bike_computer::TaskTracer &BikeSystem::getTaskLogger() {
+  return _taskTracer;
+}
+
+bike_computer::Speedometer &BikeSystem::getSpeedometer() {
+  return _speedometer;
+}
+
+uint32_t BikeSystem::getNbrOfFrameOverruns() const {
+  return _periodicRelease.getNbrOfOverruns();
+}
 #endif // defined(MBED_TEST_MODE)
 
 void BikeSystem::init() {
@@ -170,31 +261,52 @@ void BikeSystem::init() {
   // initialize the lcd display
   disco::ReturnCode rc = _displayDevice.init();
   if (rc != disco::ReturnCode::Ok) {
-    tr_error("Failed to initialized the lcd display: %d", static_cast<int>(rc));
+    DEFERRED_LOG_ERROR(bike_computer::kLogDisplayInitFailed,
+                       static_cast<int>(rc));
   }
 
+  // everything must be drawn again on the initialized display
+  _incrementalDisplay.invalidate();
+
   // initialize the sensor device
   bool present = _sensorDevice.init();
   if (!present) {
-    tr_error("Sensor not present or initialization failed");
+    DEFERRED_LOG_ERROR(bike_computer::kLogSensorInitFailed);
   }
 
   // enable/disable task logging
-  _taskLogger.enable(true);
+  _taskTracer.enable(true);
+  bike_computer::TracePoints::getInstance().enable(true);
+
+  // ideal releases, for the jitter and response time statistics
+  _taskTracer.setTaskRelease(advembsof::TaskLogger::kGearTaskIndex,
+                             kGearTaskPeriod, kGearTaskDelay);
+  _taskTracer.setTaskRelease(advembsof::TaskLogger::kSpeedTaskIndex,
+                             kSpeedDistanceTaskPeriod, kSpeedDistanceTaskDelay);
+  _taskTracer.setTaskRelease(advembsof::TaskLogger::kTemperatureTaskIndex,
+                             kTemperatureTaskPeriod, kTemperatureTaskDelay);
+  _taskTracer.setTaskRelease(advembsof::TaskLogger::kResetTaskIndex,
+                             kResetTaskPeriod, kResetTaskDelay);
+  _taskTracer.setTaskRelease(advembsof::TaskLogger::kDisplayTask1Index,
+                             kDisplayTask1Period, kDisplayTask1Delay);
+  _taskTracer.setTaskRelease(advembsof::TaskLogger::kDisplayTask2Index,
+                             kDisplayTask2Period, kDisplayTask2Delay);
 }
 
 void BikeSystem::gearTask() {
   auto taskStartTime = _timer.elapsed_time();
+  _taskWorkloads.run(advembsof::TaskLogger::kGearTaskIndex);
 
   _currentGear = _gearDevice.getCurrentGear();
   _currentGearSize = _gearDevice.getCurrentGearSize();
 
-  _taskLogger.logPeriodAndExecutionTime(
+  _taskTracer.logPeriodAndExecutionTime(
       _timer, advembsof::TaskLogger::kGearTaskIndex, taskStartTime);
 }
 
 void BikeSystem::speedDistanceTask() {
   auto taskStartTime = _timer.elapsed_time();
+  _taskWorkloads.run(advembsof::TaskLogger::kSpeedTaskIndex);
 
   const auto pedalRotationTime = _pedalDevice.getCurrentRotationTime();
   _speedometer.setCurrentRotationTime(pedalRotationTime);
@@ -203,63 +315,64 @@ void BikeSystem::speedDistanceTask() {
   _currentSpeed = _speedometer.getCurrentSpeed();
   _traveledDistance = _speedometer.getDistance();
 
-  _taskLogger.logPeriodAndExecutionTime(
+  _taskTracer.logPeriodAndExecutionTime(
       _timer, advembsof::TaskLogger::kSpeedTaskIndex, taskStartTime);
 }
 
 void BikeSystem::temperatureTask() {
   auto taskStartTime = _timer.elapsed_time();
+  _taskWorkloads.run(advembsof::TaskLogger::kTemperatureTaskIndex);
 
   _currentTemperature = _sensorDevice.readTemperature();
 
-  ThisThread::sleep_for(std::chrono::duration_cast<std::chrono::milliseconds>(
-      kTemperatureTaskComputationTime -
-      (_timer.elapsed_time() - taskStartTime)));
-
-  _taskLogger.logPeriodAndExecutionTime(
+  _taskTracer.logPeriodAndExecutionTime(
       _timer, advembsof::TaskLogger::kTemperatureTaskIndex, taskStartTime);
 }
 
 void BikeSystem::resetTask() {
   auto taskStartTime = _timer.elapsed_time();
+  _taskWorkloads.run(advembsof::TaskLogger::kResetTaskIndex);
 
   if (core_util_atomic_load_bool(&_resetFlag)) {
-    tr_info("Reset task: response time is %" PRIu64 " usecs",
-            (_timer.elapsed_time() - _resetTime).count());
+    DEFERRED_LOG_INFO(bike_computer::kLogResetResponseTime,
+                      (_timer.elapsed_time() - _resetTime).count());
     _speedometer.reset();
 
     core_util_atomic_store_bool(&_resetFlag, false);
   }
 
-  _taskLogger.logPeriodAndExecutionTime(
+  _taskTracer.logPeriodAndExecutionTime(
       _timer, advembsof::TaskLogger::kResetTaskIndex, taskStartTime);
 }
 
 void BikeSystem::displayTask1() {
   auto taskStartTime = _timer.elapsed_time();
+  _taskWorkloads.run(advembsof::TaskLogger::kDisplayTask1Index);
 
-  _displayDevice.displayGear(_currentGear);
-  _displayDevice.displaySpeed(_currentSpeed);
-  _displayDevice.displayDistance(_traveledDistance);
+  _incrementalDisplay.displayGear(_currentGear);
+  _incrementalDisplay.displaySpeed(_currentSpeed);
+  _incrementalDisplay.displayDistance(_traveledDistance);
 
-  ThisThread::sleep_for(std::chrono::duration_cast<std::chrono::milliseconds>(
-      kDisplayTask1ComputationTime - (_timer.elapsed_time() - taskStartTime)));
-
-  _taskLogger.logPeriodAndExecutionTime(
+  _taskTracer.logPeriodAndExecutionTime(
       _timer, advembsof::TaskLogger::kDisplayTask1Index, taskStartTime);
 }
 
 void BikeSystem::displayTask2() {
   auto taskStartTime = _timer.elapsed_time();
+  _taskWorkloads.run(advembsof::TaskLogger::kDisplayTask2Index);
 
-  _displayDevice.displayTemperature(_currentTemperature);
-
-  ThisThread::sleep_for(std::chrono::duration_cast<std::chrono::milliseconds>(
-      kDisplayTask2ComputationTime - (_timer.elapsed_time() - taskStartTime)));
+  _incrementalDisplay.displayTemperature(_currentTemperature);
 
-  _taskLogger.logPeriodAndExecutionTime(
+  _taskTracer.logPeriodAndExecutionTime(
       _timer, advembsof::TaskLogger::kDisplayTask2Index, taskStartTime);
 }
 
-void BikeSystem::cpuTask() { _cpuLogger.printStats(); }
+void BikeSystem::cpuTask() {
+  _cpuLogger.printStats();
+  _taskTracer.drainTo(*mbed::mbed_file_handle(STDOUT_FILENO));
+  bike_computer::TracePoints::getInstance().drainTo(
+      *mbed::mbed_file_handle(STDOUT_FILENO));
+  bike_computer::DeferredLog::getInstance().drainTo(
+      *mbed::mbed_file_handle(STDOUT_FILENO));
+}
 } // namespace static_scheduling_with_event
@@ -48,14 +48,16 @@ uint8_t GearDevice::getCurrentGear() {
 }
 
 void GearDevice::onUp() {
-  if (_currentGear < bike_computer::kMaxGear) {
-    core_util_atomic_incr_u8(&_currentGear, 1);
+  uint8_t gear = core_util_atomic_load_u8(&_currentGear);
+  while (gear < bike_computer::kMaxGear &&
+         !core_util_atomic_cas_u8(&_currentGear, &gear, gear + 1)) {
   }
 }
 
 void GearDevice::onDown() {
-  if (_currentGear < bike_computer::kMaxGear) {
-    core_util_atomic_decr_u8(&_currentGear, 1);
+  uint8_t gear = core_util_atomic_load_u8(&_currentGear);
+  while (gear > bike_computer::kMinGear &&
+         !core_util_atomic_cas_u8(&_currentGear, &gear, gear - 1)) {
   }
 }
 
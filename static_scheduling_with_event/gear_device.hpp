@@ -37,14 +37,16 @@ public:
   GearDevice(GearDevice &) = delete;
   GearDevice &operator=(GearDevice &) = delete;
 
-  // method called for updating the bike system
+  // method called for updating the bike system, reads the gear set by the
+  // ISRs in constant time
   uint8_t getCurrentGear();
   uint8_t getCurrentGearSize() const;
 
+private:
+  // ISRs, each press is applied in order and clamped to the gear range
   void onUp();
   void onDown();
 
-private:
   // data members
   volatile uint8_t _currentGear = bike_computer::kMinGear;
 };
@@ -24,9 +24,6 @@
 
 namespace static_scheduling_with_event {
 
-// definition of task execution time
-static constexpr std::chrono::microseconds kTaskRunTime = 200000us;
-
 PedalDevice::PedalDevice() {
   disco::Joystick::getInstance().setLeftCallback(
       callback(this, &PedalDevice::onLeft));
@@ -35,27 +32,24 @@ PedalDevice::PedalDevice() {
 }
 
 std::chrono::milliseconds PedalDevice::getCurrentRotationTime() {
-  uint32_t currentStep = core_util_atomic_load_u32(&_currentStep);
   return bike_computer::kMinPedalRotationTime +
-         currentStep * bike_computer::kDeltaPedalRotationTime;
+         core_util_atomic_load_u32(&_currentStep) *
+             bike_computer::kDeltaPedalRotationTime;
 }
 
-void PedalDevice::increaseRotationSpeed() {
-  uint32_t currentStep = core_util_atomic_load_u32(&_currentStep);
-  if (currentStep > 0) {
-    core_util_atomic_decr_u32(&_currentStep, 1);
+// left decreases the rotation speed (one more step), right increases it
+void PedalDevice::onLeft() {
+  uint32_t step = core_util_atomic_load_u32(&_currentStep);
+  while (step < kNbrOfSteps &&
+         !core_util_atomic_cas_u32(&_currentStep, &step, step + 1)) {
   }
 }
 
-void PedalDevice::decreaseRotationSpeed() {
-  uint32_t currentStep = core_util_atomic_load_u32(&_currentStep);
-  if (currentStep < kNbrOfSteps) {
-    core_util_atomic_incr_u32(&_currentStep, 1);
+void PedalDevice::onRight() {
+  uint32_t step = core_util_atomic_load_u32(&_currentStep);
+  while (step > 0 &&
+         !core_util_atomic_cas_u32(&_currentStep, &step, step - 1)) {
   }
 }
 
-void PedalDevice::onLeft() { decreaseRotationSpeed(); }
-
-void PedalDevice::onRight() { increaseRotationSpeed(); }
-
 } // namespace static_scheduling_with_event
@@ -37,15 +37,15 @@ public:
   PedalDevice(PedalDevice &) = delete;
   PedalDevice &operator=(PedalDevice &) = delete;
 
-  // method called for updating the bike system
+  // method called for updating the bike system, reads the rotation time set
+  // by the ISRs in constant time
   std::chrono::milliseconds getCurrentRotationTime();
 
 private:
-  // private methods
+  // ISRs, each press is applied in order and clamped to the rotation time
+  // range
   void onLeft();
   void onRight();
-  void increaseRotationSpeed();
-  void decreaseRotationSpeed();
 
   // data members
   static constexpr uint32_t kNbrOfSteps =